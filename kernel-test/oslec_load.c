@@ -0,0 +1,284 @@
+/*
+  oslec_load.c
+  Created 18 October 2026
+
+  Synthetic span load generator for measuring how many channels of
+  OSLEC a machine can run in kernel mode.  Simulates N E1 or T1 spans
+  with a 1ms hrtimer tick, like the interrupt from a real card.  Each
+  tick every active channel is fed a chunk of synthetic speech + echo
+  through oslec_echo_can_update(), just like Zaptel does.
+
+  Load kernel/oslec.ko first, then for example:
+
+    # insmod oslec_load.ko spans=8 t1=0 ramp=5
+    (wait)
+    # rmmod oslec_load
+    # dmesg
+
+  Once a second it logs the active channel count, the ISR latency
+  (how late the tick ran) worst and average, the CPU used by the
+  ticks, and the number of overruns (ticks where we spent more than
+  1ms, or missed ticks altogether).  With ramp=S another span is
+  brought up every S seconds, and the channel count at which overruns
+  first appear is reported as the point where deadlines start to slip.
+*/
+
+/*
+  Copyright (C) 2026
+
+  All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+
+#include "../kernel/oslec.h"    /* the Zaptel interface, not ./oslec.h */
+
+#define CHUNKSIZE  8        /* samples per channel per tick */
+#define TICK_NS    1000000  /* 1ms */
+#define TICKS_SEC  1000
+#define N          8000     /* samples in the synthetic signal tables */
+#define ECHO_DELAY 40       /* 5ms echo path delay */
+#define MAX_SPANS  64
+
+static int spans = 4;
+static int t1 = 0;
+static int taps = 256;
+static int ramp = 0;
+module_param(spans, int, 0444);
+MODULE_PARM_DESC(spans, "number of simulated spans");
+module_param(t1, int, 0444);
+MODULE_PARM_DESC(t1, "1 for T1 spans (24 channels), 0 for E1 (30 channels)");
+module_param(taps, int, 0444);
+MODULE_PARM_DESC(taps, "echo canceller length in taps");
+module_param(ramp, int, 0444);
+MODULE_PARM_DESC(ramp, "seconds between bringing up each span, 0 for all at once");
+
+static struct echo_can_state **ec;
+static int    chans_per_span;
+static int    max_chans;
+static int    active_chans;
+static short *far;            /* far end speech, looped */
+static short *near;           /* near end speech, for double talk */
+
+static struct hrtimer tick_timer;
+static volatile int   running;
+static u32            tick;
+
+/* stats for the current second, all times in ns.  Note 64 bit
+   divides must go through div_s64() etc for 32 bit kernels */
+
+static s64 lat_worst, lat_sum;
+static s64 busy_sum;
+static int overruns;
+
+/* totals */
+
+static s64 busy_total, elapsed_total;
+static s64 lat_worst_total;
+static int overruns_total;
+static int slip_chans;
+
+/*
+   Crude synthetic speech: noise through a one pole low pass filter,
+   switched on and off at a syllabic rate.  The near end talks about
+   a quarter of the time, so we get some double talk too.  Made once
+   at load time so the signal generation isn't part of the load we
+   are measuring.
+*/
+
+static void make_signals(void) {
+  u32 seed = 1;
+  int i, y, n;
+
+  y = 0;
+  for(i=0; i<N; i++) {
+    seed = seed*1664525 + 1013904223;
+    n = (short)(seed >> 16);
+    y += (n - y) >> 2;
+    far[i] = (((i/1200) % 3) == 2) ? 0 : y >> 1;
+  }
+  for(i=0; i<N; i++)
+    near[i] = (((i/2000) % 4) == 1) ? far[(i + N/2) % N] : 0;
+}
+
+/* one chunk for every active channel, each channel starts at a
+   different place in the signal tables */
+
+static void run_chunk(void) {
+  int c, i, tx, rx;
+  u32 t;
+
+  for(c=0; c<active_chans; c++) {
+    t = tick*CHUNKSIZE + c*97;
+    for(i=0; i<CHUNKSIZE; i++, t++) {
+      tx = far[t % N];
+      rx = far[(t + N - ECHO_DELAY) % N]/4 + near[t % N];
+      oslec_echo_can_update(ec[c], tx, rx);
+    }
+  }
+}
+
+static void end_of_second(void) {
+  int sec = tick/TICKS_SEC;
+
+  printk("oslec_load: %4d s chans: %4d latency (us) worst: %4d avg: %4d "
+	 "cpu: %3d%% overruns: %d\n",
+	 sec, active_chans,
+	 (int)div_s64(lat_worst, 1000), (int)div_s64(lat_sum, TICKS_SEC*1000),
+	 (int)div_s64(busy_sum, TICKS_SEC*TICK_NS/100),
+	 overruns);
+
+  if (overruns && (slip_chans == 0))
+    slip_chans = active_chans;
+
+  if (lat_worst > lat_worst_total)
+    lat_worst_total = lat_worst;
+  overruns_total += overruns;
+  lat_worst = lat_sum = busy_sum = 0;
+  overruns = 0;
+
+  /* bring up another span */
+
+  if (ramp && ((sec % ramp) == 0) && (active_chans < max_chans))
+    active_chans += chans_per_span;
+}
+
+static enum hrtimer_restart tick_handler(struct hrtimer *timer) {
+  ktime_t now, done;
+  s64     lat, busy;
+  u64     missed;
+
+  if (!running)
+    return HRTIMER_NORESTART;
+
+  now = hrtimer_cb_get_time(timer);
+  lat = ktime_to_ns(ktime_sub(now, hrtimer_get_expires(timer)));
+
+  run_chunk();
+
+  done = hrtimer_cb_get_time(timer);
+  busy = ktime_to_ns(ktime_sub(done, now));
+
+  if (lat > lat_worst)
+    lat_worst = lat;
+  lat_sum += lat;
+  busy_sum += busy;
+  busy_total += busy;
+
+  /* hrtimer_forward() tells us how many ticks we have skipped over,
+     more than one means we missed some altogether */
+
+  missed = hrtimer_forward(timer, done, ns_to_ktime(TICK_NS));
+  if ((busy > TICK_NS) || (missed > 1))
+    overruns++;
+
+  elapsed_total += TICK_NS*missed;
+  tick += missed;
+  if ((tick % TICKS_SEC) < missed)
+    end_of_second();
+
+  return HRTIMER_RESTART;
+}
+
+static int __init init_load(void)
+{
+  int c;
+
+  if ((spans < 1) || (spans > MAX_SPANS)) {
+    printk("oslec_load: spans must be 1..%d\n", MAX_SPANS);
+    return -EINVAL;
+  }
+
+  chans_per_span = t1 ? 24 : 30;
+  max_chans = spans*chans_per_span;
+
+  ec = kmalloc(max_chans*sizeof(struct echo_can_state *), GFP_KERNEL);
+  far = vmalloc(N*sizeof(short));
+  near = vmalloc(N*sizeof(short));
+  if ((ec == NULL) || (far == NULL) || (near == NULL))
+    goto fail;
+  memset(ec, 0, max_chans*sizeof(struct echo_can_state *));
+  make_signals();
+
+  for(c=0; c<max_chans; c++) {
+    ec[c] = oslec_echo_can_create(taps, 0);
+    if (ec[c] == NULL)
+      goto fail;
+  }
+
+  active_chans = ramp ? chans_per_span : max_chans;
+  tick = 0;
+  slip_chans = 0;
+
+  printk("oslec_load: %d %s spans, %d channels, %d taps\n",
+	 spans, t1 ? "T1" : "E1", max_chans, taps);
+
+  running = 1;
+  hrtimer_init(&tick_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+  tick_timer.function = tick_handler;
+  hrtimer_start(&tick_timer, ns_to_ktime(TICK_NS), HRTIMER_MODE_REL);
+
+  return 0;
+
+ fail:
+  if (ec) {
+    for(c=0; c<max_chans; c++)
+      if (ec[c])
+	oslec_echo_can_free(ec[c]);
+    kfree(ec);
+  }
+  if (far)
+    vfree(far);
+  if (near)
+    vfree(near);
+  return -ENOMEM;
+}
+
+static void __exit cleanup_load(void)
+{
+  int c;
+
+  running = 0;
+  hrtimer_cancel(&tick_timer);
+
+  printk("oslec_load: %d s, worst latency %d us, cpu %d%%, %d overruns\n",
+	 tick/TICKS_SEC, (int)div_s64(lat_worst_total, 1000),
+	 elapsed_total ? (int)div64_u64(busy_total*100, elapsed_total) : 0,
+	 overruns_total);
+  if (slip_chans)
+    printk("oslec_load: deadlines started to slip at %d channels\n", slip_chans);
+  else
+    printk("oslec_load: no slips, up to %d channels\n", active_chans);
+
+  for(c=0; c<max_chans; c++)
+    oslec_echo_can_free(ec[c]);
+  kfree(ec);
+  vfree(far);
+  vfree(near);
+}
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Synthetic span load generator for OSLEC");
+
+module_init(init_load);
+module_exit(cleanup_load);
@@ -28,8 +28,11 @@
 #ifndef __OSLEC__
 #define __OSLEC__
 
+#include <linux/list.h>
+
 struct echo_can_state {
   void *ec;
+  struct list_head list;   /* all instances, for /proc/oslec/stats */
 };
 
 struct echo_can_state *oslec_echo_can_create(int len, int adaption_mode);
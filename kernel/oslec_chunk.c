@@ -0,0 +1,171 @@
+/*
+  oslec_chunk.c
+  Created 18 October 2026
+
+  Chunk based front end for OSLEC, see oslec_chunk.h.  This sits
+  alongside the Zaptel per-sample wrapper in oslec_wrap.c and uses it
+  to create and free the e/c instances, so channels set up here still
+  show up in /proc/oslec.
+
+  Channels are registered per span.  On each interrupt the driver can
+  call oslec_span_process() once for the whole span, which takes the
+  span lock once and runs the block canceller over each channel's
+  chunk in turn, rather than taking a call (and checking the monitor
+  state) for every sample of every channel.
+*/
+
+/*
+  Copyright (C) 2026
+
+  All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/version.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/spinlock.h>
+
+#include "oslec_chunk.h"
+#include <echo.h>
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,0)
+EXPORT_SYMBOL(oslec_span_register);
+EXPORT_SYMBOL(oslec_span_unregister);
+EXPORT_SYMBOL(oslec_echocan_create);
+EXPORT_SYMBOL(oslec_echocan_free);
+EXPORT_SYMBOL(oslec_echocan_process);
+EXPORT_SYMBOL(oslec_echocan_hpf_tx);
+EXPORT_SYMBOL(oslec_span_process);
+#endif
+
+#define SPAN_NAME_LEN 32
+
+struct oslec_span {
+  char                    name[SPAN_NAME_LEN];
+  int                     channels;
+  spinlock_t              lock;     /* protects chan[] */
+  struct echo_can_state **chan;     /* NULL where no e/c is running */
+};
+
+struct oslec_span *oslec_span_register(const char *name, int channels) {
+  struct oslec_span *span;
+
+  span = kmalloc(sizeof(struct oslec_span), GFP_KERNEL);
+  if (span == NULL)
+    return NULL;
+
+  span->chan = kmalloc(channels*sizeof(struct echo_can_state *), GFP_KERNEL);
+  if (span->chan == NULL) {
+    kfree(span);
+    return NULL;
+  }
+  memset(span->chan, 0, channels*sizeof(struct echo_can_state *));
+
+  strncpy(span->name, name, SPAN_NAME_LEN - 1);
+  span->name[SPAN_NAME_LEN - 1] = 0;
+  span->channels = channels;
+  spin_lock_init(&span->lock);
+
+  printk("oslec: registered span %s, %d channels\n", span->name, channels);
+
+  return span;
+}
+
+void oslec_span_unregister(struct oslec_span *span) {
+  int i;
+
+  for(i=0; i<span->channels; i++)
+    oslec_echocan_free(span, i);
+
+  printk("oslec: unregistered span %s\n", span->name);
+  kfree(span->chan);
+  kfree(span);
+}
+
+struct echo_can_state *oslec_echocan_create(struct oslec_span *span, int chan, int len) {
+  struct echo_can_state *ec, *old;
+  unsigned long flags;
+
+  if ((chan < 0) || (chan >= span->channels))
+    return NULL;
+
+  /* the e/c is allocated before we take the lock, as kmalloc() may sleep */
+
+  ec = oslec_echo_can_create(len, 0);
+  if (ec == NULL)
+    return NULL;
+
+  spin_lock_irqsave(&span->lock, flags);
+  old = span->chan[chan];
+  span->chan[chan] = ec;
+  spin_unlock_irqrestore(&span->lock, flags);
+
+  if (old)
+    oslec_echo_can_free(old);
+
+  return ec;
+}
+
+void oslec_echocan_free(struct oslec_span *span, int chan) {
+  struct echo_can_state *ec;
+  unsigned long flags;
+
+  if ((chan < 0) || (chan >= span->channels))
+    return;
+
+  /* once it's out of chan[] oslec_span_process() can't be using it, so
+     it's safe to free outside the span lock */
+
+  spin_lock_irqsave(&span->lock, flags);
+  ec = span->chan[chan];
+  span->chan[chan] = NULL;
+  spin_unlock_irqrestore(&span->lock, flags);
+
+  if (ec)
+    oslec_echo_can_free(ec);
+}
+
+/*
+   Like oslec_echo_can_update() these run in the context of an ISR.
+   The caller is responsible for not freeing ec while they run, just
+   as with the Zaptel interface.
+*/
+
+void oslec_echocan_process(struct echo_can_state *ec, short *isig, const short *iref, u32 size) {
+  echo_can_update_block((echo_can_state_t*)(ec->ec), isig, iref, isig, size);
+}
+
+void oslec_echocan_hpf_tx(struct echo_can_state *ec, short *iref, u32 size) {
+  echo_can_hpf_tx_block((echo_can_state_t*)(ec->ec), iref, size);
+}
+
+void oslec_span_process(struct oslec_span *span, short *isig[], short *iref[], u32 size) {
+  struct echo_can_state *ec;
+  unsigned long flags;
+  int i;
+
+  spin_lock_irqsave(&span->lock, flags);
+
+  for(i=0; i<span->channels; i++) {
+    ec = span->chan[i];
+    if (ec)
+      echo_can_update_block((echo_can_state_t*)(ec->ec), isig[i], iref[i], isig[i], size);
+  }
+
+  spin_unlock_irqrestore(&span->lock, flags);
+}
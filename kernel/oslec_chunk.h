@@ -0,0 +1,62 @@
+/*
+  oslec_chunk.h
+  Created 18 October 2026
+
+  Chunk based interface for OSLEC, in the style of the DAHDI echocan
+  interface.  Rather than calling oslec_echo_can_update() once per
+  sample, the driver passes a chunk of samples per channel (usually
+  ZT_CHUNKSIZE, 8 samples or 1ms), or the chunks for every channel on
+  a span at once.
+*/
+
+/*
+  Copyright (C) 2026
+
+  All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#ifndef __OSLEC_CHUNK__
+#define __OSLEC_CHUNK__
+
+#include "oslec.h"
+
+/* A span is a group of channels serviced by the same interrupt, e.g.
+   the 30 or 31 channels of an E1 */
+
+struct oslec_span;
+
+struct oslec_span *oslec_span_register(const char *name, int channels);
+void oslec_span_unregister(struct oslec_span *span);
+
+/* create/free the e/c on one channel of a span, process context only */
+
+struct echo_can_state *oslec_echocan_create(struct oslec_span *span, int chan, int len);
+void oslec_echocan_free(struct oslec_span *span, int chan);
+
+/* Cancel echo from one chunk of one channel.  isig (the signal from the
+   line, including echo) is replaced with the clean signal, iref is the
+   signal we sent to the line. */
+
+void oslec_echocan_process(struct echo_can_state *ec, short *isig, const short *iref, u32 size);
+void oslec_echocan_hpf_tx(struct echo_can_state *ec, short *iref, u32 size);
+
+/* Cancel echo from one chunk of every channel on a span.  isig[chan]
+   and iref[chan] point to the chunk for each channel, channels with no
+   e/c are left alone. */
+
+void oslec_span_process(struct oslec_span *span, short *isig[], short *iref[], u32 size);
+
+#endif
@@ -42,6 +42,7 @@
 #include <linux/version.h>
 #include <linux/slab.h>
 #include <linux/proc_fs.h>
+#include <linux/rcupdate.h>
 #include <asm/atomic.h>
 #include <asm/delay.h>
 
@@ -51,6 +52,7 @@
 
 #include "oslec.h"
 #include <echo.h>
+#include <tone_detect_fixed.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,0)
 EXPORT_SYMBOL(oslec_echo_can_create);
@@ -59,6 +61,14 @@ EXPORT_SYMBOL(oslec_echo_can_update);
 EXPORT_SYMBOL(oslec_echo_can_traintap);
 EXPORT_SYMBOL(oslec_echo_can_identify);
 EXPORT_SYMBOL(oslec_hpf_tx);
+EXPORT_SYMBOL(dtmf_rx_fixed_init);
+EXPORT_SYMBOL(dtmf_rx_fixed_parms);
+EXPORT_SYMBOL(dtmf_rx_fixed_set_realtime_callback);
+EXPORT_SYMBOL(dtmf_rx_fixed);
+EXPORT_SYMBOL(dtmf_rx_fixed_get);
+EXPORT_SYMBOL(bell_mf_rx_fixed_init);
+EXPORT_SYMBOL(bell_mf_rx_fixed);
+EXPORT_SYMBOL(bell_mf_rx_fixed_get);
 #endif
 
 /* constants for isr cycle averaging */
@@ -124,6 +134,25 @@ static inline volatile unsigned int cycles(void) {
 static echo_can_state_t *mon_ec;
 static int num_ec;
 static int len_ec;
+
+/* every e/c instance, so /proc/oslec/stats can report them all */
+
+static LIST_HEAD(ec_list);
+
+/* Event tracing, see /proc/oslec/trace.  Each e/c created while
+   trace_on is set gets a trace ring of 2^TRACE_LOG2_LEN events (8 bytes
+   each) so we only burn the memory while someone is debugging. */
+
+#define TRACE_LOG2_LEN 12
+
+static int trace_on;
+
+/* Coefficient snapshots, see /proc/oslec/taps.  snap_ec is the
+   channel being watched, snap_buf holds the record being read. */
+
+static struct echo_can_state *snap_ec;
+static char *snap_buf;
+static int snap_len;
  
 /* We need this lock as multiple threads may try to manipulate
    the globals used for diagnostics at the same time.
@@ -177,9 +206,15 @@ struct echo_can_state *oslec_echo_can_create(int len, int adaption_mode) {
 				       | ECHO_CAN_USE_TX_HPF
 				       | ECHO_CAN_USE_RX_HPF);
 				   
+  /* Allocate the trace ring here, as we can't kmalloc() with the lock
+     held.  Failure is OK, we just don't trace this call. */
+
+  if (trace_on)
+    echo_can_trace_enable((echo_can_state_t*)(ec->ec), TRACE_LOG2_LEN);
 
   spin_lock_irqsave(&oslec_lock, flags);
   num_ec++;
+  list_add_tail(&ec->list, &ec_list);
 
   /* We monitor the first e/c created after mon_ec is set to NULL.  If
      no other calls exist this will be the first call.  If a monitored
@@ -207,6 +242,16 @@ void oslec_echo_can_free(struct echo_can_state *ec) {
   if (mon_ec == ec->ec)
     mon_ec = NULL;
 
+  /* echo_can_free() frees the attached snapshot */
+
+  if (snap_ec == ec) {
+    snap_ec = NULL;
+    kfree(snap_buf);
+    snap_buf = NULL;
+    snap_len = 0;
+  }
+
+  list_del(&ec->list);
   echo_can_free((echo_can_state_t*)(ec->ec));
   num_ec--;
   free(ec);
@@ -260,11 +305,20 @@ void oslec_echo_can_identify(char *buf, size_t len)
        strncpy(buf, "Oslec", len);
 }
 
+/* format a level in 0.1dB steps, e.g. -3 as "-0.3" */
+
+static char *db10_str(char *s, int db10) {
+  sprintf(s, "%s%d.%d", (db10 < 0) ? "-" : "", abs(db10)/10, abs(db10)%10);
+  return s;
+}
+
 static int proc_read_info(char *buf, char **start, off_t offset,
                           int count, int *eof, void *data)
 {
   int len;
   char mode_str[80];
+  char erl_str[16], erle_str[16];
+  echo_can_stats_t stats;
   unsigned long flags;
 
   *eof = 1;
@@ -304,6 +358,8 @@ static int proc_read_info(char *buf, char **start, off_t offset,
   else
     strcat(mode_str, "|   |");		
 
+  echo_can_get_stats(mon_ec, &stats);
+
   len = sprintf(buf,
 		"channels.......: %d\n"
 		"length (taps)..: %d\n"
@@ -315,9 +371,14 @@ static int proc_read_info(char *buf, char **start, off_t offset,
 		"shift..........: %d\n"
 		"Double Talk....: %d\n"
 		"Lbgn...........: %d\n"
+		"ERL (dB).......: %s\n"
+		"ERLE (dB)......: %s\n"
+		"Converged......: %d\n"
+		"Converge (ms)..: %d\n"
 		"MIPs (last)....: %d\n"
 		"MIPs (worst)...: %d\n"
-		"MIPs (avergage): %d\n",
+		"MIPs (avergage): %d\n"
+		"Trace lost.....: %u\n",
 		num_ec,
 		len_ec,
 		mon_ec->adaption_mode, mode_str,
@@ -328,9 +389,14 @@ static int proc_read_info(char *buf, char **start, off_t offset,
 		mon_ec->shift,
 		(mon_ec->nonupdate_dwell != 0),
 		mon_ec->Lbgn,
+		db10_str(erl_str, stats.erl),
+		db10_str(erle_str, stats.erle),
+		stats.converged,
+		stats.converge_time,
 		8*cycles_last/1000,
 		8*cycles_worst/1000,
-		8*cycles_average/1000
+		8*cycles_average/1000,
+		(mon_ec->trace_ring) ? mon_ec->trace_ring->lost : 0
 		);
 
   spin_unlock_irqrestore(&oslec_lock, flags);
@@ -338,6 +404,65 @@ static int proc_read_info(char *buf, char **start, off_t offset,
   return len;
 }
 
+/*
+  /proc/oslec/stats gives a line per e/c instance, so you can see at a
+  glance which calls have converged.  The estimates are only updated
+  during far end single talk, "meas" is how much of that (in ms) each
+  one is based on.
+
+  There may be more channels than fit in a page, so we use the
+  "record number" trick: offset counts lines (the header is line 0)
+  and *start tells the proc code how many lines we returned.
+*/
+
+#define STATS_LINE_LEN 64
+
+static int proc_read_stats(char *buf, char **start, off_t offset,
+                           int count, int *eof, void *data)
+{
+  struct echo_can_state *ec;
+  echo_can_stats_t stats;
+  char erl_str[16], erle_str[16];
+  unsigned long flags;
+  int len, line, n;
+
+  len = n = 0;
+  line = 1;
+
+  if (offset == 0) {
+    len += sprintf(buf, " chan  taps  conv  conv(ms)   ERL(dB)  ERLE(dB)  meas(ms)\n");
+    n++;
+  }
+
+  spin_lock_irqsave(&oslec_lock, flags);
+
+  list_for_each_entry(ec, &ec_list, list) {
+    if (len + STATS_LINE_LEN > count)
+      break;
+    if (line >= offset) {
+      echo_can_get_stats((echo_can_state_t*)(ec->ec), &stats);
+      len += sprintf(buf + len, "%5d %5d %5d %9d %9s %9s %9d\n", 
+		     line - 1,
+		     ((echo_can_state_t*)(ec->ec))->taps,
+		     stats.converged,
+		     stats.converge_time,
+		     db10_str(erl_str, stats.erl),
+		     db10_str(erle_str, stats.erle),
+		     stats.measured_time);
+      n++;
+    }
+    line++;
+  }
+
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  *start = (char *)(long)n;
+  if (n == 0)
+    *eof = 1;
+
+  return len;
+}
+
 static int proc_read_mode(char *buf, char **start, off_t offset,
                           int count, int *eof, void *data)
 {
@@ -408,22 +533,247 @@ static int proc_write_reset(struct file *file, const char *buffer,
   return count;
 }
 
+/*
+  Reading /proc/oslec/trace returns the events logged by the monitored
+  e/c as binary echo_can_trace_event_t records, oldest first.  Events
+  are removed as they are read.  If the ring fills up, the events that
+  do not fit are dropped, and an ECHO_CAN_TRACE_LOST record giving the
+  number dropped goes in ahead of the next event that fits.  The total
+  is shown as "Trace lost" in /proc/oslec/info.  Something like:
+
+    # echo 1 > /proc/oslec/trace
+    (make a new call)
+    # cat /proc/oslec/trace > trace.bin
+
+  then decode with user/oslec_trace.  Writing 0 stops tracing on
+  every channel, not just the monitored one.
+*/
+
+static int proc_read_trace(char *buf, char **start, off_t offset,
+                           int count, int *eof, void *data)
+{
+  int n;
+  unsigned long flags;
+
+  spin_lock_irqsave(&oslec_lock, flags);
+
+  if (mon_ec == NULL) {
+    spin_unlock_irqrestore(&oslec_lock, flags);
+    *eof = 1;
+    return 0;
+  }
+
+  n = echo_can_trace_read(mon_ec, (echo_can_trace_event_t *)buf, 
+			  count/sizeof(echo_can_trace_event_t));
+
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  /* data is consumed as it is read, so always return it from the start
+     of the page */
+
+  *start = buf;
+  if (n == 0)
+    *eof = 1;
+
+  return n*sizeof(echo_can_trace_event_t);
+}
+
+static int proc_write_trace(struct file *file, const char *buffer,
+                            unsigned long count, void *data)
+{
+  char *endbuffer;
+  unsigned long flags;
+  struct echo_can_state *ec;
+
+  spin_lock_irqsave(&oslec_lock, flags);
+
+  trace_on = simple_strtol (buffer, &endbuffer, 10);
+
+  /* switching on takes effect from the next call created, as that's
+     when the trace ring is allocated.  Every call created while
+     tracing was on has a ring, so switch them all off. */
+
+  if (trace_on == 0) {
+    list_for_each_entry(ec, &ec_list, list)
+      echo_can_trace_disable((echo_can_state_t*)(ec->ec));
+  }
+
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  return count;
+}
+
+/*
+  /proc/oslec/taps exports the foreground and background filter
+  coefficients of one channel, so the impulse response of a live call
+  can be plotted.  Write the channel number (as listed in
+  /proc/oslec/stats) to start watching it, and -1 to stop.  Each read
+  returns one binary record:
+
+    uint32_t sample;          canceller sample count at the snapshot
+    uint32_t taps;
+    int16_t  fg[taps];
+    int16_t  bg[taps];
+
+  which user/oslec_taps can print for gnuplot.  The snapshot memory is
+  only allocated while a channel is being watched.
+*/
+
+static struct echo_can_state *find_channel(int chan) {
+  struct echo_can_state *ec;
+
+  list_for_each_entry(ec, &ec_list, list) {
+    if (chan-- == 0)
+      return ec;
+  }
+  return NULL;
+}
+
+static void taps_unwatch(void) {
+  echo_can_snapshot_t *snap = NULL;
+  char *buf;
+  unsigned long flags;
+
+  spin_lock_irqsave(&oslec_lock, flags);
+  if (snap_ec)
+    snap = echo_can_snapshot_detach((echo_can_state_t*)(snap_ec->ec));
+  snap_ec = NULL;
+  buf = snap_buf;
+  snap_buf = NULL;
+  snap_len = 0;
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  /* oslec_echo_can_update() may still be writing to the snapshot on
+     another CPU, wait until it can't be before freeing */
+
+  if (snap) {
+    synchronize_sched();
+    echo_can_snapshot_free(snap);
+  }
+  kfree(buf);
+}
+
+static int proc_read_taps(char *buf, char **start, off_t offset,
+                          int count, int *eof, void *data)
+{
+  echo_can_state_t *ec;
+  uint32_t *hdr;
+  int len, n;
+  unsigned long flags;
+
+  spin_lock_irqsave(&oslec_lock, flags);
+
+  if (snap_ec == NULL) {
+    spin_unlock_irqrestore(&oslec_lock, flags);
+    *eof = 1;
+    return 0;
+  }
+
+  /* take a fresh copy at the start of each record, the rest of the
+     record comes from the same copy */
+
+  if (offset == 0) {
+    ec = (echo_can_state_t*)(snap_ec->ec);
+    hdr = (uint32_t *)snap_buf;
+    n = echo_can_snapshot_read(ec->snapshot, &hdr[0], 
+			       (int16_t *)(snap_buf + 8),
+			       (int16_t *)(snap_buf + 8) + ec->taps);
+    hdr[1] = n;
+    snap_len = n ? 8 + 4*n : 0;
+  }
+
+  len = snap_len - offset;
+  if (len > count)
+    len = count;
+  if (len < 0)
+    len = 0;
+  memcpy(buf, snap_buf + offset, len);
+
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  *start = buf;
+  if (offset + len >= snap_len)
+    *eof = 1;
+
+  return len;
+}
+
+static int proc_write_taps(struct file *file, const char *buffer,
+                           unsigned long count, void *data)
+{
+  echo_can_snapshot_t *snap;
+  struct echo_can_state *ec;
+  char *endbuffer, *buf;
+  int chan, taps;
+  unsigned long flags;
+
+  chan = simple_strtol (buffer, &endbuffer, 10);
+
+  taps_unwatch();
+  if (chan < 0)
+    return count;
+
+  spin_lock_irqsave(&oslec_lock, flags);
+  ec = find_channel(chan);
+  taps = ec ? ((echo_can_state_t*)(ec->ec))->taps : 0;
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  if (ec == NULL) {
+    printk("no echo canceller on channel %d\n", chan);
+    return count;
+  }
+
+  /* allocate without the lock held, then check the channel is still
+     there before attaching */
+
+  snap = echo_can_snapshot_create(taps);
+  buf = kmalloc(8 + 4*taps, GFP_KERNEL);
+  if ((snap == NULL) || (buf == NULL))
+    goto fail;
+
+  spin_lock_irqsave(&oslec_lock, flags);
+  if ((find_channel(chan) != ec) 
+      || echo_can_snapshot_attach((echo_can_state_t*)(ec->ec), snap)) {
+    spin_unlock_irqrestore(&oslec_lock, flags);
+    goto fail;
+  }
+  snap_ec = ec;
+  snap_buf = buf;
+  snap_len = 0;
+  spin_unlock_irqrestore(&oslec_lock, flags);
+
+  return count;
+
+ fail:
+  if (snap)
+    echo_can_snapshot_free(snap);
+  kfree(buf);
+  return count;
+}
+
 static int __init init_oslec(void)
 {
-    struct proc_dir_entry *proc_oslec, *proc_mode, *proc_reset;
+    struct proc_dir_entry *proc_oslec, *proc_mode, *proc_reset, *proc_trace;
+    struct proc_dir_entry *proc_taps;
 
     printk("Open Source Line Echo Canceller Installed\n");
 
     num_ec = 0;
     mon_ec = NULL;
+    trace_on = 0;
 
     proc_oslec = proc_mkdir("oslec", 0);
     create_proc_read_entry("oslec/info", 0, NULL, proc_read_info, NULL);
+    create_proc_read_entry("oslec/stats", 0, NULL, proc_read_stats, NULL);
     proc_mode = create_proc_read_entry("oslec/mode", 0, NULL, proc_read_mode, NULL);
     proc_reset = create_proc_read_entry("oslec/reset", 0, NULL, NULL, NULL);
+    proc_trace = create_proc_read_entry("oslec/trace", 0, NULL, proc_read_trace, NULL);
+    proc_taps = create_proc_read_entry("oslec/taps", 0, NULL, proc_read_taps, NULL);
 
     proc_mode->write_proc = proc_write_mode;
     proc_reset->write_proc = proc_write_reset;
+    proc_trace->write_proc = proc_write_trace;
+    proc_taps->write_proc = proc_write_taps;
     spin_lock_init(&oslec_lock);
 
     return 0;
@@ -431,7 +781,11 @@ static int __init init_oslec(void)
 
 static void __exit cleanup_oslec(void)
 {
+    taps_unwatch();
+    remove_proc_entry("oslec/taps", NULL);
+    remove_proc_entry("oslec/trace", NULL);
     remove_proc_entry("oslec/reset", NULL);
+    remove_proc_entry("oslec/stats", NULL);
     remove_proc_entry("oslec/info", NULL);
     remove_proc_entry("oslec/mode", NULL);
     remove_proc_entry("oslec", NULL);
@@ -53,6 +53,7 @@
 #include "spandsp/fsk.h"
 #include "spandsp/tone_detect.h"
 #include "spandsp/tone_generate.h"
+#include "spandsp/tone_analysis.h"
 #include "spandsp/dtmf.h"
 #include "spandsp/adsi.h"
 
@@ -422,6 +423,103 @@ void adsi_rx_init(adsi_rx_state_t *s,
 }
 /*- End of function --------------------------------------------------------*/
 
+void adsi_rx_bank(adsi_rx_bank_state_t *s, const int16_t *amp[], int len)
+{
+    int i;
+
+    if (s->fsk)
+    {
+        fsk_rx_bank(s->fsk, amp, len);
+    }
+    else
+    {
+        for (i = 0;  i < s->channels;  i++)
+            adsi_rx(&s->chan[i], amp[i], len);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+adsi_rx_bank_state_t *adsi_rx_bank_init(adsi_rx_bank_state_t *s,
+                                        int channels,
+                                        int standard,
+                                        put_msg_func_t put_msg,
+                                        void *user_data[])
+{
+    fsk_rx_state_t **rx;
+    int alloced;
+    int i;
+
+    if (channels <= 0)
+        return NULL;
+    alloced = FALSE;
+    if (s == NULL)
+    {
+        if ((s = (adsi_rx_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+        alloced = TRUE;
+    }
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    if ((s->chan = (adsi_rx_state_t *) malloc(channels*sizeof(adsi_rx_state_t))) == NULL)
+    {
+        if (alloced)
+            free(s);
+        return NULL;
+    }
+    for (i = 0;  i < channels;  i++)
+        adsi_rx_init(&s->chan[i], standard, put_msg, (user_data)  ?  user_data[i]  :  NULL);
+    if (standard != ADSI_STANDARD_CLIP_DTMF)
+    {
+        /* Run the channels' own FSK receivers as a bank */
+        if ((rx = (fsk_rx_state_t **) malloc(channels*sizeof(fsk_rx_state_t *))) != NULL)
+        {
+            for (i = 0;  i < channels;  i++)
+                rx[i] = &s->chan[i].fskrx;
+            s->fsk = fsk_rx_bank_attach(NULL, channels, rx);
+            free(rx);
+        }
+        if (s->fsk == NULL)
+        {
+            free(s->chan);
+            if (alloced)
+                free(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int adsi_rx_bank_release(adsi_rx_bank_state_t *s)
+{
+    if (s->fsk)
+        fsk_rx_bank_release(s->fsk);
+    free(s->chan);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int adsi_rx_bank_reset_channel(adsi_rx_bank_state_t *s, int chan)
+{
+    adsi_rx_state_t *t;
+
+    if (chan < 0  ||  chan >= s->channels)
+        return -1;
+    t = &s->chan[chan];
+    adsi_rx_init(t, t->standard, t->put_msg, t->user_data);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+adsi_rx_state_t *adsi_rx_bank_channel(adsi_rx_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return NULL;
+    return &s->chan[chan];
+}
+/*- End of function --------------------------------------------------------*/
+
 int adsi_tx(adsi_tx_state_t *s, int16_t *amp, int max_len)
 {
     int len;
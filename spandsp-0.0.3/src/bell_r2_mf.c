@@ -47,6 +47,7 @@
 #include "spandsp/dds.h"
 #include "spandsp/tone_detect.h"
 #include "spandsp/tone_generate.h"
+#include "spandsp/tone_analysis.h"
 #include "spandsp/bell_r2_mf.h"
 
 #if !defined(M_PI)
@@ -403,6 +404,128 @@ r2_mf_tx_state_t *r2_mf_tx_init(r2_mf_tx_state_t *s)
 }
 /*- End of function --------------------------------------------------------*/
 
+/* Make the decisions for the end of a detection block. This is shared by the
+   receiver, and by receivers subscribed to a tone analysis engine. */
+static void bell_mf_rx_block_result(bell_mf_rx_state_t *s, const float energy[])
+{
+    int i;
+    int best;
+    int second_best;
+    uint8_t hit;
+
+    /* Find the two highest energies. The spec says to look for
+       two tones and two tones only. Taking this literally -ie
+       only two tones pass the minimum threshold - doesn't work
+       well. The sinc function mess, due to rectangular windowing
+       ensure that! Find the two highest energies and ensure they
+       are considerably stronger than any of the others. */
+    if (energy[0] > energy[1])
+    {
+        best = 0;
+        second_best = 1;
+    }
+    else
+    {
+        best = 1;
+        second_best = 0;
+    }
+    for (i = 2;  i < 6;  i++)
+    {
+        if (energy[i] >= energy[best])
+        {
+            second_best = best;
+            best = i;
+        }
+        else if (energy[i] >= energy[second_best])
+        {
+            second_best = i;
+        }
+    }
+    /* Basic signal level and twist tests */
+    hit = 0;
+    if (energy[best] >= BELL_MF_THRESHOLD
+        &&
+        energy[second_best] >= BELL_MF_THRESHOLD
+        &&
+        energy[best] < energy[second_best]*BELL_MF_TWIST
+        &&
+        energy[best]*BELL_MF_TWIST > energy[second_best])
+    {
+        /* Relative peak test */
+        hit = 'X';
+        for (i = 0;  i < 6;  i++)
+        {
+            if (i != best  &&  i != second_best)
+            {
+                if (energy[i]*BELL_MF_RELATIVE_PEAK >= energy[second_best])
+                {
+                    /* The best two are not clearly the best */
+                    hit = 0;
+                    break;
+                }
+            }
+        }
+    }
+    if (hit)
+    {
+        /* Get the values into ascending order */
+        if (second_best < best)
+        {
+            i = best;
+            best = second_best;
+            second_best = i;
+        }
+        best = best*5 + second_best - 1;
+        hit = bell_mf_positions[best];
+        /* Look for two successive similar results */
+        /* The logic in the next test is:
+           For KP we need 4 successive identical clean detects, with
+           two blocks of something different preceeding it. For anything
+           else we need two successive identical clean detects, with
+           two blocks of something different preceeding it. */
+        if (hit == s->hits[4]
+            &&
+            hit == s->hits[3]
+            &&
+               ((hit != '*'  &&  hit != s->hits[2]  &&  hit != s->hits[1])
+                ||
+                (hit == '*'  &&  hit == s->hits[2]  &&  hit != s->hits[1]  &&  hit != s->hits[0])))
+        {
+            if (s->current_digits < MAX_BELL_MF_DIGITS)
+            {
+                s->digits[s->current_digits++] = (char) hit;
+                s->digits[s->current_digits] = '\0';
+                if (s->callback)
+                {
+                    s->callback(s->callback_data, s->digits, s->current_digits);
+                    s->current_digits = 0;
+                }
+            }
+            else
+            {
+                s->lost_digits++;
+            }
+        }
+    }
+    s->hits[0] = s->hits[1];
+    s->hits[1] = s->hits[2];
+    s->hits[2] = s->hits[3];
+    s->hits[3] = s->hits[4];
+    s->hits[4] = hit;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bell_mf_rx_flush_digits(bell_mf_rx_state_t *s)
+{
+    if (s->current_digits  &&  s->callback)
+    {
+        s->callback(s->callback_data, s->digits, s->current_digits);
+        s->digits[0] = '\0';
+        s->current_digits = 0;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
 int bell_mf_rx(bell_mf_rx_state_t *s, const int16_t amp[], int samples)
 {
     float energy[6];
@@ -411,12 +534,8 @@ int bell_mf_rx(bell_mf_rx_state_t *s, const int16_t amp[], int samples)
     int i;
     int j;
     int sample;
-    int best;
-    int second_best;
     int limit;
-    uint8_t hit;
 
-    hit = 0;
     for (sample = 0;  sample < samples;  sample = limit)
     {
         if ((samples - sample) >= (120 - s->current_sample))
@@ -458,119 +577,15 @@ int bell_mf_rx(bell_mf_rx_state_t *s, const int16_t amp[], int samples)
             continue;
 
         /* We are at the end of an MF detection block */
-        /* Find the two highest energies. The spec says to look for
-           two tones and two tones only. Taking this literally -ie
-           only two tones pass the minimum threshold - doesn't work
-           well. The sinc function mess, due to rectangular windowing
-           ensure that! Find the two highest energies and ensure they
-           are considerably stronger than any of the others. */
-        energy[0] = goertzel_result(&s->out[0]);
-        energy[1] = goertzel_result(&s->out[1]);
-        if (energy[0] > energy[1])
-        {
-            best = 0;
-            second_best = 1;
-        }
-        else
-        {
-            best = 1;
-            second_best = 0;
-        }
-        for (i = 2;  i < 6;  i++)
-        {
+        for (i = 0;  i < 6;  i++)
             energy[i] = goertzel_result(&s->out[i]);
-            if (energy[i] >= energy[best])
-            {
-                second_best = best;
-                best = i;
-            }
-            else if (energy[i] >= energy[second_best])
-            {
-                second_best = i;
-            }
-        }
-        /* Basic signal level and twist tests */
-        hit = 0;
-        if (energy[best] >= BELL_MF_THRESHOLD
-            &&
-            energy[second_best] >= BELL_MF_THRESHOLD
-            &&
-            energy[best] < energy[second_best]*BELL_MF_TWIST
-            &&
-            energy[best]*BELL_MF_TWIST > energy[second_best])
-        {
-            /* Relative peak test */
-            hit = 'X';
-            for (i = 0;  i < 6;  i++)
-            {
-                if (i != best  &&  i != second_best)
-                {
-                    if (energy[i]*BELL_MF_RELATIVE_PEAK >= energy[second_best])
-                    {
-                        /* The best two are not clearly the best */
-                        hit = 0;
-                        break;
-                    }
-                }
-            }
-        }
-        if (hit)
-        {
-            /* Get the values into ascending order */
-            if (second_best < best)
-            {
-                i = best;
-                best = second_best;
-                second_best = i;
-            }
-            best = best*5 + second_best - 1;
-            hit = bell_mf_positions[best];
-            /* Look for two successive similar results */
-            /* The logic in the next test is:
-               For KP we need 4 successive identical clean detects, with
-               two blocks of something different preceeding it. For anything
-               else we need two successive identical clean detects, with
-               two blocks of something different preceeding it. */
-            if (hit == s->hits[4]
-                &&
-                hit == s->hits[3]
-                &&
-                   ((hit != '*'  &&  hit != s->hits[2]  &&  hit != s->hits[1])
-                    ||
-                    (hit == '*'  &&  hit == s->hits[2]  &&  hit != s->hits[1]  &&  hit != s->hits[0])))
-            {
-                if (s->current_digits < MAX_BELL_MF_DIGITS)
-                {
-                    s->digits[s->current_digits++] = (char) hit;
-                    s->digits[s->current_digits] = '\0';
-                    if (s->callback)
-                    {
-                        s->callback(s->callback_data, s->digits, s->current_digits);
-                        s->current_digits = 0;
-                    }
-                }
-                else
-                {
-                    s->lost_digits++;
-                }
-            }
-        }
-        s->hits[0] = s->hits[1];
-        s->hits[1] = s->hits[2];
-        s->hits[2] = s->hits[3];
-        s->hits[3] = s->hits[4];
-        s->hits[4] = hit;
+        bell_mf_rx_block_result(s, energy);
         /* Reinitialise the detector for the next block */
         for (i = 0;  i < 6;  i++)
             goertzel_reset(&s->out[i]);
         s->current_sample = 0;
     }
-    if (s->current_digits  &&  s->callback)
-    {
-        s->callback(s->callback_data, s->digits, s->current_digits);
-        s->digits[0] = '\0';
-        s->current_digits = 0;
-    }
+    bell_mf_rx_flush_digits(s);
     return 0;
 }
 /*- End of function --------------------------------------------------------*/
@@ -622,6 +637,29 @@ bell_mf_rx_state_t *bell_mf_rx_init(bell_mf_rx_state_t *s,
 }
 /*- End of function --------------------------------------------------------*/
 
+static void bell_mf_rx_analysis_report(void *user_data, const float energies[], float energy)
+{
+    bell_mf_rx_state_t *s;
+
+    s = (bell_mf_rx_state_t *) user_data;
+    bell_mf_rx_block_result(s, energies);
+    bell_mf_rx_flush_digits(s);
+}
+/*- End of function --------------------------------------------------------*/
+
+int bell_mf_rx_subscribe(bell_mf_rx_state_t *s, tone_analysis_state_t *t)
+{
+    int i;
+
+    if ((i = tone_analysis_subscribe(t, bell_mf_detect_desc, 6, bell_mf_rx_analysis_report, s)) < 0)
+        return -1;
+    /* A block below this cannot pass the signal level test, as a Goertzel result
+       can never exceed the block length times the block energy. */
+    tone_analysis_set_gate(t, i, 0.9f*BELL_MF_THRESHOLD/120.0f);
+    return i;
+}
+/*- End of function --------------------------------------------------------*/
+
 int r2_mf_rx(r2_mf_rx_state_t *s, const int16_t amp[], int samples)
 {
     float energy[6];
@@ -43,10 +43,16 @@
 #include <stdio.h>
 #include <time.h>
 #include <fcntl.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/tone_detect.h"
 #include "spandsp/tone_generate.h"
+#include "spandsp/tone_analysis.h"
 #include "spandsp/dtmf.h"
 
 #if !defined(M_PI)
@@ -82,6 +88,8 @@ static const char dtmf_positions[] = "123A" "456B" "789C" "*0#D";
 
 static goertzel_descriptor_t dtmf_detect_row[4];
 static goertzel_descriptor_t dtmf_detect_col[4];
+static sliding_dft_descriptor_t dtmf_sliding_row[4];
+static sliding_dft_descriptor_t dtmf_sliding_col[4];
 
 static int dtmf_tx_inited = FALSE;
 static tone_gen_descriptor_t dtmf_digit_tones[16];
@@ -171,6 +179,288 @@ static __inline__ void _dtmf_goertzel_update(goertzel_state_t *s,
 #endif
 /*- End of function --------------------------------------------------------*/
 
+/* Apply the signal level, twist, relative peak and fraction of total energy
+   tests to a set of filter energies. This is shared by the block and sliding
+   DFT modes. */
+static uint8_t dtmf_rx_hit(dtmf_rx_state_t *s,
+                           const float row_energy[],
+                           const float col_energy[],
+                           float energy,
+                           float *tone_energy)
+{
+    int i;
+    int best_row;
+    int best_col;
+    uint8_t hit;
+
+    /* Find the peak row and the peak column */
+    best_row = 0;
+    best_col = 0;
+    for (i = 1;  i < 4;  i++)
+    {
+        if (row_energy[i] > row_energy[best_row])
+            best_row = i;
+        if (col_energy[i] > col_energy[best_col])
+            best_col = i;
+    }
+    hit = 0;
+    /* Basic signal level test and the twist test */
+    if (row_energy[best_row] >= DTMF_THRESHOLD
+        &&
+        col_energy[best_col] >= DTMF_THRESHOLD
+        &&
+        col_energy[best_col] < row_energy[best_row]*s->reverse_twist
+        &&
+        col_energy[best_col]*s->normal_twist > row_energy[best_row])
+    {
+        /* Relative peak test ... */
+        for (i = 0;  i < 4;  i++)
+        {
+            if ((i != best_col  &&  col_energy[i]*DTMF_RELATIVE_PEAK_COL > col_energy[best_col])
+                ||
+                (i != best_row  &&  row_energy[i]*DTMF_RELATIVE_PEAK_ROW > row_energy[best_row]))
+            {
+                break;
+            }
+        }
+        /* ... and fraction of total energy test */
+        if (i >= 4
+            &&
+            (row_energy[best_row] + col_energy[best_col]) > DTMF_TO_TOTAL_ENERGY*energy)
+        {
+            hit = dtmf_positions[(best_row << 2) + best_col];
+        }
+    }
+    if (tone_energy)
+        *tone_energy = row_energy[best_row] + col_energy[best_col];
+    return hit;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Report a change of confirmed digit */
+static void dtmf_rx_report_digit(dtmf_rx_state_t *s, uint8_t hit)
+{
+    if (s->realtime_callback)
+    {
+        /* Avoid reporting multiple no digit conditions on flaky hits */
+        if (s->in_digit  ||  hit)
+            s->realtime_callback(s->realtime_callback_data, hit);
+    }
+    else
+    {
+        if (hit)
+        {
+            if (s->current_digits < MAX_DTMF_DIGITS)
+            {
+                s->digits[s->current_digits++] = (char) hit;
+                s->digits[s->current_digits] = '\0';
+                if (s->callback)
+                {
+                    s->callback(s->callback_data, s->digits, s->current_digits);
+                    s->current_digits = 0;
+                }
+            }
+            else
+            {
+                s->lost_digits++;
+            }
+        }
+    }
+    s->in_digit = hit;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Make the decisions for the end of a detection block. This is shared by the
+   single channel receiver and the receiver bank. */
+static void dtmf_rx_block_result(dtmf_rx_state_t *s,
+                                 const float row_energy[],
+                                 const float col_energy[],
+                                 float energy)
+{
+    uint8_t hit;
+
+    hit = dtmf_rx_hit(s, row_energy, col_energy, energy, NULL);
+    /* The logic in the next test should ensure the following for different successive hit patterns:
+            -----ABB = start of digit B.
+            ----B-BB = start of digit B
+            ----A-BB = start of digit B
+            BBBBBABB = still in digit B.
+            BBBBBB-- = end of digit B
+            BBBBBBC- = end of digit B
+            BBBBACBB = B ends, then B starts again.
+            BBBBBBCC = B ends, then C starts.
+            BBBBBCDD = B ends, then D starts.
+       This can work with:
+            - Back to back differing digits. Back-to-back digits should
+              not happen. The spec. says there should be a gap between digits.
+              However, many real phones do not impose a gap, and rolling across
+              the keypad can produce little or no gap.
+            - It tolerates nasty phones that give a very wobbly start to a digit.
+            - VoIP can give sample slips. The phase jumps that produces will cause
+              the block it is in to give no detection. This logic will ride over a
+              single missed block, and not falsely declare a second digit. If the
+              hiccup happens in the wrong place on a minimum length digit, however
+              we would still fail to detect that digit. Could anything be done to
+              deal with that? Packet loss is clearly a no-go zone.
+              Note this is only relevant to VoIP using A-law, u-law or similar.
+              Low bit rate codecs scramble DTMF too much for it to be recognised,
+              and often slip in units larger than a sample. */
+    if (hit != s->in_digit)
+    {
+        if (s->last_hit != s->in_digit)
+        {
+            /* We have two successive indications that something has changed. */
+            /* To declare digit on, the hits must agree. Otherwise we declare tone off. */
+            hit = (hit  &&  hit == s->last_hit)  ?  hit   :  0;
+            dtmf_rx_report_digit(s, hit);
+        }
+    }
+    s->last_hit = hit;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void dtmf_rx_flush_digits(dtmf_rx_state_t *s)
+{
+    if (s->current_digits  &&  s->callback)
+    {
+        s->callback(s->callback_data, s->digits, s->current_digits);
+        s->digits[0] = '\0';
+        s->current_digits = 0;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ float dtmf_rx_dialtone_filter(dtmf_rx_state_t *s, float famp)
+{
+    float v1;
+
+    /* Sharp notches applied at 350Hz and 440Hz - the two common dialtone frequencies.
+       These are rather high Q, to achieve the required narrowness, without using lots of
+       sections. */
+    v1 = 0.98356f*famp + 1.8954426f*s->z350_1 - 0.9691396f*s->z350_2;
+    famp = v1 - 1.9251480f*s->z350_1 + s->z350_2;
+    s->z350_2 = s->z350_1;
+    s->z350_1 = v1;
+
+    v1 = 0.98456f*famp + 1.8529543f*s->z440_1 - 0.9691396f*s->z440_2;
+    famp = v1 - 1.8819938f*s->z440_1 + s->z440_2;
+    s->z440_2 = s->z440_1;
+    s->z440_1 = v1;
+    return famp;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Forget the digit the sliding DFT decisions were building evidence for, so the
+   next digit, even a repeat of the same one, starts from nothing. */
+static void dtmf_rx_sliding_clear_candidate(dtmf_rx_state_t *s)
+{
+    s->candidate = 0;
+    s->candidate_hits = 0;
+    s->candidate_misses = 0;
+    s->candidate_start = 0;
+    s->candidate_onset = 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Make the decisions for the sliding DFT mode, after each decision interval */
+static void dtmf_rx_sliding_result(dtmf_rx_state_t *s, uint8_t hit, float tone_energy, float energy)
+{
+    float len;
+
+    if (hit)
+    {
+        if (hit != s->candidate)
+        {
+            /* The tests have just started to pass this digit. A tone pair which
+               fills len samples of the window has tone energies totalling about
+               len/2 times the energy in the window, which tells us roughly where
+               in the window the digit started. */
+            len = (energy > 0.0f)  ?  2.0f*tone_energy/energy  :  (float) DTMF_BLOCK_LEN;
+            if (len > (float) DTMF_BLOCK_LEN)
+                len = (float) DTMF_BLOCK_LEN;
+            s->candidate = hit;
+            s->candidate_start = s->sample_count;
+            s->candidate_onset = s->sample_count - (uint32_t) (len + 0.5f);
+            s->candidate_hits = 0;
+            s->candidate_misses = 0;
+        }
+        s->candidate_hits++;
+        if (hit == s->in_digit)
+        {
+            s->digit_last_seen = s->sample_count;
+        }
+        else if (s->sample_count - s->candidate_start >= DTMF_BLOCK_LEN
+                 &&
+                 s->candidate_hits > 2*s->candidate_misses)
+        {
+            /* Windows at least a block length apart, so not sharing any audio,
+               have passed the tests for this digit, as have most of the windows
+               in between. This is at least as well proven as a digit from two
+               agreeing blocks. */
+            s->onset = s->candidate_onset;
+            s->digit_last_seen = s->sample_count;
+            dtmf_rx_report_digit(s, hit);
+            dtmf_rx_sliding_clear_candidate(s);
+        }
+    }
+    else if (s->candidate)
+    {
+        /* Ride over the odd miss, as a slightly off frequency tone can fail the
+           tests in some window positions. */
+        if (++s->candidate_misses > s->candidate_hits)
+            s->candidate = 0;
+    }
+    if (s->in_digit  &&  s->sample_count - s->digit_last_seen >= DTMF_BLOCK_LEN)
+    {
+        dtmf_rx_report_digit(s, 0);
+        dtmf_rx_sliding_clear_candidate(s);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int dtmf_rx_sliding(dtmf_rx_state_t *s, const int16_t amp[], int samples)
+{
+    float row_energy[4];
+    float col_energy[4];
+    float tone_energy;
+    float famp;
+    float out;
+    uint8_t hit;
+    int i;
+    int j;
+
+    for (j = 0;  j < samples;  j++)
+    {
+        famp = amp[j];
+        if (s->filter_dialtone)
+            famp = dtmf_rx_dialtone_filter(s, famp);
+        out = s->window[s->window_ptr];
+        s->window[s->window_ptr] = famp;
+        if (++s->window_ptr >= DTMF_BLOCK_LEN)
+            s->window_ptr = 0;
+        s->window_energy += (double) famp*famp - (double) out*out;
+        for (i = 0;  i < 4;  i++)
+        {
+            sliding_dft_update(&s->row_sdft[i], famp, out);
+            sliding_dft_update(&s->col_sdft[i], famp, out);
+        }
+        s->sample_count++;
+        if (++s->current_sample < s->sliding_hop)
+            continue;
+        s->current_sample = 0;
+        for (i = 0;  i < 4;  i++)
+        {
+            row_energy[i] = sliding_dft_result(&s->row_sdft[i]);
+            col_energy[i] = sliding_dft_result(&s->col_sdft[i]);
+        }
+        hit = dtmf_rx_hit(s, row_energy, col_energy, (float) s->window_energy, &tone_energy);
+        dtmf_rx_sliding_result(s, hit, tone_energy, (float) s->window_energy);
+    }
+    dtmf_rx_flush_digits(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
 int dtmf_rx(dtmf_rx_state_t *s, const int16_t amp[], int samples)
 {
     float row_energy[4];
@@ -180,12 +470,10 @@ int dtmf_rx(dtmf_rx_state_t *s, const int16_t amp[], int samples)
     int i;
     int j;
     int sample;
-    int best_row;
-    int best_col;
     int limit;
-    uint8_t hit;
 
-    hit = 0;
+    if (s->sliding_hop)
+        return dtmf_rx_sliding(s, amp, samples);
     for (sample = 0;  sample < samples;  sample = limit)
     {
         /* The block length is optimised to meet the DTMF specs. */
@@ -203,20 +491,7 @@ int dtmf_rx(dtmf_rx_state_t *s, const int16_t amp[], int samples)
         {
             famp = amp[j];
             if (s->filter_dialtone)
-            {
-                /* Sharp notches applied at 350Hz and 440Hz - the two common dialtone frequencies.
-                   These are rather high Q, to achieve the required narrowness, without using lots of
-                   sections. */
-                v1 = 0.98356f*famp + 1.8954426f*s->z350_1 - 0.9691396f*s->z350_2;
-                famp = v1 - 1.9251480f*s->z350_1 + s->z350_2;
-                s->z350_2 = s->z350_1;
-                s->z350_1 = v1;
-
-                v1 = 0.98456f*famp + 1.8529543f*s->z440_1 - 0.9691396f*s->z440_2;
-                famp = v1 - 1.8819938f*s->z440_1 + s->z440_2;
-                s->z440_2 = s->z440_1;
-                s->z440_1 = v1;
-            }
+                famp = dtmf_rx_dialtone_filter(s, famp);
             s->energy += famp*famp;
             /* With GCC 2.95, the following unrolled code seems to take about 35%
                (rough estimate) as long as a neat little 0-3 loop */
@@ -258,111 +533,12 @@ int dtmf_rx(dtmf_rx_state_t *s, const int16_t amp[], int samples)
             continue;
 
         /* We are at the end of a DTMF detection block */
-        /* Find the peak row and the peak column */
-        row_energy[0] = goertzel_result(&s->row_out[0]);
-        best_row = 0;
-        col_energy[0] = goertzel_result(&s->col_out[0]);
-        best_col = 0;
-
-        for (i = 1;  i < 4;  i++)
+        for (i = 0;  i < 4;  i++)
         {
             row_energy[i] = goertzel_result(&s->row_out[i]);
-            if (row_energy[i] > row_energy[best_row])
-                best_row = i;
             col_energy[i] = goertzel_result(&s->col_out[i]);
-            if (col_energy[i] > col_energy[best_col])
-                best_col = i;
         }
-        hit = 0;
-        /* Basic signal level test and the twist test */
-        if (row_energy[best_row] >= DTMF_THRESHOLD
-            &&
-            col_energy[best_col] >= DTMF_THRESHOLD
-            &&
-            col_energy[best_col] < row_energy[best_row]*s->reverse_twist
-            &&
-            col_energy[best_col]*s->normal_twist > row_energy[best_row])
-        {
-            /* Relative peak test ... */
-            for (i = 0;  i < 4;  i++)
-            {
-                if ((i != best_col  &&  col_energy[i]*DTMF_RELATIVE_PEAK_COL > col_energy[best_col])
-                    ||
-                    (i != best_row  &&  row_energy[i]*DTMF_RELATIVE_PEAK_ROW > row_energy[best_row]))
-                {
-                    break;
-                }
-            }
-            /* ... and fraction of total energy test */
-            if (i >= 4
-                &&
-                (row_energy[best_row] + col_energy[best_col]) > DTMF_TO_TOTAL_ENERGY*s->energy)
-            {
-                hit = dtmf_positions[(best_row << 2) + best_col];
-            }
-        }
-        /* The logic in the next test should ensure the following for different successive hit patterns:
-                -----ABB = start of digit B.
-                ----B-BB = start of digit B
-                ----A-BB = start of digit B
-                BBBBBABB = still in digit B.
-                BBBBBB-- = end of digit B
-                BBBBBBC- = end of digit B
-                BBBBACBB = B ends, then B starts again.
-                BBBBBBCC = B ends, then C starts.
-                BBBBBCDD = B ends, then D starts.
-           This can work with:
-                - Back to back differing digits. Back-to-back digits should
-                  not happen. The spec. says there should be a gap between digits.
-                  However, many real phones do not impose a gap, and rolling across
-                  the keypad can produce little or no gap.
-                - It tolerates nasty phones that give a very wobbly start to a digit.
-                - VoIP can give sample slips. The phase jumps that produces will cause
-                  the block it is in to give no detection. This logic will ride over a
-                  single missed block, and not falsely declare a second digit. If the
-                  hiccup happens in the wrong place on a minimum length digit, however
-                  we would still fail to detect that digit. Could anything be done to
-                  deal with that? Packet loss is clearly a no-go zone.
-                  Note this is only relevant to VoIP using A-law, u-law or similar.
-                  Low bit rate codecs scramble DTMF too much for it to be recognised,
-                  and often slip in units larger than a sample. */
-        if (hit != s->in_digit)
-        {
-            if (s->last_hit != s->in_digit)
-            {
-                /* We have two successive indications that something has changed. */
-                /* To declare digit on, the hits must agree. Otherwise we declare tone off. */
-                hit = (hit  &&  hit == s->last_hit)  ?  hit   :  0;
-                if (s->realtime_callback)
-                {
-                    /* Avoid reporting multiple no digit conditions on flaky hits */
-                    if (s->in_digit  ||  hit)
-                        s->realtime_callback(s->realtime_callback_data, hit);
-                }
-                else
-                {
-                    if (hit)
-                    {
-                        if (s->current_digits < MAX_DTMF_DIGITS)
-                        {
-                            s->digits[s->current_digits++] = (char) hit;
-                            s->digits[s->current_digits] = '\0';
-                            if (s->callback)
-                            {
-                                s->callback(s->callback_data, s->digits, s->current_digits);
-                                s->current_digits = 0;
-                            }
-                        }
-                        else
-                        {
-                            s->lost_digits++;
-                        }
-                    }
-                }
-                s->in_digit = hit;
-            }
-        }
-        s->last_hit = hit;
+        dtmf_rx_block_result(s, row_energy, col_energy, s->energy);
         /* Reinitialise the detector for the next block */
         for (i = 0;  i < 4;  i++)
         {
@@ -372,12 +548,7 @@ int dtmf_rx(dtmf_rx_state_t *s, const int16_t amp[], int samples)
         s->energy = 0.0;
         s->current_sample = 0;
     }
-    if (s->current_digits  &&  s->callback)
-    {
-        s->callback(s->callback_data, s->digits, s->current_digits);
-        s->digits[0] = '\0';
-        s->current_digits = 0;
-    }
+    dtmf_rx_flush_digits(s);
     return 0;
 }
 /*- End of function --------------------------------------------------------*/
@@ -450,6 +621,8 @@ dtmf_rx_state_t *dtmf_rx_init(dtmf_rx_state_t *s,
         {
             make_goertzel_descriptor(&dtmf_detect_row[i], dtmf_row[i], 102);
             make_goertzel_descriptor(&dtmf_detect_col[i], dtmf_col[i], 102);
+            make_sliding_dft_descriptor(&dtmf_sliding_row[i], dtmf_row[i], DTMF_BLOCK_LEN);
+            make_sliding_dft_descriptor(&dtmf_sliding_col[i], dtmf_col[i], DTMF_BLOCK_LEN);
         }
         initialised = TRUE;
     }
@@ -460,6 +633,7 @@ dtmf_rx_state_t *dtmf_rx_init(dtmf_rx_state_t *s,
     }
     s->energy = 0.0;
     s->current_sample = 0;
+    s->sliding_hop = 0;
     s->lost_digits = 0;
     s->current_digits = 0;
     s->digits[0] = '\0';
@@ -467,6 +641,392 @@ dtmf_rx_state_t *dtmf_rx_init(dtmf_rx_state_t *s,
 }
 /*- End of function --------------------------------------------------------*/
 
+int dtmf_rx_set_sliding(dtmf_rx_state_t *s, int hop)
+{
+    int i;
+
+    if (hop < 0  ||  hop > DTMF_BLOCK_LEN)
+        return -1;
+    /* Restart the detection in the selected mode */
+    for (i = 0;  i < 4;  i++)
+    {
+        goertzel_reset(&s->row_out[i]);
+        goertzel_reset(&s->col_out[i]);
+        sliding_dft_init(&s->row_sdft[i], &dtmf_sliding_row[i]);
+        sliding_dft_init(&s->col_sdft[i], &dtmf_sliding_col[i]);
+    }
+    memset(s->window, 0, sizeof(s->window));
+    s->window_ptr = 0;
+    s->window_energy = 0.0;
+    s->energy = 0.0;
+    s->current_sample = 0;
+    dtmf_rx_sliding_clear_candidate(s);
+    s->digit_last_seen = 0;
+    s->onset = 0;
+    s->sample_count = 0;
+    s->sliding_hop = hop;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+uint32_t dtmf_rx_onset(dtmf_rx_state_t *s)
+{
+    return s->onset;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void dtmf_rx_analysis_report(void *user_data, const float energies[], float energy)
+{
+    dtmf_rx_state_t *s;
+
+    s = (dtmf_rx_state_t *) user_data;
+    dtmf_rx_block_result(s, energies, energies + 4, energy);
+    dtmf_rx_flush_digits(s);
+}
+/*- End of function --------------------------------------------------------*/
+
+int dtmf_rx_subscribe(dtmf_rx_state_t *s, tone_analysis_state_t *t)
+{
+    goertzel_descriptor_t desc[8];
+    int i;
+
+    /* The engine shares the raw audio between its subscribers, so there is
+       nowhere to put this receiver's dial tone filter */
+    if (s->filter_dialtone)
+        return -1;
+    for (i = 0;  i < 4;  i++)
+    {
+        desc[i] = dtmf_detect_row[i];
+        desc[i + 4] = dtmf_detect_col[i];
+    }
+    if ((i = tone_analysis_subscribe(t, desc, 8, dtmf_rx_analysis_report, s)) < 0)
+        return -1;
+    /* A Goertzel result can never exceed the block length times the block
+       energy, so a block below this cannot pass the signal level test. A little
+       is allowed for rounding. */
+    tone_analysis_set_gate(t, i, 0.9f*DTMF_THRESHOLD/102.0f);
+    return i;
+}
+/*- End of function --------------------------------------------------------*/
+
+/*
+ * The bank functions run a number of DTMF receivers in lockstep, with common
+ * block timing. The audio for each block is interleaved across the channels,
+ * and then each vector of channels is run through the dial tone filter and the
+ * Goertzel filters for the whole block, with the filter states held in
+ * registers. The arithmetic is exactly that of dtmf_rx(), so the energies, and
+ * therefore the digits, are the same. Only the decisions at the end of each
+ * block are made one channel at a time.
+ */
+#define DTMF_RX_BANK_NUM_ARRAYS     (2*8 + 5)
+
+#if defined(__AVX512F__)
+#define DTMF_RX_BANK_LANES  16
+typedef __m512 dtmf_vec_t;
+#define vload(p)        _mm512_loadu_ps(p)
+#define vstore(p, x)    _mm512_storeu_ps(p, x)
+#define vset1           _mm512_set1_ps
+#define vadd            _mm512_add_ps
+#define vsub            _mm512_sub_ps
+#define vmul            _mm512_mul_ps
+#elif defined(__AVX2__)
+#define DTMF_RX_BANK_LANES  8
+typedef __m256 dtmf_vec_t;
+#define vload(p)        _mm256_loadu_ps(p)
+#define vstore(p, x)    _mm256_storeu_ps(p, x)
+#define vset1           _mm256_set1_ps
+#define vadd            _mm256_add_ps
+#define vsub            _mm256_sub_ps
+#define vmul            _mm256_mul_ps
+#elif defined(__SSE2__)
+#define DTMF_RX_BANK_LANES  4
+typedef __m128 dtmf_vec_t;
+#define vload(p)        _mm_loadu_ps(p)
+#define vstore(p, x)    _mm_storeu_ps(p, x)
+#define vset1           _mm_set1_ps
+#define vadd            _mm_add_ps
+#define vsub            _mm_sub_ps
+#define vmul            _mm_mul_ps
+#else
+#define DTMF_RX_BANK_LANES  1
+typedef float dtmf_vec_t;
+#define vload(p)        (*(p))
+#define vstore(p, x)    (*(p) = (x))
+#define vset1(x)        (x)
+#define vadd(a, b)      ((a) + (b))
+#define vsub(a, b)      ((a) - (b))
+#define vmul(a, b)      ((a)*(b))
+#endif
+
+static void bank_filter_block(dtmf_rx_bank_state_t *s, int len)
+{
+    dtmf_vec_t v1;
+    dtmf_vec_t v2[8];
+    dtmf_vec_t v3[8];
+    dtmf_vec_t fac[8];
+    dtmf_vec_t famp;
+    dtmf_vec_t energy;
+    dtmf_vec_t z350_1;
+    dtmf_vec_t z350_2;
+    dtmf_vec_t z440_1;
+    dtmf_vec_t z440_2;
+    const float *x;
+    int c;
+    int i;
+    int j;
+
+    for (i = 0;  i < 8;  i++)
+        fac[i] = vset1(s->fac[i]);
+    for (c = 0;  c < s->stride;  c += DTMF_RX_BANK_LANES)
+    {
+        for (i = 0;  i < 8;  i++)
+        {
+            v2[i] = vload(&s->v2[i][c]);
+            v3[i] = vload(&s->v3[i][c]);
+        }
+        energy = vload(&s->energy[c]);
+        x = &s->famp[c];
+        if (s->filter_dialtone)
+        {
+            z350_1 = vload(&s->z350_1[c]);
+            z350_2 = vload(&s->z350_2[c]);
+            z440_1 = vload(&s->z440_1[c]);
+            z440_2 = vload(&s->z440_2[c]);
+            for (j = 0;  j < len;  j++, x += s->stride)
+            {
+                famp = vload(x);
+                v1 = vsub(vadd(vmul(vset1(0.98356f), famp), vmul(vset1(1.8954426f), z350_1)), vmul(vset1(0.9691396f), z350_2));
+                famp = vadd(vsub(v1, vmul(vset1(1.9251480f), z350_1)), z350_2);
+                z350_2 = z350_1;
+                z350_1 = v1;
+
+                v1 = vsub(vadd(vmul(vset1(0.98456f), famp), vmul(vset1(1.8529543f), z440_1)), vmul(vset1(0.9691396f), z440_2));
+                famp = vadd(vsub(v1, vmul(vset1(1.8819938f), z440_1)), z440_2);
+                z440_2 = z440_1;
+                z440_1 = v1;
+
+                energy = vadd(energy, vmul(famp, famp));
+                for (i = 0;  i < 8;  i++)
+                {
+                    v1 = v2[i];
+                    v2[i] = v3[i];
+                    v3[i] = vadd(vsub(vmul(fac[i], v2[i]), v1), famp);
+                }
+            }
+            vstore(&s->z350_1[c], z350_1);
+            vstore(&s->z350_2[c], z350_2);
+            vstore(&s->z440_1[c], z440_1);
+            vstore(&s->z440_2[c], z440_2);
+        }
+        else
+        {
+            for (j = 0;  j < len;  j++, x += s->stride)
+            {
+                famp = vload(x);
+                energy = vadd(energy, vmul(famp, famp));
+                for (i = 0;  i < 8;  i++)
+                {
+                    v1 = v2[i];
+                    v2[i] = v3[i];
+                    v3[i] = vadd(vsub(vmul(fac[i], v2[i]), v1), famp);
+                }
+            }
+        }
+        for (i = 0;  i < 8;  i++)
+        {
+            vstore(&s->v2[i][c], v2[i]);
+            vstore(&s->v3[i][c], v3[i]);
+        }
+        vstore(&s->energy[c], energy);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static float bank_goertzel_result(dtmf_rx_bank_state_t *s, int i, int c)
+{
+    goertzel_state_t g;
+
+    g.v2 = s->v2[i][c];
+    g.v3 = s->v3[i][c];
+    g.fac = s->fac[i];
+    return goertzel_result(&g);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_init_channel(dtmf_rx_bank_state_t *s, int c)
+{
+    int i;
+
+    for (i = 0;  i < 8;  i++)
+    {
+        s->v2[i][c] = 0.0f;
+        s->v3[i][c] = 0.0f;
+    }
+    s->energy[c] = 0.0f;
+    s->z350_1[c] = 0.0f;
+    s->z350_2[c] = 0.0f;
+    s->z440_1[c] = 0.0f;
+    s->z440_2[c] = 0.0f;
+}
+/*- End of function --------------------------------------------------------*/
+
+dtmf_rx_bank_state_t *dtmf_rx_bank_init(dtmf_rx_bank_state_t *s,
+                                        int channels,
+                                        void (*callback)(void *user_data, const char *digits, int len),
+                                        void *user_data[])
+{
+    float *x;
+    int i;
+
+    if (channels <= 0)
+        return NULL;
+    if (s == NULL)
+    {
+        if ((s = (dtmf_rx_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+    }
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    /* Round up to whole vectors, so the filters never need a scalar tail */
+    s->stride = (channels + DTMF_RX_BANK_LANES - 1) & ~(DTMF_RX_BANK_LANES - 1);
+    if ((x = (float *) malloc((DTMF_RX_BANK_NUM_ARRAYS + 102)*s->stride*sizeof(float))) == NULL)
+        return NULL;
+    /* The padding lanes are zeroed too, so the vector code only ever sees
+       sane values. */
+    memset(x, 0, (DTMF_RX_BANK_NUM_ARRAYS + 102)*s->stride*sizeof(float));
+    if ((s->chan = (dtmf_rx_state_t *) malloc(channels*sizeof(dtmf_rx_state_t))) == NULL)
+    {
+        free(x);
+        return NULL;
+    }
+    /* The Goertzel states and the energy must be kept together, as they are
+       cleared as one at the end of each block. */
+    for (i = 0;  i < 8;  i++)
+    {
+        s->v2[i] = x;
+        s->v3[i] = (x += s->stride);
+        x += s->stride;
+    }
+    s->energy = x;
+    s->z350_1 = (x += s->stride);
+    s->z350_2 = (x += s->stride);
+    s->z440_1 = (x += s->stride);
+    s->z440_2 = (x += s->stride);
+    s->famp = (x += s->stride);
+
+    for (i = 0;  i < channels;  i++)
+        dtmf_rx_init(&s->chan[i], callback, (user_data)  ?  user_data[i]  :  NULL);
+    for (i = 0;  i < 4;  i++)
+    {
+        s->fac[i] = dtmf_detect_row[i].fac;
+        s->fac[i + 4] = dtmf_detect_col[i].fac;
+    }
+    s->filter_dialtone = FALSE;
+    s->current_sample = 0;
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int dtmf_rx_bank_release(dtmf_rx_bank_state_t *s)
+{
+    free(s->v2[0]);
+    free(s->chan);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int dtmf_rx_bank_reset_channel(dtmf_rx_bank_state_t *s, int chan)
+{
+    dtmf_rx_state_t *t;
+
+    if (chan < 0  ||  chan >= s->channels)
+        return -1;
+    bank_init_channel(s, chan);
+    t = &s->chan[chan];
+    t->in_digit = 0;
+    t->last_hit = 0;
+    t->lost_digits = 0;
+    t->current_digits = 0;
+    t->digits[0] = '\0';
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+dtmf_rx_state_t *dtmf_rx_bank_channel(dtmf_rx_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return NULL;
+    return &s->chan[chan];
+}
+/*- End of function --------------------------------------------------------*/
+
+void dtmf_rx_bank_parms(dtmf_rx_bank_state_t *s,
+                        int filter_dialtone,
+                        int twist,
+                        int reverse_twist)
+{
+    int i;
+
+    if (filter_dialtone >= 0)
+    {
+        memset(s->z350_1, 0, 4*s->stride*sizeof(float));
+        s->filter_dialtone = filter_dialtone;
+    }
+    for (i = 0;  i < s->channels;  i++)
+        dtmf_rx_parms(&s->chan[i], -1, twist, reverse_twist);
+}
+/*- End of function --------------------------------------------------------*/
+
+int dtmf_rx_bank(dtmf_rx_bank_state_t *s, const int16_t *amp[], int samples)
+{
+    float row_energy[4];
+    float col_energy[4];
+    float *x;
+    int i;
+    int j;
+    int c;
+    int sample;
+    int limit;
+
+    for (sample = 0;  sample < samples;  sample = limit)
+    {
+        if ((samples - sample) >= (102 - s->current_sample))
+            limit = sample + (102 - s->current_sample);
+        else
+            limit = samples;
+        /* Interleave this part of the block across the channels */
+        for (c = 0;  c < s->channels;  c++)
+        {
+            x = &s->famp[c];
+            for (j = sample;  j < limit;  j++, x += s->stride)
+                *x = amp[c][j];
+        }
+        bank_filter_block(s, limit - sample);
+        s->current_sample += (limit - sample);
+        if (s->current_sample < 102)
+            continue;
+
+        /* We are at the end of a DTMF detection block */
+        for (c = 0;  c < s->channels;  c++)
+        {
+            for (i = 0;  i < 4;  i++)
+            {
+                row_energy[i] = bank_goertzel_result(s, i, c);
+                col_energy[i] = bank_goertzel_result(s, i + 4, c);
+            }
+            dtmf_rx_block_result(&s->chan[c], row_energy, col_energy, s->energy[c]);
+        }
+        /* Reinitialise the detectors for the next block */
+        memset(s->v2[0], 0, (2*8 + 1)*s->stride*sizeof(float));
+        s->current_sample = 0;
+    }
+    for (c = 0;  c < s->channels;  c++)
+        dtmf_rx_flush_digits(&s->chan[c]);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
 static void dtmf_tx_initialise(void)
 {
     int row;
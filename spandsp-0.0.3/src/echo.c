@@ -113,14 +113,19 @@
 #include <linux/module.h>     
 #include <linux/kernel.h>
 #include <linux/slab.h>
+#include <asm/system.h>
 #define malloc(a) kmalloc((a), GFP_KERNEL)
 #define free(a) kfree(a)
+#define ec_wmb() smp_wmb()
+#define ec_mb() smp_mb()
 #else
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 
+#define ec_wmb() __sync_synchronize()
+#define ec_mb() __sync_synchronize()
 #endif
 
 #include "spandsp/bit_operations.h"
@@ -136,10 +141,19 @@
 #define TRUE (!FALSE)
 #endif
 
+/* Default tuning, see echo_can_tuning_t */
 #define MIN_TX_POWER_FOR_ADAPTION   64
 #define MIN_RX_POWER_FOR_ADAPTION   64
 #define DTD_HANGOVER               600     /* 600 samples, or 75ms     */
+#define TRANSFER_FG_EIGHTHS          7     /* Lclean_bg < 0.875*Lclean */
+#define TRANSFER_TX_EIGHTHS          1     /* Lclean_bg < 0.125*Ltx    */
+#define TRANSFER_COUNT               6
+#define NLP_RATIO                   16     /* 24dB                     */
+#define BGN_MAX_LEVEL               40
 #define DC_LOG2BETA                  3     /* log2() of DC filter Beta */
+#define TRACE_MAX_LOG2_LEN          16     /* largest trace ring we allow */
+#define SNAPSHOT_INTERVAL           512    /* samples between snapshots, power of 2 */
+#define METER_LOG2TC                10     /* ERL/ERLE averaging, 128ms */
 
 /*-----------------------------------------------------------------------*\
 
@@ -297,9 +311,7 @@ echo_can_state_t *echo_can_create(int len, int adaption_mode)
 
     ec->cng_level = 1000;
     echo_can_adaption_mode(ec, adaption_mode);
-
-    ec->snapshot = (int16_t*)malloc(ec->taps*sizeof(int16_t));
-    memset(ec->snapshot, 0, sizeof(int16_t)*ec->taps);
+    echo_can_default_tuning(&ec->tuning);
 
     ec->cond_met = 0;
     ec->Pstates = 0;
@@ -309,6 +321,7 @@ echo_can_state_t *echo_can_create(int len, int adaption_mode)
     ec->Lbgn = ec->Lbgn_acc = 0;
     ec->Lbgn_upper = 200;
     ec->Lbgn_upper_acc = ec->Lbgn_upper << 13;
+    ec->converge_samples = -1;
 
     return  ec;
 }
@@ -322,7 +335,13 @@ void echo_can_free(echo_can_state_t *ec)
     fir16_free(&ec->fir_state_bg);
     for (i = 0;  i < 2;  i++)
         free(ec->fir_taps16[i]);
-    free(ec->snapshot);
+    if (ec->snapshot)
+        echo_can_snapshot_free(ec->snapshot);
+    if (ec->trace_ring)
+    {
+        free(ec->trace_ring->event);
+        free(ec->trace_ring);
+    }
     free(ec);
 }
 /*- End of function --------------------------------------------------------*/
@@ -333,6 +352,31 @@ void echo_can_adaption_mode(echo_can_state_t *ec, int adaption_mode)
 }
 /*- End of function --------------------------------------------------------*/
 
+void echo_can_default_tuning(echo_can_tuning_t *tuning)
+{
+    tuning->min_tx_power = MIN_TX_POWER_FOR_ADAPTION;
+    tuning->min_rx_power = MIN_RX_POWER_FOR_ADAPTION;
+    tuning->dtd_hangover = DTD_HANGOVER;
+    tuning->transfer_fg_eighths = TRANSFER_FG_EIGHTHS;
+    tuning->transfer_tx_eighths = TRANSFER_TX_EIGHTHS;
+    tuning->transfer_count = TRANSFER_COUNT;
+    tuning->nlp_ratio = NLP_RATIO;
+    tuning->bgn_max_level = BGN_MAX_LEVEL;
+}
+/*- End of function --------------------------------------------------------*/
+
+void echo_can_set_tuning(echo_can_state_t *ec, const echo_can_tuning_t *tuning)
+{
+    ec->tuning = *tuning;
+}
+/*- End of function --------------------------------------------------------*/
+
+void echo_can_get_tuning(echo_can_state_t *ec, echo_can_tuning_t *tuning)
+{
+    *tuning = ec->tuning;
+}
+/*- End of function --------------------------------------------------------*/
+
 void echo_can_flush(echo_can_state_t *ec)
 {
     int i;
@@ -356,11 +400,354 @@ void echo_can_flush(echo_can_state_t *ec)
 
     ec->curr_pos = ec->taps - 1;
     ec->Pstates = 0;
+
+    ec->Ltx_slow = ec->Ltx_slow_acc = 0;
+    ec->Lrx_slow = ec->Lrx_slow_acc = 0;
+    ec->Lclean_slow = ec->Lclean_slow_acc = 0;
+    ec->meter_samples = 0;
+    ec->converged = FALSE;
+    ec->converge_samples = -1;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Coefficient snapshots -------------------------------------------------------*/
+
+/* The taps change every sample while we are adapting, so a reader
+   can't just copy them out without stopping the canceller.  Instead
+   echo_can_update() copies them to the snapshot every
+   SNAPSHOT_INTERVAL samples, bracketed by a sequence count (a seqlock).
+   Readers retry if the count changed, or was odd, while they were
+   copying.  The canceller never waits for anyone. */
+
+echo_can_snapshot_t *echo_can_snapshot_create(int taps)
+{
+    echo_can_snapshot_t *snap;
+
+    if ((snap = (echo_can_snapshot_t *) malloc(sizeof(*snap))) == NULL)
+        return  NULL;
+    if ((snap->coeffs = (int16_t *) malloc(2*taps*sizeof(int16_t))) == NULL)
+    {
+        free(snap);
+        return  NULL;
+    }
+    snap->seq = 0;
+    snap->sample = 0;
+    snap->taps = taps;
+    return  snap;
+}
+/*- End of function --------------------------------------------------------*/
+
+void echo_can_snapshot_free(echo_can_snapshot_t *snap)
+{
+    free(snap->coeffs);
+    free(snap);
+}
+/*- End of function --------------------------------------------------------*/
+
+int echo_can_snapshot_attach(echo_can_state_t *ec, echo_can_snapshot_t *snap)
+{
+    if (ec->snapshot  ||  snap->taps != ec->taps)
+        return  -1;
+    ec_wmb();
+    ec->snapshot = snap;
+    return  0;
+}
+/*- End of function --------------------------------------------------------*/
+
+echo_can_snapshot_t *echo_can_snapshot_detach(echo_can_state_t *ec)
+{
+    echo_can_snapshot_t *snap;
+
+    snap = ec->snapshot;
+    ec->snapshot = NULL;
+    ec_mb();
+    return  snap;
 }
 /*- End of function --------------------------------------------------------*/
 
-void echo_can_snapshot(echo_can_state_t *ec) {
-    memcpy(ec->snapshot, ec->fir_taps16[0], ec->taps*sizeof(int16_t));
+int echo_can_snapshot_read(echo_can_snapshot_t *snap, uint32_t *sample, int16_t fg[], int16_t bg[])
+{
+    uint32_t seq;
+
+    for (;;)
+    {
+        seq = snap->seq;
+        ec_mb();
+        if (seq == 0)
+            return  0;
+        if ((seq & 1) == 0)
+        {
+            memcpy(fg, snap->coeffs, snap->taps*sizeof(int16_t));
+            memcpy(bg, snap->coeffs + snap->taps, snap->taps*sizeof(int16_t));
+            *sample = snap->sample;
+            ec_mb();
+            if (snap->seq == seq)
+                break;
+        }
+    }
+    return  snap->taps;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void snapshot_update(echo_can_state_t *ec, echo_can_snapshot_t *snap)
+{
+    snap->seq++;
+    ec_wmb();
+    memcpy(snap->coeffs, ec->fir_taps16[0], ec->taps*sizeof(int16_t));
+    memcpy(snap->coeffs + ec->taps, ec->fir_taps16[1], ec->taps*sizeof(int16_t));
+    snap->sample = ec->samples;
+    ec_wmb();
+    snap->seq++;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* ERL/ERLE metering ----------------------------------------------------------*/
+
+/* log2(x) in Q8.  top_bit() gives the integer part, and the bits below
+   it a linear estimate of the fraction, which we bend towards the
+   log2() curve with a quadratic correction.  Good to about 0.05dB,
+   which is plenty for monitoring. */
+
+static int log2_q8(int x)
+{
+    int tb;
+    int frac;
+
+    if (x < 1)
+        x = 1;
+    tb = top_bit(x);
+    if (tb >= 8)
+        frac = (x >> (tb - 8)) & 0xFF;
+    else
+        frac = (x << (8 - tb)) & 0xFF;
+    frac += (frac*(256 - frac)*89) >> 16;
+    return (tb << 8) + frac;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* 20log10(num/den) in 0.1dB steps.  20log10(2) = 6.0206dB, so each
+   Q8 log2 step is 60.206/256 of 0.1dB, or about 963/4096. */
+
+static int ratio_db10(int num, int den)
+{
+    return ((log2_q8(num) - log2_q8(den))*963)/4096;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Called every sample from echo_can_update().  We only learn anything
+   about the echo path when the far end is talking and the near end
+   isn't, so the averages are gated on that.  The expensive part (the
+   dB conversion) is left to echo_can_get_stats(). */
+
+static __inline__ void meter_update(echo_can_state_t *ec)
+{
+    if ((ec->Ltx <= MIN_TX_POWER_FOR_ADAPTION) || ec->nonupdate_dwell)
+        return;
+
+    if (ec->meter_samples == 0)
+        ec->meter_start = ec->samples;
+    if (ec->meter_samples != 0xFFFFFFFF)
+        ec->meter_samples++;
+
+    ec->Ltx_slow_acc += ec->Ltx - ec->Ltx_slow;
+    ec->Ltx_slow = (ec->Ltx_slow_acc + (1<<(METER_LOG2TC-1))) >> METER_LOG2TC;
+    ec->Lrx_slow_acc += ec->Lrx - ec->Lrx_slow;
+    ec->Lrx_slow = (ec->Lrx_slow_acc + (1<<(METER_LOG2TC-1))) >> METER_LOG2TC;
+    ec->Lclean_slow_acc += ec->Lclean - ec->Lclean_slow;
+    ec->Lclean_slow = (ec->Lclean_slow_acc + (1<<(METER_LOG2TC-1))) >> METER_LOG2TC;
+
+    /* Wait until the averages have settled before passing judgement */
+    if (ec->meter_samples < (1 << METER_LOG2TC))
+        return;
+
+    /* Converged means the canceller itself has taken at least 18dB out
+       of the echo.  This is judged on the ERLE alone, as a line with a
+       high ERL would otherwise look converged with the canceller doing
+       nothing.  We need to fall back under 12dB before we call it
+       unconverged again, so the verdict doesn't flap. */
+    if (!ec->converged)
+    {
+        if (8*ec->Lclean_slow < ec->Lrx_slow)
+        {
+            ec->converged = TRUE;
+            if (ec->converge_samples < 0)
+                ec->converge_samples = ec->samples - ec->meter_start;
+        }
+    }
+    else
+    {
+        if (4*ec->Lclean_slow >= ec->Lrx_slow)
+            ec->converged = FALSE;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+void echo_can_get_stats(echo_can_state_t *ec, echo_can_stats_t *stats)
+{
+    stats->erl = ratio_db10(ec->Ltx_slow, ec->Lrx_slow);
+    stats->erle = ratio_db10(ec->Lrx_slow, ec->Lclean_slow);
+    stats->converged = ec->converged;
+    if (ec->converge_samples < 0)
+        stats->converge_time = -1;
+    else
+        stats->converge_time = ec->converge_samples/8;
+    stats->measured_time = ec->meter_samples/8;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Event trace ----------------------------------------------------------------*/
+
+/*
+   The trace ring lets us see what the canceller was doing around the
+   time of an echo complaint, rather than guessing from a snapshot of
+   the levels.  It is single producer (echo_can_update(), which may be
+   in an ISR) and single consumer (e.g. a /proc read), so we get away
+   without locks.  The producer only ever writes head, the consumer
+   only ever writes tail.
+
+   When tracing is off the only cost in echo_can_update() is a test of
+   ec->trace once per sample.  That test reads ec->trace just once, and
+   passes the pointer it read down, as echo_can_trace_disable() may
+   clear ec->trace on another CPU at any moment.
+
+   Events which find the ring full are dropped, and counted.  An
+   ECHO_CAN_TRACE_LOST event, giving the number dropped, goes in ahead of
+   the next event there is room for, so the reader can see the gap.
+*/
+
+int echo_can_trace_enable(echo_can_state_t *ec, int log2_len)
+{
+    echo_can_trace_t *t;
+
+    if (log2_len < 1  ||  log2_len > TRACE_MAX_LOG2_LEN)
+        return -1;
+    if (ec->trace_ring == NULL)
+    {
+        if ((t = (echo_can_trace_t *) malloc(sizeof(*t))) == NULL)
+            return -1;
+        memset(t, 0, sizeof(*t));
+        t->event = (echo_can_trace_event_t *) malloc(sizeof(echo_can_trace_event_t) << log2_len);
+        if (t->event == NULL)
+        {
+            free(t);
+            return -1;
+        }
+        t->mask = (1 << log2_len) - 1;
+        ec->trace_ring = t;
+    }
+    /* Start with the current state, so we only log changes from here on */
+    ec->trace_mode = ec->adaption_mode;
+    ec->trace_adapt = FALSE;
+    ec->trace_nlp = FALSE;
+    ec->trace_clip = FALSE;
+    ec_wmb();
+    ec->trace = ec->trace_ring;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+void echo_can_trace_disable(echo_can_state_t *ec)
+{
+    /* The ring itself stays put until echo_can_free(), as the ISR
+       may still be writing to it. */
+    ec->trace = NULL;
+}
+/*- End of function --------------------------------------------------------*/
+
+int echo_can_trace_read(echo_can_state_t *ec, echo_can_trace_event_t *events, int max)
+{
+    echo_can_trace_t *t;
+    uint32_t head;
+    uint32_t tail;
+    int n;
+
+    if ((t = ec->trace_ring) == NULL)
+        return 0;
+    head = t->head;
+    ec_mb();
+    tail = t->tail;
+    for (n = 0;  n < max  &&  tail != head;  n++)
+        events[n] = t->event[tail++ & t->mask];
+    ec_mb();
+    t->tail = tail;
+    return n;
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ void trace_put(echo_can_trace_t *t, uint32_t head, uint32_t sample, int type, int value)
+{
+    echo_can_trace_event_t *ev;
+
+    ev = &t->event[head & t->mask];
+    ev->sample = sample;
+    ev->type = (uint16_t) type;
+    ev->value = (int16_t) value;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void trace_event(echo_can_trace_t *t, uint32_t sample, int type, int value)
+{
+    uint32_t head;
+    uint32_t dropped;
+
+    head = t->head;
+    /* Any events dropped since the last one logged need a slot of their own */
+    dropped = t->lost - t->lost_logged;
+    if (head - t->tail > t->mask - (dropped != 0))
+    {
+        /* Full - the reader is not keeping up, so drop the newest */
+        t->lost++;
+        return;
+    }
+    if (dropped)
+    {
+        trace_put(t, head++, sample, ECHO_CAN_TRACE_LOST, (dropped > 32767)  ?  32767  :  dropped);
+        t->lost_logged += dropped;
+    }
+    trace_put(t, head, sample, type, value);
+    /* The events must be visible before the reader can see the new head */
+    ec_wmb();
+    t->head = head + 1;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Called once per sample, at the end of echo_can_update(), when tracing
+   is on.  Works out which state transitions happened in this sample. */
+
+static void trace_update(echo_can_state_t *ec, echo_can_trace_t *t, int dwell_before, int nlp, int clip)
+{
+    if (ec->adaption_mode != ec->trace_mode)
+    {
+        ec->trace_mode = ec->adaption_mode;
+        trace_event(t, ec->samples, ECHO_CAN_TRACE_MODE, ec->adaption_mode);
+    }
+    if (dwell_before == 0  &&  ec->nonupdate_dwell)
+        trace_event(t, ec->samples, ECHO_CAN_TRACE_DTD_START, ec->Lrx);
+    else if (dwell_before  &&  ec->nonupdate_dwell == 0)
+        trace_event(t, ec->samples, ECHO_CAN_TRACE_DTD_END, ec->Lrx);
+    /* Once the transfer conditions are met the taps are copied on every
+       sample, so only log the start of each run of transfers. */
+    if (ec->adapt  &&  !ec->trace_adapt)
+        trace_event(t, ec->samples, ECHO_CAN_TRACE_FG_TRANSFER, ec->Lclean_bg);
+    ec->trace_adapt = ec->adapt;
+    if (nlp != ec->trace_nlp)
+    {
+        ec->trace_nlp = nlp;
+        trace_event(t,
+                    ec->samples,
+                    (nlp)  ?  ECHO_CAN_TRACE_NLP_ENGAGE  :  ECHO_CAN_TRACE_NLP_RELEASE,
+                    ec->Lclean);
+    }
+
+    /* Input at full scale is almost certainly clipped, and upsets the
+       canceller badly, so log when it starts. */
+    if (ec->tx >= 32767  ||  ec->tx <= -32767)
+        clip = ec->tx;
+    else if (ec->rx >= 32767  ||  ec->rx <= -32767)
+        clip = ec->rx;
+    if (clip  &&  !ec->trace_clip)
+        trace_event(t, ec->samples, ECHO_CAN_TRACE_CLIP, clip);
+    ec->trace_clip = (clip != 0);
 }
 /*- End of function --------------------------------------------------------*/
 
@@ -371,6 +758,11 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
     int32_t echo_value;
     int clean_bg;
     int tmp, tmp1;
+    int dwell_before;
+    int nlp;
+    int clip;
+    echo_can_trace_t *trace;
+    echo_can_snapshot_t *snap;
 
     /* Input scaling was found be required to prevent problems when tx
        starts clipping.  Another possible way to handle this would be the
@@ -379,6 +771,8 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
     ec->tx = tx; ec->rx = rx;
     tx >>=1;
     rx >>=1;
+    clip = 0;
+    nlp = FALSE;
 
     /* 
        Filter DC, 3dB point is 160Hz (I think), note 32 bit precision required
@@ -409,8 +803,14 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
       /* hard limit filter to prevent clipping.  Note that at this stage
 	 rx should be limited to +/- 16383 due to right shift above */
       tmp1 = ec->rx_1 >> 15;
-      if (tmp1 > 16383) tmp1 = 16383;
-      if (tmp1 < -16383) tmp1 = -16383;
+      if (tmp1 > 16383) {
+	  tmp1 = 16383;
+	  clip = ec->rx;
+      }
+      if (tmp1 < -16383) {
+	  tmp1 = -16383;
+	  clip = ec->rx;
+      }
       rx = tmp1;
       ec->rx_2 = tmp;
     }
@@ -497,7 +897,7 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
 	   for a divide versus a top_bit() implementation.
 	*/
 
-	P = MIN_TX_POWER_FOR_ADAPTION + ec->Pstates;
+	P = ec->tuning.min_tx_power + ec->Pstates;
 	logP = top_bit(P) + ec->log2taps;
 	shift = 30 - 2 - logP;
 	ec->shift = shift;
@@ -509,11 +909,14 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
        near end speech */
 
     ec->adapt = 0;
-    if ((ec->Lrx > MIN_RX_POWER_FOR_ADAPTION) && (ec->Lrx > ec->Ltx)) 
-	ec->nonupdate_dwell = DTD_HANGOVER;
+    dwell_before = ec->nonupdate_dwell;
+    if ((ec->Lrx > ec->tuning.min_rx_power) && (ec->Lrx > ec->Ltx)) 
+	ec->nonupdate_dwell = ec->tuning.dtd_hangover;
     if (ec->nonupdate_dwell)
 	ec->nonupdate_dwell--;
 
+    meter_update(ec);
+
     /* Transfer logic ------------------------------------------------------*/
 
     /* These conditions are from the dual path paper [1], I messed with
@@ -521,11 +924,12 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
 
     if ((ec->adaption_mode & ECHO_CAN_USE_ADAPTION) &&
 	(ec->nonupdate_dwell == 0) && 
-	(8*ec->Lclean_bg < 7*ec->Lclean) /* (ec->Lclean_bg < 0.875*ec->Lclean) */ && 
-	(8*ec->Lclean_bg < ec->Ltx)      /* (ec->Lclean_bg < 0.125*ec->Ltx)    */ )       
+	(8*ec->Lclean_bg < ec->tuning.transfer_fg_eighths*ec->Lclean) /* (ec->Lclean_bg < 0.875*ec->Lclean) */ && 
+	(8*ec->Lclean_bg < ec->tuning.transfer_tx_eighths*ec->Ltx)    /* (ec->Lclean_bg < 0.125*ec->Ltx)    */ )       
     {
-	if (ec->cond_met == 6) {
-	    /* BG filter has had better results for 6 consecutive samples */
+	if (ec->cond_met >= ec->tuning.transfer_count) {
+	    /* BG filter has had better results for transfer_count (usually
+	       6) consecutive samples */
 	    ec->adapt = 1;
 	    memcpy(ec->fir_taps16[0], ec->fir_taps16[1], ec->taps*sizeof(int16_t));
 	}
@@ -543,10 +947,11 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
         /* Non-linear processor - a fancy way to say "zap small signals, to avoid
            residual echo due to (uLaw/ALaw) non-linearity in the channel.". */
 
-      if ((16*ec->Lclean < ec->Ltx))
+      if ((ec->tuning.nlp_ratio*ec->Lclean < ec->Ltx))
       {
 	/* Our e/c has improved echo by at least 24 dB (each factor of 2 is 6dB,
 	   so 2*2*2*2=16 is the same as 6+6+6+6=24dB) */
+        nlp = TRUE;
         if (ec->adaption_mode & ECHO_CAN_USE_CNG)
 	{
 	    ec->cng_level = ec->Lbgn;
@@ -588,7 +993,7 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
 	     include high level signals like near end speech.  When
 	     combined with CNG or especially CLIP seems to work OK.
 	  */
-	  if (ec->Lclean < 40) {
+	  if (ec->Lclean < ec->tuning.bgn_max_level) {
 	      ec->Lbgn_acc += abs(ec->clean) - ec->Lbgn;
 	      ec->Lbgn = (ec->Lbgn_acc + (1<<11)) >> 12;
 	  }
@@ -603,6 +1008,17 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx)
     if (ec->adaption_mode & ECHO_CAN_DISABLE)
       ec->clean_nlp = rx;
 
+    trace = ec->trace;
+    if (trace)
+        trace_update(ec, trace, dwell_before, nlp, clip);
+    if ((ec->samples & (SNAPSHOT_INTERVAL - 1)) == 0)
+    {
+        snap = ec->snapshot;
+        if (snap)
+            snapshot_update(ec, snap);
+    }
+    ec->samples++;
+
     /* Output scaled back up again to match input scaling */
 
     return (int16_t) ec->clean_nlp << 1;
@@ -654,5 +1070,34 @@ int16_t echo_can_hpf_tx(echo_can_state_t *ec, int16_t tx) {
     return tx;
 }
 
+/*- End of function --------------------------------------------------------*/
+
+/*
+   Block versions, for drivers that hand us a chunk of samples per
+   interrupt (e.g. ZT_CHUNKSIZE, usually 8) rather than calling us a
+   sample at a time.  A driver makes one call into us per chunk, rather
+   than one per sample.  Inside, each sample still goes through
+   echo_can_update(), as it is far too big to inline, so the results
+   are bit exact with the per sample functions.
+*/
+
+void echo_can_update_block(echo_can_state_t *ec, int16_t clean[], const int16_t tx[], const int16_t rx[], int len)
+{
+    int i;
+
+    for (i = 0;  i < len;  i++)
+        clean[i] = echo_can_update(ec, tx[i], rx[i]);
+}
+/*- End of function --------------------------------------------------------*/
+
+void echo_can_hpf_tx_block(echo_can_state_t *ec, int16_t tx[], int len)
+{
+    int i;
+
+    if ((ec->adaption_mode & ECHO_CAN_USE_TX_HPF) == 0)
+        return;
+    for (i = 0;  i < len;  i++)
+        tx[i] = echo_can_hpf_tx(ec, tx[i]);
+}
 /*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -41,6 +41,9 @@
 #include <math.h>
 #endif
 #include <assert.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/complex.h"
@@ -254,17 +257,85 @@ fsk_rx_state_t *fsk_rx_init(fsk_rx_state_t *s,
 }
 /*- End of function --------------------------------------------------------*/
 
-int fsk_rx(fsk_rx_state_t *s, const int16_t *amp, int len)
+static __inline__ void fsk_rx_demod(fsk_rx_state_t *s, int16_t amp, int *buf_ptr)
 {
-    int buf_ptr;
     int baudstate;
-    int sample;
     int j;
     int32_t dot;
     int32_t sum;
-    int32_t power;
     icomplex_t ph;
 
+    /* Non-coherent FSK demodulation by correlation with the target tones
+       over a one baud interval. The slow V.xx specs. are too open ended
+       to allow anything fancier to be used. The dot products are calculated
+       using a sliding window approach, so the compute load is not that great. */
+    /* The *totally* asynchronous character to character behaviour of these
+       modems, when carrying async. data, seems to force a sample by sample
+       approach. */
+    for (j = 0;  j < 2;  j++)
+    {
+        s->dot_i[j] -= s->window_i[j][*buf_ptr];
+        s->dot_q[j] -= s->window_q[j][*buf_ptr];
+
+        ph = dds_complex(&(s->phase_acc[j]), s->phase_rate[j]);
+        s->window_i[j][*buf_ptr] = (ph.re*amp) >> s->scaling_shift;
+        s->window_q[j][*buf_ptr] = (ph.im*amp) >> s->scaling_shift;
+
+        s->dot_i[j] += s->window_i[j][*buf_ptr];
+        s->dot_q[j] += s->window_q[j][*buf_ptr];
+    }
+    dot = s->dot_i[0] >> 15;
+    sum = dot*dot;
+    dot = s->dot_q[0] >> 15;
+    sum += dot*dot;
+    dot = s->dot_i[1] >> 15;
+    sum -= dot*dot;
+    dot = s->dot_q[1] >> 15;
+    sum -= dot*dot;
+    baudstate = (sum < 0);
+
+    if (s->lastbit != baudstate)
+    {
+        s->lastbit = baudstate;
+        if (s->sync_mode)
+        {
+            /* For synchronous use (e.g. HDLC channels in FAX modems), nudge
+               the baud phase gently, trying to keep it centred on the bauds. */
+            if (s->baud_pll < 0x8000)
+                s->baud_pll += (s->baud_inc >> 3);
+            else
+                s->baud_pll -= (s->baud_inc >> 3);
+        }
+        else
+        {
+            /* For async. operation, believe transitions completely, and
+               sample appropriately. This allows instant start on the first
+               transition. */
+            /* We must now be about half way to a sampling point. We do not do
+               any fractional sample estimation of the transitions, so this is
+               the most accurate baud alignment we can do. */
+            s->baud_pll = 0x8000;
+        }
+
+    }
+    if ((s->baud_pll += s->baud_inc) >= 0x10000)
+    {
+        /* We should be in the middle of a baud now, so report the current
+           state as the next bit */
+        s->baud_pll -= 0x10000;
+        s->put_bit(s->user_data, baudstate);
+    }
+    if (++(*buf_ptr) >= s->correlation_span)
+        *buf_ptr = 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int fsk_rx(fsk_rx_state_t *s, const int16_t *amp, int len)
+{
+    int buf_ptr;
+    int sample;
+    int32_t power;
+
     buf_ptr = s->buf_ptr;
 
     for (sample = 0;  sample < len;  sample++)
@@ -288,71 +359,346 @@ int fsk_rx(fsk_rx_state_t *s, const int16_t *amp, int len)
             s->put_bit(s->user_data, PUTBIT_CARRIER_UP);
             s->carrier_present = TRUE;
         }
-        /* Non-coherent FSK demodulation by correlation with the target tones
-           over a one baud interval. The slow V.xx specs. are too open ended
-           to allow anything fancier to be used. The dot products are calculated
-           using a sliding window approach, so the compute load is not that great. */
-        /* The *totally* asynchronous character to character behaviour of these
-           modems, when carrying async. data, seems to force a sample by sample
-           approach. */
-        for (j = 0;  j < 2;  j++)
-        {
-            s->dot_i[j] -= s->window_i[j][buf_ptr];
-            s->dot_q[j] -= s->window_q[j][buf_ptr];
+        fsk_rx_demod(s, amp[sample], &buf_ptr);
+    }
+    s->buf_ptr = buf_ptr;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* The bank runs the power meters and carrier detect checks of 8 channels at a
+   time. The audio is transposed into vectors of 16 bit samples, one lane per
+   channel, and the differences between samples are taken in 16 bit lanes, so
+   they wrap exactly as the int16_t argument to power_meter_update() does. The
+   squares and the power meter readings are in two vectors of 32 bit lanes. */
+#if defined(__SSE2__)
+#define FSK_RX_BANK_LANES 8
+
+/* The working arrays of a bank, each one entry per channel */
+enum
+{
+    BANK_READING = 0,
+    BANK_MIN_POWER,
+    BANK_LAST_SAMPLE,
+    BANK_NUM_ARRAYS
+};
+
+#define bank_array(s, n)    (&(s)->vec[(n)*(s)->stride])
 
-            ph = dds_complex(&(s->phase_acc[j]), s->phase_rate[j]);
-            s->window_i[j][buf_ptr] = (ph.re*amp[sample]) >> s->scaling_shift;
-            s->window_q[j][buf_ptr] = (ph.im*amp[sample]) >> s->scaling_shift;
+static __inline__ void transpose_8x8(__m128i r[8])
+{
+    __m128i t[8];
+    __m128i u[8];
+    int i;
 
-            s->dot_i[j] += s->window_i[j][buf_ptr];
-            s->dot_q[j] += s->window_q[j][buf_ptr];
+    for (i = 0;  i < 4;  i++)
+    {
+        t[2*i] = _mm_unpacklo_epi16(r[2*i], r[2*i + 1]);
+        t[2*i + 1] = _mm_unpackhi_epi16(r[2*i], r[2*i + 1]);
+    }
+    for (i = 0;  i < 2;  i++)
+    {
+        u[4*i] = _mm_unpacklo_epi32(t[4*i], t[4*i + 2]);
+        u[4*i + 1] = _mm_unpackhi_epi32(t[4*i], t[4*i + 2]);
+        u[4*i + 2] = _mm_unpacklo_epi32(t[4*i + 1], t[4*i + 3]);
+        u[4*i + 3] = _mm_unpackhi_epi32(t[4*i + 1], t[4*i + 3]);
+    }
+    for (i = 0;  i < 4;  i++)
+    {
+        r[2*i] = _mm_unpacklo_epi64(u[i], u[i + 4]);
+        r[2*i + 1] = _mm_unpackhi_epi64(u[i], u[i + 4]);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_demod(fsk_rx_state_t *s, const int16_t amp[], const int16_t gated[][FSK_RX_BANK_LANES], int len, int lane)
+{
+    int buf_ptr;
+    int sample;
+
+    /* This follows fsk_rx(), with the carrier detect decisions already made */
+    buf_ptr = s->buf_ptr;
+    for (sample = 0;  sample < len;  sample++)
+    {
+        if (gated[sample][lane])
+        {
+            if (s->carrier_present)
+            {
+                s->put_bit(s->user_data, PUTBIT_CARRIER_DOWN);
+                s->carrier_present = FALSE;
+            }
+            continue;
         }
-        dot = s->dot_i[0] >> 15;
-        sum = dot*dot;
-        dot = s->dot_q[0] >> 15;
-        sum += dot*dot;
-        dot = s->dot_i[1] >> 15;
-        sum -= dot*dot;
-        dot = s->dot_q[1] >> 15;
-        sum -= dot*dot;
-        baudstate = (sum < 0);
-
-        if (s->lastbit != baudstate)
+        if (!s->carrier_present)
         {
-            s->lastbit = baudstate;
-            if (s->sync_mode)
+            s->put_bit(s->user_data, PUTBIT_CARRIER_UP);
+            s->carrier_present = TRUE;
+        }
+        fsk_rx_demod(s, amp[sample], &buf_ptr);
+    }
+    s->buf_ptr = buf_ptr;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_rx_group(fsk_rx_bank_state_t *s, int c, const int16_t *amp[], int len)
+{
+    const int16_t *chan_amp[FSK_RX_BANK_LANES];
+    int16_t tail[FSK_RX_BANK_LANES][8];
+    int16_t gated[FSK_RX_BANK_CHUNK][FSK_RX_BANK_LANES];
+    __m128i r[8];
+    __m128i last;
+    __m128i reading_lo;
+    __m128i reading_hi;
+    __m128i min_lo;
+    __m128i min_hi;
+    __m128i shift;
+    __m128i diff;
+    __m128i lo;
+    __m128i hi;
+    __m128i weak;
+    __m128i closed;
+    int lanes;
+    int any;
+    int sample;
+    int limit;
+    int steps;
+    int i;
+    int j;
+    int k;
+
+    lanes = s->channels - c;
+    if (lanes > FSK_RX_BANK_LANES)
+        lanes = FSK_RX_BANK_LANES;
+    for (i = 0;  i < lanes;  i++)
+        chan_amp[i] = amp[c + i];
+    reading_lo = _mm_loadu_si128((const __m128i *) (bank_array(s, BANK_READING) + c));
+    reading_hi = _mm_loadu_si128((const __m128i *) (bank_array(s, BANK_READING) + c + 4));
+    min_lo = _mm_loadu_si128((const __m128i *) (bank_array(s, BANK_MIN_POWER) + c));
+    min_hi = _mm_loadu_si128((const __m128i *) (bank_array(s, BANK_MIN_POWER) + c + 4));
+    last = _mm_packs_epi32(_mm_loadu_si128((const __m128i *) (bank_array(s, BANK_LAST_SAMPLE) + c)),
+                           _mm_loadu_si128((const __m128i *) (bank_array(s, BANK_LAST_SAMPLE) + c + 4)));
+    shift = _mm_cvtsi32_si128(s->chan[c]->power.shift);
+    memset(tail, 0, sizeof(tail));
+    for (sample = 0;  sample < len;  sample = limit)
+    {
+        limit = sample + FSK_RX_BANK_CHUNK;
+        if (limit > len)
+            limit = len;
+        closed = _mm_set1_epi16(-1);
+        for (j = sample;  j < limit;  j += 8)
+        {
+            steps = limit - j;
+            if (steps > 8)
+                steps = 8;
+            for (i = 0;  i < lanes;  i++)
             {
-                /* For synchronous use (e.g. HDLC channels in FAX modems), nudge
-                   the baud phase gently, trying to keep it centred on the bauds. */
-                if (s->baud_pll < 0x8000)
-                    s->baud_pll += (s->baud_inc >> 3);
+                if (steps == 8)
+                {
+                    r[i] = _mm_loadu_si128((const __m128i *) &chan_amp[i][j]);
+                }
                 else
-                    s->baud_pll -= (s->baud_inc >> 3);
+                {
+                    memcpy(tail[i], &chan_amp[i][j], steps*sizeof(int16_t));
+                    r[i] = _mm_loadu_si128((const __m128i *) tail[i]);
+                }
             }
-            else
+            /* Unused lanes hold silence, and never pass the carrier check */
+            for (  ;  i < FSK_RX_BANK_LANES;  i++)
+                r[i] = _mm_setzero_si128();
+            transpose_8x8(r);
+            for (k = 0;  k < steps;  k++)
             {
-                /* For async. operation, believe transitions completely, and
-                   sample appropriately. This allows instant start on the first
-                   transition. */
-                /* We must now be about half way to a sampling point. We do not do
-                   any fractional sample estimation of the transitions, so this is
-                   the most accurate baud alignment we can do. */
-                s->baud_pll = 0x8000;
+                /* This follows power_meter_update() for each channel */
+                diff = _mm_sub_epi16(r[k], last);
+                last = r[k];
+                lo = _mm_mullo_epi16(diff, diff);
+                hi = _mm_mulhi_epi16(diff, diff);
+                reading_lo = _mm_add_epi32(reading_lo, _mm_sra_epi32(_mm_sub_epi32(_mm_unpacklo_epi16(lo, hi), reading_lo), shift));
+                reading_hi = _mm_add_epi32(reading_hi, _mm_sra_epi32(_mm_sub_epi32(_mm_unpackhi_epi16(lo, hi), reading_hi), shift));
+                /* Each lane is all ones where the signal is too weak to demodulate */
+                weak = _mm_packs_epi32(_mm_cmplt_epi32(reading_lo, min_lo), _mm_cmplt_epi32(reading_hi, min_hi));
+                _mm_storeu_si128((__m128i *) gated[j - sample + k], weak);
+                closed = _mm_and_si128(closed, weak);
             }
-
         }
-        if ((s->baud_pll += s->baud_inc) >= 0x10000)
+        /* Only the channels with a signal, or with a carrier to drop, need any more work */
+        any = ~_mm_movemask_epi8(_mm_packs_epi16(closed, closed));
+        for (i = 0;  i < lanes;  i++)
         {
-            /* We should be in the middle of a baud now, so report the current
-               state as the next bit */
-            s->baud_pll -= 0x10000;
-            s->put_bit(s->user_data, baudstate);
+            if ((any & (1 << i))  ||  s->chan[c + i]->carrier_present)
+                bank_demod(s->chan[c + i], &chan_amp[i][sample], gated, limit - sample, i);
         }
-        if (++buf_ptr >= s->correlation_span)
-            buf_ptr = 0;
     }
-    s->buf_ptr = buf_ptr;
+    _mm_storeu_si128((__m128i *) (bank_array(s, BANK_READING) + c), reading_lo);
+    _mm_storeu_si128((__m128i *) (bank_array(s, BANK_READING) + c + 4), reading_hi);
+    _mm_storeu_si128((__m128i *) (bank_array(s, BANK_LAST_SAMPLE) + c), _mm_srai_epi32(_mm_unpacklo_epi16(last, last), 16));
+    _mm_storeu_si128((__m128i *) (bank_array(s, BANK_LAST_SAMPLE) + c + 4), _mm_srai_epi32(_mm_unpackhi_epi16(last, last), 16));
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_load_states(fsk_rx_bank_state_t *s)
+{
+    fsk_rx_state_t *t;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        t = s->chan[c];
+        bank_array(s, BANK_READING)[c] = t->power.reading;
+        bank_array(s, BANK_MIN_POWER)[c] = t->min_power;
+        bank_array(s, BANK_LAST_SAMPLE)[c] = t->last_sample;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_save_states(fsk_rx_bank_state_t *s)
+{
+    fsk_rx_state_t *t;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        t = s->chan[c];
+        t->power.reading = bank_array(s, BANK_READING)[c];
+        t->last_sample = (int16_t) bank_array(s, BANK_LAST_SAMPLE)[c];
+    }
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+int fsk_rx_bank(fsk_rx_bank_state_t *s, const int16_t *amp[], int len)
+{
+    int c;
+
+#if defined(FSK_RX_BANK_LANES)
+    bank_load_states(s);
+    for (c = 0;  c < s->channels;  c += FSK_RX_BANK_LANES)
+        bank_rx_group(s, c, amp, len);
+    bank_save_states(s);
+#else
+    for (c = 0;  c < s->channels;  c++)
+        fsk_rx(s->chan[c], amp[c], len);
+#endif
     return 0;
 }
 /*- End of function --------------------------------------------------------*/
+
+static fsk_rx_bank_state_t *bank_alloc(fsk_rx_bank_state_t *s, int channels, int own)
+{
+    int alloced;
+
+    if (channels <= 0)
+        return NULL;
+    alloced = FALSE;
+    if (s == NULL)
+    {
+        if ((s = (fsk_rx_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+        alloced = TRUE;
+    }
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    if ((s->chan = (fsk_rx_state_t **) malloc(channels*sizeof(fsk_rx_state_t *))) == NULL)
+    {
+        if (alloced)
+            free(s);
+        return NULL;
+    }
+    if (own  &&  (s->own = (fsk_rx_state_t *) malloc(channels*sizeof(fsk_rx_state_t))) == NULL)
+    {
+        free(s->chan);
+        if (alloced)
+            free(s);
+        return NULL;
+    }
+#if defined(FSK_RX_BANK_LANES)
+    /* Round up to whole vectors, so the vector code never needs a scalar tail */
+    s->stride = (channels + FSK_RX_BANK_LANES - 1) & ~(FSK_RX_BANK_LANES - 1);
+    if ((s->vec = (int32_t *) malloc(BANK_NUM_ARRAYS*s->stride*sizeof(int32_t))) == NULL)
+    {
+        free(s->own);
+        free(s->chan);
+        if (alloced)
+            free(s);
+        return NULL;
+    }
+    memset(s->vec, 0, BANK_NUM_ARRAYS*s->stride*sizeof(int32_t));
+#else
+    s->stride = channels;
+#endif
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+fsk_rx_bank_state_t *fsk_rx_bank_init(fsk_rx_bank_state_t *s,
+                                      int channels,
+                                      fsk_spec_t *spec,
+                                      int sync_mode,
+                                      put_bit_func_t put_bit,
+                                      void *user_data[])
+{
+    int i;
+
+    if ((s = bank_alloc(s, channels, TRUE)) == NULL)
+        return NULL;
+    s->spec = spec;
+    s->sync_mode = sync_mode;
+    for (i = 0;  i < channels;  i++)
+    {
+        s->chan[i] = &s->own[i];
+        fsk_rx_init(s->chan[i], spec, sync_mode, put_bit, (user_data)  ?  user_data[i]  :  NULL);
+    }
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+fsk_rx_bank_state_t *fsk_rx_bank_attach(fsk_rx_bank_state_t *s, int channels, fsk_rx_state_t *rx[])
+{
+    int i;
+
+    if (channels <= 0)
+        return NULL;
+    /* The vector code runs all the power meters with the same time constant */
+    for (i = 1;  i < channels;  i++)
+    {
+        if (rx[i]->power.shift != rx[0]->power.shift)
+            return NULL;
+    }
+    if ((s = bank_alloc(s, channels, FALSE)) == NULL)
+        return NULL;
+    for (i = 0;  i < channels;  i++)
+        s->chan[i] = rx[i];
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int fsk_rx_bank_release(fsk_rx_bank_state_t *s)
+{
+    free(s->vec);
+    free(s->own);
+    free(s->chan);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int fsk_rx_bank_reset_channel(fsk_rx_bank_state_t *s, int chan)
+{
+    fsk_rx_state_t *t;
+
+    if (chan < 0  ||  chan >= s->channels  ||  s->own == NULL)
+        return -1;
+    t = s->chan[chan];
+    fsk_rx_init(t, s->spec, s->sync_mode, t->put_bit, t->user_data);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+fsk_rx_state_t *fsk_rx_bank_channel(fsk_rx_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return NULL;
+    return s->chan[chan];
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -41,6 +41,11 @@
 #include <math.h>
 #endif
 #include <assert.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/logging.h"
@@ -91,6 +96,81 @@ static const uint8_t alaw_to_ulaw_table[256] =
     214, 215, 212, 213, 218, 219, 216, 217, 207, 207, 206, 206, 210, 211, 208, 209
 };
 
+/* Decoding tables for the block decoders, generated from ulaw_to_linear() and
+   alaw_to_linear(). Unlike a 64K encoding table, these 512 byte tables will
+   happily stay in the cache. */
+static const int16_t ulaw_to_linear_table[256] =
+{
+    -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+    -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+    -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+    -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+     -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+     -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+     -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+     -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+     -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+     -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+      -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+      -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+      -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+      -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+      -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+       -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+     32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+     23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+     15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+     11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+      7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+      5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+      3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+      2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+      1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+      1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+       876,    844,    812,    780,    748,    716,    684,    652,
+       620,    588,    556,    524,    492,    460,    428,    396,
+       372,    356,    340,    324,    308,    292,    276,    260,
+       244,    228,    212,    196,    180,    164,    148,    132,
+       120,    112,    104,     96,     88,     80,     72,     64,
+        56,     48,     40,     32,     24,     16,      8,      0
+};
+
+static const int16_t alaw_to_linear_table[256] =
+{
+     -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+     -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+     -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+     -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+    -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+    -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+    -11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+    -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+      -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+      -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+       -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+      -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+     -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+     -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+      -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+      -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+      5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+      7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+      2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+      3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+     22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+     30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+     11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+     15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+       344,    328,    376,    360,    280,    264,    312,    296,
+       472,    456,    504,    488,    408,    392,    440,    424,
+        88,     72,    120,    104,     24,      8,     56,     40,
+       216,    200,    248,    232,    152,    136,    184,    168,
+      1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+      1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+       688,    656,    752,    720,    560,    528,    624,    592,
+       944,    912,   1008,    976,    816,    784,    880,    848
+};
+
 uint8_t alaw_to_ulaw(uint8_t alaw)
 {
     return alaw_to_ulaw_table[alaw];
@@ -102,4 +182,225 @@ uint8_t ulaw_to_alaw(uint8_t ulaw)
     return ulaw_to_alaw_table[ulaw];
 }
 /*- End of function --------------------------------------------------------*/
+
+/*
+   The block encoders work on 8 (SSE2) or 16 (AVX2) samples at a time, with
+   no branches. The segment is found by comparing the magnitude with each
+   segment boundary, and the quantisation bits are shifted down by a
+   multiply, as the shift differs from sample to sample. The magnitude is
+   limited to 32767 first. For u-law that gives the same code as the
+   overflow check in linear_to_ulaw(). For A-law the only values affected
+   are small negative ones, which linear_to_alaw() maps to zero.
+*/
+#if defined(__AVX2__)
+/* Count one more segment, and halve the multiplier, where the magnitude is
+   above the start of segment k. This is written out for each segment, as
+   the compiler won't always unroll a loop for us. */
+#define SEGMENT_STEP(k, step) \
+    gt = _mm256_cmpgt_epi16(mag, _mm256_set1_epi16((0x100 << ((k) - 1)) - 1)); \
+    seg = _mm256_sub_epi16(seg, gt); \
+    mul = _mm256_sub_epi16(mul, _mm256_and_si256(gt, _mm256_set1_epi16(step)))
+
+static __inline__ __m256i ulaw_encode_vec(__m256i linear)
+{
+    __m256i neg;
+    __m256i mag;
+    __m256i seg;
+    __m256i mul;
+    __m256i gt;
+    __m256i code;
+
+    neg = _mm256_srai_epi16(linear, 15);
+    mag = _mm256_sub_epi16(_mm256_xor_si256(linear, neg), neg);
+    mag = _mm256_adds_epu16(mag, _mm256_set1_epi16(ULAW_BIAS));
+    mag = _mm256_sub_epi16(mag, _mm256_subs_epu16(mag, _mm256_set1_epi16(32767)));
+    seg = _mm256_setzero_si256();
+    mul = _mm256_set1_epi16(1 << 13);
+    SEGMENT_STEP(1, 1 << 12);
+    SEGMENT_STEP(2, 1 << 11);
+    SEGMENT_STEP(3, 1 << 10);
+    SEGMENT_STEP(4, 1 << 9);
+    SEGMENT_STEP(5, 1 << 8);
+    SEGMENT_STEP(6, 1 << 7);
+    SEGMENT_STEP(7, 1 << 6);
+    code = _mm256_and_si256(_mm256_mulhi_epu16(mag, mul), _mm256_set1_epi16(0x0F));
+    code = _mm256_or_si256(code, _mm256_slli_epi16(seg, 4));
+    return _mm256_xor_si256(code, _mm256_andnot_si256(_mm256_and_si256(neg, _mm256_set1_epi16(0x80)), _mm256_set1_epi16(0xFF)));
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ __m256i alaw_encode_vec(__m256i linear)
+{
+    __m256i neg;
+    __m256i mag;
+    __m256i seg;
+    __m256i mul;
+    __m256i gt;
+    __m256i code;
+
+    neg = _mm256_srai_epi16(linear, 15);
+    mag = _mm256_add_epi16(_mm256_xor_si256(linear, neg), _mm256_and_si256(neg, _mm256_set1_epi16(-7)));
+    mag = _mm256_max_epi16(mag, _mm256_setzero_si256());
+    seg = _mm256_setzero_si256();
+    mul = _mm256_set1_epi16(1 << 12);
+    SEGMENT_STEP(1, 0);
+    SEGMENT_STEP(2, 1 << 11);
+    SEGMENT_STEP(3, 1 << 10);
+    SEGMENT_STEP(4, 1 << 9);
+    SEGMENT_STEP(5, 1 << 8);
+    SEGMENT_STEP(6, 1 << 7);
+    SEGMENT_STEP(7, 1 << 6);
+    code = _mm256_and_si256(_mm256_mulhi_epu16(mag, mul), _mm256_set1_epi16(0x0F));
+    code = _mm256_or_si256(code, _mm256_slli_epi16(seg, 4));
+    return _mm256_xor_si256(code, _mm256_or_si256(_mm256_set1_epi16(ALAW_AMI_MASK), _mm256_andnot_si256(neg, _mm256_set1_epi16(0x80))));
+}
+/*- End of function --------------------------------------------------------*/
+
+#define G711_VEC_LEN    16
+
+static __inline__ void store_codes(uint8_t *dst, __m256i code)
+{
+    /* The pack works within each 128 bit lane, so gather the two halves of
+       the result into the low lane before storing it */
+    code = _mm256_permute4x64_epi64(_mm256_packus_epi16(code, code), 0x08);
+    _mm_storeu_si128((__m128i *) dst, _mm256_castsi256_si128(code));
+}
+/*- End of function --------------------------------------------------------*/
+
+#define LOAD_AMP(p)     _mm256_loadu_si256((const __m256i *) (p))
+#elif defined(__SSE2__)
+#define SEGMENT_STEP(k, step) \
+    gt = _mm_cmpgt_epi16(mag, _mm_set1_epi16((0x100 << ((k) - 1)) - 1)); \
+    seg = _mm_sub_epi16(seg, gt); \
+    mul = _mm_sub_epi16(mul, _mm_and_si128(gt, _mm_set1_epi16(step)))
+
+static __inline__ __m128i ulaw_encode_vec(__m128i linear)
+{
+    __m128i neg;
+    __m128i mag;
+    __m128i seg;
+    __m128i mul;
+    __m128i gt;
+    __m128i code;
+
+    neg = _mm_srai_epi16(linear, 15);
+    mag = _mm_sub_epi16(_mm_xor_si128(linear, neg), neg);
+    mag = _mm_adds_epu16(mag, _mm_set1_epi16(ULAW_BIAS));
+    mag = _mm_sub_epi16(mag, _mm_subs_epu16(mag, _mm_set1_epi16(32767)));
+    seg = _mm_setzero_si128();
+    mul = _mm_set1_epi16(1 << 13);
+    SEGMENT_STEP(1, 1 << 12);
+    SEGMENT_STEP(2, 1 << 11);
+    SEGMENT_STEP(3, 1 << 10);
+    SEGMENT_STEP(4, 1 << 9);
+    SEGMENT_STEP(5, 1 << 8);
+    SEGMENT_STEP(6, 1 << 7);
+    SEGMENT_STEP(7, 1 << 6);
+    code = _mm_and_si128(_mm_mulhi_epu16(mag, mul), _mm_set1_epi16(0x0F));
+    code = _mm_or_si128(code, _mm_slli_epi16(seg, 4));
+    return _mm_xor_si128(code, _mm_andnot_si128(_mm_and_si128(neg, _mm_set1_epi16(0x80)), _mm_set1_epi16(0xFF)));
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ __m128i alaw_encode_vec(__m128i linear)
+{
+    __m128i neg;
+    __m128i mag;
+    __m128i seg;
+    __m128i mul;
+    __m128i gt;
+    __m128i code;
+
+    neg = _mm_srai_epi16(linear, 15);
+    mag = _mm_add_epi16(_mm_xor_si128(linear, neg), _mm_and_si128(neg, _mm_set1_epi16(-7)));
+    mag = _mm_max_epi16(mag, _mm_setzero_si128());
+    seg = _mm_setzero_si128();
+    mul = _mm_set1_epi16(1 << 12);
+    SEGMENT_STEP(1, 0);
+    SEGMENT_STEP(2, 1 << 11);
+    SEGMENT_STEP(3, 1 << 10);
+    SEGMENT_STEP(4, 1 << 9);
+    SEGMENT_STEP(5, 1 << 8);
+    SEGMENT_STEP(6, 1 << 7);
+    SEGMENT_STEP(7, 1 << 6);
+    code = _mm_and_si128(_mm_mulhi_epu16(mag, mul), _mm_set1_epi16(0x0F));
+    code = _mm_or_si128(code, _mm_slli_epi16(seg, 4));
+    return _mm_xor_si128(code, _mm_or_si128(_mm_set1_epi16(ALAW_AMI_MASK), _mm_andnot_si128(neg, _mm_set1_epi16(0x80))));
+}
+/*- End of function --------------------------------------------------------*/
+
+#define G711_VEC_LEN    8
+
+static __inline__ void store_codes(uint8_t *dst, __m128i code)
+{
+    _mm_storel_epi64((__m128i *) dst, _mm_packus_epi16(code, code));
+}
+/*- End of function --------------------------------------------------------*/
+
+#define LOAD_AMP(p)     _mm_loadu_si128((const __m128i *) (p))
+#endif
+
+void g711_ulaw_encode_block(uint8_t ulaw[], const int16_t amp[], int len)
+{
+    int i;
+
+    i = 0;
+#if defined(G711_VEC_LEN)
+    for (  ;  i <= len - G711_VEC_LEN;  i += G711_VEC_LEN)
+        store_codes(ulaw + i, ulaw_encode_vec(LOAD_AMP(amp + i)));
+#endif
+    for (  ;  i < len;  i++)
+        ulaw[i] = linear_to_ulaw(amp[i]);
+}
+/*- End of function --------------------------------------------------------*/
+
+void g711_alaw_encode_block(uint8_t alaw[], const int16_t amp[], int len)
+{
+    int i;
+
+    i = 0;
+#if defined(G711_VEC_LEN)
+    for (  ;  i <= len - G711_VEC_LEN;  i += G711_VEC_LEN)
+        store_codes(alaw + i, alaw_encode_vec(LOAD_AMP(amp + i)));
+#endif
+    for (  ;  i < len;  i++)
+        alaw[i] = linear_to_alaw(amp[i]);
+}
+/*- End of function --------------------------------------------------------*/
+
+void g711_ulaw_decode_block(int16_t amp[], const uint8_t ulaw[], int len)
+{
+    int i;
+
+    for (i = 0;  i < len;  i++)
+        amp[i] = ulaw_to_linear_table[ulaw[i]];
+}
+/*- End of function --------------------------------------------------------*/
+
+void g711_alaw_decode_block(int16_t amp[], const uint8_t alaw[], int len)
+{
+    int i;
+
+    for (i = 0;  i < len;  i++)
+        amp[i] = alaw_to_linear_table[alaw[i]];
+}
+/*- End of function --------------------------------------------------------*/
+
+void g711_alaw_to_ulaw_block(uint8_t ulaw[], const uint8_t alaw[], int len)
+{
+    int i;
+
+    for (i = 0;  i < len;  i++)
+        ulaw[i] = alaw_to_ulaw_table[alaw[i]];
+}
+/*- End of function --------------------------------------------------------*/
+
+void g711_ulaw_to_alaw_block(uint8_t alaw[], const uint8_t ulaw[], int len)
+{
+    int i;
+
+    for (i = 0;  i < len;  i++)
+        alaw[i] = ulaw_to_alaw_table[ulaw[i]];
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
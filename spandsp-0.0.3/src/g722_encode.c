@@ -51,92 +51,160 @@
 #include "spandsp/dc_restore.h"
 #include "spandsp/g722.h"
 
-static void block4(g722_encode_state_t *s, int band, int d)
+#include "g722_local.h"
+
+/* The last two entries repeat the last real one, so the binary search in the
+   quantizer can step past the end of the table without going wrong. */
+static const int q6[32] =
+{
+       0,   35,   72,  110,  150,  190,  233,  276,
+     323,  370,  422,  473,  530,  587,  650,  714,
+     786,  858,  940, 1023, 1121, 1219, 1339, 1458,
+    1612, 1765, 1980, 2195, 2557, 2919, 2919, 2919
+};
+static const int iln[32] =
+{
+     0, 63, 62, 31, 30, 29, 28, 27,
+    26, 25, 24, 23, 22, 21, 20, 19,
+    18, 17, 16, 15, 14, 13, 12, 11,
+    10,  9,  8,  7,  6,  5,  4,  0
+};
+static const int ilp[32] =
+{
+     0, 61, 60, 59, 58, 57, 56, 55,
+    54, 53, 52, 51, 50, 49, 48, 47,
+    46, 45, 44, 43, 42, 41, 40, 39,
+    38, 37, 36, 35, 34, 33, 32,  0
+};
+static const int wl[8] =
+{
+    -60, -30, 58, 172, 334, 538, 1198, 3042
+};
+static const int rl42[16] =
+{
+    0, 7, 6, 5, 4, 3, 2, 1, 7, 6, 5, 4, 3, 2, 1, 0
+};
+static const int ilb[32] =
+{
+    2048, 2093, 2139, 2186, 2233, 2282, 2332,
+    2383, 2435, 2489, 2543, 2599, 2656, 2714,
+    2774, 2834, 2896, 2960, 3025, 3091, 3158,
+    3228, 3298, 3371, 3444, 3520, 3597, 3676,
+    3756, 3838, 3922, 4008
+};
+static const int qm4[16] =
+{
+         0, -20456, -12896, -8968,
+     -6288,  -4240,  -2584, -1200,
+     20456,  12896,   8968,  6288,
+      4240,   2584,   1200,     0
+};
+static const int qm2[4] =
 {
+    -7408,  -1616,   7408,   1616
+};
+static const int ihn[3] = {0, 1, 0};
+static const int ihp[3] = {0, 3, 2};
+static const int wh[3] = {0, -214, 798};
+static const int rh2[4] = {2, 1, 2, 1};
+
+static void encode_low_band(g722_band_t *s, uint8_t ilow[], const int xlow[], int len)
+{
+    int el;
+    int wd;
     int wd1;
     int wd2;
     int wd3;
+    int ril;
+    int dlow;
+    int step;
     int i;
+    int j;
 
-    /* Block 4, RECONS */
-    s->band[band].d[0] = d;
-    s->band[band].r[0] = saturate(s->band[band].s + d);
-
-    /* Block 4, PARREC */
-    s->band[band].p[0] = saturate(s->band[band].sz + d);
+    for (j = 0;  j < len;  j++)
+    {
+        /* Block 1L, SUBTRA */
+        el = saturate(xlow[j] - s->s);
 
-    /* Block 4, UPPOL2 */
-    for (i = 0;  i < 3;  i++)
-        s->band[band].sg[i] = s->band[band].p[i] >> 15;
-    wd1 = saturate(s->band[band].a[1] << 2);
+        /* Block 1L, QUANTL */
+        wd = (el >= 0)  ?  el  :  -(el + 1);
 
-    wd2 = (s->band[band].sg[0] == s->band[band].sg[1])  ?  -wd1  :  wd1;
-    if (wd2 > 32767)
-        wd2 = 32767;
-    wd3 = (wd2 >> 7) + ((s->band[band].sg[0] == s->band[band].sg[2])  ?  128  :  -128);
-    wd3 += (s->band[band].a[2]*32512) >> 15;
-    if (wd3 > 12288)
-        wd3 = 12288;
-    else if (wd3 < -12288)
-        wd3 = -12288;
-    s->band[band].ap[2] = wd3;
+        /* Find the first decision level above wd. The levels rise monotonically,
+           so a branch free binary search gets there in 5 steps, rather than
+           walking up through as many as 29 of them. */
+        i = 1;
+        for (step = 16;  step;  step >>= 1)
+            i += (wd >= ((q6[i + step - 1]*s->det) >> 12))  ?  step  :  0;
+        if (i > 30)
+            i = 30;
+        ilow[j] = (uint8_t) ((el < 0)  ?  iln[i]  :  ilp[i]);
 
-    /* Block 4, UPPOL1 */
-    s->band[band].sg[0] = s->band[band].p[0] >> 15;
-    s->band[band].sg[1] = s->band[band].p[1] >> 15;
-    wd1 = (s->band[band].sg[0] == s->band[band].sg[1])  ?  192  :  -192;
-    wd2 = (s->band[band].a[1]*32640) >> 15;
+        /* Block 2L, INVQAL */
+        ril = ilow[j] >> 2;
+        wd2 = qm4[ril];
+        dlow = (s->det*wd2) >> 15;
 
-    s->band[band].ap[1] = saturate(wd1 + wd2);
-    wd3 = saturate(15360 - s->band[band].ap[2]);
-    if (s->band[band].ap[1] > wd3)
-        s->band[band].ap[1] = wd3;
-    else if (s->band[band].ap[1] < -wd3)
-        s->band[band].ap[1] = -wd3;
+        /* Block 3L, LOGSCL */
+        wd = (s->nb*127) >> 7;
+        s->nb = wd + wl[rl42[ril]];
+        if (s->nb < 0)
+            s->nb = 0;
+        else if (s->nb > 18432)
+            s->nb = 18432;
 
-    /* Block 4, UPZERO */
-    wd1 = (d == 0)  ?  0  :  128;
-    s->band[band].sg[0] = d >> 15;
-    for (i = 1;  i < 7;  i++)
-    {
-        s->band[band].sg[i] = s->band[band].d[i] >> 15;
-        wd2 = (s->band[band].sg[i] == s->band[band].sg[0])  ?  wd1  :  -wd1;
-        wd3 = (s->band[band].b[i]*32640) >> 15;
-        s->band[band].bp[i] = saturate(wd2 + wd3);
-    }
+        /* Block 3L, SCALEL */
+        wd1 = (s->nb >> 6) & 31;
+        wd2 = 8 - (s->nb >> 11);
+        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+        s->det = wd3 << 2;
 
-    /* Block 4, DELAYA */
-    for (i = 6;  i > 0;  i--)
-    {
-        s->band[band].d[i] = s->band[band].d[i - 1];
-        s->band[band].b[i] = s->band[band].bp[i];
-    }
-    
-    for (i = 2;  i > 0;  i--)
-    {
-        s->band[band].r[i] = s->band[band].r[i - 1];
-        s->band[band].p[i] = s->band[band].p[i - 1];
-        s->band[band].a[i] = s->band[band].ap[i];
+        block4(s, dlow);
     }
+}
+/*- End of function --------------------------------------------------------*/
 
-    /* Block 4, FILTEP */
-    wd1 = saturate(s->band[band].r[1] + s->band[band].r[1]);
-    wd1 = (s->band[band].a[1]*wd1) >> 15;
-    wd2 = saturate(s->band[band].r[2] + s->band[band].r[2]);
-    wd2 = (s->band[band].a[2]*wd2) >> 15;
-    s->band[band].sp = saturate(wd1 + wd2);
+static void encode_high_band(g722_band_t *s, uint8_t ihigh[], const int xhigh[], int len)
+{
+    int eh;
+    int wd;
+    int wd1;
+    int wd2;
+    int wd3;
+    int mih;
+    int dhigh;
+    int j;
 
-    /* Block 4, FILTEZ */
-    s->band[band].sz = 0;
-    for (i = 6;  i > 0;  i--)
+    for (j = 0;  j < len;  j++)
     {
-        wd1 = saturate(s->band[band].d[i] + s->band[band].d[i]);
-        s->band[band].sz += (s->band[band].b[i]*wd1) >> 15;
-    }
-    s->band[band].sz = saturate(s->band[band].sz);
+        /* Block 1H, SUBTRA */
+        eh = saturate(xhigh[j] - s->s);
+
+        /* Block 1H, QUANTH */
+        wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+        wd1 = (564*s->det) >> 12;
+        mih = (wd >= wd1)  ?  2  :  1;
+        ihigh[j] = (uint8_t) ((eh < 0)  ?  ihn[mih]  :  ihp[mih]);
+
+        /* Block 2H, INVQAH */
+        wd2 = qm2[ihigh[j]];
+        dhigh = (s->det*wd2) >> 15;
+
+        /* Block 3H, LOGSCH */
+        wd = (s->nb*127) >> 7;
+        s->nb = wd + wh[rh2[ihigh[j]]];
+        if (s->nb < 0)
+            s->nb = 0;
+        else if (s->nb > 22528)
+            s->nb = 22528;
+
+        /* Block 3H, SCALEH */
+        wd1 = (s->nb >> 6) & 31;
+        wd2 = 10 - (s->nb >> 11);
+        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+        s->det = wd3 << 2;
 
-    /* Block 4, PREDIC */
-    s->band[band].s = saturate(s->band[band].sp + s->band[band].sz);
+        block4(s, dhigh);
+    }
 }
 /*- End of function --------------------------------------------------------*/
 
@@ -175,217 +243,106 @@ int g722_encode_release(g722_encode_state_t *s)
 
 int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[], int len)
 {
-    static const int q6[32] =
-    {
-           0,   35,   72,  110,  150,  190,  233,  276,
-         323,  370,  422,  473,  530,  587,  650,  714,
-         786,  858,  940, 1023, 1121, 1219, 1339, 1458,
-        1612, 1765, 1980, 2195, 2557, 2919,    0,    0
-    };
-    static const int iln[32] =
-    {
-         0, 63, 62, 31, 30, 29, 28, 27,
-        26, 25, 24, 23, 22, 21, 20, 19,
-        18, 17, 16, 15, 14, 13, 12, 11,
-        10,  9,  8,  7,  6,  5,  4,  0
-    };
-    static const int ilp[32] =
-    {
-         0, 61, 60, 59, 58, 57, 56, 55,
-        54, 53, 52, 51, 50, 49, 48, 47,
-        46, 45, 44, 43, 42, 41, 40, 39,
-        38, 37, 36, 35, 34, 33, 32,  0
-    };
-    static const int wl[8] =
-    {
-        -60, -30, 58, 172, 334, 538, 1198, 3042
-    };
-    static const int rl42[16] =
-    {
-        0, 7, 6, 5, 4, 3, 2, 1, 7, 6, 5, 4, 3, 2, 1, 0
-    };
-    static const int ilb[32] =
-    {
-        2048, 2093, 2139, 2186, 2233, 2282, 2332,
-        2383, 2435, 2489, 2543, 2599, 2656, 2714,
-        2774, 2834, 2896, 2960, 3025, 3091, 3158,
-        3228, 3298, 3371, 3444, 3520, 3597, 3676,
-        3756, 3838, 3922, 4008
-    };
-    static const int qm4[16] =
-    {
-             0, -20456, -12896, -8968,
-         -6288,  -4240,  -2584, -1200,
-         20456,  12896,   8968,  6288,
-          4240,   2584,   1200,     0
-    };
-    static const int qm2[4] =
-    {
-        -7408,  -1616,   7408,   1616
-    };
-    static const int qmf_coeffs[12] =
-    {
-           3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
-    };
-    static const int ihn[3] = {0, 1, 0};
-    static const int ihp[3] = {0, 3, 2};
-    static const int wh[3] = {0, -214, 798};
-    static const int rh2[4] = {2, 1, 2, 1};
-
-    int dlow;
-    int dhigh;
-    int el;
-    int wd;
-    int wd1;
-    int ril;
-    int wd2;
-    int il4;
-    int ih2;
-    int wd3;
-    int eh;
-    int mih;
+    /* Low and high band PCM from the QMF */
+    int xlow[G722_BLOCK_LEN];
+    int xhigh[G722_BLOCK_LEN];
+    uint8_t ilow[G722_BLOCK_LEN];
+    uint8_t ihigh[G722_BLOCK_LEN];
+    const int16_t *x;
+    int sum;
+    int diff;
+    int codes;
+    int n;
     int i;
     int j;
-    /* Low and high band PCM from the QMF */
-    int xlow;
-    int xhigh;
     int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
-    int ihigh;
-    int ilow;
     int code;
 
+    /* Without the QMF there is one code per sample. With it there is one per
+       pair of samples. */
+    codes = (s->itu_test_mode  ||  s->eight_k)  ?  len  :  len/2;
     g722_bytes = 0;
-    xhigh = 0;
-    for (j = 0;  j < len;  )
+    for (j = 0;  j < codes;  j += n)
     {
+        n = codes - j;
+        if (n > G722_BLOCK_LEN)
+            n = G722_BLOCK_LEN;
+
+        /* Split the block into the two sub-bands */
         if (s->itu_test_mode)
         {
-            xlow =
-            xhigh = amp[j++] >> 1;
+            for (i = 0;  i < n;  i++)
+            {
+                xlow[i] =
+                xhigh[i] = *amp++ >> 1;
+            }
+        }
+        else if (s->eight_k)
+        {
+            for (i = 0;  i < n;  i++)
+                xlow[i] = *amp++;
         }
         else
+        {
+            /* Apply the transmit QMF, discarding every other output */
+            for (i = 0;  i < n;  i++)
+            {
+                x = qmf_push(s->x, &s->ptr, amp[0], amp[1]);
+                amp += 2;
+                qmf_apply(x, &sum, &diff);
+                xlow[i] = sum >> 13;
+                xhigh[i] = diff >> 13;
+            }
+        }
+
+        /* Run each sub-band's ADPCM across the whole block */
+        encode_low_band(&s->band[0], ilow, xlow, n);
+        if (!s->eight_k)
+            encode_high_band(&s->band[1], ihigh, xhigh, n);
+
+        for (i = 0;  i < n;  i++)
         {
             if (s->eight_k)
             {
-                xlow = amp[j++];
+                /* Just leave the high bits as zero */
+                code = (0xC0 | ilow[i]) >> (8 - s->bits_per_sample);
             }
             else
             {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-    
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
+                code = ((ihigh[i] << 6) | ilow[i]) >> (8 - s->bits_per_sample);
+            }
+
+            if (s->packed)
+            {
+                /* Pack the code bits */
+                s->out_buffer |= (code << s->out_bits);
+                s->out_bits += s->bits_per_sample;
+                if (s->out_bits >= 8)
                 {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
+                    g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
+                    s->out_bits -= 8;
+                    s->out_buffer >>= 8;
                 }
-                xlow = (sumeven + sumodd) >> 13;
-                xhigh = (sumeven - sumodd) >> 13;
             }
-        }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
-
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
-
-        for (i = 1;  i < 30;  i++)
-        {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
-        }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
-
-        block4(s, 0, dlow);
-        
-        if (s->eight_k)
-        {
-            /* Just leave the high bits as zero */
-            code = (0xC0 | ilow) >> (8 - s->bits_per_sample);
-        }
-        else
-        {
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
-
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-            s->band[1].nb = wd + wh[ih2];
-            if (s->band[1].nb < 0)
-                s->band[1].nb = 0;
-            else if (s->band[1].nb > 22528)
-                s->band[1].nb = 22528;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
-
-            block4(s, 1, dhigh);
-            code = ((ihigh << 6) | ilow) >> (8 - s->bits_per_sample);
-        }
-
-        if (s->packed)
-        {
-            /* Pack the code bits */
-            s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
-            if (s->out_bits >= 8)
+            else
             {
-                g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
-                s->out_bits -= 8;
-                s->out_buffer >>= 8;
+                g722_data[g722_bytes++] = (uint8_t) code;
             }
         }
-        else
-        {
-            g722_data[g722_bytes++] = (uint8_t) code;
-        }
     }
     return g722_bytes;
 }
 /*- End of function --------------------------------------------------------*/
+
+int g722_encode_batch(g722_encode_state_t *s[], uint8_t *g722_data[], const int16_t *amp[], int channels, int len)
+{
+    int g722_bytes;
+    int i;
+
+    g722_bytes = 0;
+    for (i = 0;  i < channels;  i++)
+        g722_bytes = g722_encode(s[i], g722_data[i], amp[i], len);
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
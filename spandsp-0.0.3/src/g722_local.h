@@ -0,0 +1,267 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * g722_local.h - The ITU G.722 codec, parts common to the encoder and decoder.
+ *
+ * Written by Steve Underwood <steveu@coppice.org>
+ *
+ * Copyright (C) 2005 Steve Underwood
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * Based on a single channel 64kbps only G.722 codec which is:
+ *
+ *****    Copyright (c) CMU    1993      *****
+ * Computer Science, Speech Group
+ * Chengxiang Lu and Alex Hauptmann
+ */
+
+#if !defined(_G722_LOCAL_H_)
+#define _G722_LOCAL_H_
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* The number of codes the encoder and decoder process in each pass of a block.
+   Each band is run across a whole block before moving on to the other band, so
+   the band's state stays in the cache and the loops stay tight. */
+#define G722_BLOCK_LEN      160
+
+/* The QMF coefficients, interleaved to match the signal history. Applied to the 24
+   most recent samples, qmf_sum gives the sum of the even and odd tap accumulators,
+   and qmf_diff gives the difference. */
+static const int16_t qmf_sum[24] =
+{
+       3,  -11,  -11,   53,   12, -156,   32,  362, -210, -805,  951, 3876,
+    3876,  951, -805, -210,  362,   32, -156,   12,   53,  -11,  -11,    3
+};
+static const int16_t qmf_diff[24] =
+{
+      -3,  -11,   11,   53,  -12, -156,  -32,  362,  210, -805, -951, 3876,
+   -3876,  951,  805, -210, -362,   32,  156,   12,  -53,  -11,   11,    3
+};
+
+/*! Add a pair of samples to the QMF signal history.
+    \param x The signal history, which is held twice over.
+    \param ptr The current position in the history.
+    \param a The first (earlier) sample.
+    \param b The second (later) sample.
+    \return A pointer to the 24 most recent samples, oldest first. */
+static __inline__ const int16_t *qmf_push(int16_t x[], int *ptr, int16_t a, int16_t b)
+{
+    x[*ptr] =
+    x[*ptr + 24] = a;
+    x[*ptr + 1] =
+    x[*ptr + 25] = b;
+    if ((*ptr += 2) >= 24)
+        *ptr = 0;
+    return &x[*ptr];
+}
+/*- End of function --------------------------------------------------------*/
+
+/*! Apply the QMF to the 24 most recent samples.
+    \param x The signal history, oldest first.
+    \param sum The sum of the even and odd tap accumulators.
+    \param diff The even tap accumulator minus the odd tap accumulator. */
+static __inline__ void qmf_apply(const int16_t x[], int *sum, int *diff)
+{
+#if defined(__SSE2__)
+    __m128i x0;
+    __m128i x1;
+    __m128i x2;
+    __m128i vsum;
+    __m128i vdiff;
+
+    /* All the products fit comfortably in 32 bits, so pmaddwd does the work */
+    x0 = _mm_loadu_si128((const __m128i *) &x[0]);
+    x1 = _mm_loadu_si128((const __m128i *) &x[8]);
+    x2 = _mm_loadu_si128((const __m128i *) &x[16]);
+    vsum = _mm_add_epi32(_mm_madd_epi16(x0, _mm_loadu_si128((const __m128i *) &qmf_sum[0])),
+                         _mm_madd_epi16(x1, _mm_loadu_si128((const __m128i *) &qmf_sum[8])));
+    vsum = _mm_add_epi32(vsum, _mm_madd_epi16(x2, _mm_loadu_si128((const __m128i *) &qmf_sum[16])));
+    vdiff = _mm_add_epi32(_mm_madd_epi16(x0, _mm_loadu_si128((const __m128i *) &qmf_diff[0])),
+                          _mm_madd_epi16(x1, _mm_loadu_si128((const __m128i *) &qmf_diff[8])));
+    vdiff = _mm_add_epi32(vdiff, _mm_madd_epi16(x2, _mm_loadu_si128((const __m128i *) &qmf_diff[16])));
+    /* Reduce both accumulators together */
+    vsum = _mm_add_epi32(_mm_unpacklo_epi32(vsum, vdiff), _mm_unpackhi_epi32(vsum, vdiff));
+    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 8));
+    *sum = _mm_cvtsi128_si32(vsum);
+    *diff = _mm_cvtsi128_si32(_mm_srli_si128(vsum, 4));
+#else
+    int i;
+    int s;
+    int d;
+
+    s = 0;
+    d = 0;
+    for (i = 0;  i < 24;  i++)
+    {
+        s += x[i]*qmf_sum[i];
+        d += x[i]*qmf_diff[i];
+    }
+    *sum = s;
+    *diff = d;
+#endif
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ void block4(g722_band_t *s, int d)
+{
+    int wd1;
+    int wd2;
+    int wd3;
+    int ap1;
+    int ap2;
+    int sg1;
+    int sg2;
+#if defined(__SSE2__)
+    __m128i dv;
+    __m128i bv;
+    __m128i sg;
+    __m128i wd;
+    __m128i lo;
+    __m128i hi;
+#else
+    int i;
+#endif
+
+    /* Block 4, RECONS */
+    s->r[0] = saturate(s->s + d);
+
+    /* Block 4, PARREC */
+    s->p[0] = saturate(s->sz + d);
+
+    /* Block 4, UPPOL2 */
+    /* The sign comparisons are on noise-like data, so they are done with masks
+       rather than branches. sg1 and sg2 are 0 where the signs match p[0], and -1
+       where they differ. */
+    sg1 = (s->p[0] ^ s->p[1]) >> 15;
+    sg2 = (s->p[0] ^ s->p[2]) >> 15;
+    wd1 = saturate(s->a[1] << 2);
+    wd2 = (wd1 ^ ~sg1) - ~sg1;
+    if (wd2 > 32767)
+        wd2 = 32767;
+    wd3 = (wd2 >> 7) + ((128 ^ sg2) - sg2);
+    wd3 += (s->a[2]*32512) >> 15;
+    if (wd3 > 12288)
+        wd3 = 12288;
+    else if (wd3 < -12288)
+        wd3 = -12288;
+    ap2 = wd3;
+
+    /* Block 4, UPPOL1 */
+    wd1 = (192 ^ sg1) - sg1;
+    wd2 = (s->a[1]*32640) >> 15;
+    ap1 = saturate(wd1 + wd2);
+    wd3 = saturate(15360 - ap2);
+    if (ap1 > wd3)
+        ap1 = wd3;
+    else if (ap1 < -wd3)
+        ap1 = -wd3;
+
+#if defined(__SSE2__)
+    /* The six tap zero predictor is updated and applied eight 16 bit lanes at a time.
+       Lanes 0 and 7 of b[] are always zero, so they contribute nothing. */
+    dv = _mm_loadu_si128((const __m128i *) s->d);
+    bv = _mm_loadu_si128((const __m128i *) s->b);
+
+    /* Block 4, UPZERO */
+    sg = _mm_srai_epi16(_mm_xor_si128(dv, _mm_set1_epi16((int16_t) d)), 15);
+    wd = _mm_set1_epi16((d == 0)  ?  0  :  128);
+    wd = _mm_sub_epi16(_mm_xor_si128(wd, sg), sg);
+    /* (b*32640) >> 15 fits in 16 bits, so it can be pieced together from the high and
+       low halves of the product */
+    lo = _mm_mullo_epi16(bv, _mm_set1_epi16(32640));
+    hi = _mm_mulhi_epi16(bv, _mm_set1_epi16(32640));
+    lo = _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+    bv = _mm_and_si128(_mm_adds_epi16(wd, lo), _mm_set_epi16(0, -1, -1, -1, -1, -1, -1, 0));
+    _mm_storeu_si128((__m128i *) s->b, bv);
+
+    /* Block 4, DELAYA */
+    dv = _mm_slli_si128(_mm_insert_epi16(dv, d, 0), 2);
+    _mm_storeu_si128((__m128i *) s->d, dv);
+    s->r[2] = s->r[1];
+    s->r[1] = s->r[0];
+    s->p[2] = s->p[1];
+    s->p[1] = s->p[0];
+    s->a[2] = ap2;
+    s->a[1] = ap1;
+
+    /* Block 4, FILTEP */
+    wd1 = saturate(s->r[1] + s->r[1]);
+    wd1 = (s->a[1]*wd1) >> 15;
+    wd2 = saturate(s->r[2] + s->r[2]);
+    wd2 = (s->a[2]*wd2) >> 15;
+    s->sp = saturate(wd1 + wd2);
+
+    /* Block 4, FILTEZ */
+    /* Each product is shifted before the products are summed, so they need their full
+       32 bits */
+    dv = _mm_adds_epi16(dv, dv);
+    lo = _mm_mullo_epi16(bv, dv);
+    hi = _mm_mulhi_epi16(bv, dv);
+    wd = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15),
+                       _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+    wd = _mm_add_epi32(wd, _mm_srli_si128(wd, 8));
+    wd = _mm_add_epi32(wd, _mm_srli_si128(wd, 4));
+    s->sz = saturate(_mm_cvtsi128_si32(wd));
+#else
+    /* Block 4, UPZERO */
+    wd1 = (d == 0)  ?  0  :  128;
+    for (i = 1;  i < 7;  i++)
+    {
+        sg1 = (s->d[i] ^ d) >> 15;
+        wd2 = (wd1 ^ sg1) - sg1;
+        wd3 = (s->b[i]*32640) >> 15;
+        s->b[i] = saturate(wd2 + wd3);
+    }
+
+    /* Block 4, DELAYA */
+    s->d[0] = d;
+    for (i = 6;  i > 0;  i--)
+        s->d[i] = s->d[i - 1];
+    s->r[2] = s->r[1];
+    s->r[1] = s->r[0];
+    s->p[2] = s->p[1];
+    s->p[1] = s->p[0];
+    s->a[2] = ap2;
+    s->a[1] = ap1;
+
+    /* Block 4, FILTEP */
+    wd1 = saturate(s->r[1] + s->r[1]);
+    wd1 = (s->a[1]*wd1) >> 15;
+    wd2 = saturate(s->r[2] + s->r[2]);
+    wd2 = (s->a[2]*wd2) >> 15;
+    s->sp = saturate(wd1 + wd2);
+
+    /* Block 4, FILTEZ */
+    wd3 = 0;
+    for (i = 6;  i > 0;  i--)
+    {
+        wd1 = saturate(s->d[i] + s->d[i]);
+        wd3 += (s->b[i]*wd1) >> 15;
+    }
+    s->sz = saturate(wd3);
+#endif
+
+    /* Block 4, PREDIC */
+    s->s = saturate(s->sp + s->sz);
+}
+/*- End of function --------------------------------------------------------*/
+
+#endif
+/*- End of file ------------------------------------------------------------*/
@@ -66,6 +66,11 @@
 #if defined(HAVE_MATH_H)
 #include <math.h>
 #endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/dc_restore.h"
@@ -1175,4 +1180,953 @@ int g726_encode(g726_state_t *s,
     return g726_bytes;
 }
 /*- End of function --------------------------------------------------------*/
+
+/*
+ * The bank functions run a number of G.726 channels in lockstep. Each sample
+ * is processed in three passes over the channels:
+ *  - the predictor, the step size and, when encoding, the quantizer.
+ *  - the table lookups for the codes.
+ *  - reconstruction of the signal, and adaption.
+ * With SSE2 or AVX2 the first and last passes work on a vector of channels at
+ * a time, in 32 bit lanes. Otherwise they do the same as the single channel
+ * code, a channel at a time.
+ */
+#define G726_BANK_NUM_ARRAYS    33
+
+#if defined(__AVX2__)  ||  defined(__SSE2__)
+#if defined(__AVX2__)
+#define G726_LANES      8
+typedef __m256i g726_vec_t;
+typedef __m256 g726_vecf_t;
+#define vload(p)        _mm256_loadu_si256((const __m256i *) (p))
+#define vstore(p, x)    _mm256_storeu_si256((__m256i *) (p), x)
+#define vset1           _mm256_set1_epi32
+#define vzero           _mm256_setzero_si256
+#define vadd            _mm256_add_epi32
+#define vsub            _mm256_sub_epi32
+#define vand            _mm256_and_si256
+#define vandnot         _mm256_andnot_si256
+#define vor             _mm256_or_si256
+#define vxor            _mm256_xor_si256
+#define vsrai           _mm256_srai_epi32
+#define vsrli           _mm256_srli_epi32
+#define vslli           _mm256_slli_epi32
+#define vsra(x, n)      _mm256_sra_epi32(x, _mm_cvtsi32_si128(n))
+#define vcmpeq          _mm256_cmpeq_epi32
+#define vcmpgt          _mm256_cmpgt_epi32
+#define vmadd16         _mm256_madd_epi16
+#define vcvtf           _mm256_cvtepi32_ps
+#define vcvti           _mm256_cvttps_epi32
+#define vmulf           _mm256_mul_ps
+#define vasf            _mm256_castsi256_ps
+#define vasi            _mm256_castps_si256
+#else
+#define G726_LANES      4
+typedef __m128i g726_vec_t;
+typedef __m128 g726_vecf_t;
+#define vload(p)        _mm_loadu_si128((const __m128i *) (p))
+#define vstore(p, x)    _mm_storeu_si128((__m128i *) (p), x)
+#define vset1           _mm_set1_epi32
+#define vzero           _mm_setzero_si128
+#define vadd            _mm_add_epi32
+#define vsub            _mm_sub_epi32
+#define vand            _mm_and_si128
+#define vandnot         _mm_andnot_si128
+#define vor             _mm_or_si128
+#define vxor            _mm_xor_si128
+#define vsrai           _mm_srai_epi32
+#define vsrli           _mm_srli_epi32
+#define vslli           _mm_slli_epi32
+#define vsra(x, n)      _mm_sra_epi32(x, _mm_cvtsi32_si128(n))
+#define vcmpeq          _mm_cmpeq_epi32
+#define vcmpgt          _mm_cmpgt_epi32
+#define vmadd16         _mm_madd_epi16
+#define vcvtf           _mm_cvtepi32_ps
+#define vcvti           _mm_cvttps_epi32
+#define vmulf           _mm_mul_ps
+#define vasf            _mm_castsi128_ps
+#define vasi            _mm_castps_si128
+#endif
+
+#define vones()         vcmpeq(vzero(), vzero())
+#define vsel(m, a, b)   vor(vand(m, a), vandnot(m, b))
+#define vcmplt(a, b)    vcmpgt(b, a)
+#define vmax(a, b)      vsel(vcmpgt(a, b), a, b)
+#define vmin(a, b)      vsel(vcmplt(a, b), a, b)
+#define vabs(x)         vsub(vxor(x, vsrai(x, 31)), vsrai(x, 31))
+/* Wrap to 16 bits, like storing in an int16_t */
+#define vwrap16(x)      vsrai(vslli(x, 16), 16)
+/* top_bit() of a positive value, from the exponent of it as a float */
+#define vtop_bit(x)     vsub(vsrli(vasi(vcvtf(x)), 23), vset1(127))
+/* 2^n as a float, for -126 <= n <= 127 */
+#define vpow2(n)        vasf(vslli(vadd(n, vset1(127)), 23))
+/* x shifted left by n, or right by -n, for 0 <= x < 2^24. This is exact, as
+   long as no more than 24 significant bits are kept. */
+#define vshift(x, n)    vcvti(vmulf(vcvtf(x), vpow2(n)))
+
+/*
+ * fmult() for a vector of channels. The shifts in G.726 are by a different
+ * amount in each lane, so they are done as multiplies by powers of 2 in
+ * single precision floating point.
+ */
+static __inline__ g726_vec_t fmult_vec(g726_vec_t an, g726_vec_t srn)
+{
+    g726_vec_t pos;
+    g726_vec_t zero;
+    g726_vec_t anmag;
+    g726_vec_t anexp;
+    g726_vec_t anmant;
+    g726_vec_t wanexp;
+    g726_vec_t wanmant;
+    g726_vec_t retval;
+    g726_vec_t sign;
+
+    pos = vcmpgt(an, vzero());
+    anmag = vsel(pos, an, vand(vsub(vzero(), an), vset1(0x1FFF)));
+    zero = vcmpeq(anmag, vzero());
+    /* top_bit(anmag) - 5, or -6 for zero */
+    anexp = vsel(zero, vset1(-6), vsub(vtop_bit(anmag), vset1(5)));
+    anmant = vsel(zero, vset1(32), vshift(anmag, vsub(vzero(), anexp)));
+    wanexp = vsub(vadd(anexp, vand(vsrai(srn, 6), vset1(0xF))), vset1(13));
+    /* Both values are less than 64, so a 16 bit multiply will do */
+    wanmant = vsrai(vadd(vmadd16(anmant, vand(srn, vset1(0x3F))), vset1(0x30)), 4);
+    retval = vand(vshift(wanmant, wanexp), vset1(0x7FFF));
+    sign = vsrai(vxor(an, srn), 31);
+    return vsub(vxor(retval, sign), sign);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_front(g726_bank_state_t *s, int encode)
+{
+    g726_vec_t sezi;
+    g726_vec_t sei;
+    g726_vec_t se;
+    g726_vec_t y;
+    g726_vec_t yu;
+    g726_vec_t ap;
+    g726_vec_t dif;
+    g726_vec_t d;
+    g726_vec_t dqm;
+    g726_vec_t exp;
+    g726_vec_t dln;
+    g726_vec_t i;
+    g726_vec_t neg;
+    g726_vec_t code;
+    int size;
+    int c;
+    int k;
+
+    size = (s->quantizer_states - 1) >> 1;
+    for (c = 0;  c < s->stride;  c += G726_LANES)
+    {
+        /* predictor_zero() and predictor_pole() */
+        sezi = fmult_vec(vsrai(vload(s->b[0] + c), 2), vload(s->dq[0] + c));
+        for (k = 1;  k < 6;  k++)
+            sezi = vadd(sezi, fmult_vec(vsrai(vload(s->b[k] + c), 2), vload(s->dq[k] + c)));
+        sezi = vwrap16(sezi);
+        sei = vadd(fmult_vec(vsrai(vload(s->a[1] + c), 2), vload(s->sr[1] + c)),
+                   fmult_vec(vsrai(vload(s->a[0] + c), 2), vload(s->sr[0] + c)));
+        sei = vwrap16(vadd(sezi, vwrap16(sei)));
+        vstore(s->sezi + c, sezi);
+        vstore(s->sei + c, sei);
+
+        /* step_size(). ap is never negative, so a 16 bit multiply will do. */
+        yu = vload(s->yu + c);
+        ap = vload(s->ap + c);
+        y = vsrai(vload(s->yl + c), 6);
+        dif = vsub(yu, y);
+        d = vmadd16(dif, vsrai(ap, 2));
+        y = vadd(y, vsrai(vadd(d, vand(vsrai(dif, 31), vset1(0x3F))), 6));
+        y = vsel(vcmplt(ap, vset1(256)), y, yu);
+        vstore(s->y + c, y);
+
+        if (encode)
+        {
+            /* quantize() */
+            se = vsrai(sei, 1);
+            d = vwrap16(vsub(vload(s->sl + c), se));
+            dqm = vsrli(vabs(d), 1);
+            exp = vadd(vtop_bit(vmax(dqm, vset1(1))), vadd(vset1(1), vcmpeq(dqm, vzero())));
+            dqm = vabs(d);
+            dln = vadd(vslli(exp, 7), vand(vshift(dqm, vsub(vset1(7), exp)), vset1(0x7F)));
+            dln = vwrap16(vsub(dln, vsrai(y, 2)));
+            i = vset1(size);
+            for (k = 0;  k < size;  k++)
+                i = vadd(i, vcmpgt(vset1(s->qtab[k]), dln));
+            neg = vsrai(d, 31);
+            code = vsel(neg, vsub(vset1((size << 1) + 1), i), i);
+            if ((s->quantizer_states & 1))
+                code = vsel(vandnot(neg, vcmpeq(i, vzero())), vset1(s->quantizer_states), code);
+            vstore(s->code + c, code);
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_back(g726_bank_state_t *s)
+{
+    g726_vec_t ones;
+    g726_vec_t code;
+    g726_vec_t y;
+    g726_vec_t se;
+    g726_vec_t dql;
+    g726_vec_t dq;
+    g726_vec_t dqneg;
+    g726_vec_t sr;
+    g726_vec_t dqsez;
+    g726_vec_t pk0;
+    g726_vec_t mag;
+    g726_vec_t magnz;
+    g726_vec_t yl;
+    g726_vec_t ylint;
+    g726_vec_t thr;
+    g726_vec_t tr;
+    g726_vec_t yu;
+    g726_vec_t pks1_zero;
+    g726_vec_t nz;
+    g726_vec_t a0;
+    g726_vec_t a2p;
+    g726_vec_t fa1;
+    g726_vec_t x;
+    g726_vec_t pks2_zero;
+    g726_vec_t a1ul;
+    g726_vec_t bi;
+    g726_vec_t exp;
+    g726_vec_t td;
+    g726_vec_t fi;
+    g726_vec_t dms;
+    g726_vec_t dml;
+    g726_vec_t ap;
+    g726_vec_t fast;
+    int sign;
+    int dqmask;
+    int bshift;
+    int c;
+    int i;
+
+    sign = 1 << (s->bits_per_sample - 1);
+    /* Distinguish 40Kbps mode from the others */
+    dqmask = (s->bits_per_sample == 5)  ?  0x7FFF  :  0x3FFF;
+    bshift = (s->bits_per_sample == 5)  ?  9  :  8;
+    ones = vones();
+    for (c = 0;  c < s->stride;  c += G726_LANES)
+    {
+        code = vload(s->code + c);
+        y = vload(s->y + c);
+        se = vsrai(vload(s->sei + c), 1);
+
+        /* reconstruct() */
+        dql = vadd(vload(s->dqln + c), vsrai(y, 2));
+        dq = vshift(vadd(vset1(128), vand(dql, vset1(127))), vsub(vand(vsrai(dql, 7), vset1(15)), vset1(7)));
+        dq = vandnot(vsrai(dql, 31), dq);
+        dq = vsub(dq, vand(vcmpgt(vand(code, vset1(sign)), vzero()), vset1(0x8000)));
+
+        /* Reconstruct the signal, and the pole prediction difference */
+        dqneg = vsrai(dq, 31);
+        sr = vwrap16(vsel(dqneg, vsub(se, vand(dq, vset1(dqmask))), vadd(se, dq)));
+        dqsez = vwrap16(vsub(vadd(sr, vsrai(vload(s->sezi + c), 1)), se));
+        vstore(s->recon + c, sr);
+
+        /* update() */
+        pk0 = vsrli(dqsez, 31);
+        mag = vand(dq, vset1(0x7FFF));
+        magnz = vandnot(vcmpeq(mag, vzero()), ones);
+
+        /* TRANS */
+        yl = vload(s->yl + c);
+        ylint = vsrai(yl, 15);
+        thr = vshift(vadd(vand(vsrai(yl, 10), vset1(0x1F)), vset1(32)), vmin(ylint, vset1(9)));
+        thr = vsel(vcmpgt(ylint, vset1(9)), vset1(31 << 10), thr);
+        thr = vsrai(vadd(thr, vsrai(thr, 1)), 1);
+        tr = vandnot(vcmpeq(vload(s->td + c), vzero()), vcmpgt(mag, thr));
+
+        /* FUNCTW & FILTD & DELAY, LIMB */
+        yu = vadd(y, vsrai(vsub(vload(s->wi + c), y), 5));
+        yu = vmin(vmax(yu, vset1(544)), vset1(5120));
+        vstore(s->yu + c, yu);
+        /* FILTE & DELAY */
+        vstore(s->yl + c, vadd(yl, vadd(yu, vsrai(vsub(vzero(), yl), 6))));
+
+        /* UPA2. These masks are set where pks1 and pks2 (pk0 ^ pk[1]) are zero. */
+        pks1_zero = vcmpeq(vxor(pk0, vload(s->pk[0] + c)), vzero());
+        nz = vandnot(vcmpeq(dqsez, vzero()), ones);
+        a0 = vload(s->a[0] + c);
+        a2p = vload(s->a[1] + c);
+        a2p = vsub(a2p, vsrai(a2p, 7));
+        fa1 = vsel(pks1_zero, vsub(vzero(), a0), a0);
+        x = vsrai(fa1, 5);
+        x = vsel(vcmplt(fa1, vset1(-8191)), vset1(-0x100), x);
+        x = vsel(vcmpgt(fa1, vset1(8191)), vset1(0xFF), x);
+        x = vadd(a2p, x);
+        /* LIMC */
+        pks2_zero = vcmpeq(vxor(pk0, vload(s->pk[1] + c)), vzero());
+        fa1 = vadd(x, vsel(pks2_zero, vset1(0x80), vset1(-0x80)));
+        fa1 = vsel(vcmplt(x, vsel(pks2_zero, vset1(12160), vset1(12416))), fa1, vset1(12288));
+        fa1 = vsel(vcmpgt(x, vsel(pks2_zero, vset1(-12416), vset1(-12160))), fa1, vset1(-12288));
+        a2p = vsel(nz, fa1, a2p);
+        /* TRIGB & DELAY */
+        vstore(s->a[1] + c, vandnot(tr, a2p));
+
+        /* UPA1 */
+        a0 = vsub(a0, vsrai(a0, 8));
+        a0 = vadd(a0, vand(nz, vsel(pks1_zero, vset1(192), vset1(-192))));
+        /* LIMD */
+        a1ul = vsub(vset1(15360), a2p);
+        a0 = vmax(vmin(a0, a1ul), vsub(vzero(), a1ul));
+        vstore(s->a[0] + c, vandnot(tr, a0));
+
+        /* UPB */
+        for (i = 0;  i < 6;  i++)
+        {
+            bi = vload(s->b[i] + c);
+            bi = vsub(bi, vsra(bi, bshift));
+            x = vcmpgt(vxor(dq, vload(s->dq[i] + c)), vset1(-1));
+            bi = vadd(bi, vand(magnz, vsel(x, vset1(128), vset1(-128))));
+            vstore(s->b[i] + c, vandnot(tr, vwrap16(bi)));
+        }
+
+        /* FLOAT A */
+        x = vor(mag, vandnot(magnz, vset1(1)));
+        exp = vadd(vtop_bit(x), vset1(1));
+        x = vadd(vslli(exp, 6), vshift(x, vsub(vset1(6), exp)));
+        x = vsub(x, vand(dqneg, vset1(0x400)));
+        x = vsel(magnz, x, vsel(dqneg, vset1(-0x3E0), vset1(0x20)));
+        vstore(s->dq[5] + c, x);
+
+        /* FLOAT B */
+        mag = vabs(sr);
+        x = vor(mag, vand(vcmpeq(mag, vzero()), vset1(1)));
+        exp = vadd(vtop_bit(x), vset1(1));
+        x = vadd(vslli(exp, 6), vshift(x, vsub(vset1(6), exp)));
+        x = vsub(x, vand(vsrai(sr, 31), vset1(0x400)));
+        x = vsel(vcmpeq(sr, vzero()), vset1(0x20), x);
+        x = vsel(vcmpeq(sr, vset1(-32768)), vset1(-0x3E0), x);
+        vstore(s->sr[1] + c, x);
+
+        /* DELAY A */
+        vstore(s->pk[1] + c, pk0);
+
+        /* TONE */
+        td = vandnot(tr, vcmplt(a2p, vset1(-11776)));
+        vstore(s->td + c, vsrli(td, 31));
+
+        /* FILTA, FILTB */
+        fi = vload(s->fi + c);
+        dms = vload(s->dms + c);
+        dms = vwrap16(vadd(dms, vsrai(vsub(fi, dms), 5)));
+        vstore(s->dms + c, dms);
+        dml = vload(s->dml + c);
+        dml = vwrap16(vadd(dml, vsrai(vsub(vwrap16(vslli(fi, 2)), dml), 7)));
+        vstore(s->dml + c, dml);
+
+        /* SUBTC, and the adaption speed */
+        fast = vor(vcmplt(y, vset1(1536)), td);
+        fast = vor(fast, vandnot(vcmplt(vabs(vsub(vslli(dms, 2), dml)), vsrai(dml, 3)), ones));
+        ap = vload(s->ap + c);
+        ap = vsel(fast, vadd(ap, vsrai(vsub(vset1(0x200), ap), 4)), vadd(ap, vsrai(vsub(vzero(), ap), 4)));
+        vstore(s->ap + c, vsel(tr, vset1(256), vwrap16(ap)));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+#else
+#define G726_LANES      1
+
+static __inline__ int bank_step_size(g726_bank_state_t *s, int c)
+{
+    int y;
+    int dif;
+    int al;
+
+    if (s->ap[c] >= 256)
+        return s->yu[c];
+    y = s->yl[c] >> 6;
+    dif = s->yu[c] - y;
+    al = s->ap[c] >> 2;
+    if (dif > 0)
+        y += (dif*al) >> 6;
+    else if (dif < 0)
+        y += (dif*al + 0x3F) >> 6;
+    return y;
+}
+/*- End of function --------------------------------------------------------*/
+
+/*
+ * update() for one channel of a bank. The new dq[0], sr[0] and pk[0] values
+ * are written to dq[5], sr[1] and pk[1], and bank_shift() then moves the
+ * delay lines along for all the channels at once.
+ */
+static void bank_update(g726_bank_state_t *s,
+                        int c,
+                        int y,
+                        int wi,
+                        int fi,
+                        int dq,
+                        int sr,
+                        int dqsez)
+{
+    int16_t mag;
+    int16_t exp;
+    int16_t a2p;
+    int16_t a1ul;
+    int16_t pks1;
+    int16_t fa1;
+    int16_t ylint;
+    int16_t dqthr;
+    int16_t ylfrac;
+    int16_t thr;
+    int16_t pk0;
+    int16_t a0;
+    int16_t bi;
+    int16_t yu;
+    int i;
+    int tr;
+
+    a2p = 0;
+    pk0 = (dqsez < 0)  ?  1  :  0;
+
+    mag = (int16_t) (dq & 0x7FFF);
+    /* TRANS */
+    ylint = (int16_t) (s->yl[c] >> 15);
+    ylfrac = (int16_t) ((s->yl[c] >> 10) & 0x1F);
+    thr = (ylint > 9)  ?  (31 << 10)  :  ((32 + ylfrac) << ylint);
+    dqthr = (thr + (thr >> 1)) >> 1;
+    tr = (s->td[c]  &&  mag > dqthr);
+
+    /* FUNCTW & FILTD & DELAY, LIMB */
+    yu = y + ((wi - y) >> 5);
+    if (yu < 544)
+        yu = 544;
+    else if (yu > 5120)
+        yu = 5120;
+    s->yu[c] = yu;
+    /* FILTE & DELAY */
+    s->yl[c] += s->yu[c] + ((-s->yl[c]) >> 6);
+
+    if (tr)
+    {
+        s->a[0][c] = 0;
+        s->a[1][c] = 0;
+        for (i = 0;  i < 6;  i++)
+            s->b[i][c] = 0;
+    }
+    else
+    {
+        /* UPA2 */
+        pks1 = pk0 ^ s->pk[0][c];
+        a0 = (int16_t) s->a[0][c];
+        a2p = (int16_t) (s->a[1][c] - (s->a[1][c] >> 7));
+        if (dqsez != 0)
+        {
+            fa1 = (pks1)  ?  a0  :  -a0;
+            if (fa1 < -8191)
+                a2p -= 0x100;
+            else if (fa1 > 8191)
+                a2p += 0xFF;
+            else
+                a2p += fa1 >> 5;
+
+            if (pk0 ^ s->pk[1][c])
+            {
+                /* LIMC */
+                if (a2p <= -12160)
+                    a2p = -12288;
+                else if (a2p >= 12416)
+                    a2p = 12288;
+                else
+                    a2p -= 0x80;
+            }
+            else if (a2p <= -12416)
+                a2p = -12288;
+            else if (a2p >= 12160)
+                a2p = 12288;
+            else
+                a2p += 0x80;
+        }
+        /* TRIGB & DELAY */
+        s->a[1][c] = a2p;
+
+        /* UPA1 */
+        a0 -= a0 >> 8;
+        if (dqsez != 0)
+            a0 += (pks1 == 0)  ?  192  :  -192;
+        /* LIMD */
+        a1ul = 15360 - a2p;
+        if (a0 < -a1ul)
+            a0 = -a1ul;
+        else if (a0 > a1ul)
+            a0 = a1ul;
+        s->a[0][c] = a0;
+
+        /* UPB */
+        for (i = 0;  i < 6;  i++)
+        {
+            bi = (int16_t) s->b[i][c];
+            bi -= bi >> ((s->bits_per_sample == 5)  ?  9  :  8);
+            if (mag)
+                bi += ((dq ^ s->dq[i][c]) >= 0)  ?  128  :  -128;
+            s->b[i][c] = bi;
+        }
+    }
+
+    /* FLOAT A */
+    if (mag == 0)
+    {
+        s->dq[5][c] = (dq >= 0)  ?  0x20  :  (int16_t) 0xFC20;
+    }
+    else
+    {
+        exp = (int16_t) (top_bit(mag) + 1);
+        s->dq[5][c] = (int16_t) ((dq >= 0)
+                                 ?  ((exp << 6) + ((mag << 6) >> exp))
+                                 :  ((exp << 6) + ((mag << 6) >> exp) - 0x400));
+    }
+
+    /* FLOAT B */
+    if (sr == 0)
+    {
+        s->sr[1][c] = 0x20;
+    }
+    else if (sr > 0)
+    {
+        exp = (int16_t) (top_bit(sr) + 1);
+        s->sr[1][c] = (int16_t) ((exp << 6) + ((sr << 6) >> exp));
+    }
+    else if (sr > -32768)
+    {
+        mag = (int16_t) -sr;
+        exp = (int16_t) (top_bit(mag) + 1);
+        s->sr[1][c] = (int16_t) ((exp << 6) + ((mag << 6) >> exp) - 0x400);
+    }
+    else
+    {
+        s->sr[1][c] = (int16_t) 0xFC20;
+    }
+
+    /* DELAY A */
+    s->pk[1][c] = pk0;
+
+    /* TONE */
+    s->td[c] = (!tr  &&  a2p < -11776);
+
+    /* FILTA, FILTB */
+    s->dms[c] = (int16_t) (s->dms[c] + ((fi - s->dms[c]) >> 5));
+    s->dml[c] = (int16_t) (s->dml[c] + (((int16_t) (fi << 2) - s->dml[c]) >> 7));
+
+    if (tr)
+        s->ap[c] = 256;
+    else if (y < 1536  ||  s->td[c]  ||  abs((s->dms[c] << 2) - s->dml[c]) >= (s->dml[c] >> 3))
+        s->ap[c] = (int16_t) (s->ap[c] + ((0x200 - s->ap[c]) >> 4));
+    else
+        s->ap[c] = (int16_t) (s->ap[c] + ((-s->ap[c]) >> 4));
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_front(g726_bank_state_t *s, int encode)
+{
+    int16_t sezi;
+    int16_t sepi;
+    int16_t d;
+    int c;
+    int i;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        sezi = fmult(s->b[0][c] >> 2, s->dq[0][c]);
+        for (i = 1;  i < 6;  i++)
+            sezi += fmult(s->b[i][c] >> 2, s->dq[i][c]);
+        sepi = fmult(s->a[1][c] >> 2, s->sr[1][c]) + fmult(s->a[0][c] >> 2, s->sr[0][c]);
+        s->sezi[c] = sezi;
+        s->sei[c] = (int16_t) (sezi + sepi);
+        s->y[c] = bank_step_size(s, c);
+        if (encode)
+        {
+            d = s->sl[c] - (int16_t) (s->sei[c] >> 1);
+            s->code[c] = quantize(d, s->y[c], s->qtab, s->quantizer_states);
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_back(g726_bank_state_t *s)
+{
+    int16_t se;
+    int16_t sr;
+    int16_t dq;
+    int16_t dqsez;
+    int sign;
+    int c;
+
+    sign = 1 << (s->bits_per_sample - 1);
+    for (c = 0;  c < s->channels;  c++)
+    {
+        dq = reconstruct(s->code[c] & sign, s->dqln[c], s->y[c]);
+        se = (int16_t) (s->sei[c] >> 1);
+        if (dq < 0)
+            sr = se - (dq & ((s->bits_per_sample == 5)  ?  0x7FFF  :  0x3FFF));
+        else
+            sr = se + dq;
+        dqsez = sr + (s->sezi[c] >> 1) - se;
+        s->recon[c] = sr;
+        bank_update(s, c, s->y[c], s->wi[c], s->fi[c], dq, sr, dqsez);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+static void bank_lookup(g726_bank_state_t *s)
+{
+    int code;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        code = s->code[c];
+        s->dqln[c] = s->dqlntab[code];
+        s->wi[c] = s->witab[code];
+        s->fi[c] = s->fitab[code];
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_shift(g726_bank_state_t *s)
+{
+    int32_t *x;
+    int i;
+
+    x = s->dq[5];
+    for (i = 5;  i > 0;  i--)
+        s->dq[i] = s->dq[i - 1];
+    s->dq[0] = x;
+    x = s->sr[1];
+    s->sr[1] = s->sr[0];
+    s->sr[0] = x;
+    x = s->pk[1];
+    s->pk[1] = s->pk[0];
+    s->pk[0] = x;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_init_channel(g726_bank_state_t *s, int c)
+{
+    int i;
+
+    s->yl[c] = 34816;
+    s->yu[c] = 544;
+    s->dms[c] = 0;
+    s->dml[c] = 0;
+    s->ap[c] = 0;
+    for (i = 0;  i < 2;  i++)
+    {
+        s->a[i][c] = 0;
+        s->pk[i][c] = 0;
+        s->sr[i][c] = 32;
+    }
+    for (i = 0;  i < 6;  i++)
+    {
+        s->b[i][c] = 0;
+        s->dq[i][c] = 32;
+    }
+    s->td[c] = FALSE;
+}
+/*- End of function --------------------------------------------------------*/
+
+g726_bank_state_t *g726_bank_init(g726_bank_state_t *s, int channels, int bit_rate, int ext_coding, int packing)
+{
+    int32_t *x;
+    int alloced;
+    int i;
+
+    if (bit_rate != 16000  &&  bit_rate != 24000  &&  bit_rate != 32000  &&  bit_rate != 40000)
+        return NULL;
+    if (channels <= 0)
+        return NULL;
+    alloced = FALSE;
+    if (s == NULL)
+    {
+        if ((s = (g726_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+        alloced = TRUE;
+    }
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    /* Round up to whole vectors, so the predictor never needs a scalar tail */
+    s->stride = (channels + G726_LANES - 1)/G726_LANES*G726_LANES;
+    if ((x = (int32_t *) malloc(G726_BANK_NUM_ARRAYS*s->stride*sizeof(int32_t))) == NULL)
+    {
+        if (alloced)
+            free(s);
+        return NULL;
+    }
+    memset(x, 0, G726_BANK_NUM_ARRAYS*s->stride*sizeof(int32_t));
+    if ((s->bs = (bitstream_state_t *) malloc(channels*sizeof(bitstream_state_t))) == NULL)
+    {
+        free(x);
+        if (alloced)
+            free(s);
+        return NULL;
+    }
+    s->yl = x;
+    s->yu = (x += s->stride);
+    s->dms = (x += s->stride);
+    s->dml = (x += s->stride);
+    s->ap = (x += s->stride);
+    for (i = 0;  i < 2;  i++)
+    {
+        s->a[i] = (x += s->stride);
+        s->pk[i] = (x += s->stride);
+        s->sr[i] = (x += s->stride);
+    }
+    for (i = 0;  i < 6;  i++)
+    {
+        s->b[i] = (x += s->stride);
+        s->dq[i] = (x += s->stride);
+    }
+    s->td = (x += s->stride);
+    s->sl = (x += s->stride);
+    s->code = (x += s->stride);
+    s->y = (x += s->stride);
+    s->sezi = (x += s->stride);
+    s->sei = (x += s->stride);
+    s->dqln = (x += s->stride);
+    s->wi = (x += s->stride);
+    s->fi = (x += s->stride);
+    s->recon = (x += s->stride);
+
+    s->rate = bit_rate;
+    s->ext_coding = ext_coding;
+    s->packing = packing;
+    switch (bit_rate)
+    {
+    case 16000:
+        s->dqlntab = g726_16_dqlntab;
+        s->witab = g726_16_witab;
+        s->fitab = g726_16_fitab;
+        s->qtab = qtab_726_16;
+        s->quantizer_states = 4;
+        s->bits_per_sample = 2;
+        break;
+    case 24000:
+        s->dqlntab = g726_24_dqlntab;
+        s->witab = g726_24_witab;
+        s->fitab = g726_24_fitab;
+        s->qtab = qtab_726_24;
+        s->quantizer_states = 7;
+        s->bits_per_sample = 3;
+        break;
+    case 32000:
+    default:
+        s->dqlntab = g726_32_dqlntab;
+        s->witab = g726_32_witab;
+        s->fitab = g726_32_fitab;
+        s->qtab = qtab_726_32;
+        s->quantizer_states = 15;
+        s->bits_per_sample = 4;
+        break;
+    case 40000:
+        s->dqlntab = g726_40_dqlntab;
+        s->witab = g726_40_witab;
+        s->fitab = g726_40_fitab;
+        s->qtab = qtab_726_40;
+        s->quantizer_states = 31;
+        s->bits_per_sample = 5;
+        break;
+    }
+    /* The padding lanes are initialised too, so the vector code only ever sees
+       sane values. */
+    for (i = 0;  i < s->stride;  i++)
+        bank_init_channel(s, i);
+    for (i = 0;  i < s->channels;  i++)
+        bitstream_init(&s->bs[i]);
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g726_bank_release(g726_bank_state_t *s)
+{
+    free(s->yl);
+    free(s->bs);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g726_bank_reset_channel(g726_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return -1;
+    /* The channels share one octet phase, so the bit packing state is left
+       alone. Only the codec state starts again. */
+    bank_init_channel(s, chan);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g726_bank_decode(g726_bank_state_t *s,
+                     int16_t *amp[],
+                     const uint8_t *g726_data[],
+                     int g726_bytes)
+{
+    int i;
+    int c;
+    int samples;
+    int load;
+    int sign;
+    int16_t sl;
+    bitstream_state_t *bs;
+
+    sign = 1 << (s->bits_per_sample - 1);
+    for (samples = i = 0;  ;  samples++)
+    {
+        /* The channels are in lockstep, so they all run out of data together */
+        if (s->packing != G726_PACKING_NONE)
+        {
+            load = (s->bs[0].residue < s->bits_per_sample);
+            if (load  &&  i >= g726_bytes)
+                break;
+            for (c = 0;  c < s->channels;  c++)
+            {
+                /* Unpack the code bits */
+                bs = &s->bs[c];
+                if (s->packing != G726_PACKING_LEFT)
+                {
+                    if (load)
+                    {
+                        bs->bitstream |= (g726_data[c][i] << bs->residue);
+                        bs->residue += 8;
+                    }
+                    s->code[c] = bs->bitstream & ((1 << s->bits_per_sample) - 1);
+                    bs->bitstream >>= s->bits_per_sample;
+                }
+                else
+                {
+                    if (load)
+                    {
+                        bs->bitstream = (bs->bitstream << 8) | g726_data[c][i];
+                        bs->residue += 8;
+                    }
+                    s->code[c] = (bs->bitstream >> (bs->residue - s->bits_per_sample)) & ((1 << s->bits_per_sample) - 1);
+                }
+                bs->residue -= s->bits_per_sample;
+            }
+            if (load)
+                i++;
+        }
+        else
+        {
+            if (i >= g726_bytes)
+                break;
+            for (c = 0;  c < s->channels;  c++)
+                s->code[c] = g726_data[c][i] & ((1 << s->bits_per_sample) - 1);
+            i++;
+        }
+        bank_front(s, FALSE);
+        bank_lookup(s);
+        bank_back(s);
+        switch (s->ext_coding)
+        {
+        case G726_ENCODING_ALAW:
+            for (c = 0;  c < s->channels;  c++)
+            {
+                sl = tandem_adjust_alaw(s->recon[c], s->sei[c] >> 1, s->y[c], s->code[c], sign, s->qtab, s->quantizer_states);
+                ((uint8_t *) amp[c])[samples] = (uint8_t) sl;
+            }
+            break;
+        case G726_ENCODING_ULAW:
+            for (c = 0;  c < s->channels;  c++)
+            {
+                sl = tandem_adjust_ulaw(s->recon[c], s->sei[c] >> 1, s->y[c], s->code[c], sign, s->qtab, s->quantizer_states);
+                ((uint8_t *) amp[c])[samples] = (uint8_t) sl;
+            }
+            break;
+        default:
+            for (c = 0;  c < s->channels;  c++)
+                amp[c][samples] = (int16_t) (s->recon[c] << 2);
+            break;
+        }
+        bank_shift(s);
+    }
+    return samples;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g726_bank_encode(g726_bank_state_t *s,
+                     uint8_t *g726_data[],
+                     const int16_t *amp[],
+                     int len)
+{
+    int i;
+    int c;
+    int g726_bytes;
+    int filled;
+    unsigned int code;
+    bitstream_state_t *bs;
+
+    for (g726_bytes = i = 0;  i < len;  i++)
+    {
+        /* Linearize the input samples to 14-bit PCM */
+        switch (s->ext_coding)
+        {
+        case G726_ENCODING_ALAW:
+            for (c = 0;  c < s->channels;  c++)
+                s->sl[c] = alaw_to_linear(((const uint8_t *) amp[c])[i]) >> 2;
+            break;
+        case G726_ENCODING_ULAW:
+            for (c = 0;  c < s->channels;  c++)
+                s->sl[c] = ulaw_to_linear(((const uint8_t *) amp[c])[i]) >> 2;
+            break;
+        default:
+            for (c = 0;  c < s->channels;  c++)
+                s->sl[c] = amp[c][i] >> 2;
+            break;
+        }
+        bank_front(s, TRUE);
+        bank_lookup(s);
+        bank_back(s);
+        bank_shift(s);
+
+        /* The channels are in lockstep, so they all fill a byte together */
+        filled = FALSE;
+        for (c = 0;  c < s->channels;  c++)
+        {
+            code = s->code[c];
+            if (s->packing != G726_PACKING_NONE)
+            {
+                /* Pack the code bits */
+                bs = &s->bs[c];
+                if (s->packing != G726_PACKING_LEFT)
+                {
+                    bs->bitstream |= (code << bs->residue);
+                    bs->residue += s->bits_per_sample;
+                    if (bs->residue >= 8)
+                    {
+                        g726_data[c][g726_bytes] = (uint8_t) (bs->bitstream & 0xFF);
+                        bs->bitstream >>= 8;
+                        bs->residue -= 8;
+                        filled = TRUE;
+                    }
+                }
+                else
+                {
+                    bs->bitstream = (bs->bitstream << s->bits_per_sample) | code;
+                    bs->residue += s->bits_per_sample;
+                    if (bs->residue >= 8)
+                    {
+                        g726_data[c][g726_bytes] = (uint8_t) ((bs->bitstream >> (bs->residue - 8)) & 0xFF);
+                        bs->residue -= 8;
+                        filled = TRUE;
+                    }
+                }
+            }
+            else
+            {
+                g726_data[c][g726_bytes] = (uint8_t) code;
+                filled = TRUE;
+            }
+        }
+        if (filled)
+            g726_bytes++;
+    }
+    return g726_bytes;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
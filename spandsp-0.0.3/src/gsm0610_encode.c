@@ -51,6 +51,11 @@
 #include "spandsp/gsm0610.h"
 
 #include "gsm0610_local.h"
+#include "testcpuid.h"
+
+#if defined(GSM0610_RUNTIME_SIMD)
+int gsm0610_simd = GSM0610_SIMD_NONE;
+#endif
 
 /* 4.2 FIXED POINT IMPLEMENTATION OF THE RPE-LTP CODER */
 
@@ -115,6 +120,13 @@ gsm0610_state_t *gsm0610_init(gsm0610_state_t *s, int packing)
     }
     /*endif*/
     memset((char *) s, '\0', sizeof (gsm0610_state_t));
+#if defined(GSM0610_RUNTIME_SIMD)
+    if (has_AVX2())
+        gsm0610_simd = GSM0610_SIMD_AVX2;
+    else if (has_SIMD2())
+        gsm0610_simd = GSM0610_SIMD_SSE2;
+    /*endif*/
+#endif
     s->nrp = 40;
     s->packing = packing;
     return s;
@@ -35,6 +35,24 @@
 
 #define	GSM0610_MAGIC                   0xD
 
+/* With a new enough GCC on x86, the hot loops of the encoder have SSE2 and AVX2
+   versions. These are built whatever the compiler flags, and the best one for the
+   CPU is picked at run time by gsm0610_init(). */
+#if defined(__GNUC__)  &&  (defined(__i386__)  ||  defined(__x86_64__))  &&  (__GNUC__ > 4  ||  (__GNUC__ == 4  &&  __GNUC_MINOR__ >= 9))
+#define GSM0610_RUNTIME_SIMD
+#include <immintrin.h>
+
+enum
+{
+    GSM0610_SIMD_NONE = 0,
+    GSM0610_SIMD_SSE2,
+    GSM0610_SIMD_AVX2
+};
+
+/* The SIMD level in use, one of the GSM0610_SIMD_xxx values */
+extern int gsm0610_simd;
+#endif
+
 static __inline__ int16_t gsm_add(int16_t a, int16_t b)
 {
 #if defined(__GNUC__)  &&  defined(__i386__)
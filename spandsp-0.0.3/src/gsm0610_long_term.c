@@ -144,6 +144,192 @@ int32_t gsm0610_max_cross_corr(const int16_t *wt, const int16_t *dp, int16_t *Nc
 /*- End of function --------------------------------------------------------*/
 #endif
 
+#if !(defined(__GNUC__)  &&  defined(__i386__))
+static int32_t max_cross_corr(const int16_t *wt, const int16_t *dp, int16_t *Nc_out)
+{
+    int32_t L_max;
+    int16_t Nc;
+    int16_t lambda;
+
+    L_max = 0;
+    Nc = 40; /* index for the maximum cross-correlation */
+
+    for (lambda = 40;  lambda <= 120;  lambda++)
+    {
+        int32_t L_result;
+
+        L_result  = (wt[0]*dp[0 - lambda])
+                  + (wt[1]*dp[1 - lambda])
+                  + (wt[2]*dp[2 - lambda])
+                  + (wt[3]*dp[3 - lambda])
+                  + (wt[4]*dp[4 - lambda])
+                  + (wt[5]*dp[5 - lambda])
+                  + (wt[6]*dp[6 - lambda])
+                  + (wt[7]*dp[7 - lambda])
+                  + (wt[8]*dp[8 - lambda])
+                  + (wt[9]*dp[9 - lambda])
+                  + (wt[10]*dp[10 - lambda])
+                  + (wt[11]*dp[11 - lambda])
+                  + (wt[12]*dp[12 - lambda])
+                  + (wt[13]*dp[13 - lambda])
+                  + (wt[14]*dp[14 - lambda])
+                  + (wt[15]*dp[15 - lambda])
+                  + (wt[16]*dp[16 - lambda])
+                  + (wt[17]*dp[17 - lambda])
+                  + (wt[18]*dp[18 - lambda])
+                  + (wt[19]*dp[19 - lambda])
+                  + (wt[20]*dp[20 - lambda])
+                  + (wt[21]*dp[21 - lambda])
+                  + (wt[22]*dp[22 - lambda])
+                  + (wt[23]*dp[23 - lambda])
+                  + (wt[24]*dp[24 - lambda])
+                  + (wt[25]*dp[25 - lambda])
+                  + (wt[26]*dp[26 - lambda])
+                  + (wt[27]*dp[27 - lambda])
+                  + (wt[28]*dp[28 - lambda])
+                  + (wt[29]*dp[29 - lambda])
+                  + (wt[30]*dp[30 - lambda])
+                  + (wt[31]*dp[31 - lambda])
+                  + (wt[32]*dp[32 - lambda])
+                  + (wt[33]*dp[33 - lambda])
+                  + (wt[34]*dp[34 - lambda])
+                  + (wt[35]*dp[35 - lambda])
+                  + (wt[36]*dp[36 - lambda])
+                  + (wt[37]*dp[37 - lambda])
+                  + (wt[38]*dp[38 - lambda])
+                  + (wt[39]*dp[39 - lambda]);
+
+        if (L_result > L_max)
+        {
+            Nc = lambda;
+            L_max = L_result;
+        }
+        /*endif*/
+    }
+    /*endfor*/
+    *Nc_out = Nc;
+    return  L_max;
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+#if defined(GSM0610_RUNTIME_SIMD)
+/* Find the largest of the 81 correlations for lags 40 to 120. The first of any equal
+   maxima is picked, as the plain C code does. */
+static int32_t pick_max(const int32_t L_result[81], int16_t *Nc_out)
+{
+    int32_t L_max;
+    int k;
+
+    L_max = 0;
+    *Nc_out = 40;
+    for (k = 0;  k <= 80;  k++)
+    {
+        if (L_result[k] > L_max)
+        {
+            *Nc_out = k + 40;
+            L_max = L_result[k];
+        }
+        /*endif*/
+    }
+    /*endfor*/
+    return  L_max;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Sum the four 32 bit lanes of each of a, b, c and d, giving the four sums in
+   that order. */
+static __inline__ __attribute__((target("sse2"))) __m128i hsum4_sse2(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    a = _mm_add_epi32(_mm_unpacklo_epi32(a, b), _mm_unpackhi_epi32(a, b));
+    c = _mm_add_epi32(_mm_unpacklo_epi32(c, d), _mm_unpackhi_epi32(c, d));
+    return _mm_add_epi32(_mm_unpacklo_epi64(a, c), _mm_unpackhi_epi64(a, c));
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ __attribute__((target("sse2"))) __m128i cross_corr_sse2(const __m128i w[5], const int16_t *x)
+{
+    __m128i acc;
+
+    acc = _mm_madd_epi16(w[0], _mm_loadu_si128((const __m128i *) &x[0]));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(w[1], _mm_loadu_si128((const __m128i *) &x[8])));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(w[2], _mm_loadu_si128((const __m128i *) &x[16])));
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(w[3], _mm_loadu_si128((const __m128i *) &x[24])));
+    return _mm_add_epi32(acc, _mm_madd_epi16(w[4], _mm_loadu_si128((const __m128i *) &x[32])));
+}
+/*- End of function --------------------------------------------------------*/
+
+static __attribute__((target("sse2"))) int32_t max_cross_corr_sse2(const int16_t *wt, const int16_t *dp, int16_t *Nc_out)
+{
+    __m128i w[5];
+    __m128i acc;
+    int32_t L_result[81];
+    int lambda;
+    int k;
+
+    for (k = 0;  k < 5;  k++)
+        w[k] = _mm_loadu_si128((const __m128i *) &wt[8*k]);
+    /*endfor*/
+    /* Work out the correlations four lags at a time. The 81st one is done on its own,
+       as a fourth lag would reach back before dp[-120]. */
+    for (lambda = 40;  lambda < 120;  lambda += 4)
+    {
+        acc = hsum4_sse2(cross_corr_sse2(w, dp - lambda),
+                         cross_corr_sse2(w, dp - lambda - 1),
+                         cross_corr_sse2(w, dp - lambda - 2),
+                         cross_corr_sse2(w, dp - lambda - 3));
+        _mm_storeu_si128((__m128i *) &L_result[lambda - 40], acc);
+    }
+    /*endfor*/
+    acc = cross_corr_sse2(w, dp - 120);
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+    L_result[80] = _mm_cvtsi128_si32(acc);
+    return  pick_max(L_result, Nc_out);
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ __attribute__((target("avx2"))) __m128i cross_corr_avx2(__m256i w0, __m256i w1, __m128i w2, const int16_t *x)
+{
+    __m256i acc;
+
+    acc = _mm256_add_epi32(_mm256_madd_epi16(w0, _mm256_loadu_si256((const __m256i *) &x[0])),
+                           _mm256_madd_epi16(w1, _mm256_loadu_si256((const __m256i *) &x[16])));
+    return _mm_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)),
+                         _mm_madd_epi16(w2, _mm_loadu_si128((const __m128i *) &x[32])));
+}
+/*- End of function --------------------------------------------------------*/
+
+static __attribute__((target("avx2"))) int32_t max_cross_corr_avx2(const int16_t *wt, const int16_t *dp, int16_t *Nc_out)
+{
+    __m256i w0;
+    __m256i w1;
+    __m128i w2;
+    __m128i acc;
+    int32_t L_result[81];
+    int lambda;
+
+    w0 = _mm256_loadu_si256((const __m256i *) &wt[0]);
+    w1 = _mm256_loadu_si256((const __m256i *) &wt[16]);
+    w2 = _mm_loadu_si128((const __m128i *) &wt[32]);
+    for (lambda = 40;  lambda < 120;  lambda += 4)
+    {
+        acc = hsum4_sse2(cross_corr_avx2(w0, w1, w2, dp - lambda),
+                         cross_corr_avx2(w0, w1, w2, dp - lambda - 1),
+                         cross_corr_avx2(w0, w1, w2, dp - lambda - 2),
+                         cross_corr_avx2(w0, w1, w2, dp - lambda - 3));
+        _mm_storeu_si128((__m128i *) &L_result[lambda - 40], acc);
+    }
+    /*endfor*/
+    acc = cross_corr_avx2(w0, w1, w2, dp - 120);
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+    acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 4));
+    L_result[80] = _mm_cvtsi128_si32(acc);
+    return  pick_max(L_result, Nc_out);
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
 /* This procedure computes the LTP gain (bc) and the LTP lag (Nc)
    for the long term analysis filter.   This is done by calculating a
    maximum of the cross-correlation function between the current
@@ -174,9 +360,6 @@ static int16_t evaluate_ltp_parameters(int16_t d[40],
     int16_t scale;
     int16_t temp;
     int32_t L_temp;
-#if !(defined(__GNUC__)  &&  defined(__i386__))
-    int16_t lambda;
-#endif
 
     /* Search of the optimum scaling of d[0..39]. */
     dmax = 0;
@@ -214,65 +397,17 @@ static int16_t evaluate_ltp_parameters(int16_t d[40],
     /*endfor*/
 
     /* Search for the maximum cross-correlation and coding of the LTP lag */
+#if defined(GSM0610_RUNTIME_SIMD)
+    if (gsm0610_simd == GSM0610_SIMD_AVX2)
+        L_max = max_cross_corr_avx2(wt, dp, &Nc);
+    else if (gsm0610_simd == GSM0610_SIMD_SSE2)
+        L_max = max_cross_corr_sse2(wt, dp, &Nc);
+    else
+#endif
 #if defined(__GNUC__)  &&  defined(__i386__)
     L_max = gsm0610_max_cross_corr(wt, dp, &Nc);
 #else
-    L_max = 0;
-    Nc = 40; /* index for the maximum cross-correlation */
-
-    for (lambda = 40;  lambda <= 120;  lambda++)
-    {
-        int32_t L_result;
-
-        L_result  = (wt[0]*dp[0 - lambda])
-                  + (wt[1]*dp[1 - lambda])
-                  + (wt[2]*dp[2 - lambda])
-                  + (wt[3]*dp[3 - lambda])
-                  + (wt[4]*dp[4 - lambda])
-                  + (wt[5]*dp[5 - lambda])
-                  + (wt[6]*dp[6 - lambda])
-                  + (wt[7]*dp[7 - lambda])
-                  + (wt[8]*dp[8 - lambda])
-                  + (wt[9]*dp[9 - lambda])
-                  + (wt[10]*dp[10 - lambda])
-                  + (wt[11]*dp[11 - lambda])
-                  + (wt[12]*dp[12 - lambda])
-                  + (wt[13]*dp[13 - lambda])
-                  + (wt[14]*dp[14 - lambda])
-                  + (wt[15]*dp[15 - lambda])
-                  + (wt[16]*dp[16 - lambda])
-                  + (wt[17]*dp[17 - lambda])
-                  + (wt[18]*dp[18 - lambda])
-                  + (wt[19]*dp[19 - lambda])
-                  + (wt[20]*dp[20 - lambda])
-                  + (wt[21]*dp[21 - lambda])
-                  + (wt[22]*dp[22 - lambda])
-                  + (wt[23]*dp[23 - lambda])
-                  + (wt[24]*dp[24 - lambda])
-                  + (wt[25]*dp[25 - lambda])
-                  + (wt[26]*dp[26 - lambda])
-                  + (wt[27]*dp[27 - lambda])
-                  + (wt[28]*dp[28 - lambda])
-                  + (wt[29]*dp[29 - lambda])
-                  + (wt[30]*dp[30 - lambda])
-                  + (wt[31]*dp[31 - lambda])
-                  + (wt[32]*dp[32 - lambda])
-                  + (wt[33]*dp[33 - lambda])
-                  + (wt[34]*dp[34 - lambda])
-                  + (wt[35]*dp[35 - lambda])
-                  + (wt[36]*dp[36 - lambda])
-                  + (wt[37]*dp[37 - lambda])
-                  + (wt[38]*dp[38 - lambda])
-                  + (wt[39]*dp[39 - lambda]);
-
-        if (L_result > L_max)
-        {
-            Nc = lambda;
-            L_max = L_result;
-        }
-        /*endif*/
-    }
-    /*endfor*/
+    L_max = max_cross_corr(wt, dp, &Nc);
 #endif
     *Nc_out = Nc;
 
@@ -43,6 +43,7 @@
 #include <math.h>
 #endif
 #include <stdlib.h>
+#include <string.h>
 
 #include "spandsp/telephony.h"
 #include "spandsp/dc_restore.h"
@@ -204,6 +205,169 @@ void gsm0610_vec_vsraw(const int16_t *p, int n, int bits)
 /*- End of function --------------------------------------------------------*/
 #endif
 
+#if defined(GSM0610_RUNTIME_SIMD)
+/* The frame is copied to a buffer with some zeros after it, so each lag of the
+   autocorrelation can run over the whole frame, a full vector at a time. */
+static __attribute__((target("sse2"))) void acf_sse2(const int16_t amp[GSM0610_FRAME_LEN], int32_t L_ACF[9])
+{
+    int16_t buf[GSM0610_FRAME_LEN + 16] __attribute__((aligned(16)));
+    __m128i acc[9];
+    __m128i x;
+    __m128i y;
+    int i;
+    int k;
+
+    memcpy(buf, amp, GSM0610_FRAME_LEN*sizeof(buf[0]));
+    memset(&buf[GSM0610_FRAME_LEN], 0, 16*sizeof(buf[0]));
+    for (k = 0;  k < 9;  k++)
+        acc[k] = _mm_setzero_si128();
+    /*endfor*/
+    for (i = 0;  i < GSM0610_FRAME_LEN;  i += 8)
+    {
+        x = _mm_load_si128((const __m128i *) &buf[i]);
+        acc[0] = _mm_add_epi32(acc[0], _mm_madd_epi16(x, x));
+        for (k = 1;  k < 9;  k++)
+        {
+            y = _mm_loadu_si128((const __m128i *) &buf[i + k]);
+            acc[k] = _mm_add_epi32(acc[k], _mm_madd_epi16(x, y));
+        }
+        /*endfor*/
+    }
+    /*endfor*/
+    /* Reduce the accumulators four at a time */
+    for (k = 0;  k < 8;  k += 4)
+    {
+        acc[k] = _mm_add_epi32(_mm_unpacklo_epi32(acc[k], acc[k + 1]), _mm_unpackhi_epi32(acc[k], acc[k + 1]));
+        acc[k + 2] = _mm_add_epi32(_mm_unpacklo_epi32(acc[k + 2], acc[k + 3]), _mm_unpackhi_epi32(acc[k + 2], acc[k + 3]));
+        x = _mm_add_epi32(_mm_unpacklo_epi64(acc[k], acc[k + 2]), _mm_unpackhi_epi64(acc[k], acc[k + 2]));
+        _mm_storeu_si128((__m128i *) &L_ACF[k], _mm_slli_epi32(x, 1));
+    }
+    /*endfor*/
+    x = _mm_add_epi32(acc[8], _mm_srli_si128(acc[8], 8));
+    x = _mm_add_epi32(x, _mm_srli_si128(x, 4));
+    L_ACF[8] = _mm_cvtsi128_si32(x) << 1;
+}
+/*- End of function --------------------------------------------------------*/
+
+static __attribute__((target("avx2"))) void acf_avx2(const int16_t amp[GSM0610_FRAME_LEN], int32_t L_ACF[9])
+{
+    int16_t buf[GSM0610_FRAME_LEN + 16] __attribute__((aligned(32)));
+    __m256i acc[9];
+    __m256i x;
+    __m256i y;
+    __m128i z[9];
+    int i;
+    int k;
+
+    memcpy(buf, amp, GSM0610_FRAME_LEN*sizeof(buf[0]));
+    memset(&buf[GSM0610_FRAME_LEN], 0, 16*sizeof(buf[0]));
+    for (k = 0;  k < 9;  k++)
+        acc[k] = _mm256_setzero_si256();
+    /*endfor*/
+    for (i = 0;  i < GSM0610_FRAME_LEN;  i += 16)
+    {
+        x = _mm256_load_si256((const __m256i *) &buf[i]);
+        acc[0] = _mm256_add_epi32(acc[0], _mm256_madd_epi16(x, x));
+        for (k = 1;  k < 9;  k++)
+        {
+            y = _mm256_loadu_si256((const __m256i *) &buf[i + k]);
+            acc[k] = _mm256_add_epi32(acc[k], _mm256_madd_epi16(x, y));
+        }
+        /*endfor*/
+    }
+    /*endfor*/
+    for (k = 0;  k < 9;  k++)
+        z[k] = _mm_add_epi32(_mm256_castsi256_si128(acc[k]), _mm256_extracti128_si256(acc[k], 1));
+    /*endfor*/
+    for (k = 0;  k < 8;  k += 4)
+    {
+        z[k] = _mm_add_epi32(_mm_unpacklo_epi32(z[k], z[k + 1]), _mm_unpackhi_epi32(z[k], z[k + 1]));
+        z[k + 2] = _mm_add_epi32(_mm_unpacklo_epi32(z[k + 2], z[k + 3]), _mm_unpackhi_epi32(z[k + 2], z[k + 3]));
+        z[k] = _mm_add_epi32(_mm_unpacklo_epi64(z[k], z[k + 2]), _mm_unpackhi_epi64(z[k], z[k + 2]));
+        _mm_storeu_si128((__m128i *) &L_ACF[k], _mm_slli_epi32(z[k], 1));
+    }
+    /*endfor*/
+    z[8] = _mm_add_epi32(z[8], _mm_srli_si128(z[8], 8));
+    z[8] = _mm_add_epi32(z[8], _mm_srli_si128(z[8], 4));
+    L_ACF[8] = _mm_cvtsi128_si32(z[8]) << 1;
+}
+/*- End of function --------------------------------------------------------*/
+
+static __attribute__((target("sse2"))) int16_t max_abs_sse2(const int16_t amp[GSM0610_FRAME_LEN])
+{
+    __m128i x;
+    __m128i max;
+    int i;
+
+    max = _mm_setzero_si128();
+    for (i = 0;  i < GSM0610_FRAME_LEN;  i += 8)
+    {
+        x = _mm_loadu_si128((const __m128i *) &amp[i]);
+        /* The saturating subtract matches gsm_abs() for INT16_MIN */
+        max = _mm_max_epi16(max, _mm_max_epi16(x, _mm_subs_epi16(_mm_setzero_si128(), x)));
+    }
+    /*endfor*/
+    max = _mm_max_epi16(max, _mm_srli_si128(max, 8));
+    max = _mm_max_epi16(max, _mm_srli_si128(max, 4));
+    max = _mm_max_epi16(max, _mm_srli_si128(max, 2));
+    return  (int16_t) _mm_cvtsi128_si32(max);
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Scale the frame down by scalauto bits with rounding, as
+   gsm_mult_r(amp[k], 16384 >> (scalauto - 1)) does. */
+static __attribute__((target("sse2"))) void scale_down_sse2(int16_t amp[GSM0610_FRAME_LEN], int scalauto)
+{
+    __m128i x;
+    __m128i shift;
+    __m128i shift_1;
+    __m128i one;
+    int i;
+
+    shift = _mm_cvtsi32_si128(scalauto);
+    shift_1 = _mm_cvtsi32_si128(scalauto - 1);
+    one = _mm_set1_epi16(1);
+    for (i = 0;  i < GSM0610_FRAME_LEN;  i += 8)
+    {
+        x = _mm_loadu_si128((const __m128i *) &amp[i]);
+        x = _mm_add_epi16(_mm_sra_epi16(x, shift), _mm_and_si128(_mm_sra_epi16(x, shift_1), one));
+        _mm_storeu_si128((__m128i *) &amp[i], x);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void autocorrelation_simd(int16_t amp[GSM0610_FRAME_LEN], int32_t L_ACF[9])
+{
+    int k;
+    int16_t smax;
+    int16_t scalauto;
+
+    smax = max_abs_sse2(amp);
+    if (smax == 0)
+        scalauto = 0;
+    else
+        scalauto = (int16_t) (4 - gsm0610_norm((int32_t) smax << 16));
+    /*endif*/
+    if (scalauto > 0)
+        scale_down_sse2(amp, scalauto);
+    /*endif*/
+    if (gsm0610_simd == GSM0610_SIMD_AVX2)
+        acf_avx2(amp, L_ACF);
+    else
+        acf_sse2(amp, L_ACF);
+    /*endif*/
+    if (scalauto > 0)
+    {
+        for (k = 0;  k < GSM0610_FRAME_LEN;  k++)
+            amp[k] <<= scalauto;
+        /*endfor*/
+    }
+    /*endif*/
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
 /* 4.2.4 */
 static void autocorrelation(int16_t amp[GSM0610_FRAME_LEN], int32_t L_ACF[9])
 {
@@ -217,6 +381,14 @@ static void autocorrelation(int16_t amp[GSM0610_FRAME_LEN], int32_t L_ACF[9])
     int16_t sl;
 #endif
     
+#if defined(GSM0610_RUNTIME_SIMD)
+    if (gsm0610_simd != GSM0610_SIMD_NONE)
+    {
+        autocorrelation_simd(amp, L_ACF);
+        return;
+    }
+    /*endif*/
+#endif
     /* The goal is to compute the array L_ACF[k].  The signal s[i] must
        be scaled in order to avoid an overflow situation. */
 
@@ -251,6 +251,106 @@ static void short_term_analysis_filtering(gsm0610_state_t *s,
 }
 /*- End of function --------------------------------------------------------*/
 
+#if defined(GSM0610_RUNTIME_SIMD)
+/* The whole frame is filtered in one pass, with the eight stages of the lattice in
+   the eight lanes of a vector. Stage j works on sample t - j while stage 0 works on
+   sample t, so every stage can be updated at once, and the results come out of the
+   last stage 7 samples late. The stages take up the next set of reflection
+   coefficients one by one, as the sample where the set starts passes through them. */
+static __attribute__((target("sse2"))) void short_term_analysis_filtering_sse2(gsm0610_state_t *s,
+                                                                                 int16_t rp[4][8],
+                                                                                 int16_t amp[GSM0610_FRAME_LEN])
+{
+    static const int set_start[4] = {0, 13, 27, 40};
+    __m128i lane;
+    __m128i one;
+    __m128i round;
+    __m128i rp_old;
+    __m128i rp_new;
+    __m128i rp_lo;
+    __m128i rp_hi;
+    __m128i mask;
+    __m128i u;
+    __m128i din;
+    __m128i dout;
+    __m128i uin;
+    __m128i uout;
+    __m128i lo;
+    __m128i hi;
+    int set;
+    int since;
+    int t;
+    int x;
+
+    lane = _mm_set_epi16(7, 6, 5, 4, 3, 2, 1, 0);
+    one = _mm_set1_epi16(1);
+    round = _mm_set1_epi16(0x4000);
+    u = _mm_loadu_si128((const __m128i *) s->u);
+    dout = _mm_setzero_si128();
+    uout = _mm_setzero_si128();
+    rp_old =
+    rp_new = _mm_loadu_si128((const __m128i *) rp[0]);
+    /* Pairing each coefficient with 0x4000, and each signal value with 1, lets
+       pmaddwd form (rp*d + 0x4000) in one step. None of the rp values are -32768,
+       so after the shift the result always fits in 16 bits. */
+    rp_lo = _mm_unpacklo_epi16(rp_new, round);
+    rp_hi = _mm_unpackhi_epi16(rp_new, round);
+    set = 1;
+    since = 8;
+    for (t = 0;  t < GSM0610_FRAME_LEN + 7;  t++)
+    {
+        if (set < 4  &&  t == set_start[set])
+        {
+            rp_old = rp_new;
+            rp_new = _mm_loadu_si128((const __m128i *) rp[set++]);
+            since = 0;
+        }
+        /*endif*/
+        if (since < 8)
+        {
+            /* Stages 0 to since are on the new set */
+            mask = _mm_cmpgt_epi16(_mm_set1_epi16(since + 1), lane);
+            mask = _mm_or_si128(_mm_and_si128(mask, rp_new), _mm_andnot_si128(mask, rp_old));
+            rp_lo = _mm_unpacklo_epi16(mask, round);
+            rp_hi = _mm_unpackhi_epi16(mask, round);
+            since++;
+        }
+        /*endif*/
+
+        x = (t < GSM0610_FRAME_LEN)  ?  amp[t]  :  0;
+        din = _mm_insert_epi16(_mm_slli_si128(dout, 2), x, 0);
+        uin = _mm_insert_epi16(_mm_slli_si128(uout, 2), x, 0);
+
+        lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(din, one), rp_lo), 15);
+        hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(din, one), rp_hi), 15);
+        uout = _mm_adds_epi16(u, _mm_packs_epi32(lo, hi));
+        lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(u, one), rp_lo), 15);
+        hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(u, one), rp_hi), 15);
+        dout = _mm_adds_epi16(din, _mm_packs_epi32(lo, hi));
+
+        if (t < 7  ||  t >= GSM0610_FRAME_LEN)
+        {
+            /* While the pipeline fills and drains, only the stages holding a sample
+               from this frame may update their state */
+            mask = _mm_and_si128(_mm_cmpgt_epi16(_mm_set1_epi16(t + 1), lane),
+                                 _mm_cmpgt_epi16(lane, _mm_set1_epi16(t - GSM0610_FRAME_LEN)));
+            u = _mm_or_si128(_mm_and_si128(mask, uin), _mm_andnot_si128(mask, u));
+        }
+        else
+        {
+            u = uin;
+        }
+        /*endif*/
+        if (t >= 7)
+            amp[t - 7] = (int16_t) _mm_extract_epi16(dout, 7);
+        /*endif*/
+    }
+    /*endfor*/
+    _mm_storeu_si128((__m128i *) s->u, u);
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
 static void short_term_synthesis_filtering(gsm0610_state_t *s,
                                            int16_t rrp[8],
                                            int k,          // k_end - k_start
@@ -302,12 +402,31 @@ void gsm0610_short_term_analysis_filter(gsm0610_state_t *s,
     int16_t *LARpp_j;
     int16_t *LARpp_j_1;
     int16_t LARp[8];
+#if defined(GSM0610_RUNTIME_SIMD)
+    int16_t rp[4][8];
+#endif
 
     LARpp_j = s->LARpp[s->j];
     LARpp_j_1 = s->LARpp[s->j ^= 1];
 
     decode_log_area_ratios(LARc, LARpp_j);
 
+#if defined(GSM0610_RUNTIME_SIMD)
+    if (gsm0610_simd != GSM0610_SIMD_NONE)
+    {
+        coefficients_0_12(LARpp_j_1, LARpp_j, rp[0]);
+        larp_to_rp(rp[0]);
+        coefficients_13_26(LARpp_j_1, LARpp_j, rp[1]);
+        larp_to_rp(rp[1]);
+        coefficients_27_39(LARpp_j_1, LARpp_j, rp[2]);
+        larp_to_rp(rp[2]);
+        coefficients_40_159(LARpp_j, rp[3]);
+        larp_to_rp(rp[3]);
+        short_term_analysis_filtering_sse2(s, rp, amp);
+        return;
+    }
+    /*endif*/
+#endif
     coefficients_0_12(LARpp_j_1, LARpp_j, LARp);
     larp_to_rp(LARp);
     short_term_analysis_filtering(s, LARp, 13, amp);
@@ -41,6 +41,11 @@
 #if defined(HAVE_MATH_H)
 #include <math.h>
 #endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/dc_restore.h"
@@ -384,4 +389,344 @@ int ima_adpcm_encode(ima_adpcm_state_t *s,
     return  bytes;
 }
 /*- End of function --------------------------------------------------------*/
+/*
+ * The bank functions run a number of DVI4 channels in lockstep. Each sample is
+ * processed in three passes over the channels - the codes or samples are picked
+ * up from each channel's buffer, every channel's ADPCM state is stepped, and the
+ * results are put in each channel's buffer. The step is written without
+ * branches, so with SSE2 or AVX2 it works on a vector of channels at a time, in
+ * 32 bit lanes.
+ */
+#define IMA_ADPCM_BANK_NUM_ARRAYS   5
+
+#if defined(__AVX2__)  ||  defined(__SSE2__)
+#if defined(__AVX2__)
+#define IMA_ADPCM_LANES 8
+typedef __m256i ima_vec_t;
+#define vload(p)        _mm256_loadu_si256((const __m256i *) (p))
+#define vstore(p, x)    _mm256_storeu_si256((__m256i *) (p), x)
+#define vset1           _mm256_set1_epi32
+#define vzero           _mm256_setzero_si256
+#define vadd            _mm256_add_epi32
+#define vsub            _mm256_sub_epi32
+#define vand            _mm256_and_si256
+#define vor             _mm256_or_si256
+#define vxor            _mm256_xor_si256
+#define vsrai           _mm256_srai_epi32
+#define vslli           _mm256_slli_epi32
+#define vcmpeq          _mm256_cmpeq_epi32
+#define vcmpgt          _mm256_cmpgt_epi32
+#define vmin            _mm256_min_epi32
+#define vmax            _mm256_max_epi32
+/* Look up the step sizes for a vector of step indices */
+#define vstep_size(p)   _mm256_i32gather_epi32(step_size, vload(p), 4)
+#else
+#define IMA_ADPCM_LANES 4
+typedef __m128i ima_vec_t;
+#define vload(p)        _mm_loadu_si128((const __m128i *) (p))
+#define vstore(p, x)    _mm_storeu_si128((__m128i *) (p), x)
+#define vset1           _mm_set1_epi32
+#define vzero           _mm_setzero_si128
+#define vadd            _mm_add_epi32
+#define vsub            _mm_sub_epi32
+#define vand            _mm_and_si128
+#define vandnot         _mm_andnot_si128
+#define vor             _mm_or_si128
+#define vxor            _mm_xor_si128
+#define vsrai           _mm_srai_epi32
+#define vslli           _mm_slli_epi32
+#define vcmpeq          _mm_cmpeq_epi32
+#define vcmpgt          _mm_cmpgt_epi32
+#define vsel(m, a, b)   vor(vand(m, a), vandnot(m, b))
+#define vmin(a, b)      vsel(vcmpgt(b, a), a, b)
+#define vmax(a, b)      vsel(vcmpgt(a, b), a, b)
+/* SSE2 has no gather, so the step sizes are looked up one lane at a time */
+#define vstep_size(p)   _mm_set_epi32(step_size[(p)[3]], step_size[(p)[2]], step_size[(p)[1]], step_size[(p)[0]])
+#endif
+
+#define vones()         vcmpeq(vzero(), vzero())
+/* All ones in the lanes where the code has bit b set */
+#define vbit(x, b)      vcmpeq(vand(x, vset1(b)), vset1(b))
+#define vsaturate(x)    vmin(vmax(x, vset1(INT16_MIN)), vset1(INT16_MAX))
+
+/* step_adjustment[] is -1 for codes 0 to 3, and 2, 4, 6, 8 for codes 4 to 7 */
+static __inline__ ima_vec_t step_adjust_vec(ima_vec_t step_index, ima_vec_t code)
+{
+    ima_vec_t adjust;
+
+    adjust = vsub(vand(vbit(code, 0x04), vadd(vslli(vand(code, vset1(0x03)), 1), vset1(3))), vset1(1));
+    return vmin(vmax(vadd(step_index, adjust), vzero()), vset1(88));
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_decode(ima_adpcm_bank_state_t *s)
+{
+    ima_vec_t code;
+    ima_vec_t ss;
+    ima_vec_t e;
+    ima_vec_t sign;
+    int c;
+
+    for (c = 0;  c < s->stride;  c += IMA_ADPCM_LANES)
+    {
+        code = vload(&s->code[c]);
+        ss = vstep_size(&s->step_index[c]);
+        e = vsrai(ss, 3);
+        e = vadd(e, vand(vbit(code, 0x01), vsrai(ss, 2)));
+        e = vadd(e, vand(vbit(code, 0x02), vsrai(ss, 1)));
+        e = vadd(e, vand(vbit(code, 0x04), ss));
+        sign = vbit(code, 0x08);
+        e = vsub(vxor(e, sign), sign);
+        vstore(&s->last[c], vsaturate(vadd(vload(&s->last[c]), e)));
+        vstore(&s->step_index[c], step_adjust_vec(vload(&s->step_index[c]), code));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_encode(ima_adpcm_bank_state_t *s)
+{
+    ima_vec_t ss;
+    ima_vec_t e;
+    ima_vec_t mag;
+    ima_vec_t sign;
+    ima_vec_t b2;
+    ima_vec_t b1;
+    ima_vec_t b0;
+    ima_vec_t diff;
+    ima_vec_t code;
+    ima_vec_t last;
+    int c;
+
+    for (c = 0;  c < s->stride;  c += IMA_ADPCM_LANES)
+    {
+        ss = vstep_size(&s->step_index[c]);
+        last = vload(&s->last[c]);
+        e = vsub(vload(&s->sl[c]), last);
+        sign = vsrai(e, 31);
+        e = vsub(vxor(e, sign), sign);
+        /* Each bit of the code is set where the remaining error is at least the
+           step for that bit */
+        b2 = vxor(vcmpgt(ss, e), vones());
+        mag = vsub(e, vand(b2, ss));
+        b1 = vxor(vcmpgt(vsrai(ss, 1), mag), vones());
+        mag = vsub(mag, vand(b1, vsrai(ss, 1)));
+        b0 = vxor(vcmpgt(vsrai(ss, 2), mag), vones());
+        mag = vsub(mag, vand(b0, vsrai(ss, 2)));
+        diff = vadd(vsrai(ss, 3), vsub(e, mag));
+        diff = vsub(vxor(diff, sign), sign);
+        vstore(&s->last[c], vsaturate(vadd(last, diff)));
+        code = vor(vor(vand(sign, vset1(0x08)), vand(b2, vset1(0x04))),
+                   vor(vand(b1, vset1(0x02)), vand(b0, vset1(0x01))));
+        vstore(&s->code[c], code);
+        vstore(&s->step_index[c], step_adjust_vec(vload(&s->step_index[c]), code));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+#else
+static __inline__ int step_adjust(int step_index, int code)
+{
+    step_index += step_adjustment[code & 0x07];
+    if (step_index < 0)
+        step_index = 0;
+    else if (step_index > 88)
+        step_index = 88;
+    /*endif*/
+    return step_index;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_decode(ima_adpcm_bank_state_t *s)
+{
+    int code;
+    int ss;
+    int e;
+    int sign;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        code = s->code[c];
+        ss = step_size[s->step_index[c]];
+        e = (ss >> 3)
+          + (-(code & 0x01) & (ss >> 2))
+          + (-((code >> 1) & 0x01) & (ss >> 1))
+          + (-((code >> 2) & 0x01) & ss);
+        sign = -((code >> 3) & 0x01);
+        e = (e ^ sign) - sign;
+        s->last[c] = saturate(s->last[c] + e);
+        s->step_index[c] = step_adjust(s->step_index[c], code);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_encode(ima_adpcm_bank_state_t *s)
+{
+    int ss;
+    int e;
+    int mag;
+    int sign;
+    int b2;
+    int b1;
+    int b0;
+    int diff;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        ss = step_size[s->step_index[c]];
+        e = s->sl[c] - s->last[c];
+        sign = e >> 31;
+        e = (e ^ sign) - sign;
+        b2 = -(e >= ss);
+        mag = e - (b2 & ss);
+        b1 = -(mag >= (ss >> 1));
+        mag -= (b1 & (ss >> 1));
+        b0 = -(mag >= (ss >> 2));
+        mag -= (b0 & (ss >> 2));
+        diff = (ss >> 3) + e - mag;
+        diff = (diff ^ sign) - sign;
+        s->last[c] = saturate(s->last[c] + diff);
+        s->code[c] = (sign & 0x08) | (b2 & 0x04) | (b1 & 0x02) | (b0 & 0x01);
+        s->step_index[c] = step_adjust(s->step_index[c], s->code[c]);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+static void bank_init_channel(ima_adpcm_bank_state_t *s, int c)
+{
+    s->last[c] = 0;
+    s->step_index[c] = 0;
+    s->ima_byte[c] = 0;
+    s->sl[c] = 0;
+    s->code[c] = 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+ima_adpcm_bank_state_t *ima_adpcm_bank_init(ima_adpcm_bank_state_t *s, int channels, int variant)
+{
+    int32_t *x;
+    int i;
+
+    if (variant != IMA_ADPCM_DVI4)
+        return NULL;
+    /*endif*/
+    if (channels <= 0)
+        return NULL;
+    /*endif*/
+    if (s == NULL)
+    {
+        if ((s = (ima_adpcm_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+        /*endif*/
+    }
+    /*endif*/
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    /* Round up to whole vectors, so the step never needs a scalar tail */
+    s->stride = (channels + 7) & ~7;
+    if ((x = (int32_t *) malloc(IMA_ADPCM_BANK_NUM_ARRAYS*s->stride*sizeof(int32_t))) == NULL)
+        return NULL;
+    /*endif*/
+    s->last = x;
+    s->step_index = (x += s->stride);
+    s->ima_byte = (x += s->stride);
+    s->sl = (x += s->stride);
+    s->code = (x += s->stride);
+    /* The padding lanes are initialised too, so the vector code only ever sees
+       sane values. */
+    for (i = 0;  i < s->stride;  i++)
+        bank_init_channel(s, i);
+    /*endfor*/
+    return  s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int ima_adpcm_bank_release(ima_adpcm_bank_state_t *s)
+{
+    free(s->last);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int ima_adpcm_bank_reset_channel(ima_adpcm_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return -1;
+    /*endif*/
+    bank_init_channel(s, chan);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int ima_adpcm_bank_decode(ima_adpcm_bank_state_t *s,
+                          int16_t *amp[],
+                          const uint8_t *ima_data[],
+                          int ima_bytes)
+{
+    int i;
+    int c;
+    int samples;
+
+    samples = 0;
+    for (i = 0;  i < ima_bytes;  i++)
+    {
+        for (c = 0;  c < s->channels;  c++)
+            s->code[c] = ima_data[c][i] & 0xF;
+        /*endfor*/
+        bank_decode(s);
+        for (c = 0;  c < s->channels;  c++)
+            amp[c][samples] = (int16_t) s->last[c];
+        /*endfor*/
+        samples++;
+        for (c = 0;  c < s->channels;  c++)
+            s->code[c] = (ima_data[c][i] >> 4) & 0xF;
+        /*endfor*/
+        bank_decode(s);
+        for (c = 0;  c < s->channels;  c++)
+            amp[c][samples] = (int16_t) s->last[c];
+        /*endfor*/
+        samples++;
+    }
+    /*endfor*/
+    return samples;
+}
+/*- End of function --------------------------------------------------------*/
+
+int ima_adpcm_bank_encode(ima_adpcm_bank_state_t *s,
+                          uint8_t *ima_data[],
+                          const int16_t *amp[],
+                          int len)
+{
+    int i;
+    int c;
+    int bytes;
+
+    bytes = 0;
+    for (i = 0;  i < len;  i++)
+    {
+        for (c = 0;  c < s->channels;  c++)
+            s->sl[c] = amp[c][i];
+        /*endfor*/
+        bank_encode(s);
+        for (c = 0;  c < s->channels;  c++)
+            s->ima_byte[c] = ((s->ima_byte[c] >> 4) | (s->code[c] << 4)) & 0xFF;
+        /*endfor*/
+        /* The channels are in lockstep, so they all fill a byte together */
+        if ((s->bits++ & 1))
+        {
+            for (c = 0;  c < s->channels;  c++)
+                ima_data[c][bytes] = (uint8_t) s->ima_byte[c];
+            /*endfor*/
+            bytes++;
+        }
+        /*endif*/
+    }
+    /*endfor*/
+    return  bytes;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
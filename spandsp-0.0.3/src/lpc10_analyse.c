@@ -43,6 +43,11 @@
 #if defined(HAVE_MATH_H)
 #include <math.h>
 #endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/dc_restore.h"
@@ -91,10 +96,64 @@ static void eval_amdf(float speech[],
     int j;
     int n1;
     int n2;
+#if defined(__AVX2__)
+    __m256i idx1;
+    __m256i idx2;
+    __m256 acc8;
+#endif
+#if defined(__SSE2__)
+    int k;
+    const float *p1[4];
+    const float *p2[4];
+    __m128 acc4;
+    __m128 sign_mask;
+#endif
 
-    *minptr = 0;
-    *maxptr = 0;
-    for (i = 0;  i < ltau;  i++)
+    /* Several lags are worked on at once, one lag per lane. Each lane still sums
+       its terms in the same order as the plain C code, so the results are exactly
+       the same. */
+    i = 0;
+#if defined(__AVX2__)
+    for (  ;  i + 8 <= ltau;  i += 8)
+    {
+        idx1 = _mm256_loadu_si256((const __m256i *) &tau[i]);
+        /* n1 - 1 = (maxlag - tau)/2, which is never negative */
+        idx2 = _mm256_srli_epi32(_mm256_sub_epi32(_mm256_set1_epi32(maxlag), idx1), 1);
+        idx1 = _mm256_add_epi32(idx2, idx1);
+        acc8 = _mm256_setzero_ps();
+        for (j = 0;  j < lpita;  j += 4)
+        {
+            acc8 = _mm256_add_ps(acc8,
+                                 _mm256_andnot_ps(_mm256_set1_ps(-0.0f),
+                                                  _mm256_sub_ps(_mm256_i32gather_ps(speech, idx2, 4),
+                                                                _mm256_i32gather_ps(speech, idx1, 4))));
+            idx1 = _mm256_add_epi32(idx1, _mm256_set1_epi32(4));
+            idx2 = _mm256_add_epi32(idx2, _mm256_set1_epi32(4));
+        }
+        _mm256_storeu_ps(&amdf[i], acc8);
+    }
+#endif
+#if defined(__SSE2__)
+    sign_mask = _mm_set1_ps(-0.0f);
+    for (  ;  i + 4 <= ltau;  i += 4)
+    {
+        for (k = 0;  k < 4;  k++)
+        {
+            p1[k] = &speech[(maxlag - tau[i + k])/2];
+            p2[k] = p1[k] + tau[i + k];
+        }
+        acc4 = _mm_setzero_ps();
+        for (j = 0;  j < lpita;  j += 4)
+        {
+            acc4 = _mm_add_ps(acc4,
+                              _mm_andnot_ps(sign_mask,
+                                            _mm_sub_ps(_mm_set_ps(p1[3][j], p1[2][j], p1[1][j], p1[0][j]),
+                                                       _mm_set_ps(p2[3][j], p2[2][j], p2[1][j], p2[0][j]))));
+        }
+        _mm_storeu_ps(&amdf[i], acc4);
+    }
+#endif
+    for (  ;  i < ltau;  i++)
     {
         n1 = (maxlag - tau[i])/2 + 1;
         n2 = n1 + lpita - 1;
@@ -102,6 +161,12 @@ static void eval_amdf(float speech[],
         for (j = n1;  j <= n2;  j += 4)
             sum += fabsf(speech[j - 1] - speech[j + tau[i] - 1]);
         amdf[i] = sum;
+    }
+
+    *minptr = 0;
+    *maxptr = 0;
+    for (i = 0;  i < ltau;  i++)
+    {
         if (amdf[i] < amdf[*minptr])
             *minptr = i;
         if (amdf[i] > amdf[*maxptr])
@@ -374,14 +439,69 @@ static void mload(int32_t order, int32_t awins, int32_t awinf, float speech[], f
     int32_t start;
     int i;
     int r;
+#if defined(__SSE2__)
+    float rev[156 + 16];
+    float phi_v[12];
+    int last;
+#endif
+#if defined(__AVX2__)
+    __m256 acc8;
+    __m256 x8;
+#endif
+#if defined(__SSE2__)
+    __m128 acc4[3];
+    __m128 x4;
+#endif
 
     start = awins + order;
+#if defined(__SSE2__)
+    /* All the first column of phi is accumulated at once, one lane for each r, which
+       needs speech[i - r - 1] for r = 1, 2, 3... at consecutive addresses. A reversed
+       copy of the speech, with zeros after it for the unused lanes, gives that. Each
+       lane sums its terms in the same order as the plain C code. This handles an order
+       of up to 12, and LPC10 uses 10. */
+    last = awinf - 2;
+    for (i = 0;  i <= last;  i++)
+        rev[i] = speech[last - i];
+    for (  ;  i <= last + 16;  i++)
+        rev[i] = 0.0f;
+#if defined(__AVX2__)
+    acc8 = _mm256_setzero_ps();
+#endif
+    acc4[0] = _mm_setzero_ps();
+    acc4[1] = _mm_setzero_ps();
+    acc4[2] = _mm_setzero_ps();
+    for (i = start;  i <= awinf;  i++)
+    {
+        /* speech[i - r - 1] is rev[last - i + 1 + r] */
+#if defined(__AVX2__)
+        x8 = _mm256_set1_ps(speech[i - 2]);
+        acc8 = _mm256_add_ps(acc8, _mm256_mul_ps(x8, _mm256_loadu_ps(&rev[last - i + 2])));
+        x4 = _mm256_castps256_ps128(x8);
+#else
+        x4 = _mm_set1_ps(speech[i - 2]);
+        acc4[0] = _mm_add_ps(acc4[0], _mm_mul_ps(x4, _mm_loadu_ps(&rev[last - i + 2])));
+        acc4[1] = _mm_add_ps(acc4[1], _mm_mul_ps(x4, _mm_loadu_ps(&rev[last - i + 6])));
+#endif
+        acc4[2] = _mm_add_ps(acc4[2], _mm_mul_ps(x4, _mm_loadu_ps(&rev[last - i + 10])));
+    }
+#if defined(__AVX2__)
+    _mm256_storeu_ps(&phi_v[0], acc8);
+#else
+    _mm_storeu_ps(&phi_v[0], acc4[0]);
+    _mm_storeu_ps(&phi_v[4], acc4[1]);
+#endif
+    _mm_storeu_ps(&phi_v[8], acc4[2]);
+    for (r = 1;  r <= order;  r++)
+        phi[r - 1] = phi_v[r - 1];
+#else
     for (r = 1;  r <= order;  r++)
     {
         phi[r - 1] = 0.0f;
         for (i = start;  i <= awinf;  i++)
             phi[r - 1] += speech[i - 2]*speech[i - r - 1];
     }
+#endif
 
     /* Load last element of vector PSI */
     psi[order - 1] = 0.0f;
@@ -481,15 +601,66 @@ static int rcchk(int order, float rc1f[], float rc2f[])
 
 static void lpfilt(float inbuf[], float lpbuf[], int32_t len, int32_t nsamp)
 {
+#if defined(__SSE2__)
+    /* The coefficients of the first half of the filter, in the order the plain C
+       code below applies them */
+    static const float lpfilt_coeffs[16] =
+    {
+        -0.0097201988f, -0.0105179986f, -0.0083479648f, 5.860774e-4f,
+        0.0130892089f, 0.0217052232f, 0.0184161253f, 3.39723e-4f,
+        -0.0260797087f, -0.0455563702f, -0.040306855f, 5.029835e-4f,
+        0.0729262903f, 0.1572008878f, 0.2247288674f, 0.250535965f
+    };
+#endif
     int32_t j;
     float t;
+#if defined(__AVX2__)
+    __m256 t8;
+#endif
+#if defined(__SSE2__)
+    __m128 t4;
+    int k;
+#endif
 
     /* 31 point equiripple FIR LPF */
     /* Linear phase, delay = 15 samples */
     /* Passband:  ripple = 0.25 dB, cutoff =  800 Hz */
     /* Stopband:  atten. =  40. dB, cutoff = 1240 Hz */
 
-    for (j = len - nsamp;  j < len;  j++)
+    /* Several outputs are worked on at once, one per lane, each built up in the
+       same order as the plain C code. */
+    j = len - nsamp;
+#if defined(__AVX2__)
+    for (  ;  j + 8 <= len;  j += 8)
+    {
+        t8 = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&inbuf[j]), _mm256_loadu_ps(&inbuf[j - 30])),
+                           _mm256_set1_ps(lpfilt_coeffs[0]));
+        for (k = 1;  k < 15;  k++)
+        {
+            t8 = _mm256_add_ps(t8,
+                               _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&inbuf[j - k]), _mm256_loadu_ps(&inbuf[j - 30 + k])),
+                                             _mm256_set1_ps(lpfilt_coeffs[k])));
+        }
+        t8 = _mm256_add_ps(t8, _mm256_mul_ps(_mm256_loadu_ps(&inbuf[j - 15]), _mm256_set1_ps(lpfilt_coeffs[15])));
+        _mm256_storeu_ps(&lpbuf[j], t8);
+    }
+#endif
+#if defined(__SSE2__)
+    for (  ;  j + 4 <= len;  j += 4)
+    {
+        t4 = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&inbuf[j]), _mm_loadu_ps(&inbuf[j - 30])),
+                        _mm_set1_ps(lpfilt_coeffs[0]));
+        for (k = 1;  k < 15;  k++)
+        {
+            t4 = _mm_add_ps(t4,
+                            _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&inbuf[j - k]), _mm_loadu_ps(&inbuf[j - 30 + k])),
+                                       _mm_set1_ps(lpfilt_coeffs[k])));
+        }
+        t4 = _mm_add_ps(t4, _mm_mul_ps(_mm_loadu_ps(&inbuf[j - 15]), _mm_set1_ps(lpfilt_coeffs[15])));
+        _mm_storeu_ps(&lpbuf[j], t4);
+    }
+#endif
+    for (  ;  j < len;  j++)
     {
         t = (inbuf[j] + inbuf[j - 30]) * -0.0097201988f;
         t += (inbuf[j - 1] + inbuf[j - 29]) * -0.0105179986f;
@@ -543,7 +714,16 @@ static void ivfilt(float lpbuf[], float ivbuf[], int32_t len, int32_t nsamp, flo
         pc2 = ivrc[1];
     }
     /* Inverse filter LPBUF into IVBUF */
-    for (i = len - nsamp;  i < len;  i++)
+    i = len - nsamp;
+#if defined(__SSE2__)
+    for (  ;  i + 4 <= len;  i += 4)
+    {
+        _mm_storeu_ps(&ivbuf[i],
+                      _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&lpbuf[i]), _mm_mul_ps(_mm_set1_ps(pc1), _mm_loadu_ps(&lpbuf[i - 4]))),
+                                 _mm_mul_ps(_mm_set1_ps(pc2), _mm_loadu_ps(&lpbuf[i - 8]))));
+    }
+#endif
+    for (  ;  i < len;  i++)
         ivbuf[i] = lpbuf[i] - pc1*lpbuf[i - 4] - pc2*lpbuf[i - 8];
 }
 /*- End of function --------------------------------------------------------*/
@@ -391,4 +391,16 @@ int lpc10_encode(lpc10_encode_state_t *s, uint8_t code[], const int16_t amp[], i
     return quant*7;
 }
 /*- End of function --------------------------------------------------------*/
+
+int lpc10_encode_batch(lpc10_encode_state_t *s[], uint8_t *code[], const int16_t *amp[], int channels, int quant)
+{
+    int bytes;
+    int i;
+
+    bytes = 0;
+    for (i = 0;  i < channels;  i++)
+        bytes = lpc10_encode(s[i], code[i], amp[i], quant);
+    return bytes;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
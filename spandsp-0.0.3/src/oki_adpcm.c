@@ -39,6 +39,11 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/oki_adpcm.h"
@@ -46,7 +51,9 @@
 /* Routines to convert 12 bit linear samples to the Oki ADPCM coding format,
    widely used in CTI, because Dialogic use it. */
 
-static const int16_t step_size[49] =
+/* The table is padded with an unused entry, so the AVX2 code can safely fetch it
+   32 bits at a time */
+static const int16_t step_size[49 + 1] =
 {
       16,   17,   19,   21,   23,   25,   28,   31,
       34,   37,   41,   45,   50,   55,   60,   66,
@@ -54,7 +61,7 @@ static const int16_t step_size[49] =
      157,  173,  190,  209,  230,  253,  279,  307,
      337,  371,  408,  449,  494,  544,  598,  658,
      724,  796,  876,  963, 1060, 1166, 1282, 1408,
-    1552
+    1552,    0
 };
 
 static const int16_t step_adjustment[8] =
@@ -373,4 +380,491 @@ int oki_adpcm_encode(oki_adpcm_state_t *s,
     return  bytes;
 }
 /*- End of function --------------------------------------------------------*/
+/*
+ * The bank functions run a number of channels in lockstep. Each sample is
+ * processed in three passes over the channels - the codes or samples are picked
+ * up from each channel's buffer, every channel's ADPCM state is stepped, and the
+ * results are put in each channel's buffer. The step is written without
+ * branches, so with SSE2 or AVX2 it works on a vector of channels at a time, in
+ * 32 bit lanes. At 24kbps the resampling filter also works on a vector of
+ * channels at a time, adding up the taps in the same order as the single channel
+ * code, so the results are the same.
+ */
+#define OKI_ADPCM_BANK_NUM_ARRAYS   5
+
+#if defined(__AVX2__)  ||  defined(__SSE2__)
+#if defined(__AVX2__)
+#define OKI_ADPCM_LANES 8
+typedef __m256i oki_vec_t;
+typedef __m256 oki_vecf_t;
+#define vload(p)        _mm256_loadu_si256((const __m256i *) (p))
+#define vstore(p, x)    _mm256_storeu_si256((__m256i *) (p), x)
+#define vset1           _mm256_set1_epi32
+#define vzero           _mm256_setzero_si256
+#define vadd            _mm256_add_epi32
+#define vsub            _mm256_sub_epi32
+#define vand            _mm256_and_si256
+#define vor             _mm256_or_si256
+#define vxor            _mm256_xor_si256
+#define vsrai           _mm256_srai_epi32
+#define vslli           _mm256_slli_epi32
+#define vcmpeq          _mm256_cmpeq_epi32
+#define vcmpgt          _mm256_cmpgt_epi32
+#define vmin            _mm256_min_epi32
+#define vmax            _mm256_max_epi32
+#define vloadf          _mm256_loadu_ps
+#define vsetf           _mm256_set1_ps
+#define vzerof          _mm256_setzero_ps
+#define vaddf           _mm256_add_ps
+#define vmulf           _mm256_mul_ps
+#define vcvti           _mm256_cvttps_epi32
+/* Look up the step sizes for a vector of step indices */
+#define vstep_size(p)   vand(_mm256_i32gather_epi32((const int *) step_size, vload(p), 2), vset1(0xFFFF))
+#else
+#define OKI_ADPCM_LANES 4
+typedef __m128i oki_vec_t;
+typedef __m128 oki_vecf_t;
+#define vload(p)        _mm_loadu_si128((const __m128i *) (p))
+#define vstore(p, x)    _mm_storeu_si128((__m128i *) (p), x)
+#define vset1           _mm_set1_epi32
+#define vzero           _mm_setzero_si128
+#define vadd            _mm_add_epi32
+#define vsub            _mm_sub_epi32
+#define vand            _mm_and_si128
+#define vandnot         _mm_andnot_si128
+#define vor             _mm_or_si128
+#define vxor            _mm_xor_si128
+#define vsrai           _mm_srai_epi32
+#define vslli           _mm_slli_epi32
+#define vcmpeq          _mm_cmpeq_epi32
+#define vcmpgt          _mm_cmpgt_epi32
+#define vsel(m, a, b)   vor(vand(m, a), vandnot(m, b))
+#define vmin(a, b)      vsel(vcmpgt(b, a), a, b)
+#define vmax(a, b)      vsel(vcmpgt(a, b), a, b)
+#define vloadf          _mm_loadu_ps
+#define vsetf           _mm_set1_ps
+#define vzerof          _mm_setzero_ps
+#define vaddf           _mm_add_ps
+#define vmulf           _mm_mul_ps
+#define vcvti           _mm_cvttps_epi32
+/* SSE2 has no gather, so the step sizes are looked up one lane at a time */
+#define vstep_size(p)   _mm_set_epi32(step_size[(p)[3]], step_size[(p)[2]], step_size[(p)[1]], step_size[(p)[0]])
+#endif
+
+#define vones()         vcmpeq(vzero(), vzero())
+/* All ones in the lanes where the code has bit b set */
+#define vbit(x, b)      vcmpeq(vand(x, vset1(b)), vset1(b))
+/* All ones in the lanes where a >= b */
+#define vcmpge(a, b)    vxor(vcmpgt(b, a), vones())
+/* Wrap to 16 bits, like storing in an int16_t */
+#define vwrap16(x)      vsrai(vslli(x, 16), 16)
+
+/* decode() for a vector of channels */
+static __inline__ void decode_vec(oki_vec_t ss, oki_vec_t code, int32_t *last, int32_t *step_index)
+{
+    oki_vec_t e;
+    oki_vec_t sign;
+    oki_vec_t adjust;
+
+    e = vsrai(ss, 3);
+    e = vadd(e, vand(vbit(code, 0x01), vsrai(ss, 2)));
+    e = vadd(e, vand(vbit(code, 0x02), vsrai(ss, 1)));
+    e = vadd(e, vand(vbit(code, 0x04), ss));
+    sign = vbit(code, 0x08);
+    e = vsub(vxor(e, sign), sign);
+    vstore(last, vmin(vmax(vadd(vload(last), e), vset1(-2048)), vset1(2047)));
+    /* step_adjustment[] is -1 for codes 0 to 3, and 2, 4, 6, 8 for codes 4 to 7 */
+    adjust = vsub(vand(vbit(code, 0x04), vadd(vslli(vand(code, vset1(0x03)), 1), vset1(3))), vset1(1));
+    vstore(step_index, vmin(vmax(vadd(vload(step_index), adjust), vzero()), vset1(48)));
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_decode(oki_adpcm_bank_state_t *s)
+{
+    int c;
+
+    for (c = 0;  c < s->stride;  c += OKI_ADPCM_LANES)
+        decode_vec(vstep_size(&s->step_index[c]), vload(&s->code[c]), &s->last[c], &s->step_index[c]);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_encode(oki_adpcm_bank_state_t *s)
+{
+    oki_vec_t ss;
+    oki_vec_t e;
+    oki_vec_t sign;
+    oki_vec_t b2;
+    oki_vec_t b1;
+    oki_vec_t b0;
+    oki_vec_t code;
+    int c;
+
+    for (c = 0;  c < s->stride;  c += OKI_ADPCM_LANES)
+    {
+        ss = vstep_size(&s->step_index[c]);
+        e = vsub(vsrai(vload(&s->sl[c]), 4), vload(&s->last[c]));
+        sign = vsrai(e, 31);
+        e = vsub(vxor(e, sign), sign);
+        b2 = vcmpge(e, ss);
+        e = vsub(e, vand(b2, ss));
+        /* Like encode(), this takes off the whole step size, not half of it */
+        b1 = vcmpge(e, vsrai(ss, 1));
+        e = vsub(e, vand(b1, ss));
+        b0 = vcmpge(e, vsrai(ss, 2));
+        code = vor(vor(vand(sign, vset1(0x08)), vand(b2, vset1(0x04))),
+                   vor(vand(b1, vset1(0x02)), vand(b0, vset1(0x01))));
+        vstore(&s->code[c], code);
+        decode_vec(ss, code, &s->last[c], &s->step_index[c]);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Run the resampling filter for every channel, from tap "first" down in steps
+   of "step", leaving the scaled results in sl[]. */
+static void bank_filter(oki_adpcm_bank_state_t *s, int first, int step, float scale)
+{
+    oki_vecf_t z;
+    int c;
+    int l;
+    int x;
+
+    for (c = 0;  c < s->stride;  c += OKI_ADPCM_LANES)
+    {
+        z = vzerof();
+        for (l = first, x = s->ptr - 1;  l >= 0;  l -= step, x--)
+            z = vaddf(z, vmulf(vsetf(cutoff_coeffs[l]), vloadf(&s->history[(x & (32 - 1))*s->stride + c])));
+        vstore(&s->sl[c], vwrap16(vcvti(vmulf(z, vsetf(scale)))));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+#else
+static __inline__ void decode_bank_channel(oki_adpcm_bank_state_t *s, int c, int ss, int code)
+{
+    int e;
+    int sign;
+    int linear;
+    int step_index;
+
+    e = (ss >> 3)
+      + (-(code & 0x01) & (ss >> 2))
+      + (-((code >> 1) & 0x01) & (ss >> 1))
+      + (-((code >> 2) & 0x01) & ss);
+    sign = -((code >> 3) & 0x01);
+    e = (e ^ sign) - sign;
+    linear = s->last[c] + e;
+    if (linear > 2047)
+        linear = 2047;
+    else if (linear < -2048)
+        linear = -2048;
+    /*endif*/
+    s->last[c] = linear;
+    step_index = s->step_index[c] + step_adjustment[code & 0x07];
+    if (step_index < 0)
+        step_index = 0;
+    else if (step_index > 48)
+        step_index = 48;
+    /*endif*/
+    s->step_index[c] = step_index;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_decode(oki_adpcm_bank_state_t *s)
+{
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+        decode_bank_channel(s, c, step_size[s->step_index[c]], s->code[c]);
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_encode(oki_adpcm_bank_state_t *s)
+{
+    int ss;
+    int e;
+    int sign;
+    int b2;
+    int b1;
+    int b0;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        ss = step_size[s->step_index[c]];
+        e = (s->sl[c] >> 4) - s->last[c];
+        sign = e >> 31;
+        e = (e ^ sign) - sign;
+        b2 = -(e >= ss);
+        e -= (b2 & ss);
+        /* Like encode(), this takes off the whole step size, not half of it */
+        b1 = -(e >= (ss >> 1));
+        e -= (b1 & ss);
+        b0 = -(e >= (ss >> 2));
+        s->code[c] = (sign & 0x08) | (b2 & 0x04) | (b1 & 0x02) | (b0 & 0x01);
+        decode_bank_channel(s, c, ss, s->code[c]);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_filter(oki_adpcm_bank_state_t *s, int first, int step, float scale)
+{
+    float z;
+    int c;
+    int l;
+    int x;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        z = 0.0f;
+        for (l = first, x = s->ptr - 1;  l >= 0;  l -= step, x--)
+            z += cutoff_coeffs[l]*s->history[(x & (32 - 1))*s->stride + c];
+        /*endfor*/
+        s->sl[c] = (int16_t) (z*scale);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+static void bank_init_channel(oki_adpcm_bank_state_t *s, int c)
+{
+    int i;
+
+    s->last[c] = 0;
+    s->step_index[c] = 0;
+    s->oki_byte[c] = 0;
+    s->sl[c] = 0;
+    s->code[c] = 0;
+    for (i = 0;  i < 32;  i++)
+        s->history[i*s->stride + c] = 0.0f;
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+oki_adpcm_bank_state_t *oki_adpcm_bank_init(oki_adpcm_bank_state_t *s, int channels, int bit_rate)
+{
+    int32_t *x;
+    int i;
+
+    if (bit_rate != 32000  &&  bit_rate != 24000)
+        return NULL;
+    /*endif*/
+    if (channels <= 0)
+        return NULL;
+    /*endif*/
+    if (s == NULL)
+    {
+        if ((s = (oki_adpcm_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+        /*endif*/
+    }
+    /*endif*/
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    /* Round up to whole vectors, so the step never needs a scalar tail */
+    s->stride = (channels + 7) & ~7;
+    if ((x = (int32_t *) malloc(OKI_ADPCM_BANK_NUM_ARRAYS*s->stride*sizeof(int32_t))) == NULL)
+        return NULL;
+    /*endif*/
+    if ((s->history = (float *) malloc(32*s->stride*sizeof(float))) == NULL)
+    {
+        free(x);
+        return NULL;
+    }
+    /*endif*/
+    s->last = x;
+    s->step_index = (x += s->stride);
+    s->oki_byte = (x += s->stride);
+    s->sl = (x += s->stride);
+    s->code = (x += s->stride);
+    s->bit_rate = bit_rate;
+    /* The padding lanes are initialised too, so the vector code only ever sees
+       sane values. */
+    for (i = 0;  i < s->stride;  i++)
+        bank_init_channel(s, i);
+    /*endfor*/
+    return  s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int oki_adpcm_bank_release(oki_adpcm_bank_state_t *s)
+{
+    free(s->last);
+    free(s->history);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int oki_adpcm_bank_reset_channel(oki_adpcm_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return -1;
+    /*endif*/
+    bank_init_channel(s, chan);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int oki_adpcm_bank_decode(oki_adpcm_bank_state_t *s,
+                          int16_t *amp[],
+                          const uint8_t *oki_data[],
+                          int oki_bytes)
+{
+    float *history;
+    int i;
+    int c;
+    int n;
+    int samples;
+
+    samples = 0;
+    if (s->bit_rate == 32000)
+    {
+        for (i = 0;  i < oki_bytes;  i++)
+        {
+            for (c = 0;  c < s->channels;  c++)
+                s->code[c] = (oki_data[c][i] >> 4) & 0xF;
+            /*endfor*/
+            bank_decode(s);
+            for (c = 0;  c < s->channels;  c++)
+                amp[c][samples] = (int16_t) (s->last[c] << 4);
+            /*endfor*/
+            samples++;
+            for (c = 0;  c < s->channels;  c++)
+                s->code[c] = oki_data[c][i] & 0xF;
+            /*endfor*/
+            bank_decode(s);
+            for (c = 0;  c < s->channels;  c++)
+                amp[c][samples] = (int16_t) (s->last[c] << 4);
+            /*endfor*/
+            samples++;
+        }
+        /*endfor*/
+    }
+    else
+    {
+        n = 0;
+        for (i = 0;  i < oki_bytes;  )
+        {
+            /* 6k to 8k sample/second conversion */
+            if (s->phase)
+            {
+                for (c = 0;  c < s->channels;  c++)
+                    s->code[c] = (n & 1)  ?  (oki_data[c][i] & 0xF)  :  ((oki_data[c][i] >> 4) & 0xF);
+                /*endfor*/
+                if ((n++ & 1))
+                    i++;
+                /*endif*/
+                bank_decode(s);
+                history = &s->history[s->ptr*s->stride];
+                for (c = 0;  c < s->channels;  c++)
+                    history[c] = (float) (s->last[c] << 4);
+                /*endfor*/
+                s->ptr = (s->ptr + 1) & (32 - 1);
+            }
+            /*endif*/
+            bank_filter(s, 80 - 3 + s->phase, 4, 4.0f);
+            for (c = 0;  c < s->channels;  c++)
+                amp[c][samples] = (int16_t) s->sl[c];
+            /*endfor*/
+            samples++;
+            if (++s->phase > 3)
+                s->phase = 0;
+            /*endif*/
+        }
+        /*endfor*/
+    }
+    /*endif*/
+    return  samples;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_pack(oki_adpcm_bank_state_t *s, uint8_t *oki_data[], int *bytes)
+{
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+        s->oki_byte[c] = ((s->oki_byte[c] << 4) | s->code[c]) & 0xFF;
+    /*endfor*/
+    /* The channels are in lockstep, so they all fill a byte together */
+    if ((s->mark++ & 1))
+    {
+        for (c = 0;  c < s->channels;  c++)
+            oki_data[c][*bytes] = (uint8_t) s->oki_byte[c];
+        /*endfor*/
+        (*bytes)++;
+    }
+    /*endif*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_push(oki_adpcm_bank_state_t *s, const int16_t *amp[], int n)
+{
+    float *history;
+    int c;
+
+    history = &s->history[s->ptr*s->stride];
+    for (c = 0;  c < s->channels;  c++)
+        history[c] = amp[c][n];
+    /*endfor*/
+    s->ptr = (s->ptr + 1) & (32 - 1);
+}
+/*- End of function --------------------------------------------------------*/
+
+int oki_adpcm_bank_encode(oki_adpcm_bank_state_t *s,
+                          uint8_t *oki_data[],
+                          const int16_t *amp[],
+                          int len)
+{
+    int c;
+    int n;
+    int bytes;
+
+    bytes = 0;
+    if (len <= 0)
+        return 0;
+    /*endif*/
+    if (s->bit_rate == 32000)
+    {
+        for (n = 0;  n < len;  n++)
+        {
+            for (c = 0;  c < s->channels;  c++)
+                s->sl[c] = amp[c][n];
+            /*endfor*/
+            bank_encode(s);
+            bank_pack(s, oki_data, &bytes);
+        }
+        /*endfor*/
+    }
+    else
+    {
+        n = 0;
+        for (;;)
+        {
+            /* 8k to 6k sample/second conversion */
+            if (s->phase > 2)
+            {
+                bank_push(s, amp, n);
+                s->phase = 0;
+                if (++n >= len)
+                    break;
+                /*endif*/
+            }
+            /*endif*/
+            bank_push(s, amp, n);
+            bank_filter(s, 80 - s->phase, 3, 3.0f);
+            bank_encode(s);
+            bank_pack(s, oki_data, &bytes);
+            s->phase++;
+            if (++n >= len)
+                break;
+            /*endif*/
+        }
+        /*endfor*/
+    }
+    /*endif*/
+    return  bytes;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -0,0 +1,286 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * pipeline.c - Run a channel's chain of DSP stages a block at a time, with
+ *              per stage cycle accounting.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "spandsp/telephony.h"
+#include "spandsp/timing.h"
+#include "spandsp/bit_operations.h"
+#include "spandsp/bitstream.h"
+#include "spandsp/g711.h"
+#include "spandsp/g726.h"
+#include "spandsp/echo.h"
+#include "spandsp/tone_detect.h"
+#include "spandsp/tone_generate.h"
+#include "spandsp/tone_analysis.h"
+#include "spandsp/dtmf.h"
+#include "spandsp/plc.h"
+#include "spandsp/pipeline.h"
+
+#if defined(__i386__)  ||  defined(__x86_64__)
+#define pipeline_clock() rdtscll()
+#else
+static __inline__ uint64_t pipeline_clock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec*1000000000 + now.tv_nsec;
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+static void echo_can_hpf_tx_stage(void *user_data, pipeline_block_t *block)
+{
+    if (block->ref)
+        echo_can_hpf_tx_block((echo_can_state_t *) user_data, block->ref, block->len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void echo_can_stage(void *user_data, pipeline_block_t *block)
+{
+    if (block->ref)
+        echo_can_update_block((echo_can_state_t *) user_data, block->amp, block->ref, block->amp, block->len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void dtmf_rx_stage(void *user_data, pipeline_block_t *block)
+{
+    dtmf_rx((dtmf_rx_state_t *) user_data, block->amp, block->len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void tone_analysis_stage(void *user_data, pipeline_block_t *block)
+{
+    tone_analysis((tone_analysis_state_t *) user_data, block->amp, block->len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void plc_stage(void *user_data, pipeline_block_t *block)
+{
+    if (block->lost)
+        plc_fillin((plc_state_t *) user_data, block->amp, block->len);
+    else
+        plc_rx((plc_state_t *) user_data, block->amp, block->len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void alaw_encode_stage(void *user_data, pipeline_block_t *block)
+{
+    if (block->code == NULL)
+        return;
+    g711_alaw_encode_block(block->code + block->code_len, block->amp, block->len);
+    block->code_len += block->len;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void ulaw_encode_stage(void *user_data, pipeline_block_t *block)
+{
+    if (block->code == NULL)
+        return;
+    g711_ulaw_encode_block(block->code + block->code_len, block->amp, block->len);
+    block->code_len += block->len;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void g726_encode_stage(void *user_data, pipeline_block_t *block)
+{
+    if (block->code == NULL)
+        return;
+    block->code_len += g726_encode((g726_state_t *) user_data, block->code + block->code_len, block->amp, block->len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int pipeline_run(pipeline_state_t *s, int16_t amp[], int16_t ref[], int len, uint8_t code[], int lost)
+{
+    pipeline_block_t block;
+    pipeline_stage_t *stage;
+    uint64_t start;
+    uint64_t now;
+    int i;
+    int j;
+
+    block.lost = lost;
+    block.code = code;
+    block.code_len = 0;
+    for (i = 0;  i < len;  i += block.len)
+    {
+        block.len = (len - i < s->block_size)  ?  (len - i)  :  s->block_size;
+        block.amp = amp + i;
+        block.ref = (ref)  ?  (ref + i)  :  NULL;
+        if (lost)
+            memset(block.amp, 0, block.len*sizeof(block.amp[0]));
+        /* One reading of the clock between stages times them all */
+        start = pipeline_clock();
+        for (j = 0;  j < s->stages;  j++)
+        {
+            stage = &s->stage[j];
+            stage->process(stage->user_data, &block);
+            now = pipeline_clock();
+            stage->cycles += now - start;
+            stage->samples += block.len;
+            start = now;
+        }
+    }
+    return block.code_len;
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_process(pipeline_state_t *s, int16_t amp[], int16_t ref[], int len, uint8_t code[])
+{
+    return pipeline_run(s, amp, ref, len, code, FALSE);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_fillin(pipeline_state_t *s, int16_t amp[], int16_t ref[], int len, uint8_t code[])
+{
+    return pipeline_run(s, amp, ref, len, code, TRUE);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_stage(pipeline_state_t *s, const char *name, pipeline_stage_func_t process, void *user_data)
+{
+    pipeline_stage_t *stage;
+
+    if (s->stages >= PIPELINE_MAX_STAGES)
+        return -1;
+    stage = &s->stage[s->stages];
+    stage->name = name;
+    stage->process = process;
+    stage->user_data = user_data;
+    stage->samples = 0;
+    stage->cycles = 0;
+    return s->stages++;
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_echo_can_hpf_tx(pipeline_state_t *s, echo_can_state_t *ec)
+{
+    return pipeline_add_stage(s, "tx HPF", echo_can_hpf_tx_stage, ec);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_echo_can(pipeline_state_t *s, echo_can_state_t *ec)
+{
+    return pipeline_add_stage(s, "echo canceller", echo_can_stage, ec);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_dtmf_rx(pipeline_state_t *s, dtmf_rx_state_t *dtmf)
+{
+    return pipeline_add_stage(s, "DTMF rx", dtmf_rx_stage, dtmf);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_tone_analysis(pipeline_state_t *s, tone_analysis_state_t *t)
+{
+    return pipeline_add_stage(s, "tone analysis", tone_analysis_stage, t);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_plc(pipeline_state_t *s, plc_state_t *plc)
+{
+    if (s->block_size < PLC_PITCH_OVERLAP_MAX)
+        return -1;
+    return pipeline_add_stage(s, "PLC", plc_stage, plc);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_alaw_encode(pipeline_state_t *s)
+{
+    return pipeline_add_stage(s, "A-law encode", alaw_encode_stage, NULL);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_ulaw_encode(pipeline_state_t *s)
+{
+    return pipeline_add_stage(s, "u-law encode", ulaw_encode_stage, NULL);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_add_g726_encode(pipeline_state_t *s, g726_state_t *g726)
+{
+    return pipeline_add_stage(s, "G.726 encode", g726_encode_stage, g726);
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_get_stage_stats(pipeline_state_t *s, int stage, const char **name, uint64_t *samples, uint64_t *cycles)
+{
+    if (stage < 0  ||  stage >= s->stages)
+        return -1;
+    *name = s->stage[stage].name;
+    *samples = s->stage[stage].samples;
+    *cycles = s->stage[stage].cycles;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+void pipeline_reset_stats(pipeline_state_t *s)
+{
+    int i;
+
+    for (i = 0;  i < s->stages;  i++)
+    {
+        s->stage[i].samples = 0;
+        s->stage[i].cycles = 0;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+pipeline_state_t *pipeline_init(pipeline_state_t *s, int block_size)
+{
+    if (block_size < 0)
+        return NULL;
+    if (s == NULL)
+    {
+        if ((s = (pipeline_state_t *) malloc(sizeof(*s))) == NULL)
+            return NULL;
+    }
+    memset(s, 0, sizeof(*s));
+    s->block_size = (block_size)  ?  block_size  :  PIPELINE_DEFAULT_BLOCK_SIZE;
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int pipeline_release(pipeline_state_t *s)
+{
+    if (s)
+        free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
@@ -196,7 +196,7 @@ int plc_fillin(plc_state_t *s, int16_t amp[], int len)
         /* We should now be ready to fill in the gap with repeated, decaying cycles
            of what is in pitchbuf */
 
-        gain = 1.0f;
+        s->gain = 1.0f;
         /* We need to OLA the first 1/4 wavelength of the synthetic data, to smooth
            it into the previous real data. To avoid the need to introduce a delay
            in the stream, reverse the last 1/4 wavelength, and OLA with that. */
@@ -204,6 +204,8 @@ int plc_fillin(plc_state_t *s, int16_t amp[], int len)
         old_step = new_step;
         new_weight = new_step;
         old_weight = 1.0f - new_step;
+        if (pitch_overlap > len)
+            pitch_overlap = len;
         for (i = 0;  i < pitch_overlap;  i++)
         {
             amp[i] = fsaturate(old_weight*s->history[PLC_HISTORY_LEN - 1 - i] + new_weight*s->pitchbuf[i]);
@@ -216,9 +218,11 @@ int plc_fillin(plc_state_t *s, int16_t amp[], int len)
     }
     else
     {
-        gain = 1.0f - s->missing_samples*ATTENUATION_INCREMENT;
         i = 0;
     }
+    /* The fade carries on from where the last call left it, so it is the same
+       however the gap is split into calls */
+    gain = s->gain;
     for (  ;  gain > 0.0f  &&  i < len;  i++)
     {
         amp[i] = (int16_t) (s->pitchbuf[s->pitch_offset]*gain);
@@ -226,6 +230,7 @@ int plc_fillin(plc_state_t *s, int16_t amp[], int len)
         if (++s->pitch_offset >= s->pitch)
             s->pitch_offset = 0;
     }
+    s->gain = gain;
     for (  ;  i < len;  i++)
         amp[i] = 0;
     s->missing_samples += orig_len;
@@ -43,6 +43,11 @@
 #endif
 #include <memory.h>
 #include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/dc_restore.h"
@@ -521,4 +526,707 @@ sig_tone_state_t *sig_tone_init(sig_tone_state_t *s, int tone_type, sig_tone_fun
     return s;
 }
 /*- End of function --------------------------------------------------------*/
+
+/* The bank works on 32 bit integers, a vector of channels at a time. The
+   multiplies keep the low 32 bits of each product, and the shifts are
+   arithmetic, exactly as in the scalar code. Comparisons give masks of all ones
+   or all zeros in each lane. This needs a 32 bit vector multiply - SSE2 alone
+   does not have one, and emulating it leaves the bank no faster than running
+   the channels one at a time, which is what it does without SSE4.1. AVX-512
+   comparisons give mask registers, rather than vectors, so AVX-512 builds use
+   the AVX2 code. */
+#if defined(__AVX2__)
+#define SIG_TONE_BANK_LANES 8
+typedef __m256i sig_vec_t;
+#define vload(p)        _mm256_loadu_si256((const __m256i *) (p))
+#define vstore(p, x)    _mm256_storeu_si256((__m256i *) (p), x)
+#define vset1           _mm256_set1_epi32
+#define vadd            _mm256_add_epi32
+#define vsub            _mm256_sub_epi32
+#define vmul            _mm256_mullo_epi32
+#define vand            _mm256_and_si256
+#define vandnot         _mm256_andnot_si256
+#define vor             _mm256_or_si256
+#define vxor            _mm256_xor_si256
+#define vabs            _mm256_abs_epi32
+#define vsra(a, n)      _mm256_sra_epi32(a, _mm_cvtsi32_si128(n))
+#define vcmpgt          _mm256_cmpgt_epi32
+#define vsel(m, a, b)   _mm256_blendv_epi8(b, a, m)
+#define vany(m)         _mm256_movemask_epi8(m)
+#elif defined(__SSE4_1__)
+#define SIG_TONE_BANK_LANES 4
+typedef __m128i sig_vec_t;
+#define vload(p)        _mm_loadu_si128((const __m128i *) (p))
+#define vstore(p, x)    _mm_storeu_si128((__m128i *) (p), x)
+#define vset1           _mm_set1_epi32
+#define vadd            _mm_add_epi32
+#define vsub            _mm_sub_epi32
+#define vmul            _mm_mullo_epi32
+#define vand            _mm_and_si128
+#define vandnot         _mm_andnot_si128
+#define vor             _mm_or_si128
+#define vxor            _mm_xor_si128
+#define vabs            _mm_abs_epi32
+#define vsra(a, n)      _mm_sra_epi32(a, _mm_cvtsi32_si128(n))
+#define vcmpgt          _mm_cmpgt_epi32
+#define vsel(m, a, b)   _mm_blendv_epi8(b, a, m)
+#define vany(m)         _mm_movemask_epi8(m)
+#endif
+
+#if defined(SIG_TONE_BANK_LANES)
+/* The working arrays of a bank, each one entry per channel */
+enum
+{
+    BANK_NOTCH_Z1_1 = 0,
+    BANK_NOTCH_Z1_2,
+    BANK_NOTCH_Z2_1,
+    BANK_NOTCH_Z2_2,
+    BANK_NOTCH_ZL,
+    BANK_BROAD_Z1,
+    BANK_BROAD_Z2,
+    BANK_BROAD_ZL,
+    BANK_MOWN_BANDPASS,
+    BANK_FLAT_MODE,
+    BANK_TONE_PRESENT,
+    BANK_NOTCH_ENABLED,
+    BANK_FLAT_MODE_TIMEOUT,
+    BANK_NOTCH_INSERTION_TIMEOUT,
+    BANK_TONE_PERSISTENCE_TIMEOUT,
+    BANK_DURATION,
+    BANK_PASSTHROUGH,
+    BANK_NUM_STATES,
+    /* The audio, one entry per channel for each sample in a chunk */
+    BANK_AMP = BANK_NUM_STATES,
+    BANK_NUM_ARRAYS = BANK_AMP + SIG_TONE_BANK_CHUNK
+};
+
+#define bank_array(s, n)    (&(s)->vec[(n)*(s)->stride])
+
+static void bank_report_changes(sig_tone_bank_state_t *s, int c, sig_vec_t change, sig_vec_t present, sig_vec_t duration)
+{
+    sig_tone_state_t *t;
+    int32_t lane_change[SIG_TONE_BANK_LANES];
+    int32_t lane_present[SIG_TONE_BANK_LANES];
+    int32_t lane_duration[SIG_TONE_BANK_LANES];
+    int i;
+
+    vstore(lane_change, change);
+    vstore(lane_present, present);
+    vstore(lane_duration, duration);
+    for (i = 0;  i < SIG_TONE_BANK_LANES  &&  c + i < s->channels;  i++)
+    {
+        if (lane_change[i])
+        {
+            t = &s->chan[c + i];
+            if (t->sig_update)
+            {
+                if (lane_present[i])
+                    t->sig_update(t->user_data, SIG_TONE_1_CHANGE | SIG_TONE_1_PRESENT | (lane_duration[i] << 16));
+                else
+                    t->sig_update(t->user_data, SIG_TONE_1_CHANGE | (lane_duration[i] << 16));
+                /*endif*/
+            }
+            /*endif*/
+        }
+        /*endif*/
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_rx_block(sig_tone_bank_state_t *s, int len)
+{
+    const sig_tone_descriptor_t *desc;
+    sig_vec_t zero;
+    sig_vec_t one;
+    sig_vec_t notch_z1_1;
+    sig_vec_t notch_z1_2;
+    sig_vec_t notch_z2_1;
+    sig_vec_t notch_z2_2;
+    sig_vec_t notch_zl;
+    sig_vec_t broad_z1;
+    sig_vec_t broad_z2;
+    sig_vec_t broad_zl;
+    sig_vec_t notched[SIG_TONE_BANK_CHUNK];
+    sig_vec_t mown_notch[SIG_TONE_BANK_CHUNK];
+    sig_vec_t mown_bandpass;
+    sig_vec_t flat_mode;
+    sig_vec_t tone_present;
+    sig_vec_t notch_enabled;
+    sig_vec_t flat_mode_timeout;
+    sig_vec_t notch_insertion_timeout;
+    sig_vec_t tone_persistence_timeout;
+    sig_vec_t duration;
+    sig_vec_t passthrough;
+    sig_vec_t amp;
+    sig_vec_t notched_signal;
+    sig_vec_t bandpass_signal;
+    sig_vec_t flat_zl;
+    sig_vec_t sharp_zl;
+    sig_vec_t x;
+    sig_vec_t running;
+    sig_vec_t detected;
+    sig_vec_t event;
+    sig_vec_t now_present;
+    sig_vec_t change;
+    sig_vec_t arm;
+    sig_vec_t decay;
+    sig_vec_t a1_0;
+    sig_vec_t a1_1;
+    sig_vec_t a1_2;
+    sig_vec_t b1_1;
+    sig_vec_t b1_2;
+    sig_vec_t a2_1;
+    sig_vec_t a2_2;
+    sig_vec_t b2_1;
+    sig_vec_t b2_2;
+    sig_vec_t notch_slugi;
+    sig_vec_t notch_slugp;
+    sig_vec_t notch_threshold;
+    int notch_postscale;
+    int32_t *p;
+    int c;
+    int j;
+
+    desc = s->desc;
+    zero = vset1(0);
+    one = vset1(1);
+    a1_0 = vset1(desc->notch_a1[0]);
+    a1_1 = vset1(desc->notch_a1[1]);
+    a1_2 = vset1(desc->notch_a1[2]);
+    b1_1 = vset1(desc->notch_b1[1]);
+    b1_2 = vset1(desc->notch_b1[2]);
+    a2_1 = vset1(desc->notch_a2[1]);
+    a2_2 = vset1(desc->notch_a2[2]);
+    b2_1 = vset1(desc->notch_b2[1]);
+    b2_2 = vset1(desc->notch_b2[2]);
+    notch_slugi = vset1(desc->notch_slugi);
+    notch_slugp = vset1(desc->notch_slugp);
+    notch_threshold = vset1(desc->notch_threshold);
+    notch_postscale = desc->notch_postscale;
+    for (c = 0;  c < s->stride;  c += SIG_TONE_BANK_LANES)
+    {
+        notch_z1_1 = vload(bank_array(s, BANK_NOTCH_Z1_1) + c);
+        notch_z1_2 = vload(bank_array(s, BANK_NOTCH_Z1_2) + c);
+        notch_z2_1 = vload(bank_array(s, BANK_NOTCH_Z2_1) + c);
+        notch_z2_2 = vload(bank_array(s, BANK_NOTCH_Z2_2) + c);
+        notch_zl = vload(bank_array(s, BANK_NOTCH_ZL) + c);
+        broad_z1 = vload(bank_array(s, BANK_BROAD_Z1) + c);
+        broad_z2 = vload(bank_array(s, BANK_BROAD_Z2) + c);
+        broad_zl = vload(bank_array(s, BANK_BROAD_ZL) + c);
+        mown_bandpass = vload(bank_array(s, BANK_MOWN_BANDPASS) + c);
+        flat_mode = vload(bank_array(s, BANK_FLAT_MODE) + c);
+        tone_present = vload(bank_array(s, BANK_TONE_PRESENT) + c);
+        notch_enabled = vload(bank_array(s, BANK_NOTCH_ENABLED) + c);
+        flat_mode_timeout = vload(bank_array(s, BANK_FLAT_MODE_TIMEOUT) + c);
+        notch_insertion_timeout = vload(bank_array(s, BANK_NOTCH_INSERTION_TIMEOUT) + c);
+        tone_persistence_timeout = vload(bank_array(s, BANK_TONE_PERSISTENCE_TIMEOUT) + c);
+        duration = vload(bank_array(s, BANK_DURATION) + c);
+        passthrough = vload(bank_array(s, BANK_PASSTHROUGH) + c);
+        /* The notch filter never depends on the decisions, so run it over the
+           whole stretch first. This keeps each loop within the registers. */
+        p = bank_array(s, BANK_AMP) + c;
+        for (j = 0;  j < len;  j++, p += s->stride)
+        {
+            /* This follows sig_tone_rx() step for step. The notch filter is two
+               cascaded biquads. */
+            notched_signal = vmul(vload(p), a1_0);
+            notched_signal = vadd(notched_signal, vmul(notch_z1_1, b1_1));
+            notched_signal = vadd(notched_signal, vmul(notch_z1_2, b1_2));
+            x = notched_signal;
+            notched_signal = vadd(notched_signal, vmul(notch_z1_1, a1_1));
+            notched_signal = vadd(notched_signal, vmul(notch_z1_2, a1_2));
+            notch_z1_2 = notch_z1_1;
+            notch_z1_1 = vsra(x, 15);
+
+            notched_signal = vadd(notched_signal, vmul(notch_z2_1, b2_1));
+            notched_signal = vadd(notched_signal, vmul(notch_z2_2, b2_2));
+            x = notched_signal;
+            notched_signal = vadd(notched_signal, vmul(notch_z2_1, a2_1));
+            notched_signal = vadd(notched_signal, vmul(notch_z2_2, a2_2));
+            notch_z2_2 = notch_z2_1;
+            notch_z2_1 = vsra(x, 15);
+
+            notched_signal = vsra(notched_signal, notch_postscale);
+
+            notch_zl = vadd(vsra(vmul(notch_zl, notch_slugi), 15), vsra(vmul(vabs(notched_signal), notch_slugp), 15));
+            notched[j] = notched_signal;
+            mown_notch[j] = vand(notch_zl, notch_threshold);
+        }
+        /*endfor*/
+
+        p = bank_array(s, BANK_AMP) + c;
+        for (j = 0;  j < len;  j++, p += s->stride)
+        {
+            amp = vload(p);
+            /* The duration count stops at 0xFFFF. */
+            duration = vsub(duration, vcmpgt(vset1(0xFFFF), duration));
+
+            /* Move to flat mode once the tone has been present for a while */
+            running = vcmpgt(flat_mode_timeout, zero);
+            flat_mode = vor(vand(tone_present, flat_mode), vandnot(running, tone_present));
+            flat_mode_timeout = vsel(tone_present, vadd(flat_mode_timeout, running), vset1(desc->sharp_flat_timeout));
+
+            /* Flat mode - the bandpass filter is a single bi-quad stage, only
+               updated for the channels in flat mode. Channels only reach flat
+               mode after a long spell of tone, so skip it when none are there. */
+            if (vany(flat_mode))
+            {
+                bandpass_signal = vmul(amp, vset1(desc->broad_a[0]));
+                bandpass_signal = vadd(bandpass_signal, vmul(broad_z1, vset1(desc->broad_b[1])));
+                bandpass_signal = vadd(bandpass_signal, vmul(broad_z2, vset1(desc->broad_b[2])));
+                x = bandpass_signal;
+                bandpass_signal = vadd(bandpass_signal, vmul(broad_z1, vset1(desc->broad_a[1])));
+                bandpass_signal = vadd(bandpass_signal, vmul(broad_z2, vset1(desc->broad_a[2])));
+                broad_z2 = vsel(flat_mode, broad_z1, broad_z2);
+                broad_z1 = vsel(flat_mode, vsra(x, 15), broad_z1);
+                bandpass_signal = vsra(bandpass_signal, desc->broad_postscale);
+                flat_zl = vadd(vsra(vmul(broad_zl, vset1(desc->broad_slugi)), 15),
+                               vsra(vmul(vabs(bandpass_signal), vset1(desc->broad_slugp)), 15));
+            }
+            else
+            {
+                flat_zl = zero;
+            }
+            /*endif*/
+
+            /* Sharp mode - integrate the unfiltered signal */
+            sharp_zl = vadd(vsra(vmul(broad_zl, vset1(desc->unfiltered_slugi)), 15),
+                            vsra(vmul(vabs(amp), vset1(desc->unfiltered_slugp)), 15));
+            broad_zl = vsel(flat_mode, flat_zl, sharp_zl);
+            mown_bandpass = vsel(flat_mode, mown_bandpass, vand(sharp_zl, vset1(desc->unfiltered_threshold)));
+
+            /* Sharp mode persistence checking. A detection which has persisted
+               long enough is an event - the tone going on or off. */
+            detected = vsel(tone_present, vcmpgt(mown_notch[j], mown_bandpass), vcmpgt(mown_bandpass, mown_notch[j]));
+            running = vcmpgt(tone_persistence_timeout, zero);
+            event = vandnot(flat_mode, vandnot(running, detected));
+            tone_persistence_timeout = vsel(flat_mode,
+                                            tone_persistence_timeout,
+                                            vsel(event,
+                                                 vsel(tone_present, vset1(desc->tone_on_check_time), vset1(desc->tone_off_check_time)),
+                                                 vsel(detected,
+                                                      vsub(tone_persistence_timeout, one),
+                                                      vsel(tone_present, vset1(desc->tone_off_check_time), vset1(desc->tone_on_check_time)))));
+
+            /* Flat mode uses a simple linear threshold */
+            now_present = vsel(flat_mode, vcmpgt(flat_zl, vset1(desc->broad_threshold)), vxor(tone_present, event));
+
+            /* Notch insertion logic. The notch is armed while the tone is present
+               in flat mode, or as it goes on in sharp mode. It decays while the
+               tone is absent, except in sharp mode as the tone goes off. */
+            arm = vsel(flat_mode, now_present, vandnot(tone_present, now_present));
+            decay = vandnot(vor(now_present, vandnot(flat_mode, tone_present)), vset1(-1));
+            running = vcmpgt(notch_insertion_timeout, zero);
+            notch_enabled = vsel(arm, vset1(desc->notch_allowed), vandnot(vandnot(running, decay), notch_enabled));
+            notch_insertion_timeout = vsel(arm, vset1(desc->notch_lag_time), vadd(notch_insertion_timeout, vand(decay, running)));
+
+            change = vxor(tone_present, now_present);
+            tone_present = now_present;
+            if (vany(change))
+            {
+                bank_report_changes(s, c, change, tone_present, duration);
+                duration = vandnot(change, duration);
+            }
+            /*endif*/
+            vstore(p, vand(passthrough, notched[j]));
+        }
+        /*endfor*/
+        vstore(bank_array(s, BANK_NOTCH_Z1_1) + c, notch_z1_1);
+        vstore(bank_array(s, BANK_NOTCH_Z1_2) + c, notch_z1_2);
+        vstore(bank_array(s, BANK_NOTCH_Z2_1) + c, notch_z2_1);
+        vstore(bank_array(s, BANK_NOTCH_Z2_2) + c, notch_z2_2);
+        vstore(bank_array(s, BANK_NOTCH_ZL) + c, notch_zl);
+        vstore(bank_array(s, BANK_BROAD_Z1) + c, broad_z1);
+        vstore(bank_array(s, BANK_BROAD_Z2) + c, broad_z2);
+        vstore(bank_array(s, BANK_BROAD_ZL) + c, broad_zl);
+        vstore(bank_array(s, BANK_MOWN_BANDPASS) + c, mown_bandpass);
+        vstore(bank_array(s, BANK_FLAT_MODE) + c, flat_mode);
+        vstore(bank_array(s, BANK_TONE_PRESENT) + c, tone_present);
+        vstore(bank_array(s, BANK_NOTCH_ENABLED) + c, notch_enabled);
+        vstore(bank_array(s, BANK_FLAT_MODE_TIMEOUT) + c, flat_mode_timeout);
+        vstore(bank_array(s, BANK_NOTCH_INSERTION_TIMEOUT) + c, notch_insertion_timeout);
+        vstore(bank_array(s, BANK_TONE_PERSISTENCE_TIMEOUT) + c, tone_persistence_timeout);
+        vstore(bank_array(s, BANK_DURATION) + c, duration);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+#if defined(__AVX2__)
+static __inline__ void transpose_8x8(__m128i r[8])
+{
+    __m128i t[8];
+    __m128i u[8];
+    int i;
+
+    for (i = 0;  i < 4;  i++)
+    {
+        t[2*i] = _mm_unpacklo_epi16(r[2*i], r[2*i + 1]);
+        t[2*i + 1] = _mm_unpackhi_epi16(r[2*i], r[2*i + 1]);
+    }
+    /*endfor*/
+    for (i = 0;  i < 2;  i++)
+    {
+        u[4*i] = _mm_unpacklo_epi32(t[4*i], t[4*i + 2]);
+        u[4*i + 1] = _mm_unpackhi_epi32(t[4*i], t[4*i + 2]);
+        u[4*i + 2] = _mm_unpacklo_epi32(t[4*i + 1], t[4*i + 3]);
+        u[4*i + 3] = _mm_unpackhi_epi32(t[4*i + 1], t[4*i + 3]);
+    }
+    /*endfor*/
+    for (i = 0;  i < 4;  i++)
+    {
+        r[2*i] = _mm_unpacklo_epi64(u[i], u[i + 4]);
+        r[2*i + 1] = _mm_unpackhi_epi64(u[i], u[i + 4]);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+static void bank_interleave(sig_tone_bank_state_t *s, int16_t *amp[], int sample, int limit)
+{
+    int32_t *p;
+    int c;
+    int i;
+    int j;
+    int k;
+#if defined(__AVX2__)
+    __m128i r[8];
+#else
+    __m128i r[4];
+    __m128i t[4];
+#endif
+
+    for (c = 0;  c < s->channels;  c += SIG_TONE_BANK_LANES)
+    {
+        j = sample;
+        if (c + SIG_TONE_BANK_LANES <= s->channels)
+        {
+            /* Transpose whole vectors of channels, 8 samples at a time */
+            p = bank_array(s, BANK_AMP) + c;
+#if defined(__AVX2__)
+            for (  ;  j + 8 <= limit;  j += 8, p += 8*s->stride)
+            {
+                for (i = 0;  i < 8;  i++)
+                    r[i] = _mm_loadu_si128((const __m128i *) &amp[c + i][j]);
+                /*endfor*/
+                transpose_8x8(r);
+                for (i = 0;  i < 8;  i++)
+                    vstore(p + i*s->stride, _mm256_cvtepi16_epi32(r[i]));
+                /*endfor*/
+            }
+            /*endfor*/
+#else
+            for (  ;  j + 8 <= limit;  j += 8, p += 8*s->stride)
+            {
+                for (i = 0;  i < 4;  i++)
+                    r[i] = _mm_loadu_si128((const __m128i *) &amp[c + i][j]);
+                /*endfor*/
+                t[0] = _mm_unpacklo_epi16(r[0], r[1]);
+                t[1] = _mm_unpackhi_epi16(r[0], r[1]);
+                t[2] = _mm_unpacklo_epi16(r[2], r[3]);
+                t[3] = _mm_unpackhi_epi16(r[2], r[3]);
+                /* Each of these holds two samples for the 4 channels */
+                r[0] = _mm_unpacklo_epi32(t[0], t[2]);
+                r[1] = _mm_unpackhi_epi32(t[0], t[2]);
+                r[2] = _mm_unpacklo_epi32(t[1], t[3]);
+                r[3] = _mm_unpackhi_epi32(t[1], t[3]);
+                for (i = 0;  i < 4;  i++)
+                {
+                    vstore(p + 2*i*s->stride, _mm_srai_epi32(_mm_unpacklo_epi16(r[i], r[i]), 16));
+                    vstore(p + (2*i + 1)*s->stride, _mm_srai_epi32(_mm_unpackhi_epi16(r[i], r[i]), 16));
+                }
+                /*endfor*/
+            }
+            /*endfor*/
+#endif
+        }
+        /*endif*/
+        for (i = c;  i < c + SIG_TONE_BANK_LANES  &&  i < s->channels;  i++)
+        {
+            p = bank_array(s, BANK_AMP) + (j - sample)*s->stride + i;
+            for (k = j;  k < limit;  k++, p += s->stride)
+                *p = amp[i][k];
+            /*endfor*/
+        }
+        /*endfor*/
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_deinterleave(sig_tone_bank_state_t *s, int16_t *amp[], int sample, int limit)
+{
+    int32_t *p;
+    int c;
+    int i;
+    int j;
+    int k;
+#if defined(__AVX2__)
+    __m256i x;
+    __m128i r[8];
+#else
+    __m128i x;
+    __m128i y;
+    __m128i r[4];
+    __m128i t[4];
+#endif
+
+    for (c = 0;  c < s->channels;  c += SIG_TONE_BANK_LANES)
+    {
+        j = sample;
+        if (c + SIG_TONE_BANK_LANES <= s->channels)
+        {
+            /* Transpose whole vectors of channels, 8 samples at a time. The
+               samples are truncated to 16 bits, as by a cast, so each is sign
+               extended from its low 16 bits before the saturating pack. */
+            p = bank_array(s, BANK_AMP) + c;
+#if defined(__AVX2__)
+            for (  ;  j + 8 <= limit;  j += 8, p += 8*s->stride)
+            {
+                for (i = 0;  i < 8;  i++)
+                {
+                    x = _mm256_srai_epi32(_mm256_slli_epi32(vload(p + i*s->stride), 16), 16);
+                    r[i] = _mm_packs_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+                }
+                /*endfor*/
+                transpose_8x8(r);
+                for (i = 0;  i < 8;  i++)
+                    _mm_storeu_si128((__m128i *) &amp[c + i][j], r[i]);
+                /*endfor*/
+            }
+            /*endfor*/
+#else
+            for (  ;  j + 8 <= limit;  j += 8, p += 8*s->stride)
+            {
+                /* Each of these holds two samples for the 4 channels */
+                for (i = 0;  i < 4;  i++)
+                {
+                    x = _mm_srai_epi32(_mm_slli_epi32(vload(p + 2*i*s->stride), 16), 16);
+                    y = _mm_srai_epi32(_mm_slli_epi32(vload(p + (2*i + 1)*s->stride), 16), 16);
+                    r[i] = _mm_packs_epi32(x, y);
+                }
+                /*endfor*/
+                t[0] = _mm_unpacklo_epi16(r[0], r[1]);
+                t[1] = _mm_unpackhi_epi16(r[0], r[1]);
+                t[2] = _mm_unpacklo_epi16(r[2], r[3]);
+                t[3] = _mm_unpackhi_epi16(r[2], r[3]);
+                r[0] = _mm_unpacklo_epi16(t[0], t[1]);
+                r[1] = _mm_unpackhi_epi16(t[0], t[1]);
+                r[2] = _mm_unpacklo_epi16(t[2], t[3]);
+                r[3] = _mm_unpackhi_epi16(t[2], t[3]);
+                _mm_storeu_si128((__m128i *) &amp[c][j], _mm_unpacklo_epi64(r[0], r[2]));
+                _mm_storeu_si128((__m128i *) &amp[c + 1][j], _mm_unpackhi_epi64(r[0], r[2]));
+                _mm_storeu_si128((__m128i *) &amp[c + 2][j], _mm_unpacklo_epi64(r[1], r[3]));
+                _mm_storeu_si128((__m128i *) &amp[c + 3][j], _mm_unpackhi_epi64(r[1], r[3]));
+            }
+            /*endfor*/
+#endif
+        }
+        /*endif*/
+        for (i = c;  i < c + SIG_TONE_BANK_LANES  &&  i < s->channels;  i++)
+        {
+            p = bank_array(s, BANK_AMP) + (j - sample)*s->stride + i;
+            for (k = j;  k < limit;  k++, p += s->stride)
+                amp[i][k] = (int16_t) *p;
+            /*endfor*/
+        }
+        /*endfor*/
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_load_states(sig_tone_bank_state_t *s)
+{
+    sig_tone_state_t *t;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        t = &s->chan[c];
+        bank_array(s, BANK_NOTCH_Z1_1)[c] = t->notch_z1[1];
+        bank_array(s, BANK_NOTCH_Z1_2)[c] = t->notch_z1[2];
+        bank_array(s, BANK_NOTCH_Z2_1)[c] = t->notch_z2[1];
+        bank_array(s, BANK_NOTCH_Z2_2)[c] = t->notch_z2[2];
+        bank_array(s, BANK_NOTCH_ZL)[c] = t->notch_zl;
+        bank_array(s, BANK_BROAD_Z1)[c] = t->broad_z[1];
+        bank_array(s, BANK_BROAD_Z2)[c] = t->broad_z[2];
+        bank_array(s, BANK_BROAD_ZL)[c] = t->broad_zl;
+        bank_array(s, BANK_MOWN_BANDPASS)[c] = t->mown_bandpass;
+        bank_array(s, BANK_FLAT_MODE)[c] = (t->flat_mode)  ?  -1  :  0;
+        bank_array(s, BANK_TONE_PRESENT)[c] = (t->tone_present)  ?  -1  :  0;
+        bank_array(s, BANK_NOTCH_ENABLED)[c] = t->notch_enabled;
+        bank_array(s, BANK_FLAT_MODE_TIMEOUT)[c] = t->flat_mode_timeout;
+        bank_array(s, BANK_NOTCH_INSERTION_TIMEOUT)[c] = t->notch_insertion_timeout;
+        bank_array(s, BANK_TONE_PERSISTENCE_TIMEOUT)[c] = t->tone_persistence_timeout;
+        bank_array(s, BANK_DURATION)[c] = t->signaling_state_duration;
+        bank_array(s, BANK_PASSTHROUGH)[c] = (t->current_tx_tone & SIG_TONE_RX_PASSTHROUGH)  ?  -1  :  0;
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_save_states(sig_tone_bank_state_t *s)
+{
+    sig_tone_state_t *t;
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+    {
+        t = &s->chan[c];
+        t->notch_z1[1] = bank_array(s, BANK_NOTCH_Z1_1)[c];
+        t->notch_z1[2] = bank_array(s, BANK_NOTCH_Z1_2)[c];
+        t->notch_z2[1] = bank_array(s, BANK_NOTCH_Z2_1)[c];
+        t->notch_z2[2] = bank_array(s, BANK_NOTCH_Z2_2)[c];
+        t->notch_zl = bank_array(s, BANK_NOTCH_ZL)[c];
+        t->mown_notch = t->notch_zl & s->desc->notch_threshold;
+        t->broad_z[1] = bank_array(s, BANK_BROAD_Z1)[c];
+        t->broad_z[2] = bank_array(s, BANK_BROAD_Z2)[c];
+        t->broad_zl = bank_array(s, BANK_BROAD_ZL)[c];
+        t->mown_bandpass = bank_array(s, BANK_MOWN_BANDPASS)[c];
+        t->flat_mode = (bank_array(s, BANK_FLAT_MODE)[c] != 0);
+        t->tone_present = (bank_array(s, BANK_TONE_PRESENT)[c] != 0);
+        t->notch_enabled = bank_array(s, BANK_NOTCH_ENABLED)[c];
+        t->flat_mode_timeout = bank_array(s, BANK_FLAT_MODE_TIMEOUT)[c];
+        t->notch_insertion_timeout = bank_array(s, BANK_NOTCH_INSERTION_TIMEOUT)[c];
+        t->tone_persistence_timeout = bank_array(s, BANK_TONE_PERSISTENCE_TIMEOUT)[c];
+        t->signaling_state_duration = bank_array(s, BANK_DURATION)[c];
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+#endif
+
+int sig_tone_rx_bank(sig_tone_bank_state_t *s, int16_t *amp[], int len)
+{
+#if defined(SIG_TONE_BANK_LANES)
+    int sample;
+    int limit;
+
+    bank_load_states(s);
+    for (sample = 0;  sample < len;  sample = limit)
+    {
+        limit = sample + SIG_TONE_BANK_CHUNK;
+        if (limit > len)
+            limit = len;
+        /*endif*/
+        /* Interleave this stretch of audio across the channels */
+        bank_interleave(s, amp, sample, limit);
+        bank_rx_block(s, limit - sample);
+        bank_deinterleave(s, amp, sample, limit);
+    }
+    /*endfor*/
+    bank_save_states(s);
+#else
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+        sig_tone_rx(&s->chan[c], amp[c], len);
+    /*endfor*/
+#endif
+    return len;
+}
+/*- End of function --------------------------------------------------------*/
+
+int sig_tone_tx_bank(sig_tone_bank_state_t *s, int16_t *amp[], int len)
+{
+    int c;
+
+    for (c = 0;  c < s->channels;  c++)
+        sig_tone_tx(&s->chan[c], amp[c], len);
+    /*endfor*/
+    return len;
+}
+/*- End of function --------------------------------------------------------*/
+
+sig_tone_bank_state_t *sig_tone_bank_init(sig_tone_bank_state_t *s,
+                                          int channels,
+                                          int tone_type,
+                                          sig_tone_func_t sig_update,
+                                          void *user_data[])
+{
+    int alloced;
+    int i;
+
+    if (channels <= 0  ||  tone_type <= 0  ||  tone_type > 3)
+        return NULL;
+    /*endif*/
+    alloced = FALSE;
+    if (s == NULL)
+    {
+        if ((s = (sig_tone_bank_state_t *) malloc(sizeof(*s))) == NULL)
+            return  NULL;
+        /*endif*/
+        alloced = TRUE;
+    }
+    /*endif*/
+    memset(s, 0, sizeof(*s));
+    s->channels = channels;
+    if ((s->chan = (sig_tone_state_t *) malloc(channels*sizeof(sig_tone_state_t))) == NULL)
+    {
+        if (alloced)
+            free(s);
+        /*endif*/
+        return NULL;
+    }
+    /*endif*/
+#if defined(SIG_TONE_BANK_LANES)
+    /* Round up to whole vectors, so the vector code never needs a scalar tail */
+    s->stride = (channels + SIG_TONE_BANK_LANES - 1) & ~(SIG_TONE_BANK_LANES - 1);
+    if ((s->vec = (int32_t *) malloc(BANK_NUM_ARRAYS*s->stride*sizeof(int32_t))) == NULL)
+    {
+        free(s->chan);
+        if (alloced)
+            free(s);
+        /*endif*/
+        return NULL;
+    }
+    /*endif*/
+    /* The padding lanes are zeroed, and stay that way, so the vector code only
+       ever sees sane values. */
+    memset(s->vec, 0, BANK_NUM_ARRAYS*s->stride*sizeof(int32_t));
+#else
+    s->stride = channels;
+#endif
+    for (i = 0;  i < channels;  i++)
+        sig_tone_init(&s->chan[i], tone_type, sig_update, (user_data)  ?  user_data[i]  :  NULL);
+    /*endfor*/
+    s->desc = s->chan[0].desc;
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int sig_tone_bank_release(sig_tone_bank_state_t *s)
+{
+    free(s->vec);
+    free(s->chan);
+    free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int sig_tone_bank_reset_channel(sig_tone_bank_state_t *s, int chan)
+{
+    sig_tone_state_t *t;
+
+    if (chan < 0  ||  chan >= s->channels)
+        return -1;
+    /*endif*/
+    t = &s->chan[chan];
+    sig_tone_init(t, (int) (s->desc - sig_tones) + 1, t->sig_update, t->user_data);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+sig_tone_state_t *sig_tone_bank_channel(sig_tone_bank_state_t *s, int chan)
+{
+    if (chan < 0  ||  chan >= s->channels)
+        return NULL;
+    /*endif*/
+    return &s->chan[chan];
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
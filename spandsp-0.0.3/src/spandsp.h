@@ -64,8 +64,10 @@
 #include <spandsp/time_scale.h>
 #include <spandsp/tone_detect.h>
 #include <spandsp/tone_generate.h>
+#include <spandsp/tone_analysis.h>
 #include <spandsp/dtmf.h>
 #include <spandsp/bell_r2_mf.h>
+#include <spandsp/tone_detect_fixed.h>
 #include <spandsp/super_tone_rx.h>
 #include <spandsp/super_tone_tx.h>
 #include <spandsp/modem_connect_tones.h>
@@ -103,6 +105,7 @@
 #include <spandsp/gsm0610.h>
 #include <spandsp/plc.h>
 #include <spandsp/playout.h>
+#include <spandsp/pipeline.h>
 
 #endif
 /*- End of file ------------------------------------------------------------*/
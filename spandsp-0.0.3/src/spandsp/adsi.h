@@ -117,6 +117,13 @@ sends one of the following DTMF strings:
     - D1#     Number not available because the caller has restricted it.
     - D2#     Number not available because the call is international.
     - D3#     Number not available due to technical reasons.
+
+\section adsi_page_sec_3 Banks of receivers
+A bank of lines, each of which may receive caller ID, can use a bank of ADSI
+receivers, from adsi_rx_bank_init(), all using the same standard. For the FSK
+based standards, the FSK receivers of all the channels are run as a bank of FSK
+receivers, so lines with no FSK signal cost very little. Each channel receives
+exactly the messages a separate receiver would.
 */
 
 enum
@@ -323,6 +330,20 @@ typedef struct
     logging_state_t logging;
 } adsi_rx_state_t;
 
+/*!
+    A bank of ADSI receivers, for many channels using the same standard.
+*/
+typedef struct
+{
+    /*! The number of channels. */
+    int channels;
+    /*! The receiver for each channel. */
+    adsi_rx_state_t *chan;
+    /*! The bank of FSK receivers, running the FSK receivers of all the channels, or
+        NULL for a standard which does not use FSK. */
+    fsk_rx_bank_state_t *fsk;
+} adsi_rx_bank_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -343,6 +364,51 @@ void adsi_rx_init(adsi_rx_state_t *s, int standard, put_msg_func_t put_msg, void
 */
 void adsi_rx(adsi_rx_state_t *s, const int16_t *amp, int len);
 
+/*! \brief Initialise a bank of ADSI receivers, all using the same standard.
+    \param s The ADSI receive bank context. If NULL, a context is allocated with malloc.
+    \param channels The number of channels.
+    \param standard The code for the ADSI standard to be used.
+    \param put_msg A callback routine called to deliver the received messages
+           to the application.
+    \param user_data An array of opaque pointers, one per channel, for the callback
+           routine. If NULL, NULL is passed for every channel.
+    \return A pointer to the ADSI receive bank context, or NULL if there was a problem.
+*/
+adsi_rx_bank_state_t *adsi_rx_bank_init(adsi_rx_bank_state_t *s,
+                                        int channels,
+                                        int standard,
+                                        put_msg_func_t put_msg,
+                                        void *user_data[]);
+
+/*! \brief Release a bank of ADSI receivers allocated by adsi_rx_bank_init().
+    \param s The ADSI receive bank context.
+    \return 0 for OK, -1 for fail.
+*/
+int adsi_rx_bank_release(adsi_rx_bank_state_t *s);
+
+/*! \brief Reset one channel of a bank of ADSI receivers, as though it had just
+           been initialised.
+    \param s The ADSI receive bank context.
+    \param chan The channel number.
+    \return 0 for OK, -1 for a bad channel number.
+*/
+int adsi_rx_bank_reset_channel(adsi_rx_bank_state_t *s, int chan);
+
+/*! \brief Get the receiver for one channel of a bank of ADSI receivers. This may
+           be used with adsi_next_field(), or to adjust the channel's logging.
+    \param s The ADSI receive bank context.
+    \param chan The channel number.
+    \return A pointer to the channel's receiver, or NULL for a bad channel number.
+*/
+adsi_rx_state_t *adsi_rx_bank_channel(adsi_rx_bank_state_t *s, int chan);
+
+/*! \brief Receive a chunk of ADSI audio for every channel of a bank.
+    \param s The ADSI receive bank context.
+    \param amp The audio sample buffers, one per channel.
+    \param len The number of samples in each buffer.
+*/
+void adsi_rx_bank(adsi_rx_bank_state_t *s, const int16_t *amp[], int len);
+
 /*! \brief Initialise an ADSI transmit context.
     \param s The ADSI transmit context.
     \param standard The code for the ADSI standard to be used.
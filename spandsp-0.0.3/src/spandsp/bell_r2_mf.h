@@ -99,6 +99,9 @@ Note: Above -3dBm the signal starts to clip. We can detect with a little clippin
       but not up to 0dBm, which the above spec seems to require. There isn't a lot
       we can do about that. Is the spec. incorrectly worded about the dBm0 reference
       point, or have I misunderstood it?
+
+A receiver can subscribe to a shared tone analysis engine, with
+bell_mf_rx_subscribe(), when other tone detectors are run on the same channel.
 */
 
 #define MAX_BELL_MF_DIGITS 128
@@ -234,6 +237,16 @@ bell_mf_rx_state_t *bell_mf_rx_init(bell_mf_rx_state_t *s,
                                     void (*callback)(void *user_data, const char *digits, int len),
                                     void *user_data);
 
+/*! Subscribe a Bell MF receiver to a tone analysis engine. The receiver's digits
+    are then found from the audio passed to tone_analysis(), rather than bell_mf_rx().
+    An energy gate is set, so the engine skips the receiver's filters for blocks
+    too quiet to hold a digit. bell_mf_rx() itself is not gated.
+    \brief Subscribe a Bell MF receiver to a tone analysis engine.
+    \param s The Bell MF receiver context, which must already be initialised.
+    \param t The tone analysis context.
+    \return The subscriber number, or -1 for error. */
+int bell_mf_rx_subscribe(bell_mf_rx_state_t *s, tone_analysis_state_t *t);
+
 /*! Process a block of received R2 MF audio samples.
     \brief Process a block of received R2 MF audio samples.
     \param s The R2 MF receiver context.
@@ -44,6 +44,20 @@ get good performance in the presence of speech prompts, so dial tone will not
 exist. If you do need good dial tone tolerance, a dial tone filter can be
 enabled in the detector.
 
+A bank of DTMF receivers, for many channels, can be run a block at a time with
+the dtmf_rx_bank functions. These report exactly the same digits as the same
+number of separate receivers, but update the Goertzel filters, and the optional
+dial tone filter, for a vector of channels at once with SSE2, AVX2 or AVX-512
+where the CPU allows. This suits IVR front ends which listen for DTMF on every
+channel of a large system.
+
+A receiver can also subscribe to a shared tone analysis engine, with
+dtmf_rx_subscribe(), when other tone detectors are run on the same channel.
+
+For low latency, as needed for fast digit relay with RFC 2833, a receiver can be
+switched to a sliding DFT mode with dtmf_rx_set_sliding(). The start of a digit
+is then estimated to within a few samples, and can be read with dtmf_rx_onset().
+
 \section dtmf_rx_page_sec_2 How does it work?
 Like most other DSP based DTMF detector's, this one uses the Goertzel algorithm
 to look for the DTMF tones. What makes each detector design different is just how
@@ -59,6 +73,23 @@ Basic DTMF specs:
     - Attenuation <= 26dB will detect OK
     - Frequency tolerance +- 1.5% will detect, +-3.5% will reject
 
+In the normal block mode, the Goertzel filters run over fixed blocks of 102
+samples, and a digit is declared when two successive blocks give the same
+result. Because the blocks are not aligned with the digits, a digit is reported
+between 204 and 306 samples after it starts.
+
+In the sliding DFT mode, a sliding DFT for each of the 8 frequencies keeps the
+energies over the last 102 samples up to date at every sample, and the usual
+level, twist, relative peak and total energy tests are applied every few samples.
+A digit is declared when every test has passed the same digit for a full 102
+samples, so the receiver has seen the same 204 samples of evidence as in the
+block mode, and keeps its talk-off performance. As the windows are aligned with
+the digit, rather than with fixed blocks, a clean digit is reported about 190
+samples after it starts. A digit ends when it has not been seen for 102 samples.
+For a tone pair filling L samples of the window, the two tone energies total
+about L/2 times the energy in the window. This gives the start of the digit
+from the first window which passed the tests.
+
 TODO:
 */
 
@@ -73,6 +104,9 @@ repertoire of 16 DTMF dual tones.
 
 #define MAX_DTMF_DIGITS 128
 
+/*! The length of the DTMF detection block, and of the sliding DFT window. */
+#define DTMF_BLOCK_LEN  102
+
 /*!
     DTMF generator state descriptor. This defines the state of a single
     working instance of a DTMF generator.
@@ -122,9 +156,38 @@ typedef struct
     uint8_t last_hit;
     /*! The confirmed digit we are currently receiving */
     uint8_t in_digit;
-    /*! The current sample number within a processing block. */
+    /*! The current sample number within a processing block, or within a decision
+        interval in the sliding DFT mode. */
     int current_sample;
 
+    /*! The interval between decisions in the sliding DFT mode, in samples. Zero
+        for the normal block mode. */
+    int sliding_hop;
+    /*! Sliding DFT states for the rows and the columns */
+    sliding_dft_state_t row_sdft[4];
+    sliding_dft_state_t col_sdft[4];
+    /*! The audio in the sliding DFT window */
+    float window[DTMF_BLOCK_LEN];
+    /*! The next position in the window */
+    int window_ptr;
+    /*! The total energy of the audio in the window */
+    double window_energy;
+    /*! The digit the tests are currently passing, which is not yet confirmed */
+    uint8_t candidate;
+    /*! The number of decisions which have passed, and failed, the candidate digit */
+    int candidate_hits;
+    int candidate_misses;
+    /*! The sample count when the tests first passed the candidate digit */
+    uint32_t candidate_start;
+    /*! The estimated start of the candidate digit */
+    uint32_t candidate_onset;
+    /*! The sample count when the tests last passed the confirmed digit */
+    uint32_t digit_last_seen;
+    /*! The estimated start of the last confirmed digit */
+    uint32_t onset;
+    /*! The number of samples processed in the sliding DFT mode. This wraps. */
+    uint32_t sample_count;
+
     /*! The received digits buffer. This is a NULL terminated string. */
     char digits[MAX_DTMF_DIGITS + 1];
     /*! The number of digits currently in the digit buffer. */
@@ -133,6 +196,46 @@ typedef struct
     int lost_digits;
 } dtmf_rx_state_t;
 
+/*!
+    The state of a bank of DTMF digit detectors, which are stepped through each
+    block of audio in lockstep. The filter states are kept as structure of arrays,
+    with one entry per channel in each array, so the filters for several channels
+    can be updated at once. The decisions, and the digit buffer, for each channel
+    are handled by an ordinary DTMF receiver context.
+*/
+typedef struct
+{
+    /*! The number of channels */
+    int channels;
+    /*! The number of entries in each of the state arrays. This is the number of
+        channels rounded up to a whole number of vectors. */
+    int stride;
+    /*! TRUE if dialtone should be filtered before processing, on all channels */
+    int filter_dialtone;
+    /*! The current sample number within a processing block. This is common to
+        all the channels. */
+    int current_sample;
+    /*! The receiver context for each channel. Only the decision making and
+        digit reporting parts of these are used. */
+    dtmf_rx_state_t *chan;
+
+    /*! The Goertzel coefficients - the 4 rows, then the 4 columns */
+    float fac[8];
+    /*! The Goertzel filter states, in the same order as fac */
+    float *v2[8];
+    float *v3[8];
+    /*! The accumlating total energy on the same period over which the Goertzels work. */
+    float *energy;
+    /*! 350Hz filter state for the optional dialtone filter */
+    float *z350_1;
+    float *z350_2;
+    /*! 440Hz filter state for the optional dialtone filter */
+    float *z440_1;
+    float *z440_2;
+    /*! The audio for the current block, with the channels interleaved. */
+    float *famp;
+} dtmf_rx_bank_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -178,6 +281,26 @@ void dtmf_rx_set_realtime_callback(dtmf_rx_state_t *s,
     \param reverse_twist Acceptable reverse twist, in dB. < 0 to leave unchanged. */
 void dtmf_rx_parms(dtmf_rx_state_t *s, int filter_dialtone, int twist, int reverse_twist);
 
+/*! Select the sliding DFT mode, or the normal block mode, for a DTMF receiver.
+    With a decision every 8 samples, the sliding DFT mode costs about 3 times as
+    much as the block mode. It is not used by a receiver subscribed to a tone
+    analysis engine.
+    \brief Select the sliding DFT mode for a DTMF receiver.
+    \param s The DTMF receiver context.
+    \param hop The interval between decisions, in samples, from 1 to
+           DTMF_BLOCK_LEN. Zero selects the normal block mode.
+    \return 0 for OK, -1 for a bad interval. */
+int dtmf_rx_set_sliding(dtmf_rx_state_t *s, int hop);
+
+/*! Get the estimated start of the most recently confirmed digit, in the sliding
+    DFT mode. This is a count of the samples passed to the receiver since the
+    mode was selected, so it is on the same scale as an RTP timestamp for 8kHz
+    audio. It wraps in the same way.
+    \brief Get the start of the most recent digit from a DTMF receiver.
+    \param s The DTMF receiver context.
+    \return The sample count at which the digit started. */
+uint32_t dtmf_rx_onset(dtmf_rx_state_t *s);
+
 /*! Process a block of received DTMF audio samples.
     \brief Process a block of received DTMF audio samples.
     \param s The DTMF receiver context.
@@ -205,6 +328,74 @@ dtmf_rx_state_t *dtmf_rx_init(dtmf_rx_state_t *s,
                               void (*callback)(void *user_data, const char *digits, int len),
                               void *user_data);
 
+/*! Subscribe a DTMF receiver to a tone analysis engine. The receiver's digits are
+    then found from the audio passed to tone_analysis(), rather than dtmf_rx(). The
+    engine has no dial tone filter, so a receiver set up to filter dial tone, with
+    dtmf_rx_parms(), cannot subscribe. An energy gate is set, so the engine skips
+    the receiver's filters for blocks too quiet to hold a digit. dtmf_rx() itself
+    is not gated.
+    \brief Subscribe a DTMF receiver to a tone analysis engine.
+    \param s The DTMF receiver context, which must already be initialised.
+    \param t The tone analysis context.
+    \return The subscriber number, or -1 for error, including a receiver which
+            filters dial tone. */
+int dtmf_rx_subscribe(dtmf_rx_state_t *s, tone_analysis_state_t *t);
+
+/*! Initialise a bank of DTMF receiver contexts.
+    \param s The DTMF receiver bank context.
+    \param channels The number of channels in the bank.
+    \param callback An optional callback routine, used to report received digits. If
+           no callback routine is set, digits may be collected for each channel, using
+           the dtmf_rx_get() function on the context from dtmf_rx_bank_channel().
+    \param user_data An optional array of opaque pointers, one per channel, supplied
+           in the callbacks for each channel.
+    \return A pointer to the DTMF receiver bank context, or NULL for error. */
+dtmf_rx_bank_state_t *dtmf_rx_bank_init(dtmf_rx_bank_state_t *s,
+                                        int channels,
+                                        void (*callback)(void *user_data, const char *digits, int len),
+                                        void *user_data[]);
+
+/*! Free a bank of DTMF receiver contexts.
+    \param s The DTMF receiver bank context.
+    \return 0 for OK. */
+int dtmf_rx_bank_release(dtmf_rx_bank_state_t *s);
+
+/*! Restart one channel of a DTMF receiver bank, as for a new call. The other
+    channels are not affected. The callbacks and the twist settings are kept.
+    The channel stays in step with the bank's processing blocks, so its first
+    block may be a short one.
+    \param s The DTMF receiver bank context.
+    \param chan The channel number.
+    \return 0 for OK, or -1 for a bad channel number. */
+int dtmf_rx_bank_reset_channel(dtmf_rx_bank_state_t *s, int chan);
+
+/*! Get the receiver context for one channel of a DTMF receiver bank. This may be
+    used with dtmf_rx_get() and dtmf_rx_set_realtime_callback(). It should not be
+    passed to dtmf_rx() or dtmf_rx_parms().
+    \brief Get the receiver context for one channel of a DTMF receiver bank.
+    \param s The DTMF receiver bank context.
+    \param chan The channel number.
+    \return A pointer to the channel's DTMF receiver context, or NULL for a bad
+            channel number. */
+dtmf_rx_state_t *dtmf_rx_bank_channel(dtmf_rx_bank_state_t *s, int chan);
+
+/*! \brief Adjust all the channels of a DTMF receiver bank.
+    \param s The DTMF receiver bank context.
+    \param filter_dialtone TRUE to enable filtering of dialtone, FALSE
+           to disable, < 0 to leave unchanged.
+    \param twist Acceptable twist, in dB. < 0 to leave unchanged.
+    \param reverse_twist Acceptable reverse twist, in dB. < 0 to leave unchanged. */
+void dtmf_rx_bank_parms(dtmf_rx_bank_state_t *s, int filter_dialtone, int twist, int reverse_twist);
+
+/*! Process a block of received DTMF audio samples for every channel in a bank.
+    Each channel must supply the same number of samples.
+    \brief Process a block of received DTMF audio samples for a bank of channels.
+    \param s The DTMF receiver bank context.
+    \param amp The audio sample buffer for each channel.
+    \param samples The number of samples in the buffer for each channel.
+    \return The number of samples unprocessed. */
+int dtmf_rx_bank(dtmf_rx_bank_state_t *s, const int16_t *amp[], int samples);
+
 #ifdef __cplusplus
 }
 #endif
@@ -126,6 +126,127 @@ minor burden.
 #define ECHO_CAN_USE_RX_HPF         0x20
 #define ECHO_CAN_DISABLE            0x40
 
+/* Event types logged to the optional trace ring */
+
+#define ECHO_CAN_TRACE_FG_TRANSFER  1   /* bg to fg copies started, value = Lclean_bg */
+#define ECHO_CAN_TRACE_DTD_START    2   /* DTD hangover started, value = Lrx       */
+#define ECHO_CAN_TRACE_DTD_END      3   /* DTD hangover expired, value = Lrx       */
+#define ECHO_CAN_TRACE_NLP_ENGAGE   4   /* NLP started zapping, value = Lclean     */
+#define ECHO_CAN_TRACE_NLP_RELEASE  5   /* NLP stopped zapping, value = Lclean     */
+#define ECHO_CAN_TRACE_MODE         6   /* adaption mode (incl bypass), value = mode */
+#define ECHO_CAN_TRACE_CLIP         7   /* tx or rx clipping started, value = sample */
+#define ECHO_CAN_TRACE_LOST         8   /* events dropped on a full ring, value = count */
+
+/*!
+    A single canceller trace event. Kept to 8 bytes so a decent length
+    trace costs very little memory, and can be copied straight out to
+    user space.
+*/
+typedef struct
+{
+    /*! Sample count (at 8kHz) since the canceller was created. */
+    uint32_t sample;
+    /*! One of the ECHO_CAN_TRACE_xxx event types. */
+    uint16_t type;
+    /*! Event specific value. */
+    int16_t value;
+} echo_can_trace_event_t;
+
+/*!
+    Trace ring. There is exactly one writer (echo_can_update()) and one
+    reader, so no locks are needed, just ordered updates of the head and
+    tail indexes. Events are dropped (and counted) when the ring is full,
+    and an ECHO_CAN_TRACE_LOST event is logged ahead of the next one there
+    is room for.
+*/
+typedef struct
+{
+    uint32_t mask;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    /*! The total number of events dropped. */
+    volatile uint32_t lost;
+    /*! The number of dropped events already reported by an
+        ECHO_CAN_TRACE_LOST event. Only the writer uses this. */
+    uint32_t lost_logged;
+    echo_can_trace_event_t *event;
+} echo_can_trace_t;
+
+/*!
+    Running echo canceller performance estimates, see echo_can_get_stats().
+*/
+typedef struct
+{
+    /*! Echo return loss (Rin to Sin), in 0.1dB steps. */
+    int erl;
+    /*! Echo return loss enhancement (Sin to residual echo), in 0.1dB steps. */
+    int erle;
+    /*! TRUE if the canceller is converged, which is when the ERLE has
+        reached 18dB. It is cleared again if the ERLE falls below 12dB. */
+    int converged;
+    /*! Time from the first far end speech to convergence, in ms, or -1 if
+        the canceller has never converged. */
+    int converge_time;
+    /*! Amount of far end single talk the estimates are based on, in ms. */
+    int measured_time;
+} echo_can_stats_t;
+
+/*!
+    Tuning constants of a voice echo canceller.  Every canceller starts
+    with the defaults from echo_can_default_tuning(), which are the values
+    the canceller was tuned with by hand, and can be given its own set with
+    echo_can_set_tuning().  The units of each constant are given with
+    it.  The ratios are applied with integer multiplies, so they are either
+    in eighths, or whole multipliers.
+*/
+typedef struct
+{
+    /*! Regularisation of the filter state power in the background filter
+        adaption step, so very low level Tx signals don't blow up the step
+        size.  Default 64. */
+    int min_tx_power;
+    /*! Lrx must exceed this (and Ltx) for the double talk detector to
+        trigger.  Default 64. */
+    int min_rx_power;
+    /*! Samples adaption is held off after double talk is detected.
+        Default 600 (75ms). */
+    int dtd_hangover;
+    /*! The background filter must beat the foreground filter residual by
+        this ratio (in eighths) to be transferred.  Default 7 (7/8). */
+    int transfer_fg_eighths;
+    /*! The background filter residual must be this far (in eighths) below
+        Ltx to be transferred.  Default 1 (1/8). */
+    int transfer_tx_eighths;
+    /*! Consecutive samples the transfer conditions must hold before the
+        transfer is made.  Default 6. */
+    int transfer_count;
+    /*! The NLP engages when the residual is this many times below Ltx.
+        This is a whole multiplier, not eighths.  Default 16 (24dB). */
+    int nlp_ratio;
+    /*! The background noise estimate is only updated while Lclean is below
+        this.  Default 40. */
+    int bgn_max_level;
+} echo_can_tuning_t;
+
+/*!
+    Snapshot of the foreground and background filter coefficients of a
+    running canceller, see echo_can_snapshot_attach().  echo_can_update()
+    refreshes it every 64ms, using seq as a seqlock count so readers never
+    hold up the canceller.
+*/
+typedef struct
+{
+    /*! Incremented before and after each update, so odd while the
+        canceller is writing.  Zero until the first update. */
+    volatile uint32_t seq;
+    /*! The canceller's sample count when the snapshot was taken. */
+    uint32_t sample;
+    /*! The number of taps in each filter. */
+    int taps;
+    /*! The foreground taps, followed by the background taps. */
+    int16_t *coeffs;
+} echo_can_snapshot_t;
+
 /*!
     G.168 echo canceller descriptor. This defines the working state for a line
     echo canceller.
@@ -142,6 +263,8 @@ typedef struct
     int log2taps;
     int adaption_mode;
 
+    echo_can_tuning_t tuning;
+
     int cond_met;
     int32_t Pstates;
     int16_t adapt;
@@ -172,8 +295,32 @@ typedef struct
     int cng_rndnum;
     int cng_filter;
     
-    /* snapshot sample of coeffs used for development */
-    int16_t *snapshot;       
+    /* Optional coefficient snapshot, NULL unless someone is watching */
+    echo_can_snapshot_t *snapshot;
+
+    /* Number of samples processed, used to time stamp trace events */
+    uint32_t samples;
+
+    /* Slow level averages for ERL/ERLE metering, only updated during
+       far end single talk */
+    int Ltx_slow, Ltx_slow_acc;
+    int Lrx_slow, Lrx_slow_acc;
+    int Lclean_slow, Lclean_slow_acc;
+    uint32_t meter_samples;
+    uint32_t meter_start;
+    int converged;
+    int32_t converge_samples;
+
+    /* Optional event trace, NULL when tracing is off.  The ring is kept
+       in trace_ring once allocated, so tracing can be switched off
+       while echo_can_update() might be running on another CPU.  trace
+       is volatile so echo_can_update() reads it exactly once per sample. */
+    echo_can_trace_t * volatile trace;
+    echo_can_trace_t *trace_ring;
+    int trace_mode;
+    int trace_adapt;
+    int trace_nlp;
+    int trace_clip;
 
 } echo_can_state_t;
 
@@ -199,7 +346,96 @@ void echo_can_flush(echo_can_state_t *ec);
 */
 void echo_can_adaption_mode(echo_can_state_t *ec, int adaption_mode);
 
-void echo_can_snapshot(echo_can_state_t *ec);
+/*! Get the default tuning constants for a voice echo canceller.
+    \param tuning The structure to fill in.
+*/
+void echo_can_default_tuning(echo_can_tuning_t *tuning);
+
+/*! Set the tuning constants of a voice echo canceller context.  This may be
+    done at any time, but is usually done just after the context is created.
+    \param ec The echo canceller context.
+    \param tuning The new tuning constants.
+*/
+void echo_can_set_tuning(echo_can_state_t *ec, const echo_can_tuning_t *tuning);
+
+/*! Get the tuning constants of a voice echo canceller context.
+    \param ec The echo canceller context.
+    \param tuning The structure to fill in.
+*/
+void echo_can_get_tuning(echo_can_state_t *ec, echo_can_tuning_t *tuning);
+
+/*! Allocate a coefficient snapshot, to attach to a canceller of the same
+    length with echo_can_snapshot_attach().
+    \param taps The length of the canceller, in samples.
+    \return The snapshot, or NULL if it could not be allocated.
+*/
+echo_can_snapshot_t *echo_can_snapshot_create(int taps);
+
+/*! Free a coefficient snapshot.
+    \param snap The snapshot.
+*/
+void echo_can_snapshot_free(echo_can_snapshot_t *snap);
+
+/*! Attach a snapshot to a voice echo canceller context.  From now on
+    echo_can_update() will refresh it every 64ms.  An attached snapshot
+    is freed by echo_can_free().
+    \param ec The echo canceller context.
+    \param snap The snapshot.
+    \return 0 for OK, or -1 if a snapshot is already attached or the
+            lengths differ.
+*/
+int echo_can_snapshot_attach(echo_can_state_t *ec, echo_can_snapshot_t *snap);
+
+/*! Detach the snapshot from a voice echo canceller context.  The snapshot
+    must not be freed until any echo_can_update() that might be running in
+    another context has finished.
+    \param ec The echo canceller context.
+    \return The snapshot that was attached, or NULL.
+*/
+echo_can_snapshot_t *echo_can_snapshot_detach(echo_can_state_t *ec);
+
+/*! Read the coefficients from a snapshot.  May be called while
+    echo_can_update() is refreshing the snapshot in another context; we
+    just try again if it changed while we were copying.
+    \param snap The snapshot.
+    \param sample The canceller's sample count when the snapshot was taken.
+    \param fg The foreground taps.
+    \param bg The background taps.
+    \return The number of taps copied into each of fg and bg, or 0 if the
+            snapshot has not been filled in yet.
+*/
+int echo_can_snapshot_read(echo_can_snapshot_t *snap, uint32_t *sample, int16_t fg[], int16_t bg[]);
+
+/*! Get the running ERL/ERLE estimates and convergence state of a voice echo
+    canceller context.  The estimates are only updated during far end single
+    talk, so they are cheap to maintain and safe to read at any time.
+    \param ec The echo canceller context.
+    \param stats The structure to fill in.
+*/
+void echo_can_get_stats(echo_can_state_t *ec, echo_can_stats_t *stats);
+
+/*! Start logging events to the trace ring of a voice echo canceller context.
+    The ring is allocated the first time tracing is enabled.
+    \param ec The echo canceller context.
+    \param log2_len log2() of the number of events the ring can hold.
+    \return 0 for OK, -1 if the ring could not be allocated.
+*/
+int echo_can_trace_enable(echo_can_state_t *ec, int log2_len);
+
+/*! Stop logging events to the trace ring of a voice echo canceller context.
+    \param ec The echo canceller context.
+*/
+void echo_can_trace_disable(echo_can_state_t *ec);
+
+/*! Read, and remove, logged events from the trace ring.  May be called
+    while echo_can_update() is running in another context, as long as
+    there is only one reader.
+    \param ec The echo canceller context.
+    \param events The buffer for the events.
+    \param max The maximum number of events to read.
+    \return The number of events read.
+*/
+int echo_can_trace_read(echo_can_state_t *ec, echo_can_trace_event_t *events, int max);
 
 /*! Process a sample through a voice echo canceller.
     \param ec The echo canceller context.
@@ -216,5 +452,24 @@ int16_t echo_can_update(echo_can_state_t *ec, int16_t tx, int16_t rx);
 */
 int16_t echo_can_hpf_tx(echo_can_state_t *ec, int16_t tx);
 
+/*! Process a block of samples through a voice echo canceller.  The results
+    are identical to calling echo_can_update() for each sample.
+    \param ec The echo canceller context.
+    \param clean The clean (echo cancelled) received samples.  This may be
+           the same buffer as rx.
+    \param tx The transmitted audio samples.
+    \param rx The received audio samples.
+    \param len The number of samples.
+*/
+void echo_can_update_block(echo_can_state_t *ec, int16_t clean[], const int16_t tx[], const int16_t rx[], int len);
+
+/*! High pass filter a block of tx samples, in place.  The results are
+    identical to calling echo_can_hpf_tx() for each sample.
+    \param ec The echo canceller context.
+    \param tx The transmitted audio samples.
+    \param len The number of samples.
+*/
+void echo_can_hpf_tx_block(echo_can_state_t *ec, int16_t tx[], int len);
+
 #endif
 /*- End of file ------------------------------------------------------------*/
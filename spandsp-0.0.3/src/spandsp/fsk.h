@@ -76,6 +76,24 @@ Two modes of symbol synchronisation are provided:
     - In asynchronous mode each transition is taken at face value, with no temporal
       smoothing. There is no settling time for this mode, but when the signal to
       noise ratio is very poor it does not perform as well as the synchronous mode.
+
+\section fsk_page_sec_4 Banks of receivers
+
+Every ringing line on a bank of analogue lines needs an FSK receiver, for caller
+ID, but for nearly all of the time there is no FSK signal on a line. A bank of
+receivers, from fsk_rx_bank_init(), runs the receivers for many channels together.
+Each receiver only demodulates the samples where its signal power is above the
+carrier detect threshold, so the bank first runs the power meters and the
+threshold check for 8 channels at a time, in SSE2 vectors, with the power meter
+states held in per channel arrays. Then only the channels with a signal, or whose
+carrier has just dropped, go on to the correlators, bit recovery and callbacks.
+Idle channels cost little more than their power meters. The correlators can not
+be run in lock step across channels, as each channel's correlation window only
+moves on when its own signal is present.
+
+The results are exactly those of separate receivers, for each channel. The
+receiver contexts hold each channel's state between calls. Builds without SSE2
+run the channels one at a time, with the same results.
 */
 
 #if !defined(_FSK_H_)
@@ -165,6 +183,33 @@ typedef struct
     int scaling_shift;
 } fsk_rx_state_t;
 
+/*! The number of samples of each channel checked for a signal at a time, by a bank
+    of FSK receivers. */
+#define FSK_RX_BANK_CHUNK           64
+
+/*!
+    A bank of FSK modem receivers, for many channels.
+*/
+typedef struct
+{
+    /*! The number of channels. */
+    int channels;
+    /*! The spacing of the channels in the working arrays. This is the number of
+        channels, rounded up to whole vectors. */
+    int stride;
+    /*! The specification of the modem tones and rate, or NULL if the receivers
+        belong to something else. */
+    fsk_spec_t *spec;
+    /*! The synchronisation mode of the receivers. */
+    int sync_mode;
+    /*! The receiver for each channel. */
+    fsk_rx_state_t **chan;
+    /*! The receivers, when they belong to the bank. */
+    fsk_rx_state_t *own;
+    /*! The working arrays, holding the power meter states of all the channels. */
+    int32_t *vec;
+} fsk_rx_bank_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -234,6 +279,66 @@ int fsk_rx(fsk_rx_state_t *s, const int16_t *amp, int len);
 
 void fsk_rx_set_put_bit(fsk_rx_state_t *s, put_bit_func_t put_bit, void *user_data);
 
+/*! Initialise a bank of FSK modem receivers, all using the same modem tones and rate.
+    \brief Initialise a bank of FSK modem receivers.
+    \param s The bank context. If NULL, a context is allocated with malloc.
+    \param channels The number of channels.
+    \param spec The specification of the modem tones and rate.
+    \param sync_mode TRUE for synchronous modem. FALSE for asynchronous mode.
+    \param put_bit The callback routine used to put the received data.
+    \param user_data An array of opaque pointers, one per channel, passed to the
+           callback routine. If NULL, NULL is passed for every channel.
+    \return A pointer to the bank context, or NULL if there was a problem. */
+fsk_rx_bank_state_t *fsk_rx_bank_init(fsk_rx_bank_state_t *s,
+                                      int channels,
+                                      fsk_spec_t *spec,
+                                      int sync_mode,
+                                      put_bit_func_t put_bit,
+                                      void *user_data[]);
+
+/*! Initialise a bank of FSK modem receivers, to run receivers which already exist,
+    such as those inside ADSI receivers. The receivers remain the property of the
+    caller, and must have been initialised with fsk_rx_init().
+    \brief Initialise a bank of existing FSK modem receivers.
+    \param s The bank context. If NULL, a context is allocated with malloc.
+    \param channels The number of channels.
+    \param rx The receivers, one per channel.
+    \return A pointer to the bank context, or NULL if there was a problem. */
+fsk_rx_bank_state_t *fsk_rx_bank_attach(fsk_rx_bank_state_t *s, int channels, fsk_rx_state_t *rx[]);
+
+/*! \brief Release a bank of FSK modem receivers allocated by fsk_rx_bank_init(),
+           or fsk_rx_bank_attach().
+    \param s The bank context.
+    \return 0 for OK, -1 for fail. */
+int fsk_rx_bank_release(fsk_rx_bank_state_t *s);
+
+/*! Reset one channel of a bank of FSK modem receivers, as though it had just been
+    initialised. The receivers of a bank from fsk_rx_bank_attach() must be reset by
+    their owner.
+    \brief Reset one channel of a bank of FSK modem receivers.
+    \param s The bank context.
+    \param chan The channel number.
+    \return 0 for OK, -1 for a bad channel number, or a receiver the bank does
+            not own. */
+int fsk_rx_bank_reset_channel(fsk_rx_bank_state_t *s, int chan);
+
+/*! Get the receiver for one channel of a bank of FSK modem receivers. This may be
+    used to examine or adjust the channel's state between calls to fsk_rx_bank().
+    The power meter is only brought up to date at the end of each call.
+    \brief Get the receiver for one channel of a bank of FSK modem receivers.
+    \param s The bank context.
+    \param chan The channel number.
+    \return A pointer to the channel's receiver, or NULL for a bad channel number. */
+fsk_rx_state_t *fsk_rx_bank_channel(fsk_rx_bank_state_t *s, int chan);
+
+/*! Process a block of received FSK modem audio samples for every channel of a bank.
+    \brief Process a block of received FSK modem audio samples for a bank of channels.
+    \param s The bank context.
+    \param amp The audio sample buffers, one per channel.
+    \param len The number of samples in each buffer.
+    \return The number of samples unprocessed. */
+int fsk_rx_bank(fsk_rx_bank_state_t *s, const int16_t *amp[], int len);
+
 #ifdef __cplusplus
 }
 #endif
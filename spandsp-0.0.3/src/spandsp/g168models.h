@@ -222,6 +222,47 @@ const int32_t line_model_d9_coeffs[] =
       -238,   -165,   -183
 };
 
+/*! The number of G.168 line models, D.2 to D.9. */
+#define G168_LINE_MODELS    8
+
+/*!
+    The G.168 line models, D.2 to D.9, in order, for building line simulators
+    with the fir32_xxx routines.
+*/
+const int32_t * const g168_line_models[G168_LINE_MODELS] =
+{
+    line_model_d2_coeffs,
+    line_model_d3_coeffs,
+    line_model_d4_coeffs,
+    line_model_d5_coeffs,
+    line_model_d6_coeffs,
+    line_model_d7_coeffs,
+    line_model_d8_coeffs,
+    line_model_d9_coeffs
+};
+
+/*! The number of coefficients in each of g168_line_models. */
+const int g168_line_model_sizes[G168_LINE_MODELS] =
+{
+    sizeof(line_model_d2_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d3_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d4_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d5_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d6_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d7_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d8_coeffs)/sizeof(int32_t),
+    sizeof(line_model_d9_coeffs)/sizeof(int32_t)
+};
+
+/*!
+    The gain which brings each of g168_line_models to 0dB ERL, for a 16 bit
+    signal scaled up by 32768 before it is filtered.
+*/
+const float g168_line_model_ki[G168_LINE_MODELS] =
+{
+    1.39E-5, 1.44E-5, 1.52E-5, 1.77E-5, 9.33E-6, 1.51E-5, 2.33E-5, 1.33E-5
+};
+
 /*!
     The filter coefficients for the bandpass filter specified for level measurements
     in G.168.
@@ -47,6 +47,13 @@ favourite processor.
 Look up tables are used for transcoding between A-law and u-law, since it is
 difficult to achieve the precise transcoding procedure laid down in the G.711
 specification by other means.
+
+The block functions, such as g711_ulaw_encode_block(), convert a whole buffer
+at once. They give exactly the same results as the single sample functions.
+The encoders use SSE2 or AVX2, when the library is built for them, to find
+the segments of several samples at a time without branches. The decoders
+and transcoders use 256 entry look up tables, which are small enough not
+to upset the cache.
 */
 
 #if !defined(_G711_H_)
@@ -246,6 +253,56 @@ uint8_t alaw_to_ulaw(uint8_t alaw);
 */
 uint8_t ulaw_to_alaw(uint8_t ulaw);
 
+/*! \brief Encode a block of linear samples to u-law. The result is identical
+           to calling linear_to_ulaw() for each sample, but SSE2 or AVX2 is
+           used to encode several samples at once, where available.
+    \param ulaw The u-law values.
+    \param amp The samples to encode.
+    \param len The number of samples.
+*/
+void g711_ulaw_encode_block(uint8_t ulaw[], const int16_t amp[], int len);
+
+/*! \brief Decode a block of u-law samples to linear values. The result is
+           identical to calling ulaw_to_linear() for each sample.
+    \param amp The linear values.
+    \param ulaw The u-law samples to decode.
+    \param len The number of samples.
+*/
+void g711_ulaw_decode_block(int16_t amp[], const uint8_t ulaw[], int len);
+
+/*! \brief Encode a block of linear samples to A-law. The result is identical
+           to calling linear_to_alaw() for each sample, but SSE2 or AVX2 is
+           used to encode several samples at once, where available.
+    \param alaw The A-law values.
+    \param amp The samples to encode.
+    \param len The number of samples.
+*/
+void g711_alaw_encode_block(uint8_t alaw[], const int16_t amp[], int len);
+
+/*! \brief Decode a block of A-law samples to linear values. The result is
+           identical to calling alaw_to_linear() for each sample.
+    \param amp The linear values.
+    \param alaw The A-law samples to decode.
+    \param len The number of samples.
+*/
+void g711_alaw_decode_block(int16_t amp[], const uint8_t alaw[], int len);
+
+/*! \brief Transcode a block from A-law to u-law, using the procedure defined
+           in G.711.
+    \param ulaw The u-law values.
+    \param alaw The A-law samples to transcode.
+    \param len The number of samples.
+*/
+void g711_alaw_to_ulaw_block(uint8_t ulaw[], const uint8_t alaw[], int len);
+
+/*! \brief Transcode a block from u-law to A-law, using the procedure defined
+           in G.711.
+    \param alaw The A-law values.
+    \param ulaw The u-law samples to transcode.
+    \param len The number of samples.
+*/
+void g711_ulaw_to_alaw_block(uint8_t alaw[], const uint8_t ulaw[], int len);
+
 #ifdef __cplusplus
 }
 #endif
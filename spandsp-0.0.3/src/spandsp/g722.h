@@ -47,7 +47,17 @@ support an option for the linear audio to be an 8k samples/second stream. In thi
 codec is considerably faster, and still fully compatible with wideband terminals using G.722.
 
 \section g722_page_sec_2 How does it work?
-???.
+The signal is split into two sub-bands by a 24 tap QMF, and each sub-band is coded with its own
+ADPCM. The two sub-bands are independent until their codes are combined, so the codec works
+through a block at a time, running each sub-band's ADPCM across the whole block in turn. The QMF
+signal history is held twice over, so the filter always sees the latest 24 samples as one
+contiguous run, and it is computed with SIMD instructions where they are available.
+
+When a linear PCM buffer is encoded with the QMF in use, each code represents a pair of samples,
+so the buffer length should be even.
+
+A conferencing node, or similar, running many G.722 legs can encode or decode a set of channels
+with one call to g722_encode_batch() or g722_decode_batch().
 */
 
 enum
@@ -56,6 +66,25 @@ enum
     G722_PACKED = 0x0002
 };
 
+/*! The adaptive predictor and scale factor state for one of the two sub-bands. */
+typedef struct
+{
+    int s;
+    int sp;
+    int sz;
+    int r[3];
+    int a[3];
+    int p[3];
+    /*! The quantized difference signal history, in d[1] to d[6]. The other entries are
+        working space. */
+    int16_t d[8];
+    /*! The zero predictor coefficients, in b[1] to b[6]. The other entries are always
+        zero. */
+    int16_t b[8];
+    int nb;
+    int det;
+} g722_band_t;
+
 typedef struct
 {
     /*! TRUE if the operating in the special ITU test mode, with the band split filters
@@ -68,25 +97,13 @@ typedef struct
     /*! 6 for 48000kbps, 7 for 56000kbps, or 8 for 64000kbps. */
     int bits_per_sample;
 
-    /*! Signal history for the QMF */
-    int x[24];
-
-    struct
-    {
-        int s;
-        int sp;
-        int sz;
-        int r[3];
-        int a[3];
-        int ap[3];
-        int p[3];
-        int d[7];
-        int b[7];
-        int bp[7];
-        int sg[7];
-        int nb;
-        int det;
-    } band[2];
+    /*! Signal history for the QMF. This is held twice over, so the filter can always
+        read the most recent 24 samples as one contiguous run. */
+    int16_t x[48];
+    /*! The current position in the QMF signal history. */
+    int ptr;
+
+    g722_band_t band[2];
 
     unsigned int in_buffer;
     int in_bits;
@@ -106,26 +123,14 @@ typedef struct
     /*! 6 for 48000kbps, 7 for 56000kbps, or 8 for 64000kbps. */
     int bits_per_sample;
 
-    /*! Signal history for the QMF */
-    int x[24];
-
-    struct
-    {
-        int s;
-        int sp;
-        int sz;
-        int r[3];
-        int a[3];
-        int ap[3];
-        int p[3];
-        int d[7];
-        int b[7];
-        int bp[7];
-        int sg[7];
-        int nb;
-        int det;
-    } band[2];
-    
+    /*! Signal history for the QMF. This is held twice over, so the filter can always
+        read the most recent 24 samples as one contiguous run. */
+    int16_t x[48];
+    /*! The current position in the QMF signal history. */
+    int ptr;
+
+    g722_band_t band[2];
+
     unsigned int in_buffer;
     int in_bits;
     unsigned int out_buffer;
@@ -154,6 +159,16 @@ int g722_encode_release(g722_encode_state_t *s);
     \return The number of bytes of G.722 data produced. */
 int g722_encode(g722_encode_state_t *s, uint8_t g722_data[], const int16_t amp[], int len);
 
+/*! Encode a buffer of linear PCM data to G.722 for each of a set of channels.
+    The contexts should all have been initialised with the same rate and options.
+    \param s The G.722 contexts, one per channel.
+    \param g722_data The G.722 data buffers, one per channel.
+    \param amp The audio sample buffers, one per channel.
+    \param channels The number of channels.
+    \param len The number of samples in each audio buffer.
+    \return The number of bytes of G.722 data produced for each channel. */
+int g722_encode_batch(g722_encode_state_t *s[], uint8_t *g722_data[], const int16_t *amp[], int channels, int len);
+
 /*! Initialise an G.722 decode context.
     \param s The G.722 decode context.
     \param rate The bit rate of the G.722 data.
@@ -172,6 +187,16 @@ int g722_decode_release(g722_decode_state_t *s);
     \return The number of samples returned. */
 int g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[], int len);
 
+/*! Decode a buffer of G.722 data to linear PCM for each of a set of channels.
+    The contexts should all have been initialised with the same rate and options.
+    \param s The G.722 contexts, one per channel.
+    \param amp The audio sample buffers, one per channel.
+    \param g722_data The G.722 data buffers, one per channel.
+    \param channels The number of channels.
+    \param len The number of bytes of G.722 data in each buffer.
+    \return The number of samples returned for each channel. */
+int g722_decode_batch(g722_decode_state_t *s[], int16_t *amp[], const uint8_t *g722_data[], int channels, int len);
+
 #ifdef __cplusplus
 }
 #endif
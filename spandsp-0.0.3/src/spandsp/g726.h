@@ -67,6 +67,12 @@ It supports:
 
 It passes the ITU tests.
 
+A bank of G.726 channels, all at the same bit rate, can be encoded or decoded
+a frame at a time with the g726_bank functions. These give exactly the same
+results as the same number of separate G.726 contexts, but compute the
+predictor for several channels at once with SSE2 or AVX2 where the CPU
+allows. This suits gateways transcoding large numbers of ADPCM channels.
+
 \section g726_page_sec_2 How does it work?
 ???.
 */
@@ -108,7 +114,7 @@ typedef struct g726_state_s
     int ext_coding;
     /*! The number of bits per sample */
     unsigned int bits_per_sample;
-    /*! One fo the G.726_PACKING_xxx options */
+    /*! One of the G.726_PACKING_xxx options */
     int packing;
 
     /*! Locked or steady state step size multiplier. */
@@ -143,6 +149,64 @@ typedef struct g726_state_s
     g726_decoder_func_t dec_func;
 } g726_state_t;
 
+/*!
+    The state of a bank of G.726 encoders, or decoders, which all run at the same
+    bit rate and are stepped through each frame in lockstep. The channel states
+    are kept as structure of arrays, with one entry per channel in each array, so
+    the predictor can be computed for several channels at once. The field names
+    match those in g726_state_t.
+*/
+typedef struct
+{
+    /*! The number of channels */
+    int channels;
+    /*! The number of entries in each of the state arrays. This is the number of
+        channels rounded up to a whole number of vectors. */
+    int stride;
+    /*! The bit rate */
+    int rate;
+    /*! The external coding, for tandem operation */
+    int ext_coding;
+    /*! The number of bits per sample */
+    unsigned int bits_per_sample;
+    /*! One of the G.726_PACKING_xxx options */
+    int packing;
+
+    int32_t *yl;
+    int32_t *yu;
+    int32_t *dms;
+    int32_t *dml;
+    int32_t *ap;
+    int32_t *a[2];
+    int32_t *b[6];
+    int32_t *pk[2];
+    int32_t *dq[6];
+    int32_t *sr[2];
+    int32_t *td;
+
+    /*! Working storage for the current sample - the input signal, the code,
+        the step size, the zero predictor and full predictor outputs, the
+        table values for the code, and the reconstructed signal. */
+    int32_t *sl;
+    int32_t *code;
+    int32_t *y;
+    int32_t *sezi;
+    int32_t *sei;
+    int32_t *dqln;
+    int32_t *wi;
+    int32_t *fi;
+    int32_t *recon;
+
+    bitstream_state_t *bs;
+
+    /*! The tables for the bit rate in use */
+    const int *dqlntab;
+    const int *witab;
+    const int *fitab;
+    const int *qtab;
+    int quantizer_states;
+} g726_bank_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -183,6 +247,57 @@ int g726_encode(g726_state_t *s,
                 const int16_t amp[],
                 int len);
 
+/*! Initialise a bank of G.726 encode or decode contexts.
+    \param s The G.726 bank context.
+    \param channels The number of channels in the bank.
+    \param bit_rate The required bit rate for the ADPCM data.
+           The valid rates are 16000, 24000, 32000 and 40000.
+    \param ext_coding The coding used outside G.726.
+    \param packing One of the G.726_PACKING_xxx options.
+    \return A pointer to the G.726 bank context, or NULL for error. */
+g726_bank_state_t *g726_bank_init(g726_bank_state_t *s, int channels, int bit_rate, int ext_coding, int packing);
+
+/*! Free a bank of G.726 encode or decode contexts.
+    \param s The G.726 bank context.
+    \return 0 for OK. */
+int g726_bank_release(g726_bank_state_t *s);
+
+/*! Restart one channel of a G.726 bank, as for a new call. The other channels
+    are not affected. All the channels of a bank share one octet phase, so the
+    channel's bit packing carries on from where the bank is. Any part octet
+    already held for the channel is still sent, or used, ahead of the new
+    call's codes. A reset on a frame boundary which is a whole number of
+    octets into the bank's data gives exactly the same results as a freshly
+    initialised separate context.
+    \param s The G.726 bank context.
+    \param chan The channel number.
+    \return 0 for OK, or -1 for a bad channel number. */
+int g726_bank_reset_channel(g726_bank_state_t *s, int chan);
+
+/*! Decode a frame of G.726 ADPCM data to linear PCM, a-law or u-law, for every
+    channel in a bank. Each channel must supply the same number of octets.
+    \param s The G.726 bank context.
+    \param amp The audio sample buffer for each channel.
+    \param g726_data The G.726 data for each channel.
+    \param g726_bytes The number of octets of G.726 data for each channel.
+    \return The number of samples returned for each channel. */
+int g726_bank_decode(g726_bank_state_t *s,
+                     int16_t *amp[],
+                     const uint8_t *g726_data[],
+                     int g726_bytes);
+
+/*! Encode a frame of linear PCM data to G.726 ADPCM, for every channel in a
+    bank.
+    \param s The G.726 bank context.
+    \param g726_data The G.726 data produced for each channel.
+    \param amp The audio sample buffer for each channel.
+    \param len The number of samples in the buffer for each channel.
+    \return The number of bytes of G.726 data produced for each channel. */
+int g726_bank_encode(g726_bank_state_t *s,
+                     uint8_t *g726_data[],
+                     const int16_t *amp[],
+                     int len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,8 +35,11 @@ The GSM 06.10 module is an version of the widely used GSM FR codec software
 available from http://kbs.cs.tu-berlin.de/~jutta/toast.html. This version
 was produced since some versions of this codec are not bit exact, or not
 very efficient on modern processors. This implementation can use MMX instructions
-on Pentium class processors, or alternative methods on other processors. It
-passes all the ETSI test vectors. That is, it is a tested bit exact implementation.
+on Pentium class processors, or alternative methods on other processors. On x86
+processors with SSE2 or AVX2, the encoder's LTP cross-correlation, autocorrelation
+and short term analysis lattice filter use those instructions, chosen at run time
+to suit the CPU. It passes all the ETSI test vectors. That is, it is a tested bit
+exact implementation.
 
 This implementation supports encoded data in one of three packing formats:
     - Unpacked, with the 76 parameters of a GSM 06.10 code frame each occupying a
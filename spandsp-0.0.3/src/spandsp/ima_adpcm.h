@@ -39,6 +39,15 @@
 IMA ADPCM offers a good balance of simplicity and quality at a rate of
 32kbps.
 
+A bank of DVI4 channels can be encoded or decoded a frame at a time with the
+ima_adpcm_bank functions. These give exactly the same results as the same number
+of separate IMA ADPCM contexts, but step all the channels together, several at
+once with SSE2 or AVX2 where the CPU allows. Each channel's data is read from,
+and written to, the caller's own buffer for that channel, so nothing needs to be
+interleaved or copied. This suits servers playing out large numbers of ADPCM
+streams at once. VDVI is not supported by the bank, as its variable length codes
+mean the channels cannot stay in step.
+
 \section ima_adpcm_page_sec_2 How does it work?
 
 \section ima_adpcm_page_sec_3 How do I use it?
@@ -64,6 +73,32 @@ typedef struct
     int bits;
 } ima_adpcm_state_t;
 
+/*!
+    The state of a bank of IMA ADPCM (DVI4) encoders, or decoders, which are
+    stepped through each frame in lockstep. The channel states are kept as
+    structure of arrays, with one entry per channel in each array, so several
+    channels can be processed at once. The field names match those in
+    ima_adpcm_state_t.
+*/
+typedef struct
+{
+    /*! The number of channels */
+    int channels;
+    /*! The number of entries in each of the state arrays. This is the number of
+        channels rounded up to a whole number of vectors. */
+    int stride;
+    /*! The count of codes, which is the same for every channel */
+    int bits;
+
+    int32_t *last;
+    int32_t *step_index;
+    int32_t *ima_byte;
+
+    /*! Working storage for the current sample - the linear sample, and the code */
+    int32_t *sl;
+    int32_t *code;
+} ima_adpcm_bank_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -101,6 +136,49 @@ int ima_adpcm_decode(ima_adpcm_state_t *s,
                      const uint8_t ima_data[],
                      int ima_bytes);
 
+/*! Initialise a bank of IMA ADPCM encode or decode contexts.
+    \param s The IMA ADPCM bank context.
+    \param channels The number of channels in the bank.
+    \param variant The IMA ADPCM variant. Only IMA_ADPCM_DVI4 is supported.
+    \return A pointer to the IMA ADPCM bank context, or NULL for error. */
+ima_adpcm_bank_state_t *ima_adpcm_bank_init(ima_adpcm_bank_state_t *s, int channels, int variant);
+
+/*! Free a bank of IMA ADPCM encode or decode contexts.
+    \param s The IMA ADPCM bank context.
+    \return 0 for OK. */
+int ima_adpcm_bank_release(ima_adpcm_bank_state_t *s);
+
+/*! Restart one channel of an IMA ADPCM bank, as for a new call. The other
+    channels are not affected.
+    \param s The IMA ADPCM bank context.
+    \param chan The channel number.
+    \return 0 for OK, or -1 for a bad channel number. */
+int ima_adpcm_bank_reset_channel(ima_adpcm_bank_state_t *s, int chan);
+
+/*! Decode a frame of IMA ADPCM data to linear PCM, for every channel in a bank.
+    Each channel must supply the same number of octets. The samples are written
+    straight into each channel's buffer.
+    \param s The IMA ADPCM bank context.
+    \param amp The audio sample buffer for each channel.
+    \param ima_data The IMA ADPCM data for each channel.
+    \param ima_bytes The number of octets of IMA ADPCM data for each channel.
+    \return The number of samples returned for each channel. */
+int ima_adpcm_bank_decode(ima_adpcm_bank_state_t *s,
+                          int16_t *amp[],
+                          const uint8_t *ima_data[],
+                          int ima_bytes);
+
+/*! Encode a frame of linear PCM data to IMA ADPCM, for every channel in a bank.
+    \param s The IMA ADPCM bank context.
+    \param ima_data The IMA ADPCM data produced for each channel.
+    \param amp The audio sample buffer for each channel.
+    \param len The number of samples in the buffer for each channel.
+    \return The number of bytes of IMA ADPCM data produced for each channel. */
+int ima_adpcm_bank_encode(ima_adpcm_bank_state_t *s,
+                          uint8_t *ima_data[],
+                          const int16_t *amp[],
+                          int len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,15 @@ or other restrictions.
 
 \section lpc10_page_sec_2 How does it work?
 ???.
+
+Most of the encoder's time goes in the AMDF pitch search, the loading of the
+covariance matrix, and the pitch analysis filters. Where SSE2 or AVX2 are
+available these work on several lags, matrix elements or output samples at once.
+Each of those still sums its terms in the same order as the plain C code, so the
+encoded data does not change.
+
+A gateway, or similar, running many LPC10 channels can encode a set of channels
+with one call to lpc10_encode_batch().
 */
 
 #define LPC10_SAMPLES_PER_FRAME 180
@@ -187,6 +196,15 @@ int lpc10_encode_release(lpc10_encode_state_t *s);
     \return The number of bytes of LPC10e data produced. */
 int lpc10_encode(lpc10_encode_state_t *s, uint8_t code[], const int16_t amp[], int quant);
 
+/*! Encode a buffer of linear PCM data to LPC10e for each of a set of channels.
+    \param s The LPC10e contexts, one per channel.
+    \param code The LPC10e data buffers, one per channel.
+    \param amp The audio sample buffers, one per channel.
+    \param channels The number of channels.
+    \param quant The number of frames of audio in each audio buffer.
+    \return The number of bytes of LPC10e data produced for each channel. */
+int lpc10_encode_batch(lpc10_encode_state_t *s[], uint8_t *code[], const int16_t *amp[], int channels, int quant);
+
 /*! Initialise an LPC10e decode context.
     \param s The LPC10e context
     \param error_correction ???
@@ -45,7 +45,16 @@ compression algorithm on the slower samples.
 
 The algorithms for this ADPCM codec can be found in "PC Telephony - The complete guide
 to designing, building and programming systems using Dialogic and Related Hardware"
-by Bob Edgar. pg 272-276. */
+by Bob Edgar. pg 272-276.
+
+A bank of channels, all at the same bit rate, can be encoded or decoded a frame
+at a time with the oki_adpcm_bank functions. These give exactly the same results
+as the same number of separate Oki ADPCM contexts, but step all the channels
+together, several at once with SSE2 or AVX2 where the CPU allows. At 24kbps the
+resampling filter is run across the channels in the same way. Each channel's
+data is read from, and written to, the caller's own buffer for that channel, so
+nothing needs to be interleaved or copied. This suits servers playing out large
+numbers of ADPCM prompts at once. */
 
 /*!
     Oki (Dialogic) ADPCM conversion state descriptor. This defines the state of
@@ -64,6 +73,38 @@ typedef struct
     int phase;
 } oki_adpcm_state_t;
 
+/*!
+    The state of a bank of Oki ADPCM encoders, or decoders, which all run at the
+    same bit rate and are stepped through each frame in lockstep. The channel
+    states are kept as structure of arrays, with one entry per channel in each
+    array, so several channels can be processed at once. The field names match
+    those in oki_adpcm_state_t.
+*/
+typedef struct
+{
+    /*! The number of channels */
+    int channels;
+    /*! The number of entries in each of the state arrays. This is the number of
+        channels rounded up to a whole number of vectors. */
+    int stride;
+    int bit_rate;
+    /*! The count of codes, and the resampler's phase and history pointer. These
+        are the same for every channel. */
+    int mark;
+    int phase;
+    int ptr;
+
+    int32_t *last;
+    int32_t *step_index;
+    int32_t *oki_byte;
+    /*! The resampler's history, as 32 rows of one entry per channel */
+    float *history;
+
+    /*! Working storage for the current sample - the linear sample, and the code */
+    int32_t *sl;
+    int32_t *code;
+} oki_adpcm_bank_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -102,6 +143,51 @@ int oki_adpcm_encode(oki_adpcm_state_t *s,
                      const int16_t amp[],
                      int len);
 
+/*! Initialise a bank of Oki ADPCM encode or decode contexts.
+    \param s The Oki ADPCM bank context.
+    \param channels The number of channels in the bank.
+    \param bit_rate The required bit rate for the ADPCM data.
+           The valid rates are 24000 and 32000.
+    \return A pointer to the Oki ADPCM bank context, or NULL for error. */
+oki_adpcm_bank_state_t *oki_adpcm_bank_init(oki_adpcm_bank_state_t *s, int channels, int bit_rate);
+
+/*! Free a bank of Oki ADPCM encode or decode contexts.
+    \param s The Oki ADPCM bank context.
+    \return 0 for OK. */
+int oki_adpcm_bank_release(oki_adpcm_bank_state_t *s);
+
+/*! Restart one channel of an Oki ADPCM bank, as for a new call. The other
+    channels are not affected. At 24kbps the channel carries on from the bank's
+    current resampling phase.
+    \param s The Oki ADPCM bank context.
+    \param chan The channel number.
+    \return 0 for OK, or -1 for a bad channel number. */
+int oki_adpcm_bank_reset_channel(oki_adpcm_bank_state_t *s, int chan);
+
+/*! Decode a frame of Oki ADPCM data to linear PCM, for every channel in a bank.
+    Each channel must supply the same number of octets. The samples are written
+    straight into each channel's buffer.
+    \param s The Oki ADPCM bank context.
+    \param amp The audio sample buffer for each channel.
+    \param oki_data The Oki ADPCM data for each channel.
+    \param oki_bytes The number of octets of Oki ADPCM data for each channel.
+    \return The number of samples returned for each channel. */
+int oki_adpcm_bank_decode(oki_adpcm_bank_state_t *s,
+                          int16_t *amp[],
+                          const uint8_t *oki_data[],
+                          int oki_bytes);
+
+/*! Encode a frame of linear PCM data to Oki ADPCM, for every channel in a bank.
+    \param s The Oki ADPCM bank context.
+    \param oki_data The Oki ADPCM data produced for each channel.
+    \param amp The audio sample buffer for each channel.
+    \param len The number of samples in the buffer for each channel.
+    \return The number of bytes of Oki ADPCM data produced for each channel. */
+int oki_adpcm_bank_encode(oki_adpcm_bank_state_t *s,
+                          uint8_t *oki_data[],
+                          const int16_t *amp[],
+                          int len);
+
 #ifdef __cplusplus
 }
 #endif
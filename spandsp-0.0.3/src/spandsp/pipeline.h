@@ -0,0 +1,266 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * pipeline.h - Run a channel's chain of DSP stages a block at a time, with
+ *              per stage cycle accounting.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+#if !defined(_PIPELINE_H_)
+#define _PIPELINE_H_
+
+/*! \page pipeline_page Channel processing pipelines
+\section pipeline_page_sec_1 What does it do?
+A channel usually passes its audio through a chain of modules - say the transmit
+high pass filter and echo canceller, a DTMF receiver, packet loss concealment,
+and a codec. Called one after another over a whole chunk of audio, each module
+makes its own pass over the chunk, and by the time the last one runs, the start
+of the chunk may have left the L1 cache. A pipeline holds the chain of stages
+for a channel, and runs all of them over each small block of the chunk before
+moving on to the next block, so each block passes through every stage while it
+is still in the cache. The stages work on the caller's buffers in place, so
+nothing is copied between them.
+
+The time spent in each stage is accounted for, so the cost of each part of a
+channel's processing can be seen under real traffic.
+
+\section pipeline_page_sec_2 How does it work?
+Stages are added to a pipeline in the order they should run. Each is a callback
+routine, which is passed a block of the audio. The pipeline can run the echo
+canceller (and its transmit high pass filter), the DTMF receiver, a tone analysis
+engine, the packet loss concealer, and the G.711 and G.726 encoders, through
+ready made stages, and any other processing through pipeline_add_stage().
+
+Each block carries the signal being processed, which the stages may change in
+place, and the reference signal - the audio sent towards the line, which the
+echo canceller needs. The echo canceller's transmit high pass filter changes the
+reference in place, so what is left in that buffer is the audio to send. A codec
+stage appends its output to the pipeline's code buffer. There should be at most
+one codec stage in a pipeline.
+
+The modules' results do not depend on how their audio is split into calls, so a
+pipeline gives exactly the same results as calling each module in turn over the
+whole chunk. The packet loss concealer is the exception. It blends real and
+synthetic audio over up to PLC_PITCH_OVERLAP_MAX samples at the start of a gap,
+and again at the start of the audio after the gap, and a blend is cut short if
+the call it falls in is shorter than that. The concealer can, therefore, only be
+added to a pipeline whose blocks are at least PLC_PITCH_OVERLAP_MAX samples long.
+A gap always starts a new block, so a short tail block at the end of a chunk is
+never a problem. However, the first chunk of a gap given to pipeline_fillin(),
+and the first chunk after a gap given to pipeline_process(), must be at least
+PLC_PITCH_OVERLAP_MAX samples long, unless the gap or the audio really is that
+short. Otherwise the results differ from those for the same audio in longer
+chunks, though they still match calling the concealer directly with the same
+chunks.
+
+When a chunk of audio has been lost, pipeline_fillin() runs the stages with the
+block marked as lost. The packet loss concealer stage synthesises the missing
+audio, and the stages after it process that. Stages ahead of it see silence.
+
+The time spent in each stage is measured with the CPU's time stamp counter, where
+there is one, and in nanoseconds otherwise.
+*/
+
+/*! The most stages in one pipeline. */
+#define PIPELINE_MAX_STAGES             16
+/*! The default block length, in samples. */
+#define PIPELINE_DEFAULT_BLOCK_SIZE     80
+
+/*!
+    A block of audio, passed to each stage of a pipeline.
+*/
+typedef struct
+{
+    /*! The audio being processed. Stages may change this in place. */
+    int16_t *amp;
+    /*! The reference audio, sent towards the line, or NULL if there is none. */
+    int16_t *ref;
+    /*! The number of samples in the block. */
+    int len;
+    /*! TRUE if the audio in this block was lost, and is to be concealed. */
+    int lost;
+    /*! The buffer for encoded output, or NULL if there is none. */
+    uint8_t *code;
+    /*! The number of bytes of encoded output so far, for the whole chunk. A
+        codec stage writes from here, and advances this. */
+    int code_len;
+} pipeline_block_t;
+
+/*! Pipeline stage callback routine.
+    \param user_data An opaque pointer.
+    \param block The block of audio to be processed. */
+typedef void (*pipeline_stage_func_t)(void *user_data, pipeline_block_t *block);
+
+/*!
+    A stage of a pipeline.
+*/
+typedef struct
+{
+    /*! A name for the stage, for reports. */
+    const char *name;
+    /*! The callback routine which processes a block. */
+    pipeline_stage_func_t process;
+    /*! An opaque pointer passed to the callback routine. */
+    void *user_data;
+    /*! The number of samples processed. */
+    uint64_t samples;
+    /*! The time spent in the stage, in CPU cycles, or nanoseconds where the
+        CPU has no cycle counter. */
+    uint64_t cycles;
+} pipeline_stage_t;
+
+/*!
+    Channel processing pipeline descriptor.
+*/
+typedef struct
+{
+    /*! The length of the blocks passed through the stages, in samples. */
+    int block_size;
+    int stages;
+    pipeline_stage_t stage[PIPELINE_MAX_STAGES];
+} pipeline_state_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \brief Initialise a pipeline, with no stages.
+    \param s The pipeline context. If NULL, a context is allocated with malloc.
+    \param block_size The length of the blocks passed through the stages, in
+           samples. Zero selects PIPELINE_DEFAULT_BLOCK_SIZE.
+    \return A pointer to the pipeline context, or NULL for error. */
+pipeline_state_t *pipeline_init(pipeline_state_t *s, int block_size);
+
+/*! \brief Release a pipeline allocated by pipeline_init(). The stages' own
+           contexts are not released.
+    \param s The pipeline context.
+    \return 0 for OK, -1 for fail. */
+int pipeline_release(pipeline_state_t *s);
+
+/*! Add a stage to the end of a pipeline.
+    \brief Add a stage to a pipeline.
+    \param s The pipeline context.
+    \param name A name for the stage, for reports.
+    \param process The callback routine which processes each block.
+    \param user_data An opaque pointer passed to the callback routine.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_stage(pipeline_state_t *s, const char *name, pipeline_stage_func_t process, void *user_data);
+
+/*! \brief Add an echo canceller's transmit high pass filter to a pipeline. This
+           filters the reference audio in place.
+    \param s The pipeline context.
+    \param ec The echo canceller context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_echo_can_hpf_tx(pipeline_state_t *s, echo_can_state_t *ec);
+
+/*! \brief Add an echo canceller to a pipeline. This cancels the echo of the
+           reference audio from the audio being processed.
+    \param s The pipeline context.
+    \param ec The echo canceller context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_echo_can(pipeline_state_t *s, echo_can_state_t *ec);
+
+/*! \brief Add a DTMF receiver to a pipeline.
+    \param s The pipeline context.
+    \param dtmf The DTMF receiver context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_dtmf_rx(pipeline_state_t *s, dtmf_rx_state_t *dtmf);
+
+/*! \brief Add a tone analysis engine, and so all the detectors subscribed to it,
+           to a pipeline.
+    \param s The pipeline context.
+    \param t The tone analysis context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_tone_analysis(pipeline_state_t *s, tone_analysis_state_t *t);
+
+/*! \brief Add a packet loss concealer to a pipeline. Good blocks are passed to
+           plc_rx(), and lost ones are filled in by plc_fillin().
+    \param s The pipeline context.
+    \param plc The packet loss concealer context.
+    \return The stage number, or -1 if the pipeline is full, or its blocks are
+            shorter than PLC_PITCH_OVERLAP_MAX. */
+int pipeline_add_plc(pipeline_state_t *s, plc_state_t *plc);
+
+/*! \brief Add an A-law encoder to a pipeline.
+    \param s The pipeline context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_alaw_encode(pipeline_state_t *s);
+
+/*! \brief Add a u-law encoder to a pipeline.
+    \param s The pipeline context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_ulaw_encode(pipeline_state_t *s);
+
+/*! \brief Add a G.726 encoder to a pipeline.
+    \param s The pipeline context.
+    \param g726 The G.726 context.
+    \return The stage number, or -1 if the pipeline is full. */
+int pipeline_add_g726_encode(pipeline_state_t *s, g726_state_t *g726);
+
+/*! Pass a chunk of audio through all the stages of a pipeline, a block at a time.
+    \brief Process a chunk of audio through a pipeline.
+    \param s The pipeline context.
+    \param amp The audio to be processed. This is changed in place.
+    \param ref The reference audio, sent towards the line, or NULL if there is
+           none. This is changed in place by a transmit high pass filter stage.
+    \param len The number of samples in the chunk.
+    \param code The buffer for encoded output, or NULL if there is none.
+    \return The number of bytes of encoded output. */
+int pipeline_process(pipeline_state_t *s, int16_t amp[], int16_t ref[], int len, uint8_t code[]);
+
+/*! Run the stages of a pipeline for a chunk of lost audio. The packet loss
+    concealer stage fills in the audio. The first chunk of a gap should be at
+    least PLC_PITCH_OVERLAP_MAX samples long, as should the first chunk passed
+    to pipeline_process() after the gap, or the concealer's blend is cut short.
+    \brief Process a chunk of lost audio through a pipeline.
+    \param s The pipeline context.
+    \param amp The buffer for the concealed audio.
+    \param ref The reference audio, sent towards the line, or NULL if there is
+           none. This is changed in place by a transmit high pass filter stage.
+    \param len The number of samples in the chunk.
+    \param code The buffer for encoded output, or NULL if there is none.
+    \return The number of bytes of encoded output. */
+int pipeline_fillin(pipeline_state_t *s, int16_t amp[], int16_t ref[], int len, uint8_t code[]);
+
+/*! \brief Get the accounting for one stage of a pipeline.
+    \param s The pipeline context.
+    \param stage The stage number.
+    \param name The stage's name.
+    \param samples The number of samples the stage has processed.
+    \param cycles The time spent in the stage, in CPU cycles, or nanoseconds
+           where the CPU has no cycle counter.
+    \return 0 for OK, -1 for a bad stage number. */
+int pipeline_get_stage_stats(pipeline_state_t *s, int stage, const char **name, uint64_t *samples, uint64_t *cycles);
+
+/*! \brief Clear the accounting for all the stages of a pipeline.
+    \param s The pipeline context. */
+void pipeline_reset_stats(pipeline_state_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/*- End of file ------------------------------------------------------------*/
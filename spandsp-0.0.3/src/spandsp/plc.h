@@ -119,6 +119,8 @@ typedef struct
     int pitch_offset;
     /*! Pitch estimate */
     int pitch;
+    /*! The gain applied to the synthetic signal, as it fades away */
+    float gain;
     /*! Buffer for a cycle of speech */
     float pitchbuf[PLC_PITCH_MIN];
     /*! History buffer */
@@ -35,6 +35,25 @@ in many analogue signaling procotols, and digital ones derived from them.
 
 \section sig_tone_sec_2 How does it work?
 TBD
+
+\section sig_tone_sec_3 Trunk groups
+A trunk group will often have many channels, all using the same signaling tone.
+A bank of signaling tone processors, from sig_tone_bank_init(), handles all the
+channels of a group together. The receiver's filters, integrators, timers and
+decisions are run for a vector of channels at a time, stepping through a stretch
+of each channel's audio in lock step. Where sig_tone_rx() branches, between the
+sharp and flat modes, or on the persistence checks, the bank works out both
+sides for every channel, and selects the right result for each. The integer
+arithmetic is exactly that of sig_tone_rx(), so each channel's output, and its
+signaling changes, are exactly those of a separate processor. Within one call,
+the changes for each vector of channels are reported in time order, but those
+for one vector come before those for the next. The vector code needs a 32 bit
+vector multiply, so it is used in builds for SSE4.1 or AVX2. Other builds run
+the channels one at a time, with the same results.
+
+The channel contexts hold the state of each channel between calls, and can be
+examined, adjusted, or even passed to sig_tone_rx() or sig_tone_tx(), between
+calls to the bank functions.
 */
 
 #if !defined(_SIG_TONE_H_)
@@ -166,6 +185,30 @@ typedef struct
     int signaling_state_duration;
 } sig_tone_state_t;
 
+/*! The number of samples of each channel processed at a time by a signaling
+    tone bank. */
+#define SIG_TONE_BANK_CHUNK         64
+
+/*!
+    A bank of signaling tone processors, for the channels of a trunk group which
+    use the same signaling tone.
+*/
+typedef struct
+{
+    /*! The number of channels. */
+    int channels;
+    /*! The spacing of the channels in the working arrays. This is the number of
+        channels, rounded up to whole vectors. */
+    int stride;
+    /*! The signaling tone used by all the channels. */
+    sig_tone_descriptor_t *desc;
+    /*! The per channel contexts, which hold each channel's state between calls. */
+    sig_tone_state_t *chan;
+    /*! The working arrays, holding the receive states, and the audio, of all the
+        channels, interleaved across the channels. */
+    int32_t *vec;
+} sig_tone_bank_state_t;
+
 /*! Initialise a signaling tone context.
     \brief Initialise a signaling tone context.
     \param s The signaling tone context.
@@ -191,5 +234,60 @@ int sig_tone_rx(sig_tone_state_t *s, int16_t amp[], int len);
     \return The number of samples actually generated. */
 int sig_tone_tx(sig_tone_state_t *s, int16_t amp[], int len);
 
+/*! Initialise a bank of signaling tone processors, for the channels of a trunk
+    group.
+    \brief Initialise a bank of signaling tone processors.
+    \param s The signaling tone bank context. If NULL, a context is allocated with malloc.
+    \param channels The number of channels.
+    \param tone_type The type of signaling tone, used by all the channels.
+    \param sig_update Callback function to handle signaling updates.
+    \param user_data An array of opaque pointers, one per channel, passed to the
+           callback function. If NULL, NULL is passed for every channel.
+    \return A pointer to the signaling tone bank context, or NULL if there was a problem. */
+sig_tone_bank_state_t *sig_tone_bank_init(sig_tone_bank_state_t *s,
+                                          int channels,
+                                          int tone_type,
+                                          sig_tone_func_t sig_update,
+                                          void *user_data[]);
+
+/*! \brief Release a bank of signaling tone processors allocated by sig_tone_bank_init().
+    \param s The signaling tone bank context.
+    \return 0 for OK, -1 for fail. */
+int sig_tone_bank_release(sig_tone_bank_state_t *s);
+
+/*! Reset one channel of a bank of signaling tone processors, as though it had
+    just been initialised.
+    \brief Reset one channel of a bank of signaling tone processors.
+    \param s The signaling tone bank context.
+    \param chan The channel number.
+    \return 0 for OK, -1 for a bad channel number. */
+int sig_tone_bank_reset_channel(sig_tone_bank_state_t *s, int chan);
+
+/*! Get the context for one channel of a bank of signaling tone processors. This
+    may be used to examine or adjust the channel's state between calls to the
+    bank functions. A signaling change callback should not adjust it, as the
+    bank only brings it up to date at the end of each call.
+    \brief Get the context for one channel of a bank of signaling tone processors.
+    \param s The signaling tone bank context.
+    \param chan The channel number.
+    \return A pointer to the channel's context, or NULL for a bad channel number. */
+sig_tone_state_t *sig_tone_bank_channel(sig_tone_bank_state_t *s, int chan);
+
+/*! Process a block of received audio samples for every channel of a bank.
+    \brief Process a block of received audio samples for a bank of channels.
+    \param s The signaling tone bank context.
+    \param amp The audio sample buffers, one per channel.
+    \param len The number of samples in each buffer.
+    \return The number of samples unprocessed. */
+int sig_tone_rx_bank(sig_tone_bank_state_t *s, int16_t *amp[], int len);
+
+/*! Generate a block of signaling tone audio samples for every channel of a bank.
+    \brief Generate a block of signaling tone audio samples for a bank of channels.
+    \param s The signaling tone bank context.
+    \param amp The audio sample buffers, one per channel.
+    \param len The number of samples to be generated.
+    \return The number of samples actually generated. */
+int sig_tone_tx_bank(sig_tone_bank_state_t *s, int16_t *amp[], int len);
+
 #endif
 /*- End of file ------------------------------------------------------------*/
@@ -43,6 +43,10 @@ the tone patterns - the frequencies and cadencing - of the tones to be searched
 for. It constructs one or more Goertzel filters to monitor the required tones.
 If tones are close in frequency a single Goertzel set to the centre of the
 frequency range will be used. This optimises the efficiency of the detector. The
+coefficients of the filters are computed once, when the tones are added to the
+descriptor, and are packed together in the descriptor. The filter states are
+packed together in the same way, so all the monitored frequencies are updated
+in a single sweep over each block of audio, a vector of filters at a time. The
 Goertzel filters are applied without applying any special window functional
 (i.e. they use a rectangular window), so they have a sinc like response.
 However, for most tone patterns their rejection qualities are adequate. 
@@ -52,6 +56,9 @@ ITU-T E.180/Q.35 (busy, dial, ringback, reorder). Also, the extended tones,
 to ITU-T E.180, Supplement 2 and EIA/TIA-464-A (recall dial tone, special
 ringback tone, intercept tone, call waiting tone, busy verification tone,
 executive override tone, confirmation tone).
+
+A detector can subscribe to a shared tone analysis engine, with
+super_tone_rx_subscribe(), when other tone detectors are run on the same channel.
 */
 
 /*! Tone detection indication callback routine */
@@ -76,7 +83,9 @@ typedef struct
     int tones;
     super_tone_rx_segment_t **tone_list;
     int *tone_segs;
-    goertzel_descriptor_t *desc;
+    /*! The Goertzel coefficients of the monitored frequencies, packed together so
+        they can be loaded straight into vectors. Unused entries are zero. */
+    float fac[BINS/2];
 } super_tone_rx_descriptor_t;
 
 typedef struct
@@ -90,7 +99,12 @@ typedef struct
     void (*segment_callback)(void *data, int f1, int f2, int duration);
     void *callback_data;
     super_tone_rx_segment_t segments[11];
-    goertzel_state_t state[];
+    /*! The current sample number within a detection block. */
+    int current_sample;
+    /*! The Goertzel filter states of the monitored frequencies, held as arrays
+        so they can all be updated in one sweep of the audio. */
+    float v2[BINS/2];
+    float v3[BINS/2];
 } super_tone_rx_state_t;
 
 /*! Create a new supervisory tone detector descriptor.
@@ -118,7 +132,10 @@ int super_tone_rx_add_tone(super_tone_rx_descriptor_t *desc);
     \param f2 Frequency 2 (-1 for a silent period, or only one frequency).
     \param min The minimum duration, in ms.
     \param max The maximum duration, in ms.
-    \return The new number of elements in the tone description.
+    \return The new number of elements in the tone description, or -1 if the
+            descriptor has no room for the element's frequencies. At most
+            BINS/2 different frequencies can be used in one descriptor. An
+            element which is refused is not added to the tone.
 */
 int super_tone_rx_add_element(super_tone_rx_descriptor_t *desc,
                               int tone,
@@ -163,5 +180,15 @@ void super_tone_rx_segment_callback(super_tone_rx_state_t *s,
 */
 int super_tone_rx(super_tone_rx_state_t *super, const int16_t *amp, int samples);
 
+/*! Subscribe a supervisory tone detector to a tone analysis engine. The tones are
+    then found from the audio passed to tone_analysis(), rather than super_tone_rx().
+    An energy gate is set, so the engine skips the detector's filters for blocks
+    the detector would treat as silence. super_tone_rx() itself is not gated.
+    \brief Subscribe a supervisory tone detector to a tone analysis engine.
+    \param s The supervisory tone context, which must already be initialised.
+    \param t The tone analysis context.
+    \return The subscriber number, or -1 for error. */
+int super_tone_rx_subscribe(super_tone_rx_state_t *s, tone_analysis_state_t *t);
+
 #endif
 /*- End of file ------------------------------------------------------------*/
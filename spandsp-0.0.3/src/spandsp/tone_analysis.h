@@ -0,0 +1,240 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * tone_analysis.h - A shared Goertzel analysis engine, for running several
+ *                   tone detectors on one channel.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+#if !defined(_TONE_ANALYSIS_H_)
+#define _TONE_ANALYSIS_H_
+
+/*! \page tone_analysis_page Shared tone analysis
+\section tone_analysis_page_sec_1 What does it do?
+A channel will often need several tone detectors at once - say DTMF, Bell MF and
+call progress tones. Run separately, each detector makes its own pass over the
+audio, with its own set of Goertzel filters and its own measure of the total
+energy. The tone analysis engine lets those detectors share the work. Each
+detector subscribes to the engine, with the list of Goertzel filters it needs.
+The engine then makes a single pass over the audio, and hands each detector
+its filter energies, and the total energy, at the end of each of its blocks.
+The filter energies are exactly those the detectors find when running alone, so
+they make the same decisions.
+
+The DTMF receiver, the Bell MF receiver and the supervisory tone receiver can
+subscribe to an engine, with dtmf_rx_subscribe(), bell_mf_rx_subscribe() and
+super_tone_rx_subscribe().
+
+\section tone_analysis_page_sec_2 How does it work?
+Subscribed filters are gathered into groups, one for each block length, and a
+filter which is already in a group - the same frequency, over the same block
+length - is only run once, however many detectors ask for it. The total energy
+is also only measured once per group. The filters of all the groups are held
+together, as arrays of coefficients and states, and are run a vector of filters
+at a time over each stretch of audio up to the next block boundary of any group.
+At a boundary, only the filters of the groups whose blocks have ended are read
+out and restarted.
+
+Most blocks on a real channel hold silence, or speech too quiet to be a valid
+tone. A Goertzel filter's result can never exceed the block length times the
+total energy of the block, and the detectors' decisions all need a minimum
+filter result, or a minimum total energy. So each detector can set an energy
+gate, with tone_analysis_set_gate(), below which a block cannot hold a tone it
+would accept. The engine measures the energy of each block as it arrives, and
+only runs the filters of a group when its block energy reaches the lowest gate
+of the group's detectors. The detectors are still called at the end of every
+block, with zero filter energies for a skipped block, so their decision logic
+moves on exactly as it would have done. The audio of the current block is kept,
+so when the energy passes the gate part way through a block the filters can
+catch up, and the results are exactly those of the ungated filters.
+tone_analysis_get_skip_stats() reports how many blocks were skipped.
+
+Only the engine applies the gates. dtmf_rx(), bell_mf_rx() and super_tone_rx(),
+called directly, still run their filters over every block. They measure a
+block's energy in the same pass as the filters, and keep no history of the
+audio to catch up from, so they cannot know in time that a block may be skipped.
+
+The detectors must all subscribe before any audio is passed to the engine, so
+their blocks line up with the group's. The optional dial tone filter of the DTMF
+receiver is not applied to audio analysed by the engine, as the filtered audio
+could not be shared. The modem connect tone detectors use notch filters and
+level tracking, rather than block transforms, so they gain nothing from the
+engine, and continue to run separately.
+*/
+
+/*! The maximum number of different block lengths in one analysis engine. */
+#define TONE_ANALYSIS_MAX_GROUPS        4
+/*! The maximum number of distinct Goertzel filters in one analysis engine. */
+#define TONE_ANALYSIS_MAX_BINS          128
+/*! The maximum number of Goertzel filters one detector may ask for. */
+#define TONE_ANALYSIS_MAX_SUBSCRIBER_BINS 64
+/*! The maximum number of detectors subscribed to one analysis engine. */
+#define TONE_ANALYSIS_MAX_SUBSCRIBERS   8
+/*! The length of the audio history kept for gated groups. This must be a power
+    of 2. Groups with longer blocks are never gated. */
+#define TONE_ANALYSIS_HISTORY           256
+
+/*! Tone analysis result callback routine.
+    \param user_data An opaque pointer.
+    \param energies The energies from the subscriber's Goertzel filters, in the
+           order in which they were subscribed.
+    \param energy The total energy of the signal over the block. */
+typedef void (*tone_analysis_report_func_t)(void *user_data, const float energies[], float energy);
+
+/*!
+    The block timing shared by the Goertzel filters with a common block length.
+*/
+typedef struct
+{
+    /*! The block length, in samples. */
+    int samples;
+    /*! The current sample number within a block. */
+    int current_sample;
+    /*! The accumulating total energy over the current block. */
+    float energy;
+    /*! The block energy below which none of the group's detectors can find a
+        tone. Zero if the group is never gated. */
+    float gate;
+    /*! TRUE if the group's filters are running in the current block. */
+    int active;
+    /*! The number of blocks completed. */
+    int blocks;
+    /*! The number of blocks for which the filters were skipped. */
+    int skipped_blocks;
+} tone_analysis_group_t;
+
+/*!
+    A detector subscribed to a tone analysis engine.
+*/
+typedef struct
+{
+    /*! The group which sets the block timing for the subscriber's filters. */
+    int group;
+    /*! The number of filters the subscriber asked for. */
+    int bins;
+    /*! The engine filter which serves each of the subscriber's filters. */
+    uint8_t bin[TONE_ANALYSIS_MAX_SUBSCRIBER_BINS];
+    /*! The callback routine which is passed the results of each block. */
+    tone_analysis_report_func_t report;
+    /*! An opaque pointer passed to the callback routine. */
+    void *user_data;
+    /*! The block energy below which the subscriber cannot find a tone. Zero
+        if not set. */
+    float gate;
+} tone_analysis_subscriber_t;
+
+/*!
+    Tone analysis engine descriptor.
+*/
+typedef struct
+{
+    int groups;
+    tone_analysis_group_t group[TONE_ANALYSIS_MAX_GROUPS];
+    /*! The number of distinct filters. */
+    int bins;
+    /*! The group each filter belongs to. */
+    uint8_t bin_group[TONE_ANALYSIS_MAX_BINS];
+    /*! Filter coefficients, states, and end of block results, one entry per
+        filter. Entries beyond the last filter are zero, so the filters can be
+        run in whole vectors. */
+    float fac[TONE_ANALYSIS_MAX_BINS];
+    float v2[TONE_ANALYSIS_MAX_BINS];
+    float v3[TONE_ANALYSIS_MAX_BINS];
+    float result[TONE_ANALYSIS_MAX_BINS];
+    int subscribers;
+    tone_analysis_subscriber_t subscriber[TONE_ANALYSIS_MAX_SUBSCRIBERS];
+    /*! The total number of filters asked for by the subscribers. Comparing this
+        with bins shows how much work is being shared. */
+    int requested_bins;
+    /*! The most recent audio, so gated filters can catch up. */
+    int16_t history[TONE_ANALYSIS_HISTORY];
+    int history_ptr;
+} tone_analysis_state_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \brief Initialise a tone analysis engine, with no subscribers.
+    \param s The tone analysis context. If NULL, a context is allocated with malloc.
+    \return A pointer to the tone analysis context, or NULL for error. */
+tone_analysis_state_t *tone_analysis_init(tone_analysis_state_t *s);
+
+/*! \brief Release a tone analysis engine allocated by tone_analysis_init().
+    \param s The tone analysis context.
+    \return 0 for OK, -1 for fail. */
+int tone_analysis_release(tone_analysis_state_t *s);
+
+/*! Subscribe a detector to a tone analysis engine. All the filters must have the
+    same block length. This must be done before any audio is passed to the
+    engine.
+    \brief Subscribe a detector to a tone analysis engine.
+    \param s The tone analysis context.
+    \param desc The Goertzel descriptors for the filters the detector needs.
+    \param bins The number of filters.
+    \param report The callback routine which is passed the results of each block.
+    \param user_data An opaque pointer passed to the callback routine.
+    \return The subscriber number, or -1 if the filters cannot be accommodated. */
+int tone_analysis_subscribe(tone_analysis_state_t *s,
+                            const goertzel_descriptor_t desc[],
+                            int bins,
+                            tone_analysis_report_func_t report,
+                            void *user_data);
+
+/*! Set the energy gate for a detector subscribed to a tone analysis engine. A
+    block whose total energy is below the gate must be one in which the detector
+    cannot find a tone, whatever its filter energies. The filters of a group are
+    only skipped when all the detectors in the group have set a gate.
+    \brief Set the energy gate for a subscribed detector.
+    \param s The tone analysis context.
+    \param subscriber The subscriber number, from tone_analysis_subscribe().
+    \param energy The gate level, on the scale of the total energy passed to the
+           detector's callback routine. Zero disables gating.
+    \return 0 for OK, -1 for a bad subscriber number. */
+int tone_analysis_set_gate(tone_analysis_state_t *s, int subscriber, float energy);
+
+/*! \brief Get the number of blocks analysed, and skipped by the energy gate, for
+           a subscribed detector.
+    \param s The tone analysis context.
+    \param subscriber The subscriber number, from tone_analysis_subscribe().
+    \param blocks The number of blocks completed.
+    \param skipped_blocks The number of blocks for which the filters were skipped.
+    \return 0 for OK, -1 for a bad subscriber number. */
+int tone_analysis_get_skip_stats(tone_analysis_state_t *s, int subscriber, int *blocks, int *skipped_blocks);
+
+/*! Analyse a block of audio samples, for all the subscribed detectors.
+    \brief Analyse a block of audio samples.
+    \param s The tone analysis context.
+    \param amp The audio sample buffer.
+    \param samples The number of samples in the buffer.
+    \return The number of samples unprocessed. */
+int tone_analysis(tone_analysis_state_t *s, const int16_t amp[], int samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/*- End of file ------------------------------------------------------------*/
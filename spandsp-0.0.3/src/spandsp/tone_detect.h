@@ -50,6 +50,36 @@ typedef struct
     int current_sample;
 } goertzel_state_t;
 
+/*!
+    Sliding DFT descriptor. A sliding DFT gives the same measure as a Goertzel
+    filter, over the most recent block of samples, updated at every sample. The
+    recursion is slightly damped, so rounding errors die away rather than build
+    up.
+*/
+typedef struct
+{
+    /*! r.e^(jw) - the rotation applied at each sample */
+    float rot_re;
+    float rot_im;
+    /*! (r.e^(jw))^N - the weight of the sample leaving the window */
+    float tail_re;
+    float tail_im;
+    int samples;
+} sliding_dft_descriptor_t;
+
+/*!
+    Sliding DFT state descriptor.
+*/
+typedef struct
+{
+    float z_re;
+    float z_im;
+    float rot_re;
+    float rot_im;
+    float tail_re;
+    float tail_im;
+} sliding_dft_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -100,6 +130,46 @@ static __inline__ void goertzel_sample(goertzel_state_t *s, int16_t amp)
 }
 /*- End of function --------------------------------------------------------*/
 
+/*! \brief Create a descriptor for use with a sliding DFT.
+    \param t The sliding DFT descriptor.
+    \param freq The frequency to be detected, in Hz.
+    \param samples The number of samples in the sliding window. */
+void make_sliding_dft_descriptor(sliding_dft_descriptor_t *t,
+                                 float freq,
+                                 int samples);
+
+/*! \brief Initialise the state of a sliding DFT, with an empty window.
+    \param s The sliding DFT context. If NULL, a context is allocated with malloc.
+    \param t The sliding DFT descriptor.
+    \return A pointer to the sliding DFT state. */
+sliding_dft_state_t *sliding_dft_init(sliding_dft_state_t *s,
+                                      const sliding_dft_descriptor_t *t);
+
+/*! \brief Update the state of a sliding DFT. The caller keeps the window of past
+           samples, so several sliding DFTs over the same window can share it.
+    \param s The sliding DFT context.
+    \param in The sample entering the window.
+    \param out The sample leaving the window - the one from the window's length ago. */
+static __inline__ void sliding_dft_update(sliding_dft_state_t *s, float in, float out)
+{
+    float re;
+
+    re = s->rot_re*s->z_re - s->rot_im*s->z_im + in - s->tail_re*out;
+    s->z_im = s->rot_re*s->z_im + s->rot_im*s->z_re - s->tail_im*out;
+    s->z_re = re;
+}
+/*- End of function --------------------------------------------------------*/
+
+/*! \brief Evaluate the current result of a sliding DFT.
+    \param s The sliding DFT context.
+    \return The energy over the window, on the same scale as the result from
+            goertzel_result(). */
+static __inline__ float sliding_dft_result(const sliding_dft_state_t *s)
+{
+    return s->z_re*s->z_re + s->z_im*s->z_im;
+}
+/*- End of function --------------------------------------------------------*/
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,297 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * tone_detect_fixed.h - Integer only Goertzel filters, and DTMF and Bell MF
+ *                       receivers built on them, for use in kernel space.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+#if !defined(_TONE_DETECT_FIXED_H_)
+#define _TONE_DETECT_FIXED_H_
+
+/*! \page tone_detect_fixed_page Integer tone detection
+\section tone_detect_fixed_page_sec_1 What does it do?
+This module provides a Goertzel filter, a DTMF receiver and a Bell MF receiver
+which use only integer arithmetic. They make the same decisions, against the
+same thresholds, as the floating point receivers in dtmf.c and bell_r2_mf.c,
+and pass the same tests. Like echo.c, the module builds as part of a kernel
+module when __KERNEL__ is defined, so digits can be detected in the same
+interrupt pass which does the echo cancellation, instead of shipping every
+channel's audio to user space.
+
+\section tone_detect_fixed_page_sec_2 How does it work?
+The Goertzel coefficients, 2cos(w), are held in Q14. The filter states are held
+as 32 bit integers at the scale of the input samples - for the 102 or 120
+sample blocks used for DTMF and MF, and the frequencies involved, they cannot
+exceed 24 bits. The feedback product is formed in 64 bits, which is a single
+widening multiply on 32 bit machines. The energies are 64 bit integers, at the
+same scale as the floating point results, so the floating point thresholds carry
+over unchanged. The ratio tests (twist, and relative peak) use Q8 ratios.
+
+The optional dial tone notch filters have Q30 coefficients and Q6 states.
+
+The coefficients for the DTMF and MF frequencies are precomputed, as the kernel
+has no cos(). make_goertzel_fixed_descriptor() is only available in user space.
+*/
+
+#if !defined(MAX_DTMF_DIGITS)
+#define MAX_DTMF_DIGITS 128
+#endif
+#if !defined(MAX_BELL_MF_DIGITS)
+#define MAX_BELL_MF_DIGITS 128
+#endif
+
+/*!
+    Integer Goertzel filter descriptor.
+*/
+typedef struct
+{
+    /*! 2cos(w), in Q14 */
+    int16_t fac;
+    int samples;
+} goertzel_fixed_descriptor_t;
+
+/*!
+    Integer Goertzel filter state descriptor.
+*/
+typedef struct
+{
+    int32_t v2;
+    int32_t v3;
+    /*! 2cos(w), in Q14 */
+    int16_t fac;
+    int samples;
+    int current_sample;
+} goertzel_fixed_state_t;
+
+/*!
+    Integer DTMF digit detector descriptor. The fields follow those of
+    dtmf_rx_state_t.
+*/
+typedef struct
+{
+    /*! Optional callback funcion to deliver received digits. */
+    void (*callback)(void *data, const char *digits, int len);
+    /*! An opaque pointer passed to the callback function. */
+    void *callback_data;
+    /*! Optional callback funcion to deliver real time digit state changes. */
+    void (*realtime_callback)(void *data, int signal);
+    /*! An opaque pointer passed to the real time callback function. */
+    void *realtime_callback_data;
+    /*! TRUE if dialtone should be filtered before processing */
+    int filter_dialtone;
+    /*! Maximum acceptable "normal" (lower bigger than higher) twist ratio, in Q8 */
+    int32_t normal_twist;
+    /*! Maximum acceptable "reverse" (higher bigger than lower) twist ratio, in Q8 */
+    int32_t reverse_twist;
+
+    /*! 350Hz filter state for the optional dialtone filter, in Q6 */
+    int32_t z350_1;
+    int32_t z350_2;
+    /*! 440Hz filter state for the optional dialtone filter, in Q6 */
+    int32_t z440_1;
+    int32_t z440_2;
+
+    /*! Tone detector working states */
+    goertzel_fixed_state_t row_out[4];
+    goertzel_fixed_state_t col_out[4];
+    /*! The accumlating total energy on the same period over which the Goertzels work. */
+    int64_t energy;
+    /*! The result of the last tone analysis. */
+    uint8_t last_hit;
+    /*! The confirmed digit we are currently receiving */
+    uint8_t in_digit;
+    /*! The current sample number within a processing block. */
+    int current_sample;
+
+    /*! The received digits buffer. This is a NULL terminated string. */
+    char digits[MAX_DTMF_DIGITS + 1];
+    /*! The number of digits currently in the digit buffer. */
+    int current_digits;
+    /*! The number of digits which have been lost due to buffer overflows. */
+    int lost_digits;
+} dtmf_rx_fixed_state_t;
+
+/*!
+    Integer Bell MF digit detector descriptor. The fields follow those of
+    bell_mf_rx_state_t.
+*/
+typedef struct
+{
+    /*! Optional callback funcion to deliver received digits. */
+    void (*callback)(void *data, const char *digits, int len);
+    /*! An opaque pointer passed to the callback function. */
+    void *callback_data;
+    /*! Tone detector working states */
+    goertzel_fixed_state_t out[6];
+    /*! Short term history of results from the tone detection, using in persistence checking */
+    uint8_t hits[5];
+    /*! The current sample number within a processing block. */
+    int current_sample;
+
+    /*! The received digits buffer. This is a NULL terminated string. */
+    char digits[MAX_BELL_MF_DIGITS + 1];
+    /*! The number of digits currently in the digit buffer. */
+    int current_digits;
+    /*! The number of digits which have been lost due to buffer overflows. */
+    int lost_digits;
+} bell_mf_rx_fixed_state_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(__KERNEL__)
+/*! \brief Create a descriptor for use with an integer Goertzel transform. This is
+           not available in kernel space.
+    \param t The Goertzel descriptor.
+    \param freq The frequency to be detected, in Hz.
+    \param samples The number of samples in each detection block. */
+void make_goertzel_fixed_descriptor(goertzel_fixed_descriptor_t *t,
+                                    float freq,
+                                    int samples);
+#endif
+
+/*! \brief Initialise the state of an integer Goertzel transform.
+    \param s The Goertzel context.
+    \param t The Goertzel descriptor.
+    \return A pointer to the Goertzel state. */
+goertzel_fixed_state_t *goertzel_fixed_init(goertzel_fixed_state_t *s,
+                                            const goertzel_fixed_descriptor_t *t);
+
+/*! \brief Reset the state of an integer Goertzel transform.
+    \param s The Goertzel context. */
+void goertzel_fixed_reset(goertzel_fixed_state_t *s);
+
+/*! \brief Update the state of an integer Goertzel transform.
+    \param s The Goertzel context
+    \param amp The samples to be transformed
+    \param samples The number of samples
+    \return The number of samples unprocessed */
+int goertzel_fixed_update(goertzel_fixed_state_t *s,
+                          const int16_t amp[],
+                          int samples);
+
+/*! \brief Evaluate the final result of an integer Goertzel transform.
+    \param s The Goertzel context
+    \return The result of the transform. This is on the same scale as the
+            result from goertzel_result(). */
+int64_t goertzel_fixed_result(goertzel_fixed_state_t *s);
+
+/*! \brief Update the state of an integer Goertzel transform.
+    \param s The Goertzel context
+    \param amp The sample to be transformed. */
+static __inline__ void goertzel_fixed_sample(goertzel_fixed_state_t *s, int32_t amp)
+{
+    int32_t v1;
+
+    v1 = s->v2;
+    s->v2 = s->v3;
+    s->v3 = (int32_t) (((int64_t) s->fac*s->v2) >> 14) - v1 + amp;
+    s->current_sample++;
+}
+/*- End of function --------------------------------------------------------*/
+
+/*! Set a optional realtime callback for an integer DTMF receiver context. This
+    behaves like dtmf_rx_set_realtime_callback().
+    \brief Set a realtime callback for an integer DTMF receiver context.
+    \param s The DTMF receiver context.
+    \param callback Callback routine used to report the start and end of digits.
+    \param user_data An opaque pointer which is associated with the context,
+           and supplied in callbacks. */
+void dtmf_rx_fixed_set_realtime_callback(dtmf_rx_fixed_state_t *s,
+                                         void (*callback)(void *user_data, int signal),
+                                         void *user_data);
+
+/*! \brief Adjust an integer DTMF receiver context.
+    \param s The DTMF receiver context.
+    \param filter_dialtone TRUE to enable filtering of dialtone, FALSE
+           to disable, < 0 to leave unchanged.
+    \param twist Acceptable twist, in dB. < 0 to leave unchanged. Values above
+           20dB are treated as 20dB.
+    \param reverse_twist Acceptable reverse twist, in dB. < 0 to leave unchanged.
+           Values above 20dB are treated as 20dB. */
+void dtmf_rx_fixed_parms(dtmf_rx_fixed_state_t *s, int filter_dialtone, int twist, int reverse_twist);
+
+/*! Process a block of received DTMF audio samples, using integer arithmetic.
+    \brief Process a block of received DTMF audio samples, using integer arithmetic.
+    \param s The DTMF receiver context.
+    \param amp The audio sample buffer.
+    \param samples The number of samples in the buffer.
+    \return The number of samples unprocessed. */
+int dtmf_rx_fixed(dtmf_rx_fixed_state_t *s, const int16_t amp[], int samples);
+
+/*! \brief Get a string of digits from an integer DTMF receiver's output buffer.
+    \param s The DTMF receiver context.
+    \param digits The buffer for the received digits.
+    \param max The maximum  number of digits to be returned,
+    \return The number of digits actually returned. */
+size_t dtmf_rx_fixed_get(dtmf_rx_fixed_state_t *s, char *digits, int max);
+
+/*! \brief Initialise an integer DTMF receiver context.
+    \param s The DTMF receiver context.
+    \param callback An optional callback routine, used to report received digits. If
+           no callback routine is set, digits may be collected, using the
+           dtmf_rx_fixed_get() function.
+    \param user_data An opaque pointer which is associated with the context,
+           and supplied in callbacks.
+    \return A pointer to the DTMF receiver context. */
+dtmf_rx_fixed_state_t *dtmf_rx_fixed_init(dtmf_rx_fixed_state_t *s,
+                                          void (*callback)(void *user_data, const char *digits, int len),
+                                          void *user_data);
+
+/*! Process a block of received Bell MF audio samples, using integer arithmetic.
+    \brief Process a block of received Bell MF audio samples, using integer arithmetic.
+    \param s The Bell MF receiver context.
+    \param amp The audio sample buffer.
+    \param samples The number of samples in the buffer.
+    \return The number of samples unprocessed. */
+int bell_mf_rx_fixed(bell_mf_rx_fixed_state_t *s, const int16_t amp[], int samples);
+
+/*! \brief Get a string of digits from an integer Bell MF receiver's output buffer.
+    \param s The Bell MF receiver context.
+    \param digits The buffer for the received digits.
+    \param max The maximum  number of digits to be returned,
+    \return The number of digits actually returned. */
+size_t bell_mf_rx_fixed_get(bell_mf_rx_fixed_state_t *s, char *digits, int max);
+
+/*! \brief Initialise an integer Bell MF receiver context.
+    \param s The Bell MF receiver context.
+    \param callback An optional callback routine, used to report received digits. If
+           no callback routine is set, digits may be collected, using the
+           bell_mf_rx_fixed_get() function.
+    \param user_data An opaque pointer which is associated with the context,
+           and supplied in callbacks.
+    \return A pointer to the Bell MF receiver context. */
+bell_mf_rx_fixed_state_t *bell_mf_rx_fixed_init(bell_mf_rx_fixed_state_t *s,
+                                                void (*callback)(void *user_data, const char *digits, int len),
+                                                void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+/*- End of file ------------------------------------------------------------*/
@@ -44,14 +44,86 @@
 #if defined(HAVE_MATH_H)
 #include <math.h>
 #endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "spandsp/telephony.h"
 #include "spandsp/tone_detect.h"
 #include "spandsp/tone_generate.h"
+#include "spandsp/tone_analysis.h"
 #include "spandsp/super_tone_rx.h"
 
 #define THRESHOLD               8.0e7
 
+#if defined(__AVX512F__)
+#define SUPER_TONE_LANES    16
+typedef __m512 super_tone_vec_t;
+#define vload(p)        _mm512_loadu_ps(p)
+#define vstore(p, x)    _mm512_storeu_ps(p, x)
+#define vset1           _mm512_set1_ps
+#define vadd            _mm512_add_ps
+#define vsub            _mm512_sub_ps
+#define vmul            _mm512_mul_ps
+#elif defined(__AVX2__)
+#define SUPER_TONE_LANES    8
+typedef __m256 super_tone_vec_t;
+#define vload(p)        _mm256_loadu_ps(p)
+#define vstore(p, x)    _mm256_storeu_ps(p, x)
+#define vset1           _mm256_set1_ps
+#define vadd            _mm256_add_ps
+#define vsub            _mm256_sub_ps
+#define vmul            _mm256_mul_ps
+#elif defined(__SSE2__)
+#define SUPER_TONE_LANES    4
+typedef __m128 super_tone_vec_t;
+#define vload(p)        _mm_loadu_ps(p)
+#define vstore(p, x)    _mm_storeu_ps(p, x)
+#define vset1           _mm_set1_ps
+#define vadd            _mm_add_ps
+#define vsub            _mm_sub_ps
+#define vmul            _mm_mul_ps
+#else
+#define SUPER_TONE_LANES    1
+typedef float super_tone_vec_t;
+#define vload(p)        (*(p))
+#define vstore(p, x)    (*(p) = (x))
+#define vset1(x)        (x)
+#define vadd(a, b)      ((a) + (b))
+#define vsub(a, b)      ((a) - (b))
+#define vmul(a, b)      ((a)*(b))
+#endif
+
+/* The number of vectors of filters run together in each sweep of the audio */
+#define SUPER_TONE_VECTORS  2
+
+static void set_super_tone_freq(super_tone_rx_descriptor_t *desc, int bin, float freq)
+{
+    goertzel_descriptor_t goertzel_desc;
+
+    make_goertzel_descriptor(&goertzel_desc, freq, BINS);
+    desc->fac[bin] = goertzel_desc.fac;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Check whether adding a frequency would need a new entry in the pitch table */
+static int super_tone_freq_is_new(super_tone_rx_descriptor_t *desc, int freq)
+{
+    int i;
+
+    if (freq == 0)
+        return FALSE;
+    for (i = 0;  i < desc->used_frequencies;  i++)
+    {
+        if (desc->pitches[i][0] == freq)
+            return FALSE;
+    }
+    return TRUE;
+}
+/*- End of function --------------------------------------------------------*/
+
 static int add_super_tone_freq(super_tone_rx_descriptor_t *desc, int freq)
 {
     int i;
@@ -73,18 +145,14 @@ static int add_super_tone_freq(super_tone_rx_descriptor_t *desc, int freq)
             /* Merge these two */
             desc->pitches[desc->used_frequencies][0] = freq;
             desc->pitches[desc->used_frequencies][1] = i;
-            make_goertzel_descriptor(&desc->desc[desc->pitches[i][1]], (float) (freq + desc->pitches[i][0])/2, BINS);
+            set_super_tone_freq(desc, desc->pitches[i][1], (float) (freq + desc->pitches[i][0])/2);
             desc->used_frequencies++;
             return desc->pitches[i][1];
         }
     }
     desc->pitches[i][0] = freq;
     desc->pitches[i][1] = desc->monitored_frequencies;
-    if (desc->monitored_frequencies%5 == 0)
-    {
-        desc->desc = (goertzel_descriptor_t *) realloc(desc->desc, (desc->monitored_frequencies + 5)*sizeof(goertzel_descriptor_t));
-    }
-    make_goertzel_descriptor(&desc->desc[desc->monitored_frequencies++], (float) freq, BINS);
+    set_super_tone_freq(desc, desc->monitored_frequencies++, (float) freq);
     desc->used_frequencies++;
     return desc->pitches[i][1];
 }
@@ -112,7 +180,15 @@ int super_tone_rx_add_element(super_tone_rx_descriptor_t *desc,
                               int max)
 {
     int step;
+    int needed;
 
+    /* Check there is room for any new frequencies first, so a full table
+       doesn't turn the element into a silent period */
+    needed = super_tone_freq_is_new(desc, f1);
+    if (f2 != f1  &&  super_tone_freq_is_new(desc, f2))
+        needed++;
+    if (desc->used_frequencies + needed > BINS/2)
+        return -1;
     step = desc->tone_segs[tone];
     if (step%5 == 0)
     {
@@ -195,7 +271,7 @@ super_tone_rx_descriptor_t *super_tone_rx_make_descriptor(super_tone_rx_descript
 
     desc->used_frequencies = 0;
     desc->monitored_frequencies = 0;
-    desc->desc = NULL;
+    memset(desc->fac, 0, sizeof(desc->fac));
     desc->tones = 0;
     return desc;
 }
@@ -227,7 +303,7 @@ super_tone_rx_state_t *super_tone_rx_init(super_tone_rx_state_t *s,
         return NULL;
     if (s == NULL)
     {
-        s = (super_tone_rx_state_t *) malloc(sizeof(super_tone_rx_state_t) + desc->monitored_frequencies*sizeof(goertzel_state_t));
+        s = (super_tone_rx_state_t *) malloc(sizeof(super_tone_rx_state_t));
         if (s == NULL)
             return NULL;
     }
@@ -248,8 +324,9 @@ super_tone_rx_state_t *super_tone_rx_init(super_tone_rx_state_t *s,
     s->detected_tone = -1;
     s->energy = 0.0;
     s->total_energy = 0.0;
-    for (i = 0;  i < desc->monitored_frequencies;  i++)
-        goertzel_init(&s->state[i], &s->desc->desc[i]);
+    s->current_sample = 0;
+    memset(s->v2, 0, sizeof(s->v2));
+    memset(s->v3, 0, sizeof(s->v3));
     return  s;
 }
 /*- End of function --------------------------------------------------------*/
@@ -262,159 +339,257 @@ int super_tone_rx_free(super_tone_rx_state_t *s)
 }
 /*- End of function --------------------------------------------------------*/
 
-int super_tone_rx(super_tone_rx_state_t *s, const int16_t *amp, int samples)
+/* Make the decisions for the end of a detection block. This is shared by the
+   receiver, and by receivers subscribed to a tone analysis engine. */
+static void super_tone_rx_block_result(super_tone_rx_state_t *s, const float res[])
 {
-    int i;
     int j;
     int k1;
     int k2;
-    int x;
-    float res[BINS/2];
-    int sample;
 
-    for (sample = 0;  sample < samples;  sample += x)
+    /* Find our two best monitored frequencies, which also have adequate
+       energy. */
+    if (s->total_energy < THRESHOLD)
     {
-        x = 0;
-        for (i = 0;  i < s->desc->monitored_frequencies;  i++)
+        k1 = -1;
+        k2 = -1;
+    }
+    else
+    {
+        if (res[0] > res[1])
+        {
+            k1 = 0;
+            k2 = 1;
+        }
+        else
+        {
+            k1 = 1;
+            k2 = 0;
+        }
+        for (j = 2;  j < s->desc->monitored_frequencies;  j++)
+        {
+            if (res[j] >= res[k1])
+            {
+                k2 = k1;
+                k1 = j;
+            }
+            else if (res[j] >= res[k2])
+            {
+                k2 = j;
+            }
+        }
+        if (res[k1] + res[k2] < 0.5*s->total_energy)
+        {
+            k1 = -1;
+            k2 = -1;
+        }
+        else if (res[k1] > 4.0*res[k2])
+        {
+            k2 = -1;
+        }
+        else if (k2 < k1)
+        {
+            j = k1;
+            k1 = k2;
+            k2 = j;
+        }
+    }
+    /* See if this looks different to last time */
+    if (k1 != s->segments[10].f1  ||  k2 != s->segments[10].f2)
+    {
+        /* It is different, but this might just be a transitional quirk, or
+           a one shot hiccup (eg due to noise). Only if this same thing is
+           seen a second time should we change state. */
+        s->segments[10].f1 = k1;
+        s->segments[10].f2 = k2;
+        /* While things are hopping around, consider this a continuance of the
+           previous state. */
+        s->segments[9].min_duration++;
+    }
+    else
+    {
+        if (k1 != s->segments[9].f1  ||  k2 != s->segments[9].f2)
         {
-            x = goertzel_update(&s->state[i],
-                                amp + sample,
-                                samples - sample);
-            if (i == s->desc->monitored_frequencies - 1)
+            if (s->detected_tone >= 0)
+            {
+                /* Test for the continuance of the existing tone pattern, based on our new knowledge of an
+                   entire segment length. */
+                if (!test_cadence(s->desc->tone_list[s->detected_tone], -s->desc->tone_segs[s->detected_tone], s->segments, s->rotation++))
+                {
+                    s->detected_tone = -1;
+                    s->tone_callback(s->callback_data, s->detected_tone);
+                }
+            }
+            if (s->segment_callback)
             {
-                for (j = 0;  j < x;  j++)
-                    s->energy += amp[sample + j]*amp[sample + j];
+                s->segment_callback(s->callback_data,
+                                    s->segments[9].f1,
+                                    s->segments[9].f2,
+                                    s->segments[9].min_duration*BINS/8);
             }
-            if (s->state[i].current_sample >= s->state[i].samples)
+            memmove(&s->segments[0], &s->segments[1], 9*sizeof(s->segments[0]));
+            s->segments[9].f1 = k1;
+            s->segments[9].f2 = k2;
+            s->segments[9].min_duration = 1;
+        }
+        else
+        {
+            /* This is a continuance of the previous state */
+            if (s->detected_tone >= 0)
             {
-                res[i] = goertzel_result(&s->state[i]);
-                goertzel_init(&s->state[i], &s->desc->desc[i]);
-                if (i == s->desc->monitored_frequencies - 1)
+                /* Test for the continuance of the existing tone pattern. We must do this here, so we can sense the
+                   discontinuance of the tone on an excessively long segment. */
+                if (!test_cadence(s->desc->tone_list[s->detected_tone], s->desc->tone_segs[s->detected_tone], s->segments, s->rotation))
                 {
-                    /* Scale the energy so it can be compared to the results from the
-                       Goertzel filters. */
-                    s->total_energy = s->energy*(s->state[i].samples/2);
-                    s->energy = 0;
-                    /* Find our two best monitored frequencies, which also have adequate
-                       energy. */
-                    if (s->total_energy < THRESHOLD)
-                    {
-                        k1 = -1;
-                        k2 = -1;
-                    }
-                    else
-                    {
-                        if (res[0] > res[1])
-                        {
-                            k1 = 0;
-                            k2 = 1;
-                        }
-                        else
-                        {
-                            k1 = 1;
-                            k2 = 0;
-                        }
-                        for (j = 2;  j < s->desc->monitored_frequencies;  j++)
-                        {
-                            if (res[j] >= res[k1])
-                            {
-                                k2 = k1;
-                                k1 = j;
-                            }
-                            else if (res[j] >= res[k2])
-                            {
-                                k2 = j;
-                            }
-                        }
-                        if (res[k1] + res[k2] < 0.5*s->total_energy)
-                        {
-                            k1 = -1;
-                            k2 = -1;
-                        }
-                        else if (res[k1] > 4.0*res[k2])
-                        {
-                            k2 = -1;
-                        }
-                        else if (k2 < k1)
-                        {
-                            j = k1;
-                            k1 = k2;
-                            k2 = j;
-                        }
-                    }
-                    /* See if this looks different to last time */
-                    if (k1 != s->segments[10].f1  ||  k2 != s->segments[10].f2)
-                    {
-                        /* It is different, but this might just be a transitional quirk, or
-                           a one shot hiccup (eg due to noise). Only if this same thing is
-                           seen a second time should we change state. */
-                        s->segments[10].f1 = k1;
-                        s->segments[10].f2 = k2;
-                        /* While things are hopping around, consider this a continuance of the
-                           previous state. */
-                        s->segments[9].min_duration++;
-                    }
-                    else
-                    {
-                        if (k1 != s->segments[9].f1  ||  k2 != s->segments[9].f2)
-                        {
-                            if (s->detected_tone >= 0)
-                            {
-                                /* Test for the continuance of the existing tone pattern, based on our new knowledge of an
-                                   entire segment length. */
-                                if (!test_cadence(s->desc->tone_list[s->detected_tone], -s->desc->tone_segs[s->detected_tone], s->segments, s->rotation++))
-                                {
-                                    s->detected_tone = -1;
-                                    s->tone_callback(s->callback_data, s->detected_tone);
-                                }
-                            }
-                            if (s->segment_callback)
-                            {
-                                s->segment_callback(s->callback_data,
-                                                    s->segments[9].f1,
-                                                    s->segments[9].f2,
-                                                    s->segments[9].min_duration*BINS/8);
-                            }
-                            memcpy (&s->segments[0], &s->segments[1], 9*sizeof(s->segments[0]));
-                            s->segments[9].f1 = k1;
-                            s->segments[9].f2 = k2;
-                            s->segments[9].min_duration = 1;
-                        }
-                        else
-                        {
-                            /* This is a continuance of the previous state */
-                            if (s->detected_tone >= 0)
-                            {
-                                /* Test for the continuance of the existing tone pattern. We must do this here, so we can sense the
-                                   discontinuance of the tone on an excessively long segment. */
-                                if (!test_cadence(s->desc->tone_list[s->detected_tone], s->desc->tone_segs[s->detected_tone], s->segments, s->rotation))
-                                {
-                                    s->detected_tone = -1;
-                                    s->tone_callback(s->callback_data, s->detected_tone);
-                                }
-                            }
-                            s->segments[9].min_duration++;
-                        }
-                    }
-                    if (s->detected_tone < 0)
-                    {
-                        /* Test for the start of any of the monitored tone patterns */
-                        for (j = 0;  j < s->desc->tones;  j++)
-                        {
-                            if (test_cadence(s->desc->tone_list[j], s->desc->tone_segs[j], s->segments, -1))
-                            {
-                                s->detected_tone = j;
-                                s->rotation = 0;
-                                s->tone_callback(s->callback_data, s->detected_tone);
-                                break;
-                            }
-                        }
-                    }
+                    s->detected_tone = -1;
+                    s->tone_callback(s->callback_data, s->detected_tone);
                 }
             }
+            s->segments[9].min_duration++;
+        }
+    }
+    if (s->detected_tone < 0)
+    {
+        /* Test for the start of any of the monitored tone patterns */
+        for (j = 0;  j < s->desc->tones;  j++)
+        {
+            if (test_cadence(s->desc->tone_list[j], s->desc->tone_segs[j], s->segments, -1))
+            {
+                s->detected_tone = j;
+                s->rotation = 0;
+                s->tone_callback(s->callback_data, s->detected_tone);
+                break;
+            }
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Run all the monitored frequencies over a stretch of audio, in one sweep. The
+   coefficients and states are held as arrays, and SUPER_TONE_VECTORS vectors of
+   frequencies are updated together for each sample. The arithmetic for each
+   frequency is exactly that of goertzel_update(). */
+static void super_tone_rx_filter(super_tone_rx_state_t *s, const int16_t amp[], int len)
+{
+    super_tone_vec_t v1;
+    super_tone_vec_t v2[SUPER_TONE_VECTORS];
+    super_tone_vec_t v3[SUPER_TONE_VECTORS];
+    super_tone_vec_t fac[SUPER_TONE_VECTORS];
+    super_tone_vec_t famp;
+    const float *desc_fac;
+    int i;
+    int j;
+    int k;
+
+    desc_fac = s->desc->fac;
+    /* BINS/2 is a multiple of the step, and the unused coefficients are zero, so
+       whole steps can always be taken. */
+    for (k = 0;  k < s->desc->monitored_frequencies;  k += SUPER_TONE_VECTORS*SUPER_TONE_LANES)
+    {
+        for (i = 0;  i < SUPER_TONE_VECTORS;  i++)
+        {
+            fac[i] = vload(&desc_fac[k + i*SUPER_TONE_LANES]);
+            v2[i] = vload(&s->v2[k + i*SUPER_TONE_LANES]);
+            v3[i] = vload(&s->v3[k + i*SUPER_TONE_LANES]);
+        }
+        for (j = 0;  j < len;  j++)
+        {
+            famp = vset1((float) amp[j]);
+            for (i = 0;  i < SUPER_TONE_VECTORS;  i++)
+            {
+                v1 = v2[i];
+                v2[i] = v3[i];
+                v3[i] = vadd(vsub(vmul(fac[i], v2[i]), v1), famp);
+            }
+        }
+        for (i = 0;  i < SUPER_TONE_VECTORS;  i++)
+        {
+            vstore(&s->v2[k + i*SUPER_TONE_LANES], v2[i]);
+            vstore(&s->v3[k + i*SUPER_TONE_LANES], v3[i]);
+        }
+    }
+    for (j = 0;  j < len;  j++)
+        s->energy += amp[j]*amp[j];
+}
+/*- End of function --------------------------------------------------------*/
+
+int super_tone_rx(super_tone_rx_state_t *s, const int16_t *amp, int samples)
+{
+    goertzel_state_t g;
+    float res[BINS/2];
+    int i;
+    int sample;
+    int limit;
+
+    for (sample = 0;  sample < samples;  sample = limit)
+    {
+        if ((samples - sample) >= (BINS - s->current_sample))
+            limit = sample + (BINS - s->current_sample);
+        else
+            limit = samples;
+        super_tone_rx_filter(s, amp + sample, limit - sample);
+        s->current_sample += (limit - sample);
+        if (s->current_sample < BINS)
+            continue;
+
+        /* We are at the end of a detection block */
+        for (i = 0;  i < s->desc->monitored_frequencies;  i++)
+        {
+            g.v2 = s->v2[i];
+            g.v3 = s->v3[i];
+            g.fac = s->desc->fac[i];
+            res[i] = goertzel_result(&g);
         }
+        /* The best two are always looked for, so make sure there are two */
+        for (  ;  i < 2;  i++)
+            res[i] = 0.0f;
+        memset(s->v2, 0, sizeof(s->v2));
+        memset(s->v3, 0, sizeof(s->v3));
+        s->current_sample = 0;
+        /* Scale the energy so it can be compared to the results from the
+           Goertzel filters. */
+        s->total_energy = s->energy*(BINS/2);
+        s->energy = 0;
+        super_tone_rx_block_result(s, res);
     }
     return  samples;
 }
 /*- End of function --------------------------------------------------------*/
+
+static void super_tone_rx_analysis_report(void *user_data, const float energies[], float energy)
+{
+    super_tone_rx_state_t *s;
+
+    s = (super_tone_rx_state_t *) user_data;
+    /* Scale the energy so it can be compared to the results from the Goertzel
+       filters. */
+    s->total_energy = energy*(BINS/2);
+    super_tone_rx_block_result(s, energies);
+}
+/*- End of function --------------------------------------------------------*/
+
+int super_tone_rx_subscribe(super_tone_rx_state_t *s, tone_analysis_state_t *t)
+{
+    goertzel_descriptor_t desc[BINS/2];
+    int i;
+
+    for (i = 0;  i < s->desc->monitored_frequencies;  i++)
+    {
+        desc[i].fac = s->desc->fac[i];
+        desc[i].samples = BINS;
+    }
+    if ((i = tone_analysis_subscribe(t,
+                                     desc,
+                                     s->desc->monitored_frequencies,
+                                     super_tone_rx_analysis_report,
+                                     s)) < 0)
+    {
+        return -1;
+    }
+    /* The block is taken as silence when the scaled total energy is below
+       THRESHOLD, whatever the filters say. */
+    tone_analysis_set_gate(t, i, THRESHOLD/(BINS/2));
+    return i;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
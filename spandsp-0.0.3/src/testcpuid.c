@@ -33,9 +33,14 @@
 #endif
 
 #include <inttypes.h>
+#if defined(TESTBED)
+#include <stdio.h>
+#endif
+
+#include "testcpuid.h"
 
 /* Make this file just disappear if we are not on an x86 machine */
-#if defined(__i386__) //  ||  defined(__x86_64__)
+#if defined(__i386__)  ||  defined(__x86_64__)
 
 #define X86_EFLAGS_CF   0x00000001 /* Carry Flag */
 #define X86_EFLAGS_PF   0x00000004 /* Parity Flag */
@@ -55,6 +60,7 @@
 #define X86_EFLAGS_VIP  0x00100000 /* Virtual Interrupt Pending */
 #define X86_EFLAGS_ID   0x00200000 /* CPUID detection flag */
 
+#if defined(__i386__)
 /* Standard macro to see if a specific flag is changeable */
 static __inline__ int flag_is_changeable_p(uint32_t flag)
 {
@@ -78,112 +84,108 @@ static __inline__ int flag_is_changeable_p(uint32_t flag)
     return ((f1^f2) & flag) != 0;
 }
 /*- End of function --------------------------------------------------------*/
+#endif
 
 /* Probe for the CPUID instruction */
 static int have_cpuid_p(void)
 {
+#if defined(__i386__)
     return flag_is_changeable_p(X86_EFLAGS_ID);
+#else
+    /* Every x86_64 machine has CPUID */
+    return 1;
+#endif
 }
 /*- End of function --------------------------------------------------------*/
 
-int has_MMX(void)
+static void cpuid(uint32_t op, uint32_t subop, uint32_t regs[4])
 {
-    int result;
+#if defined(__i386__)
+    /* EBX may be the PIC register, so it must be preserved by hand */
+    __asm__ __volatile__ (
+        " xchgl %%ebx,%1;\n"
+        " cpuid;\n"
+        " xchgl %%ebx,%1;\n"
+        : "=a" (regs[0]), "=&r" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+        : "0" (op), "2" (subop));
+#else
+    __asm__ __volatile__ (
+        " cpuid;\n"
+        : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+        : "0" (op), "2" (subop));
+#endif
+}
+/*- End of function --------------------------------------------------------*/
+
+static int cpuid_edx_flag(uint32_t op, uint32_t flag)
+{
+    uint32_t regs[4];
 
     if (!have_cpuid_p())
         return  0;
     /*endif*/
-    __asm__ __volatile__ (
-        " push  %%ebx;\n"
-	" mov	$1,%%eax;\n"
-	" cpuid;\n"
-	" xor   %%eax,%%eax;\n"
-	" test	$0x800000,%%edx;\n"
-	" jz	1f;\n"	            /* no MMX support */
-	" inc   %%eax;\n"	    /* MMX support */
-        "1:\n"
-        " pop  %%ebx;\n"
-	: "=a" (result)
-        : 
-        : "ecx", "edx");
-    return  result;
+    cpuid(op & 0x80000000, 0, regs);
+    if (regs[0] < op)
+        return  0;
+    /*endif*/
+    cpuid(op, 0, regs);
+    return  (regs[3] & flag)  ?  1  :  0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int has_MMX(void)
+{
+    return  cpuid_edx_flag(1, 0x00800000);
 }
 /*- End of function --------------------------------------------------------*/
         
 int has_SIMD(void)
 {
-    int result;
-
-    if (!have_cpuid_p())
-        return  0;
-    /*endif*/
-    __asm__ __volatile__ (
-        " push  %%ebx;\n"
-	" mov	$1,%%eax;\n"
-	" cpuid;\n"
-	" xor   %%eax,%%eax;\n"
-	" test	$0x02000000,%%edx;\n"
-	" jz	1f;\n"		        /* no SIMD support */
-	" inc	%%eax;\n"		/* SIMD support */
-        "1:\n"
-        " pop  %%ebx;\n"
-	: "=a" (result)
-        : 
-        : "ecx", "edx");
-    return  result;
+    return  cpuid_edx_flag(1, 0x02000000);
 }
 /*- End of function --------------------------------------------------------*/
 
 int has_SIMD2(void)
 {
-    int result;
-
-    if (!have_cpuid_p())
-        return  0;
-    /*endif*/
-    __asm__ __volatile__ (
-        " push  %%ebx;\n"
-	" mov	$1,%%eax;\n"
-	" cpuid;\n"
-	" xor   %%eax,%%eax;\n"
-	" test	$0x04000000,%%edx;\n"
-	" jz	1f;\n"		        /* no SIMD2 support */
-	" inc	%%eax;\n"		/* SIMD2 support */
-        "1:\n"
-        " pop  %%ebx;\n"
-	: "=a" (result)
-        : 
-        : "ecx", "edx");
-    return  result;
+    return  cpuid_edx_flag(1, 0x04000000);
 }
 /*- End of function --------------------------------------------------------*/
         
 int has_3DNow(void)
 {
-    int result;
+    /* This needs extended MSR(1) */
+    return  cpuid_edx_flag(0x80000001, 0x80000000);
+}
+/*- End of function --------------------------------------------------------*/
+
+int has_AVX2(void)
+{
+    uint32_t regs[4];
+    uint32_t xcr0;
+    uint32_t xcr0_hi;
 
     if (!have_cpuid_p())
         return  0;
     /*endif*/
+    cpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return  0;
+    /*endif*/
+    /* The CPU must support AVX, and the OS must save the YMM registers across
+       context switches (OSXSAVE, and the SSE and AVX bits set in XCR0) */
+    cpuid(1, 0, regs);
+    if ((regs[2] & 0x18000000) != 0x18000000)
+        return  0;
+    /*endif*/
     __asm__ __volatile__ (
-        " push  %%ebx;\n"
-	" mov	$0x80000000,%%eax;\n"
-	" cpuid;\n"
-        " xor   %%ecx,%%ecx;\n"
-	" cmp	$0x80000000,%%eax;\n"
-	" jbe	1f;\n"		        /* no extended MSR(1), so no 3DNow! */
-	" mov	$0x80000001,%%eax;\n"
-	" cpuid;\n"
-        " xor   %%ecx,%%ecx;\n"
-	" test	$0x80000000,%%edx;\n"
-	" jz	1f;\n"		        /* no 3DNow! support */
-	" inc   %%ecx;\n"		/* 3DNow! support */
-        "1:\n"
-        " pop  %%ebx;\n"
-	: "=c" (result)
-        : 
-        : "eax", "edx");
-    return  result;
+        " .byte 0x0f,0x01,0xd0;\n"     /* xgetbv */
+        : "=a" (xcr0), "=d" (xcr0_hi)
+        : "c" (0));
+    if ((xcr0 & 0x06) != 0x06)
+        return  0;
+    /*endif*/
+    cpuid(7, 0, regs);
+    return  (regs[1] & 0x00000020)  ?  1  :  0;
 }
 /*- End of function --------------------------------------------------------*/
 
@@ -200,6 +202,8 @@ int main(int argc, char *argv[])
     printf("SIMD2 is %x\n", result);
     result = has_3DNow();
     printf("3DNow is %x\n", result);
+    result = has_AVX2();
+    printf("AVX2 is %x\n", result);
     return  0;
 }
 /*- End of function --------------------------------------------------------*/
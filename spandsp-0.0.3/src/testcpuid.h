@@ -0,0 +1,47 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * testcpuid.h - Check the CPU type, to identify special features, like SSE.
+ *
+ * Written by Steve Underwood <steveu@coppice.org>
+ *
+ * Copyright (C) 2004 Steve Underwood
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(_TESTCPUID_H_)
+#define _TESTCPUID_H_
+
+#if defined(__i386__)  ||  defined(__x86_64__)
+
+/* Each of these returns 1 if the CPU the program is running on has the feature,
+   and 0 if it does not. */
+int has_MMX(void);
+
+int has_SIMD(void);
+
+int has_SIMD2(void);
+
+int has_3DNow(void);
+
+/* This also checks the OS saves the AVX state, so the feature is actually usable. */
+int has_AVX2(void);
+
+#endif
+
+#endif
+/*- End of include ---------------------------------------------------------*/
@@ -0,0 +1,451 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * tone_analysis.c - A shared Goertzel analysis engine, for running several
+ *                   tone detectors on one channel.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "spandsp/telephony.h"
+#include "spandsp/tone_detect.h"
+#include "spandsp/tone_analysis.h"
+
+/* The filters are run TONE_ANALYSIS_VECTORS vectors at a time, where possible, so
+   there are several independent recursions in flight for each sample. The
+   arithmetic for each filter is exactly that of goertzel_update(). */
+#define TONE_ANALYSIS_VECTORS   4
+
+#if defined(__AVX512F__)
+#define TONE_ANALYSIS_LANES     16
+typedef __m512 tone_vec_t;
+#define vload(p)        _mm512_loadu_ps(p)
+#define vstore(p, x)    _mm512_storeu_ps(p, x)
+#define vset1           _mm512_set1_ps
+#define vadd            _mm512_add_ps
+#define vsub            _mm512_sub_ps
+#define vmul            _mm512_mul_ps
+#elif defined(__AVX2__)
+#define TONE_ANALYSIS_LANES     8
+typedef __m256 tone_vec_t;
+#define vload(p)        _mm256_loadu_ps(p)
+#define vstore(p, x)    _mm256_storeu_ps(p, x)
+#define vset1           _mm256_set1_ps
+#define vadd            _mm256_add_ps
+#define vsub            _mm256_sub_ps
+#define vmul            _mm256_mul_ps
+#elif defined(__SSE2__)
+#define TONE_ANALYSIS_LANES     4
+typedef __m128 tone_vec_t;
+#define vload(p)        _mm_loadu_ps(p)
+#define vstore(p, x)    _mm_storeu_ps(p, x)
+#define vset1           _mm_set1_ps
+#define vadd            _mm_add_ps
+#define vsub            _mm_sub_ps
+#define vmul            _mm_mul_ps
+#else
+#define TONE_ANALYSIS_LANES     1
+typedef float tone_vec_t;
+#define vload(p)        (*(p))
+#define vstore(p, x)    (*(p) = (x))
+#define vset1(x)        (x)
+#define vadd(a, b)      ((a) + (b))
+#define vsub(a, b)      ((a) - (b))
+#define vmul(a, b)      ((a)*(b))
+#endif
+
+static void filter_span(tone_analysis_state_t *s, const int16_t amp[], int len)
+{
+    tone_vec_t v1;
+    tone_vec_t v2[TONE_ANALYSIS_VECTORS];
+    tone_vec_t v3[TONE_ANALYSIS_VECTORS];
+    tone_vec_t fac[TONE_ANALYSIS_VECTORS];
+    tone_vec_t famp;
+    int run[TONE_ANALYSIS_MAX_BINS/TONE_ANALYSIS_LANES];
+    int active;
+    int vectors;
+    int runs;
+    int i;
+    int j;
+    int k;
+
+    /* Only run the vectors which hold a filter of a group which is not gated
+       off. TONE_ANALYSIS_MAX_BINS is a multiple of the vector size, and the
+       unused entries are zero, so whole vectors can always be run. Gated
+       filters which share a vector with running ones are updated too, but their
+       states are thrown away. */
+    active = 0;
+    for (i = 0;  i < s->groups;  i++)
+    {
+        if (s->group[i].active)
+            active |= (1 << i);
+    }
+    if (active == 0)
+        return;
+    vectors = (s->bins + TONE_ANALYSIS_LANES - 1)/TONE_ANALYSIS_LANES;
+    runs = 0;
+    for (k = 0;  k < vectors;  k++)
+    {
+        for (i = k*TONE_ANALYSIS_LANES;  i < (k + 1)*TONE_ANALYSIS_LANES  &&  i < s->bins;  i++)
+        {
+            if ((active & (1 << s->bin_group[i])))
+            {
+                run[runs++] = k;
+                break;
+            }
+        }
+    }
+    /* Run TONE_ANALYSIS_VECTORS vectors of filters at a time, and then whatever
+       single vectors are left. */
+    for (k = 0;  k + TONE_ANALYSIS_VECTORS <= runs;  k += TONE_ANALYSIS_VECTORS)
+    {
+        for (i = 0;  i < TONE_ANALYSIS_VECTORS;  i++)
+        {
+            fac[i] = vload(&s->fac[run[k + i]*TONE_ANALYSIS_LANES]);
+            v2[i] = vload(&s->v2[run[k + i]*TONE_ANALYSIS_LANES]);
+            v3[i] = vload(&s->v3[run[k + i]*TONE_ANALYSIS_LANES]);
+        }
+        for (j = 0;  j < len;  j++)
+        {
+            famp = vset1((float) amp[j]);
+            for (i = 0;  i < TONE_ANALYSIS_VECTORS;  i++)
+            {
+                v1 = v2[i];
+                v2[i] = v3[i];
+                v3[i] = vadd(vsub(vmul(fac[i], v2[i]), v1), famp);
+            }
+        }
+        for (i = 0;  i < TONE_ANALYSIS_VECTORS;  i++)
+        {
+            vstore(&s->v2[run[k + i]*TONE_ANALYSIS_LANES], v2[i]);
+            vstore(&s->v3[run[k + i]*TONE_ANALYSIS_LANES], v3[i]);
+        }
+    }
+    for (  ;  k < runs;  k++)
+    {
+        fac[0] = vload(&s->fac[run[k]*TONE_ANALYSIS_LANES]);
+        v2[0] = vload(&s->v2[run[k]*TONE_ANALYSIS_LANES]);
+        v3[0] = vload(&s->v3[run[k]*TONE_ANALYSIS_LANES]);
+        for (j = 0;  j < len;  j++)
+        {
+            famp = vset1((float) amp[j]);
+            v1 = v2[0];
+            v2[0] = v3[0];
+            v3[0] = vadd(vsub(vmul(fac[0], v2[0]), v1), famp);
+        }
+        vstore(&s->v2[run[k]*TONE_ANALYSIS_LANES], v2[0]);
+        vstore(&s->v3[run[k]*TONE_ANALYSIS_LANES], v3[0]);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Start the filters of a gated group part way through a block, by running them
+   over the audio of the block so far. */
+static void group_catch_up(tone_analysis_state_t *s, int group)
+{
+    float v1;
+    float v2;
+    float v3;
+    float fac;
+    int i;
+    int j;
+
+    for (i = 0;  i < s->bins;  i++)
+    {
+        if (s->bin_group[i] != group)
+            continue;
+        fac = s->fac[i];
+        v2 = 0.0f;
+        v3 = 0.0f;
+        for (j = s->group[group].current_sample;  j > 0;  j--)
+        {
+            v1 = v2;
+            v2 = v3;
+            v3 = fac*v2 - v1 + (float) s->history[(s->history_ptr - j) & (TONE_ANALYSIS_HISTORY - 1)];
+        }
+        s->v2[i] = v2;
+        s->v3[i] = v3;
+    }
+    s->group[group].active = TRUE;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void group_block_result(tone_analysis_state_t *s, int group)
+{
+    tone_analysis_group_t *g;
+    tone_analysis_subscriber_t *sub;
+    goertzel_state_t gs;
+    float energies[TONE_ANALYSIS_MAX_SUBSCRIBER_BINS];
+    int i;
+    int j;
+
+    g = &s->group[group];
+    for (i = 0;  i < s->bins;  i++)
+    {
+        if (s->bin_group[i] != group)
+            continue;
+        if (g->active)
+        {
+            gs.v2 = s->v2[i];
+            gs.v3 = s->v3[i];
+            gs.fac = s->fac[i];
+            s->result[i] = goertzel_result(&gs);
+        }
+        else
+        {
+            /* The block was below the gate, so no detector could find a tone in it */
+            s->result[i] = 0.0f;
+        }
+        /* Reinitialise the filter for the next block */
+        s->v2[i] = 0.0f;
+        s->v3[i] = 0.0f;
+    }
+    for (j = 0;  j < s->subscribers;  j++)
+    {
+        sub = &s->subscriber[j];
+        if (sub->group != group)
+            continue;
+        for (i = 0;  i < sub->bins;  i++)
+            energies[i] = s->result[sub->bin[i]];
+        sub->report(sub->user_data, energies, g->energy);
+    }
+    g->blocks++;
+    if (!g->active)
+        g->skipped_blocks++;
+    g->active = (g->gate <= 0.0f);
+    g->energy = 0.0f;
+    g->current_sample = 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int tone_analysis(tone_analysis_state_t *s, const int16_t amp[], int samples)
+{
+    tone_analysis_group_t *g;
+    float x;
+    int sample;
+    int limit;
+    int i;
+    int j;
+
+    if (s->groups == 0)
+        return 0;
+    for (sample = 0;  sample < samples;  sample = limit)
+    {
+        /* Take the audio as far as the next block boundary of any group */
+        limit = samples;
+        for (i = 0;  i < s->groups;  i++)
+        {
+            g = &s->group[i];
+            if (limit - sample > g->samples - g->current_sample)
+                limit = sample + g->samples - g->current_sample;
+        }
+        /* Measure the energy first, so the gated groups know if their filters
+           need to run. */
+        for (j = sample;  j < limit;  j++)
+        {
+            x = amp[j];
+            for (i = 0;  i < s->groups;  i++)
+                s->group[i].energy += x*x;
+        }
+        for (i = 0;  i < s->groups;  i++)
+        {
+            g = &s->group[i];
+            if (!g->active  &&  g->energy >= g->gate)
+                group_catch_up(s, i);
+        }
+        filter_span(s, amp + sample, limit - sample);
+        /* Keep the audio, in case a gated group needs to catch up later in its block */
+        for (j = (limit - sample > TONE_ANALYSIS_HISTORY)  ?  (limit - TONE_ANALYSIS_HISTORY)  :  sample;  j < limit;  j++)
+        {
+            s->history[s->history_ptr] = amp[j];
+            s->history_ptr = (s->history_ptr + 1) & (TONE_ANALYSIS_HISTORY - 1);
+        }
+        for (i = 0;  i < s->groups;  i++)
+        {
+            g = &s->group[i];
+            g->current_sample += (limit - sample);
+            if (g->current_sample >= g->samples)
+                group_block_result(s, i);
+        }
+    }
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Set a group's gate to the lowest gate of its subscribers. If any subscriber
+   has no gate, or the group's blocks are too long for the history, the group
+   is never gated. The change takes effect from the next block. */
+static void update_group_gate(tone_analysis_state_t *s, int group)
+{
+    float gate;
+    int i;
+
+    gate = -1.0f;
+    for (i = 0;  i < s->subscribers;  i++)
+    {
+        if (s->subscriber[i].group != group)
+            continue;
+        if (gate < 0.0f  ||  s->subscriber[i].gate < gate)
+            gate = s->subscriber[i].gate;
+    }
+    if (gate < 0.0f  ||  s->group[group].samples > TONE_ANALYSIS_HISTORY)
+        gate = 0.0f;
+    s->group[group].gate = gate;
+}
+/*- End of function --------------------------------------------------------*/
+
+int tone_analysis_set_gate(tone_analysis_state_t *s, int subscriber, float energy)
+{
+    if (subscriber < 0  ||  subscriber >= s->subscribers)
+        return -1;
+    s->subscriber[subscriber].gate = (energy > 0.0f)  ?  energy  :  0.0f;
+    update_group_gate(s, s->subscriber[subscriber].group);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int tone_analysis_get_skip_stats(tone_analysis_state_t *s, int subscriber, int *blocks, int *skipped_blocks)
+{
+    tone_analysis_group_t *g;
+
+    if (subscriber < 0  ||  subscriber >= s->subscribers)
+        return -1;
+    g = &s->group[s->subscriber[subscriber].group];
+    if (blocks)
+        *blocks = g->blocks;
+    if (skipped_blocks)
+        *skipped_blocks = g->skipped_blocks;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int tone_analysis_subscribe(tone_analysis_state_t *s,
+                            const goertzel_descriptor_t desc[],
+                            int bins,
+                            tone_analysis_report_func_t report,
+                            void *user_data)
+{
+    tone_analysis_subscriber_t *sub;
+    uint8_t bin[TONE_ANALYSIS_MAX_SUBSCRIBER_BINS];
+    int new_bins;
+    int group;
+    int i;
+    int j;
+
+    if (bins <= 0  ||  bins > TONE_ANALYSIS_MAX_SUBSCRIBER_BINS  ||  s->subscribers >= TONE_ANALYSIS_MAX_SUBSCRIBERS)
+        return -1;
+    for (i = 1;  i < bins;  i++)
+    {
+        if (desc[i].samples != desc[0].samples)
+            return -1;
+    }
+    /* Find, or make, the group for this block length */
+    for (group = 0;  group < s->groups;  group++)
+    {
+        if (s->group[group].samples == desc[0].samples)
+            break;
+    }
+    if (group >= s->groups)
+    {
+        if (s->groups >= TONE_ANALYSIS_MAX_GROUPS)
+            return -1;
+        memset(&s->group[group], 0, sizeof(s->group[group]));
+        s->group[group].samples = desc[0].samples;
+        s->group[group].active = TRUE;
+    }
+    /* Share any filter already in the group */
+    new_bins = s->bins;
+    for (i = 0;  i < bins;  i++)
+    {
+        for (j = 0;  j < new_bins;  j++)
+        {
+            if (s->bin_group[j] == group  &&  s->fac[j] == desc[i].fac)
+                break;
+        }
+        if (j >= new_bins)
+        {
+            if (new_bins >= TONE_ANALYSIS_MAX_BINS)
+            {
+                /* Put the unused entries back to zero */
+                memset(&s->fac[s->bins], 0, (new_bins - s->bins)*sizeof(s->fac[0]));
+                return -1;
+            }
+            s->bin_group[new_bins] = (uint8_t) group;
+            s->fac[new_bins++] = desc[i].fac;
+        }
+        bin[i] = (uint8_t) j;
+    }
+    s->bins = new_bins;
+    if (group >= s->groups)
+        s->groups++;
+
+    sub = &s->subscriber[s->subscribers];
+    sub->group = group;
+    sub->bins = bins;
+    memcpy(sub->bin, bin, bins*sizeof(bin[0]));
+    sub->report = report;
+    sub->user_data = user_data;
+    sub->gate = 0.0f;
+    s->requested_bins += bins;
+    s->subscribers++;
+    /* A new subscriber has no gate, so this stops the group being gated until
+       it sets one */
+    update_group_gate(s, group);
+    return s->subscribers - 1;
+}
+/*- End of function --------------------------------------------------------*/
+
+tone_analysis_state_t *tone_analysis_init(tone_analysis_state_t *s)
+{
+    if (s == NULL)
+    {
+        if ((s = (tone_analysis_state_t *) malloc(sizeof(*s))) == NULL)
+            return NULL;
+    }
+    memset(s, 0, sizeof(*s));
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int tone_analysis_release(tone_analysis_state_t *s)
+{
+    if (s)
+        free(s);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
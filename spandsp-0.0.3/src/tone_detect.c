@@ -54,6 +54,10 @@
 #define M_PI 3.14159265358979323846264338327
 #endif
 
+/* The damping of the sliding DFT recursion. Over a 102 sample window this
+   weights the oldest sample 0.09dB down. */
+#define SLIDING_DFT_DAMPING     0.9999
+
 void make_goertzel_descriptor(goertzel_descriptor_t *t, float freq, int samples)
 {
     t->fac = 2.0f*cosf(2.0f*M_PI*(freq/(float) SAMPLE_RATE));
@@ -118,4 +122,35 @@ float goertzel_result(goertzel_state_t *s)
     return s->v3*s->v3 + s->v2*s->v2 - s->v2*s->v3*s->fac;
 }
 /*- End of function --------------------------------------------------------*/
+
+void make_sliding_dft_descriptor(sliding_dft_descriptor_t *t, float freq, int samples)
+{
+    double w;
+    double r;
+
+    w = 2.0*M_PI*freq/(double) SAMPLE_RATE;
+    t->rot_re = SLIDING_DFT_DAMPING*cos(w);
+    t->rot_im = SLIDING_DFT_DAMPING*sin(w);
+    r = pow(SLIDING_DFT_DAMPING, samples);
+    t->tail_re = r*cos(w*samples);
+    t->tail_im = r*sin(w*samples);
+    t->samples = samples;
+}
+/*- End of function --------------------------------------------------------*/
+
+sliding_dft_state_t *sliding_dft_init(sliding_dft_state_t *s,
+                                      const sliding_dft_descriptor_t *t)
+{
+    if (s  ||  (s = malloc(sizeof(sliding_dft_state_t))))
+    {
+        s->z_re = 0.0f;
+        s->z_im = 0.0f;
+        s->rot_re = t->rot_re;
+        s->rot_im = t->rot_im;
+        s->tail_re = t->tail_re;
+        s->tail_im = t->tail_im;
+    }
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
 /*- End of file ------------------------------------------------------------*/
@@ -0,0 +1,614 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * tone_detect_fixed.c - Integer only Goertzel filters, and DTMF and Bell MF
+ *                       receivers built on them, for use in kernel space.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/string.h>
+#else
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(HAVE_TGMATH_H)
+#include <tgmath.h>
+#endif
+#if defined(HAVE_MATH_H)
+#include <math.h>
+#endif
+
+#include "spandsp/telephony.h"
+
+#if !defined(M_PI)
+/* C99 systems may not define M_PI */
+#define M_PI 3.14159265358979323846264338327
+#endif
+#endif
+
+#include "spandsp/tone_detect_fixed.h"
+
+#if !defined(NULL)
+#define NULL (void *) 0
+#endif
+#if !defined(FALSE)
+#define FALSE 0
+#endif
+#if !defined(TRUE)
+#define TRUE (!FALSE)
+#endif
+
+/* These are the thresholds of dtmf.c and bell_r2_mf.c. The energies are on the
+   same scale, so the energy thresholds are unchanged. The ratios are in Q8. */
+#define DTMF_THRESHOLD              80000000
+#define DTMF_NORMAL_TWIST           1613    /* 8dB */
+#define DTMF_REVERSE_TWIST          640     /* 4dB */
+#define DTMF_RELATIVE_PEAK_ROW      1613    /* 8dB */
+#define DTMF_RELATIVE_PEAK_COL      1613    /* 8dB */
+#define DTMF_TO_TOTAL_ENERGY        42
+
+#define BELL_MF_THRESHOLD           1600000000
+#define BELL_MF_TWIST               1024    /* 6dB */
+#define BELL_MF_RELATIVE_PEAK       3226    /* 11dB */
+
+/* 2cos(2.pi.f/8000) in Q14, for the DTMF rows and columns, and the Bell MF tones */
+static const goertzel_fixed_descriptor_t dtmf_detect_row[4] =
+{
+    {27980, 102},   /*  697Hz */
+    {26956, 102},   /*  770Hz */
+    {25701, 102},   /*  852Hz */
+    {24219, 102}    /*  941Hz */
+};
+static const goertzel_fixed_descriptor_t dtmf_detect_col[4] =
+{
+    {19073, 102},   /* 1209Hz */
+    {16325, 102},   /* 1336Hz */
+    {13085, 102},   /* 1477Hz */
+    { 9315, 102}    /* 1633Hz */
+};
+static const goertzel_fixed_descriptor_t bell_mf_detect_desc[6] =
+{
+    {27939, 120},   /*  700Hz */
+    {24917, 120},   /*  900Hz */
+    {21281, 120},   /* 1100Hz */
+    {17121, 120},   /* 1300Hz */
+    {12540, 120},   /* 1500Hz */
+    { 7650, 120}    /* 1700Hz */
+};
+
+/* The dial tone notch filters of dtmf.c, in Q30 */
+#define NOTCH_350_GAIN              1056089508      /* 0.98356   */
+#define NOTCH_350_A1                2035215995      /* 1.8954426 */
+#define NOTCH_350_B1                2067111925      /* 1.9251480 */
+#define NOTCH_440_GAIN              1057163250      /* 0.98456   */
+#define NOTCH_440_A1                1989594530      /* 1.8529543 */
+#define NOTCH_440_B1                2020775456      /* 1.8819938 */
+#define NOTCH_A2                    1040605722      /* 0.9691396 */
+
+/* 10^(dB/10), in Q8, for twists of 0dB to 20dB */
+static const int32_t twist_ratios[21] =
+{
+      256,   322,   406,   511,   643,   810,  1019,  1283,  1615,  2033,
+     2560,  3223,  4057,  5108,  6430,  8095, 10192, 12830, 16153, 20335,
+    25600
+};
+
+static const char dtmf_positions[] = "123A" "456B" "789C" "*0#D";
+
+static const char bell_mf_positions[] = "1247C-358A--69*---0B----#";
+
+#if !defined(__KERNEL__)
+void make_goertzel_fixed_descriptor(goertzel_fixed_descriptor_t *t, float freq, int samples)
+{
+    float fac;
+
+    fac = 16384.0f*2.0f*cosf(2.0f*M_PI*(freq/(float) SAMPLE_RATE));
+    /* 2cos(w) only reaches 2.0 at DC, which we never want to detect */
+    t->fac = (fac >= 32767.0f)  ?  32767  :  (int16_t) lrintf(fac);
+    t->samples = samples;
+}
+/*- End of function --------------------------------------------------------*/
+#endif
+
+goertzel_fixed_state_t *goertzel_fixed_init(goertzel_fixed_state_t *s,
+                                            const goertzel_fixed_descriptor_t *t)
+{
+    s->v2 =
+    s->v3 = 0;
+    s->fac = t->fac;
+    s->samples = t->samples;
+    s->current_sample = 0;
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+void goertzel_fixed_reset(goertzel_fixed_state_t *s)
+{
+    s->v2 =
+    s->v3 = 0;
+    s->current_sample = 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int goertzel_fixed_update(goertzel_fixed_state_t *s,
+                          const int16_t amp[],
+                          int samples)
+{
+    int i;
+    int32_t v1;
+
+    if (samples > s->samples - s->current_sample)
+        samples = s->samples - s->current_sample;
+    for (i = 0;  i < samples;  i++)
+    {
+        v1 = s->v2;
+        s->v2 = s->v3;
+        s->v3 = (int32_t) (((int64_t) s->fac*s->v2) >> 14) - v1 + amp[i];
+    }
+    s->current_sample += samples;
+    return samples;
+}
+/*- End of function --------------------------------------------------------*/
+
+int64_t goertzel_fixed_result(goertzel_fixed_state_t *s)
+{
+    int32_t v1;
+
+    /* Push a zero through the process to finish things off. */
+    v1 = s->v2;
+    s->v2 = s->v3;
+    s->v3 = (int32_t) (((int64_t) s->fac*s->v2) >> 14) - v1;
+    /* Now calculate the non-recursive side of the filter. */
+    /* The result here is not scaled down to allow for the magnification
+       effect of the filter (the usual DFT magnification effect). */
+    return (int64_t) s->v3*s->v3
+         + (int64_t) s->v2*s->v2
+         - (int64_t) s->v2*((int32_t) (((int64_t) s->v3*s->fac) >> 14));
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline__ int32_t notch(int32_t x, int32_t *z1, int32_t *z2, int32_t gain, int32_t a1, int32_t b1)
+{
+    int32_t v1;
+
+    v1 = (int32_t) (((int64_t) gain*x + (int64_t) a1*(*z1) - (int64_t) NOTCH_A2*(*z2)) >> 30);
+    x = v1 - (int32_t) (((int64_t) b1*(*z1)) >> 30) + *z2;
+    *z2 = *z1;
+    *z1 = v1;
+    return x;
+}
+/*- End of function --------------------------------------------------------*/
+
+int dtmf_rx_fixed(dtmf_rx_fixed_state_t *s, const int16_t amp[], int samples)
+{
+    int64_t row_energy[4];
+    int64_t col_energy[4];
+    int32_t famp;
+    int i;
+    int j;
+    int sample;
+    int best_row;
+    int best_col;
+    int limit;
+    uint8_t hit;
+
+    hit = 0;
+    for (sample = 0;  sample < samples;  sample = limit)
+    {
+        /* The block length is optimised to meet the DTMF specs. */
+        if ((samples - sample) >= (102 - s->current_sample))
+            limit = sample + (102 - s->current_sample);
+        else
+            limit = samples;
+        for (j = sample;  j < limit;  j++)
+        {
+            famp = amp[j];
+            if (s->filter_dialtone)
+            {
+                /* Sharp notches applied at 350Hz and 440Hz - the two common dialtone frequencies.
+                   The states carry 6 fractional bits, as these sections have high gain at
+                   their poles. */
+                famp = notch(famp*64, &s->z350_1, &s->z350_2, NOTCH_350_GAIN, NOTCH_350_A1, NOTCH_350_B1);
+                famp = notch(famp, &s->z440_1, &s->z440_2, NOTCH_440_GAIN, NOTCH_440_A1, NOTCH_440_B1);
+                famp = (famp + 32) >> 6;
+            }
+            s->energy += (int64_t) famp*famp;
+            goertzel_fixed_sample(&s->row_out[0], famp);
+            goertzel_fixed_sample(&s->col_out[0], famp);
+            goertzel_fixed_sample(&s->row_out[1], famp);
+            goertzel_fixed_sample(&s->col_out[1], famp);
+            goertzel_fixed_sample(&s->row_out[2], famp);
+            goertzel_fixed_sample(&s->col_out[2], famp);
+            goertzel_fixed_sample(&s->row_out[3], famp);
+            goertzel_fixed_sample(&s->col_out[3], famp);
+        }
+        s->current_sample += (limit - sample);
+        if (s->current_sample < 102)
+            continue;
+
+        /* We are at the end of a DTMF detection block */
+        /* Find the peak row and the peak column */
+        row_energy[0] = goertzel_fixed_result(&s->row_out[0]);
+        best_row = 0;
+        col_energy[0] = goertzel_fixed_result(&s->col_out[0]);
+        best_col = 0;
+
+        for (i = 1;  i < 4;  i++)
+        {
+            row_energy[i] = goertzel_fixed_result(&s->row_out[i]);
+            if (row_energy[i] > row_energy[best_row])
+                best_row = i;
+            col_energy[i] = goertzel_fixed_result(&s->col_out[i]);
+            if (col_energy[i] > col_energy[best_col])
+                best_col = i;
+        }
+        hit = 0;
+        /* Basic signal level test and the twist test */
+        if (row_energy[best_row] >= DTMF_THRESHOLD
+            &&
+            col_energy[best_col] >= DTMF_THRESHOLD
+            &&
+            col_energy[best_col]*256 < row_energy[best_row]*s->reverse_twist
+            &&
+            col_energy[best_col]*s->normal_twist > row_energy[best_row]*256)
+        {
+            /* Relative peak test ... */
+            for (i = 0;  i < 4;  i++)
+            {
+                if ((i != best_col  &&  col_energy[i]*DTMF_RELATIVE_PEAK_COL > col_energy[best_col]*256)
+                    ||
+                    (i != best_row  &&  row_energy[i]*DTMF_RELATIVE_PEAK_ROW > row_energy[best_row]*256))
+                {
+                    break;
+                }
+            }
+            /* ... and fraction of total energy test */
+            if (i >= 4
+                &&
+                (row_energy[best_row] + col_energy[best_col]) > DTMF_TO_TOTAL_ENERGY*s->energy)
+            {
+                hit = dtmf_positions[(best_row << 2) + best_col];
+            }
+        }
+        /* The persistence logic is that of dtmf_rx(). See there for the details. */
+        if (hit != s->in_digit)
+        {
+            if (s->last_hit != s->in_digit)
+            {
+                /* We have two successive indications that something has changed. */
+                /* To declare digit on, the hits must agree. Otherwise we declare tone off. */
+                hit = (hit  &&  hit == s->last_hit)  ?  hit   :  0;
+                if (s->realtime_callback)
+                {
+                    /* Avoid reporting multiple no digit conditions on flaky hits */
+                    if (s->in_digit  ||  hit)
+                        s->realtime_callback(s->realtime_callback_data, hit);
+                }
+                else
+                {
+                    if (hit)
+                    {
+                        if (s->current_digits < MAX_DTMF_DIGITS)
+                        {
+                            s->digits[s->current_digits++] = (char) hit;
+                            s->digits[s->current_digits] = '\0';
+                            if (s->callback)
+                            {
+                                s->callback(s->callback_data, s->digits, s->current_digits);
+                                s->current_digits = 0;
+                            }
+                        }
+                        else
+                        {
+                            s->lost_digits++;
+                        }
+                    }
+                }
+                s->in_digit = hit;
+            }
+        }
+        s->last_hit = hit;
+        /* Reinitialise the detector for the next block */
+        for (i = 0;  i < 4;  i++)
+        {
+            goertzel_fixed_reset(&s->row_out[i]);
+            goertzel_fixed_reset(&s->col_out[i]);
+        }
+        s->energy = 0;
+        s->current_sample = 0;
+    }
+    if (s->current_digits  &&  s->callback)
+    {
+        s->callback(s->callback_data, s->digits, s->current_digits);
+        s->digits[0] = '\0';
+        s->current_digits = 0;
+    }
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+size_t dtmf_rx_fixed_get(dtmf_rx_fixed_state_t *s, char *buf, int max)
+{
+    if (max > s->current_digits)
+        max = s->current_digits;
+    if (max > 0)
+    {
+        memcpy(buf, s->digits, max);
+        memmove(s->digits, s->digits + max, s->current_digits - max);
+        s->current_digits -= max;
+    }
+    buf[max] = '\0';
+    return  max;
+}
+/*- End of function --------------------------------------------------------*/
+
+void dtmf_rx_fixed_set_realtime_callback(dtmf_rx_fixed_state_t *s,
+                                         void (*callback)(void *user_data, int signal),
+                                         void *user_data)
+{
+    s->realtime_callback = callback;
+    s->realtime_callback_data = user_data;
+}
+/*- End of function --------------------------------------------------------*/
+
+void dtmf_rx_fixed_parms(dtmf_rx_fixed_state_t *s,
+                         int filter_dialtone,
+                         int twist,
+                         int reverse_twist)
+{
+    if (filter_dialtone >= 0)
+    {
+        s->z350_1 = 0;
+        s->z350_2 = 0;
+        s->z440_1 = 0;
+        s->z440_2 = 0;
+        s->filter_dialtone = filter_dialtone;
+    }
+    if (twist >= 0)
+        s->normal_twist = twist_ratios[(twist > 20)  ?  20  :  twist];
+    if (reverse_twist >= 0)
+        s->reverse_twist = twist_ratios[(reverse_twist > 20)  ?  20  :  reverse_twist];
+}
+/*- End of function --------------------------------------------------------*/
+
+dtmf_rx_fixed_state_t *dtmf_rx_fixed_init(dtmf_rx_fixed_state_t *s,
+                                          void (*callback)(void *user_data, const char *digits, int len),
+                                          void *user_data)
+{
+    int i;
+
+    s->callback = callback;
+    s->callback_data = user_data;
+    s->realtime_callback = NULL;
+    s->realtime_callback_data = NULL;
+    s->filter_dialtone = FALSE;
+    s->normal_twist = DTMF_NORMAL_TWIST;
+    s->reverse_twist = DTMF_REVERSE_TWIST;
+
+    s->in_digit = 0;
+    s->last_hit = 0;
+
+    for (i = 0;  i < 4;  i++)
+    {
+        goertzel_fixed_init(&s->row_out[i], &dtmf_detect_row[i]);
+        goertzel_fixed_init(&s->col_out[i], &dtmf_detect_col[i]);
+    }
+    s->energy = 0;
+    s->current_sample = 0;
+    s->lost_digits = 0;
+    s->current_digits = 0;
+    s->digits[0] = '\0';
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+
+int bell_mf_rx_fixed(bell_mf_rx_fixed_state_t *s, const int16_t amp[], int samples)
+{
+    int64_t energy[6];
+    int32_t famp;
+    int i;
+    int j;
+    int sample;
+    int best;
+    int second_best;
+    int limit;
+    uint8_t hit;
+
+    hit = 0;
+    for (sample = 0;  sample < samples;  sample = limit)
+    {
+        if ((samples - sample) >= (120 - s->current_sample))
+            limit = sample + (120 - s->current_sample);
+        else
+            limit = samples;
+        for (j = sample;  j < limit;  j++)
+        {
+            famp = amp[j];
+            goertzel_fixed_sample(&s->out[0], famp);
+            goertzel_fixed_sample(&s->out[1], famp);
+            goertzel_fixed_sample(&s->out[2], famp);
+            goertzel_fixed_sample(&s->out[3], famp);
+            goertzel_fixed_sample(&s->out[4], famp);
+            goertzel_fixed_sample(&s->out[5], famp);
+        }
+        s->current_sample += (limit - sample);
+        if (s->current_sample < 120)
+            continue;
+
+        /* We are at the end of an MF detection block */
+        /* Find the two highest energies, as bell_mf_rx() does */
+        energy[0] = goertzel_fixed_result(&s->out[0]);
+        energy[1] = goertzel_fixed_result(&s->out[1]);
+        if (energy[0] > energy[1])
+        {
+            best = 0;
+            second_best = 1;
+        }
+        else
+        {
+            best = 1;
+            second_best = 0;
+        }
+        for (i = 2;  i < 6;  i++)
+        {
+            energy[i] = goertzel_fixed_result(&s->out[i]);
+            if (energy[i] >= energy[best])
+            {
+                second_best = best;
+                best = i;
+            }
+            else if (energy[i] >= energy[second_best])
+            {
+                second_best = i;
+            }
+        }
+        /* Basic signal level and twist tests */
+        hit = 0;
+        if (energy[best] >= BELL_MF_THRESHOLD
+            &&
+            energy[second_best] >= BELL_MF_THRESHOLD
+            &&
+            energy[best]*256 < energy[second_best]*BELL_MF_TWIST
+            &&
+            energy[best]*BELL_MF_TWIST > energy[second_best]*256)
+        {
+            /* Relative peak test */
+            hit = 'X';
+            for (i = 0;  i < 6;  i++)
+            {
+                if (i != best  &&  i != second_best)
+                {
+                    if (energy[i]*BELL_MF_RELATIVE_PEAK >= energy[second_best]*256)
+                    {
+                        /* The best two are not clearly the best */
+                        hit = 0;
+                        break;
+                    }
+                }
+            }
+        }
+        if (hit)
+        {
+            /* Get the values into ascending order */
+            if (second_best < best)
+            {
+                i = best;
+                best = second_best;
+                second_best = i;
+            }
+            best = best*5 + second_best - 1;
+            hit = bell_mf_positions[best];
+            /* Look for two successive similar results, or four for KP, as
+               bell_mf_rx() does */
+            if (hit == s->hits[4]
+                &&
+                hit == s->hits[3]
+                &&
+                   ((hit != '*'  &&  hit != s->hits[2]  &&  hit != s->hits[1])
+                    ||
+                    (hit == '*'  &&  hit == s->hits[2]  &&  hit != s->hits[1]  &&  hit != s->hits[0])))
+            {
+                if (s->current_digits < MAX_BELL_MF_DIGITS)
+                {
+                    s->digits[s->current_digits++] = (char) hit;
+                    s->digits[s->current_digits] = '\0';
+                    if (s->callback)
+                    {
+                        s->callback(s->callback_data, s->digits, s->current_digits);
+                        s->current_digits = 0;
+                    }
+                }
+                else
+                {
+                    s->lost_digits++;
+                }
+            }
+        }
+        s->hits[0] = s->hits[1];
+        s->hits[1] = s->hits[2];
+        s->hits[2] = s->hits[3];
+        s->hits[3] = s->hits[4];
+        s->hits[4] = hit;
+        /* Reinitialise the detector for the next block */
+        for (i = 0;  i < 6;  i++)
+            goertzel_fixed_reset(&s->out[i]);
+        s->current_sample = 0;
+    }
+    if (s->current_digits  &&  s->callback)
+    {
+        s->callback(s->callback_data, s->digits, s->current_digits);
+        s->digits[0] = '\0';
+        s->current_digits = 0;
+    }
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+size_t bell_mf_rx_fixed_get(bell_mf_rx_fixed_state_t *s, char *buf, int max)
+{
+    if (max > s->current_digits)
+        max = s->current_digits;
+    if (max > 0)
+    {
+        memcpy(buf, s->digits, max);
+        memmove(s->digits, s->digits + max, s->current_digits - max);
+        s->current_digits -= max;
+    }
+    buf[max] = '\0';
+    return  max;
+}
+/*- End of function --------------------------------------------------------*/
+
+bell_mf_rx_fixed_state_t *bell_mf_rx_fixed_init(bell_mf_rx_fixed_state_t *s,
+                                                void (*callback)(void *user_data, const char *digits, int len),
+                                                void *user_data)
+{
+    int i;
+
+    s->callback = callback;
+    s->callback_data = user_data;
+
+    s->hits[0] =
+    s->hits[1] =
+    s->hits[2] =
+    s->hits[3] =
+    s->hits[4] = 0;
+
+    for (i = 0;  i < 6;  i++)
+        goertzel_fixed_init(&s->out[i], &bell_mf_detect_desc[i]);
+    s->current_sample = 0;
+    s->lost_digits = 0;
+    s->current_digits = 0;
+    s->digits[0] = '\0';
+    return s;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
@@ -33,6 +33,13 @@ of messages is passed between these instances, and checked for accuracy at
 the receiver. Since the FSK modems used for this are exercised fully by other
 tests, these tests do not include line modelling.
 
+A bank of receivers is then checked against separate receivers, for each standard.
+Some channels carry messages, at a range of levels and start times, some carry
+low level noise, and one carries noise which wanders across the carrier detect
+threshold. Every channel must receive exactly the same messages from the bank as
+from a separate receiver, and its FSK receiver must end in the same state. The
+time taken by a large bank of mostly idle lines is also measured.
+
 \section adsi_tests_page_sec_2 How does it work?
 */
 
@@ -45,6 +52,7 @@ tests, these tests do not include line modelling.
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
+#include <time.h>
 #if defined(HAVE_TGMATH_H)
 #include <tgmath.h>
 #endif
@@ -73,6 +81,20 @@ int good_message_received;
 
 int adsi_create_message(adsi_tx_state_t *s, uint8_t *msg);
 
+#define BANK_CHANNELS           13
+#define BANK_TEST_LEN           (12*SAMPLE_RATE)
+#define TIMING_CHANNELS         128
+#define TIMING_BUSY_CHANNELS    4
+#define TIMING_LEN              (2*SAMPLE_RATE)
+#define MSG_LOG_LEN             4096
+
+typedef struct
+{
+    uint8_t log[MSG_LOG_LEN];
+    int len;
+    int messages;
+} msg_log_t;
+
 int adsi_create_message(adsi_tx_state_t *s, uint8_t *msg)
 {
     const char *t;
@@ -511,6 +533,241 @@ static void put_adsi_msg(void *user_data, const uint8_t *msg, int len)
 }
 /*- End of function --------------------------------------------------------*/
 
+static void put_bank_msg(void *user_data, const uint8_t *msg, int len)
+{
+    msg_log_t *log;
+
+    log = (msg_log_t *) user_data;
+    log->messages++;
+    if (log->len + len + 1 > MSG_LOG_LEN)
+        return;
+    log->log[log->len++] = (uint8_t) len;
+    memcpy(&log->log[log->len], msg, len);
+    log->len += len;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int bank_channel_audio(adsi_tx_state_t *tx, awgn_state_t *noise, int chan, int16_t amp[], int len, int sample)
+{
+    static const int gains[4] =
+    {
+        8, 4, 2, 6
+    };
+    uint8_t msg[256 + 42];
+    int msg_len;
+    int n;
+    int i;
+
+    /* Channels 0 to 7 carry messages, 8 to 11 carry quiet noise, and channel 12
+       carries noise around the carrier detect threshold. */
+    n = 0;
+    if (chan < 8)
+    {
+        /* Stagger the starts, and leave gaps between messages */
+        if (sample >= chan*997  &&  (sample/SAMPLE_RATE)%3 != 2)
+        {
+            if ((n = adsi_tx(tx, amp, len)) < len  &&  (sample + len)%(SAMPLE_RATE/2) < len)
+            {
+                msg_len = adsi_create_message(tx, msg);
+                adsi_put_message(tx, msg, msg_len);
+            }
+        }
+        for (i = 0;  i < n;  i++)
+            amp[i] = (amp[i]*gains[chan & 3]) >> 3;
+    }
+    for (i = n;  i < len;  i++)
+        amp[i] = 0;
+    if (chan >= 8)
+    {
+        for (i = 0;  i < len;  i++)
+            amp[i] = awgn(noise);
+    }
+    return len;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void compare_fsk_rx(fsk_rx_state_t *a, fsk_rx_state_t *b, int chan)
+{
+    if (a->power.reading != b->power.reading
+        ||
+        a->last_sample != b->last_sample
+        ||
+        a->carrier_present != b->carrier_present
+        ||
+        a->buf_ptr != b->buf_ptr
+        ||
+        a->baud_pll != b->baud_pll
+        ||
+        a->lastbit != b->lastbit
+        ||
+        memcmp(a->phase_acc, b->phase_acc, sizeof(a->phase_acc))
+        ||
+        memcmp(a->dot_i, b->dot_i, sizeof(a->dot_i))
+        ||
+        memcmp(a->dot_q, b->dot_q, sizeof(a->dot_q)))
+    {
+        printf("Channel %d's FSK receiver differs from a separate receiver\n", chan);
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_tests(void)
+{
+    static const int chunk_lens[4] =
+    {
+        160, 53, 7, 100
+    };
+    static int16_t amp[BANK_CHANNELS][BLOCK_LEN];
+    static msg_log_t bank_log[BANK_CHANNELS];
+    static msg_log_t separate_log[BANK_CHANNELS];
+    static adsi_rx_state_t separate[BANK_CHANNELS];
+    adsi_tx_state_t tx[BANK_CHANNELS];
+    awgn_state_t noise[BANK_CHANNELS];
+    adsi_rx_bank_state_t *bank;
+    const int16_t *amps[BANK_CHANNELS];
+    void *user_data[BANK_CHANNELS];
+    int sample;
+    int len;
+    int i;
+    int j;
+
+    for (j = 1;  j <= ADSI_STANDARD_TDD;  j++)
+    {
+        printf("Testing a bank of %d %s receivers\n", BANK_CHANNELS, adsi_standard_to_str(j));
+        current_standard = j;
+        for (i = 0;  i < BANK_CHANNELS;  i++)
+        {
+            adsi_tx_init(&tx[i], j);
+            awgn_init_dbm0(&noise[i], 1234567 + i, (i == BANK_CHANNELS - 1)  ?  -31.0f  :  -50.0f);
+            memset(&bank_log[i], 0, sizeof(bank_log[i]));
+            memset(&separate_log[i], 0, sizeof(separate_log[i]));
+            adsi_rx_init(&separate[i], j, put_bank_msg, &separate_log[i]);
+            user_data[i] = &bank_log[i];
+            amps[i] = amp[i];
+        }
+        if ((bank = adsi_rx_bank_init(NULL, BANK_CHANNELS, j, put_bank_msg, user_data)) == NULL)
+        {
+            printf("Failed to create a bank of receivers\n");
+            exit(2);
+        }
+        for (sample = 0, i = 0;  sample < BANK_TEST_LEN;  sample += len, i++)
+        {
+            len = chunk_lens[i & 3];
+            for (j = 0;  j < BANK_CHANNELS;  j++)
+            {
+                bank_channel_audio(&tx[j], &noise[j], j, amp[j], len, sample);
+                adsi_rx(&separate[j], amp[j], len);
+            }
+            j = current_standard;
+            adsi_rx_bank(bank, amps, len);
+            /* Reset one channel part way through, on both sides */
+            if (sample < BANK_TEST_LEN/2  &&  sample + len >= BANK_TEST_LEN/2)
+            {
+                adsi_rx_bank_reset_channel(bank, 3);
+                adsi_rx_init(&separate[3], j, put_bank_msg, &separate_log[3]);
+            }
+        }
+        for (i = 0;  i < BANK_CHANNELS;  i++)
+        {
+            if (bank_log[i].messages != separate_log[i].messages
+                ||
+                bank_log[i].len != separate_log[i].len
+                ||
+                memcmp(bank_log[i].log, separate_log[i].log, bank_log[i].len))
+            {
+                printf("Channel %d received %d messages from the bank, and %d from a separate receiver\n",
+                       i,
+                       bank_log[i].messages,
+                       separate_log[i].messages);
+                exit(2);
+            }
+            if (i < 8  &&  bank_log[i].messages == 0)
+            {
+                printf("Channel %d received no messages\n", i);
+                exit(2);
+            }
+            if (j != ADSI_STANDARD_CLIP_DTMF)
+                compare_fsk_rx(&adsi_rx_bank_channel(bank, i)->fskrx, &separate[i].fskrx, i);
+        }
+        printf("    %d messages received on the busy channels\n", bank_log[0].messages + bank_log[1].messages + bank_log[2].messages + bank_log[3].messages
+                                                                + bank_log[4].messages + bank_log[5].messages + bank_log[6].messages + bank_log[7].messages);
+        adsi_rx_bank_release(bank);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static double elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec)/1.0e9;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_timing_tests(void)
+{
+    static int16_t audio[TIMING_CHANNELS][TIMING_LEN];
+    static adsi_rx_state_t separate[TIMING_CHANNELS];
+    static msg_log_t logs[TIMING_CHANNELS];
+    adsi_tx_state_t tx;
+    awgn_state_t noise;
+    adsi_rx_bank_state_t *bank;
+    const int16_t *amps[TIMING_CHANNELS];
+    void *user_data[TIMING_CHANNELS];
+    struct timespec start;
+    struct timespec end;
+    double separate_time;
+    double bank_time;
+    int sample;
+    int i;
+
+    /* A few lines carry caller ID, and the rest carry low level noise */
+    current_standard = ADSI_STANDARD_CLASS;
+    for (i = 0;  i < TIMING_CHANNELS;  i++)
+    {
+        if (i < TIMING_BUSY_CHANNELS)
+        {
+            adsi_tx_init(&tx, ADSI_STANDARD_CLASS);
+            for (sample = 0;  sample < TIMING_LEN;  sample += BLOCK_LEN)
+                bank_channel_audio(&tx, &noise, i, &audio[i][sample], BLOCK_LEN, sample);
+        }
+        else
+        {
+            awgn_init_dbm0(&noise, 7654321 + i, -50.0f);
+            for (sample = 0;  sample < TIMING_LEN;  sample++)
+                audio[i][sample] = awgn(&noise);
+        }
+        adsi_rx_init(&separate[i], ADSI_STANDARD_CLASS, put_bank_msg, &logs[i]);
+        user_data[i] = &logs[i];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (sample = 0;  sample < TIMING_LEN;  sample += BLOCK_LEN)
+    {
+        for (i = 0;  i < TIMING_CHANNELS;  i++)
+            adsi_rx(&separate[i], &audio[i][sample], BLOCK_LEN);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    separate_time = elapsed(&start, &end);
+
+    bank = adsi_rx_bank_init(NULL, TIMING_CHANNELS, ADSI_STANDARD_CLASS, put_bank_msg, user_data);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (sample = 0;  sample < TIMING_LEN;  sample += BLOCK_LEN)
+    {
+        for (i = 0;  i < TIMING_CHANNELS;  i++)
+            amps[i] = &audio[i][sample];
+        adsi_rx_bank(bank, amps, BLOCK_LEN);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    bank_time = elapsed(&start, &end);
+    adsi_rx_bank_release(bank);
+    printf("%d lines, %d with caller ID: separate receivers %.3fs, bank %.3fs (%.2f times faster)\n",
+           TIMING_CHANNELS,
+           TIMING_BUSY_CHANNELS,
+           separate_time,
+           bank_time,
+           separate_time/bank_time);
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     int16_t amp[BLOCK_LEN];
@@ -702,6 +959,8 @@ int main(int argc, char *argv[])
             }
             afFreeFileSetup(filesetup);
         }
+        bank_tests();
+        bank_timing_tests();
     }
     
     printf("Tests passed.\n");
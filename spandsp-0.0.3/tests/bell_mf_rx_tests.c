@@ -219,6 +219,43 @@ static void digit_delivery(void *data, const char *digits, int len)
 
 static int16_t amp[1000000];
 
+int use_fixed_point = FALSE;
+
+/* The tests can be run against the usual floating point receiver, or the integer
+   one from tone_detect_fixed.c */
+typedef struct
+{
+    bell_mf_rx_state_t f;
+    bell_mf_rx_fixed_state_t i;
+} test_bell_mf_rx_state_t;
+
+static void test_bell_mf_rx_init(test_bell_mf_rx_state_t *s,
+                                 void (*callback)(void *user_data, const char *digits, int len),
+                                 void *user_data)
+{
+    if (use_fixed_point)
+        bell_mf_rx_fixed_init(&s->i, callback, user_data);
+    else
+        bell_mf_rx_init(&s->f, callback, user_data);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_bell_mf_rx(test_bell_mf_rx_state_t *s, const int16_t amp[], int samples)
+{
+    if (use_fixed_point)
+        return bell_mf_rx_fixed(&s->i, amp, samples);
+    return bell_mf_rx(&s->f, amp, samples);
+}
+/*- End of function --------------------------------------------------------*/
+
+static size_t test_bell_mf_rx_get(test_bell_mf_rx_state_t *s, char *buf, int max)
+{
+    if (use_fixed_point)
+        return bell_mf_rx_fixed_get(&s->i, buf, max);
+    return bell_mf_rx_get(&s->f, buf, max);
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     int duration;
@@ -235,11 +272,21 @@ int main(int argc, char *argv[])
     float rrb;
     float rcfo;
     time_t now;
-    bell_mf_rx_state_t mf_state;
+    test_bell_mf_rx_state_t mf_state;
     awgn_state_t noise_source;
 
+    use_fixed_point = FALSE;
+    for (i = 1;  i < argc;  i++)
+    {
+        if (strcmp(argv[i], "-i") == 0)
+        {
+            use_fixed_point = TRUE;
+            continue;
+        }
+    }
+
     time(&now);
-    bell_mf_rx_init(&mf_state, NULL, NULL);
+    test_bell_mf_rx_init(&mf_state, NULL, NULL);
 
     /* Test 1: Mitel's test 1 isn't really a test. Its a calibration step,
        which has no meaning here. */
@@ -261,8 +308,8 @@ int main(int argc, char *argv[])
         {
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            actual = bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            actual = test_bell_mf_rx_get(&mf_state, buf, 128);
             if (actual != 1  ||  buf[0] != digit[0])
             {
                 printf ("    Sent     '%s'\n", digit);
@@ -314,16 +361,16 @@ int main(int argc, char *argv[])
             my_mf_gen_init((float) i/1000.0, -17, 0.0, -17, 68, 68);
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            nplus += bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            nplus += test_bell_mf_rx_get(&mf_state, buf, 128);
         }
         for (nminus = 0, i = -1;  i >= -60;  i--)
         {
             my_mf_gen_init((float) i/1000.0, -17, 0.0, -17, 68, 68);
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            nminus += bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            nminus += test_bell_mf_rx_get(&mf_state, buf, 128);
         }
         rrb = (float) (nplus + nminus)/10.0;
         rcfo = (float) (nplus - nminus)/10.0;
@@ -345,16 +392,16 @@ int main(int argc, char *argv[])
             my_mf_gen_init(0.0, -17, (float) i/1000.0, -17, 68, 68);
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            nplus += bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            nplus += test_bell_mf_rx_get(&mf_state, buf, 128);
         }
         for (nminus = 0, i = -1;  i >= -60;  i--)
         {
             my_mf_gen_init(0.0, -17, (float) i/1000.0, -17, 68, 68);
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            nminus += bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            nminus += test_bell_mf_rx_get(&mf_state, buf, 128);
         }
         rrb = (float) (nplus + nminus)/10.0;
         rcfo = (float) (nplus - nminus)/10.0;
@@ -390,8 +437,8 @@ int main(int argc, char *argv[])
 
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            nplus += bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            nplus += test_bell_mf_rx_get(&mf_state, buf, 128);
         }
         printf("    %c normal twist  = %.2fdB\n", digit[0], (float) nplus/10.0);
         if (nplus < 60)
@@ -405,8 +452,8 @@ int main(int argc, char *argv[])
 
             len = my_mf_generate(amp, digit);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            nminus += bell_mf_rx_get(&mf_state, buf, 128);
+            test_bell_mf_rx(&mf_state, amp, len);
+            nminus += test_bell_mf_rx_get(&mf_state, buf, 128);
         }
         printf("    %c reverse twist = %.2fdB\n", digit[0], (float) nminus/10.0);
         if (nminus < 60)
@@ -431,8 +478,8 @@ int main(int argc, char *argv[])
         {
             len = my_mf_generate(amp, ALL_POSSIBLE_DIGITS);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
-            if (bell_mf_rx_get(&mf_state, buf, 128) != 15)
+            test_bell_mf_rx(&mf_state, amp, len);
+            if (test_bell_mf_rx_get(&mf_state, buf, 128) != 15)
                 break;
             if (strcmp(buf, ALL_POSSIBLE_DIGITS) != 0)
                 break;
@@ -472,9 +519,9 @@ int main(int argc, char *argv[])
         {
             len = my_mf_generate(amp, ALL_POSSIBLE_DIGITS);
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
+            test_bell_mf_rx(&mf_state, amp, len);
 
-            if (bell_mf_rx_get(&mf_state, buf, 128) != 15)
+            if (test_bell_mf_rx_get(&mf_state, buf, 128) != 15)
                 break;
             if (strcmp(buf, ALL_POSSIBLE_DIGITS) != 0)
                 break;
@@ -505,9 +552,9 @@ int main(int argc, char *argv[])
             for (sample = 0;  sample < len;  sample++)
                 amp[sample] = saturate(amp[sample] + awgn(&noise_source));
             codec_munge(amp, len);
-            bell_mf_rx(&mf_state, amp, len);
+            test_bell_mf_rx(&mf_state, amp, len);
 
-            if (bell_mf_rx_get(&mf_state, buf, 128) != 15)
+            if (test_bell_mf_rx_get(&mf_state, buf, 128) != 15)
                 break;
             if (strcmp(buf, ALL_POSSIBLE_DIGITS) != 0)
                 break;
@@ -533,14 +580,14 @@ int main(int argc, char *argv[])
     printf("Test: Callback digit delivery mode.\n");
     callback_ok = FALSE;
     callback_roll = 0;
-    bell_mf_rx_init(&mf_state, digit_delivery, (void *) 0x12345678);
+    test_bell_mf_rx_init(&mf_state, digit_delivery, (void *) 0x12345678);
     my_mf_gen_init(0.0, -10, 0.0, -10, 68, 68);
     for (i = 1;  i < 10;  i++)
     {
         len = 0;
         for (j = 0;  j < i;  j++)
             len += my_mf_generate(amp + len, ALL_POSSIBLE_DIGITS);
-        bell_mf_rx(&mf_state, amp, len);
+        test_bell_mf_rx(&mf_state, amp, len);
         if (!callback_ok)
             break;
     }
@@ -0,0 +1,809 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * codec_bench.c - Measure the throughput, per frame latency and memory use
+ *                 of the speech codecs, on one thread and on all CPUs.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \page codec_bench_page Codec benchmark
+\section codec_bench_page_sec_1 What does it do?
+The codec tests only check the codecs give the right answers. This program
+measures how fast they do it. For G.711 (A-law and u-law), G.722 (all
+rates), G.726 (all rates), GSM 06.10, LPC-10, IMA ADPCM (DVI4 and VDVI) and
+Oki ADPCM (both rates) it measures, separately for encoding and decoding:
+
+    - the throughput, as channel-seconds of audio processed per CPU-second.
+    - the latency of processing one frame, as the 50th, 90th and 99th
+      percentiles and the worst case.
+    - the memory used by one instance of the codec.
+
+Each codec is run on a single thread, and then on every CPU at once, so the
+effect of sharing caches and memory bandwidth shows up. The results go to a
+CSV file, one row per codec, direction and thread count, which can be kept
+to track regressions, or used to size a transcoding node.
+
+\section codec_bench_page_sec_2 How does it work?
+A few seconds of speech-like test signal (noise through a low pass filter,
+switched on and off at a syllabic rate) is made at start up, so the signal
+generation is not part of what is being measured. Each thread has its own
+codec instances. Before timing the decoder, each thread encodes the signal
+once with its own encoder, so the decoder is fed real codes.
+
+Each thread then feeds its codec the signal a frame at a time, until it has
+used the requested amount of CPU time. Nothing is timed inside this loop. The
+CPU time is only read after each pass over the whole signal, so the
+throughput, which is the audio processed divided by the CPU time used by all
+the threads, is the codec's alone.
+
+The latencies come from a separate pass of at least LATENCY_FRAMES frames, after
+the throughput run. Each frame is timed with the monotonic clock, and the times
+are gathered in a histogram with 10ns bins. Reading the clock takes longer
+than a G.711 frame, so the cost of a pair of clock reads, with nothing between
+them, is measured first, and taken off each frame's time.
+
+The memory per instance is the size of the codec's state, which is all it
+allocates. G.711 has no state.
+
+\section codec_bench_page_sec_3 How do I use it?
+    ./codec_bench                  all codecs, 1 thread and all CPUs
+    ./codec_bench -c g726 -s 5     just the G.726 rates, 5 CPU-seconds each
+    ./codec_bench -j 8 -o x.csv    1 thread and 8 threads, report in x.csv
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <string.h>
+#if defined(HAVE_TGMATH_H)
+#include <tgmath.h>
+#endif
+#if defined(HAVE_MATH_H)
+#include <math.h>
+#endif
+#include <time.h>
+#include <pthread.h>
+#include <audiofile.h>
+#include <tiffio.h>
+
+#include "spandsp.h"
+
+#if !defined(FALSE)
+#define FALSE 0
+#endif
+#if !defined(TRUE)
+#define TRUE (!FALSE)
+#endif
+
+#define REPORT_FILE_NAME    "codec_bench.csv"
+#define MAX_THREADS         256
+
+/* The test signal, at the highest sample rate of any of the codecs. The 8k
+   codecs just treat it as 8k samples, which makes no real difference to them. */
+#define SIGNAL_SAMPLES      (16000*4)
+
+/* The largest frame of any of the codecs, in samples and in bytes of code */
+#define MAX_FRAME_SAMPLES   320
+#define MAX_FRAME_BYTES     512
+
+/* The latency histogram has 10ns bins, up to 1ms. Anything slower goes in the
+   last bin, and only shows up in the worst case. */
+#define HIST_BIN_NS         10
+#define HIST_BINS           100000
+
+#define DEFAULT_CPU_SECONDS 1.0
+
+/* The least number of frames timed one at a time for the latencies */
+#define LATENCY_FRAMES      20000
+/* The number of empty pairs of clock reads used to find the cost of timing */
+#define TIMER_CALIBRATIONS  1000
+
+typedef struct bench_codec_s bench_codec_t;
+
+struct bench_codec_s
+{
+    const char *name;
+    /* The rate, variant, etc. passed to the init functions */
+    int arg;
+    int sample_rate;
+    int frame_samples;
+    size_t enc_bytes;
+    size_t dec_bytes;
+    void *(*enc_init)(const bench_codec_t *c);
+    int (*encode)(void *s, uint8_t code[], const int16_t amp[], int len);
+    void (*enc_release)(void *s);
+    void *(*dec_init)(const bench_codec_t *c);
+    int (*decode)(void *s, int16_t amp[], const uint8_t code[], int len);
+    void (*dec_release)(void *s);
+};
+
+enum
+{
+    DIR_ENCODE = 0,
+    DIR_DECODE
+};
+
+typedef struct
+{
+    const bench_codec_t *codec;
+    int direction;
+    double cpu_seconds;
+
+    /* What the thread measured */
+    int64_t frames;
+    double cpu_used;
+    uint32_t *hist;
+    int64_t timed_frames;
+    int64_t max_ns;
+    int failed;
+} bench_thread_t;
+
+typedef struct
+{
+    const bench_codec_t *codec;
+    int direction;
+    int threads;
+    size_t bytes_per_instance;
+    double channel_seconds;
+    double cpu_seconds;
+    double wall_seconds;
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double max_us;
+} bench_result_t;
+
+static int16_t test_signal[SIGNAL_SAMPLES];
+
+static bench_result_t *results;
+static int n_results;
+
+/* G.711 has no state, so its "instance" just says which law to use */
+enum
+{
+    G711_ALAW = 0,
+    G711_ULAW
+};
+
+static int alaw_id = G711_ALAW;
+static int ulaw_id = G711_ULAW;
+
+static void *g711_init(const bench_codec_t *c)
+{
+    return (c->arg == G711_ALAW)  ?  (void *) &alaw_id  :  (void *) &ulaw_id;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void g711_release(void *s)
+{
+}
+/*- End of function --------------------------------------------------------*/
+
+static int g711_encode(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    if (*(int *) s == G711_ALAW)
+        g711_alaw_encode_block(code, amp, len);
+    else
+        g711_ulaw_encode_block(code, amp, len);
+    return len;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int g711_decode(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    if (*(int *) s == G711_ALAW)
+        g711_alaw_decode_block(amp, code, len);
+    else
+        g711_ulaw_decode_block(amp, code, len);
+    return len;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *g722_enc_init(const bench_codec_t *c)
+{
+    return g722_encode_init(NULL, c->arg, 0);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int g722_enc(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    return g722_encode((g722_encode_state_t *) s, code, amp, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void g722_enc_release(void *s)
+{
+    g722_encode_release((g722_encode_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *g722_dec_init(const bench_codec_t *c)
+{
+    return g722_decode_init(NULL, c->arg, 0);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int g722_dec(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    return g722_decode((g722_decode_state_t *) s, amp, code, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void g722_dec_release(void *s)
+{
+    g722_decode_release((g722_decode_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *g726_codec_init(const bench_codec_t *c)
+{
+    return g726_init(NULL, c->arg, G726_ENCODING_LINEAR, G726_PACKING_NONE);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int g726_enc(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    return g726_encode((g726_state_t *) s, code, amp, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int g726_dec(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    return g726_decode((g726_state_t *) s, amp, code, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void g726_codec_release(void *s)
+{
+    g726_release((g726_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *gsm0610_codec_init(const bench_codec_t *c)
+{
+    return gsm0610_init(NULL, c->arg);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int gsm0610_enc(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    return gsm0610_encode((gsm0610_state_t *) s, code, amp, len/160);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int gsm0610_dec(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    return gsm0610_decode((gsm0610_state_t *) s, amp, code, len/33);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void gsm0610_codec_release(void *s)
+{
+    gsm0610_release((gsm0610_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *lpc10_enc_init(const bench_codec_t *c)
+{
+    return lpc10_encode_init(NULL, c->arg);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int lpc10_enc(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    return lpc10_encode((lpc10_encode_state_t *) s, code, amp, len/LPC10_SAMPLES_PER_FRAME);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void lpc10_enc_release(void *s)
+{
+    lpc10_encode_release((lpc10_encode_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *lpc10_dec_init(const bench_codec_t *c)
+{
+    return lpc10_decode_init(NULL, c->arg);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int lpc10_dec(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    return lpc10_decode((lpc10_decode_state_t *) s, amp, code, len/7);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void lpc10_dec_release(void *s)
+{
+    lpc10_decode_release((lpc10_decode_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *ima_adpcm_codec_init(const bench_codec_t *c)
+{
+    return ima_adpcm_init(NULL, c->arg);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int ima_adpcm_enc(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    return ima_adpcm_encode((ima_adpcm_state_t *) s, code, amp, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int ima_adpcm_dec(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    return ima_adpcm_decode((ima_adpcm_state_t *) s, amp, code, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void ima_adpcm_codec_release(void *s)
+{
+    ima_adpcm_release((ima_adpcm_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *oki_adpcm_codec_init(const bench_codec_t *c)
+{
+    return oki_adpcm_init(NULL, c->arg);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int oki_adpcm_enc(void *s, uint8_t code[], const int16_t amp[], int len)
+{
+    return oki_adpcm_encode((oki_adpcm_state_t *) s, code, amp, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int oki_adpcm_dec(void *s, int16_t amp[], const uint8_t code[], int len)
+{
+    return oki_adpcm_decode((oki_adpcm_state_t *) s, amp, code, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void oki_adpcm_codec_release(void *s)
+{
+    oki_adpcm_release((oki_adpcm_state_t *) s);
+}
+/*- End of function --------------------------------------------------------*/
+
+#define G711_CODEC(name, law) \
+    {name, law, 8000, 160, 0, 0, g711_init, g711_encode, g711_release, g711_init, g711_decode, g711_release}
+#define G722_CODEC(name, rate) \
+    {name, rate, 16000, 320, sizeof(g722_encode_state_t), sizeof(g722_decode_state_t), \
+     g722_enc_init, g722_enc, g722_enc_release, g722_dec_init, g722_dec, g722_dec_release}
+#define G726_CODEC(name, rate) \
+    {name, rate, 8000, 160, sizeof(g726_state_t), sizeof(g726_state_t), \
+     g726_codec_init, g726_enc, g726_codec_release, g726_codec_init, g726_dec, g726_codec_release}
+#define IMA_ADPCM_CODEC(name, variant) \
+    {name, variant, 8000, 160, sizeof(ima_adpcm_state_t), sizeof(ima_adpcm_state_t), \
+     ima_adpcm_codec_init, ima_adpcm_enc, ima_adpcm_codec_release, ima_adpcm_codec_init, ima_adpcm_dec, ima_adpcm_codec_release}
+#define OKI_ADPCM_CODEC(name, rate) \
+    {name, rate, 8000, 160, sizeof(oki_adpcm_state_t), sizeof(oki_adpcm_state_t), \
+     oki_adpcm_codec_init, oki_adpcm_enc, oki_adpcm_codec_release, oki_adpcm_codec_init, oki_adpcm_dec, oki_adpcm_codec_release}
+
+static const bench_codec_t codecs[] =
+{
+    G711_CODEC("g711_alaw", G711_ALAW),
+    G711_CODEC("g711_ulaw", G711_ULAW),
+    G722_CODEC("g722_64k", 64000),
+    G722_CODEC("g722_56k", 56000),
+    G722_CODEC("g722_48k", 48000),
+    G726_CODEC("g726_16k", 16000),
+    G726_CODEC("g726_24k", 24000),
+    G726_CODEC("g726_32k", 32000),
+    G726_CODEC("g726_40k", 40000),
+    {"gsm0610", GSM0610_PACKING_VOIP, 8000, 160, sizeof(gsm0610_state_t), sizeof(gsm0610_state_t),
+     gsm0610_codec_init, gsm0610_enc, gsm0610_codec_release, gsm0610_codec_init, gsm0610_dec, gsm0610_codec_release},
+    {"lpc10", FALSE, 8000, LPC10_SAMPLES_PER_FRAME, sizeof(lpc10_encode_state_t), sizeof(lpc10_decode_state_t),
+     lpc10_enc_init, lpc10_enc, lpc10_enc_release, lpc10_dec_init, lpc10_dec, lpc10_dec_release},
+    IMA_ADPCM_CODEC("ima_adpcm_dvi4", IMA_ADPCM_DVI4),
+    IMA_ADPCM_CODEC("ima_adpcm_vdvi", IMA_ADPCM_VDVI),
+    OKI_ADPCM_CODEC("oki_adpcm_32k", 32000),
+    OKI_ADPCM_CODEC("oki_adpcm_24k", 24000),
+    {NULL}
+};
+
+/* Crude synthetic speech: noise through a one pole low pass filter, switched
+   on and off at a syllabic rate, so the adaptive codecs see both loud and
+   quiet passages. */
+static void make_signal(void)
+{
+    uint32_t seed;
+    int y;
+    int n;
+    int i;
+
+    seed = 1;
+    y = 0;
+    for (i = 0;  i < SIGNAL_SAMPLES;  i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        n = (int16_t) (seed >> 16);
+        y += (n - y) >> 2;
+        test_signal[i] = (((i/2400)%3) == 2)  ?  (y >> 6)  :  (y >> 1);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static double timespec_to_seconds(const struct timespec *t)
+{
+    return t->tv_sec + t->tv_nsec*1.0e-9;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int64_t timespec_diff_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (int64_t) (b->tv_sec - a->tv_sec)*1000000000 + (b->tv_nsec - a->tv_nsec);
+}
+/*- End of function --------------------------------------------------------*/
+
+/* The least time between two back to back clock reads. This is the cost of
+   timing anything, and it is taken off each frame's time. */
+static int64_t timer_overhead_ns(void)
+{
+    struct timespec start;
+    struct timespec end;
+    int64_t ns;
+    int64_t min_ns;
+    int i;
+
+    min_ns = INT64_MAX;
+    for (i = 0;  i < TIMER_CALIBRATIONS;  i++)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ns = timespec_diff_ns(&start, &end);
+        if (ns < min_ns)
+            min_ns = ns;
+    }
+    return min_ns;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *bench_thread(void *arg)
+{
+    bench_thread_t *t;
+    const bench_codec_t *c;
+    struct timespec cpu_start;
+    struct timespec cpu_now;
+    struct timespec start;
+    struct timespec end;
+    int16_t amp[MAX_FRAME_SAMPLES];
+    uint8_t *code;
+    int *code_len;
+    void *enc;
+    void *dec;
+    int frames_in_signal;
+    int64_t overhead_ns;
+    int64_t ns;
+    int f;
+
+    t = (bench_thread_t *) arg;
+    c = t->codec;
+    frames_in_signal = SIGNAL_SAMPLES/c->frame_samples;
+    code = malloc(frames_in_signal*MAX_FRAME_BYTES);
+    code_len = malloc(frames_in_signal*sizeof(int));
+    enc = c->enc_init(c);
+    dec = c->dec_init(c);
+    if (code == NULL  ||  code_len == NULL  ||  enc == NULL  ||  dec == NULL)
+    {
+        t->failed = TRUE;
+        return NULL;
+    }
+
+    /* Encode the whole signal once, so the decoder has real codes to work on */
+    if (t->direction == DIR_DECODE)
+    {
+        for (f = 0;  f < frames_in_signal;  f++)
+            code_len[f] = c->encode(enc, &code[f*MAX_FRAME_BYTES], &test_signal[f*c->frame_samples], c->frame_samples);
+    }
+
+    /* The throughput, with the CPU time only read once per pass over the signal */
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+    do
+    {
+        for (f = 0;  f < frames_in_signal;  f++)
+        {
+            if (t->direction == DIR_ENCODE)
+                c->encode(enc, &code[f*MAX_FRAME_BYTES], &test_signal[f*c->frame_samples], c->frame_samples);
+            else
+                c->decode(dec, amp, &code[f*MAX_FRAME_BYTES], code_len[f]);
+        }
+        t->frames += frames_in_signal;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_now);
+        t->cpu_used = timespec_to_seconds(&cpu_now) - timespec_to_seconds(&cpu_start);
+    }
+    while (t->cpu_used < t->cpu_seconds);
+
+    /* The latencies, a frame at a time, less the cost of reading the clock */
+    overhead_ns = timer_overhead_ns();
+    do
+    {
+        for (f = 0;  f < frames_in_signal;  f++)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (t->direction == DIR_ENCODE)
+                c->encode(enc, &code[f*MAX_FRAME_BYTES], &test_signal[f*c->frame_samples], c->frame_samples);
+            else
+                c->decode(dec, amp, &code[f*MAX_FRAME_BYTES], code_len[f]);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            ns = timespec_diff_ns(&start, &end) - overhead_ns;
+            if (ns < 0)
+                ns = 0;
+            t->hist[(ns/HIST_BIN_NS < HIST_BINS)  ?  ns/HIST_BIN_NS  :  HIST_BINS - 1]++;
+            if (ns > t->max_ns)
+                t->max_ns = ns;
+        }
+        t->timed_frames += frames_in_signal;
+    }
+    while (t->timed_frames < LATENCY_FRAMES);
+
+    c->enc_release(enc);
+    c->dec_release(dec);
+    free(code);
+    free(code_len);
+    return NULL;
+}
+/*- End of function --------------------------------------------------------*/
+
+static double percentile_us(const uint32_t hist[], int64_t total, double fraction)
+{
+    int64_t target;
+    int64_t count;
+    int i;
+
+    target = (int64_t) (total*fraction);
+    count = 0;
+    for (i = 0;  i < HIST_BINS;  i++)
+    {
+        count += hist[i];
+        if (count > target)
+            break;
+    }
+    /* Report the middle of the bin */
+    return (i*HIST_BIN_NS + HIST_BIN_NS/2)/1000.0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int run_bench(const bench_codec_t *c, int direction, int n_threads, double cpu_seconds)
+{
+    pthread_t threads[MAX_THREADS];
+    bench_thread_t *t;
+    bench_result_t *r;
+    uint32_t *hist;
+    struct timespec wall_start;
+    struct timespec wall_end;
+    int64_t frames;
+    int64_t timed_frames;
+    int64_t max_ns;
+    double cpu_used;
+    int i;
+    int j;
+
+    if ((t = calloc(n_threads, sizeof(*t))) == NULL
+        ||
+        (hist = calloc(HIST_BINS, sizeof(*hist))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    for (i = 0;  i < n_threads;  i++)
+    {
+        t[i].codec = c;
+        t[i].direction = direction;
+        t[i].cpu_seconds = cpu_seconds;
+        if ((t[i].hist = calloc(HIST_BINS, sizeof(uint32_t))) == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            exit(2);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    for (i = 0;  i < n_threads;  i++)
+    {
+        if (pthread_create(&threads[i], NULL, bench_thread, &t[i]))
+        {
+            fprintf(stderr, "Cannot create thread\n");
+            exit(2);
+        }
+    }
+    for (i = 0;  i < n_threads;  i++)
+        pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+    frames = 0;
+    timed_frames = 0;
+    max_ns = 0;
+    cpu_used = 0.0;
+    for (i = 0;  i < n_threads;  i++)
+    {
+        if (t[i].failed)
+        {
+            fprintf(stderr, "Cannot start %s\n", c->name);
+            return -1;
+        }
+        frames += t[i].frames;
+        timed_frames += t[i].timed_frames;
+        cpu_used += t[i].cpu_used;
+        if (t[i].max_ns > max_ns)
+            max_ns = t[i].max_ns;
+        for (j = 0;  j < HIST_BINS;  j++)
+            hist[j] += t[i].hist[j];
+        free(t[i].hist);
+    }
+    free(t);
+
+    if ((results = realloc(results, (n_results + 1)*sizeof(*results))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    r = &results[n_results++];
+    r->codec = c;
+    r->direction = direction;
+    r->threads = n_threads;
+    r->bytes_per_instance = (direction == DIR_ENCODE)  ?  c->enc_bytes  :  c->dec_bytes;
+    r->channel_seconds = (double) frames*c->frame_samples/c->sample_rate;
+    r->cpu_seconds = cpu_used;
+    r->wall_seconds = timespec_to_seconds(&wall_end) - timespec_to_seconds(&wall_start);
+    r->p50_us = percentile_us(hist, timed_frames, 0.50);
+    r->p90_us = percentile_us(hist, timed_frames, 0.90);
+    r->p99_us = percentile_us(hist, timed_frames, 0.99);
+    r->max_us = max_ns/1000.0;
+    free(hist);
+
+    printf("%-15s %s %3d %6d %12.1f %12.1f %9.3f %9.3f %9.3f %9.3f\n",
+           c->name,
+           (direction == DIR_ENCODE)  ?  "encode"  :  "decode",
+           n_threads,
+           (int) r->bytes_per_instance,
+           r->channel_seconds/r->cpu_seconds,
+           r->channel_seconds/r->wall_seconds,
+           r->p50_us,
+           r->p90_us,
+           r->p99_us,
+           r->max_us);
+    fflush(stdout);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int write_report(const char *name)
+{
+    bench_result_t *r;
+    FILE *f;
+    int i;
+
+    if ((f = fopen(name, "w")) == NULL)
+        return -1;
+    fprintf(f, "codec,direction,threads,sample_rate,frame_samples,bytes_per_instance,channel_seconds,cpu_seconds,"
+               "chan_sec_per_cpu_sec,chan_sec_per_wall_sec,p50_us,p90_us,p99_us,max_us\n");
+    for (i = 0;  i < n_results;  i++)
+    {
+        r = &results[i];
+        fprintf(f, "%s,%s,%d,%d,%d,%d,%.3f,%.3f,%.1f,%.1f,%.3f,%.3f,%.3f,%.3f\n",
+                r->codec->name,
+                (r->direction == DIR_ENCODE)  ?  "encode"  :  "decode",
+                r->threads,
+                r->codec->sample_rate,
+                r->codec->frame_samples,
+                (int) r->bytes_per_instance,
+                r->channel_seconds,
+                r->cpu_seconds,
+                r->channel_seconds/r->cpu_seconds,
+                r->channel_seconds/r->wall_seconds,
+                r->p50_us,
+                r->p90_us,
+                r->p99_us,
+                r->max_us);
+    }
+    fclose(f);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    const bench_codec_t *c;
+    const char *report;
+    const char *only_codec;
+    double cpu_seconds;
+    int n_threads;
+    int selected;
+    int i;
+
+    report = REPORT_FILE_NAME;
+    only_codec = NULL;
+    cpu_seconds = DEFAULT_CPU_SECONDS;
+    n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (i = 1;  i < argc;  i++)
+    {
+        if (strcmp(argv[i], "-j") == 0  &&  i + 1 < argc)
+        {
+            n_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0  &&  i + 1 < argc)
+        {
+            report = argv[++i];
+        }
+        else if (strcmp(argv[i], "-c") == 0  &&  i + 1 < argc)
+        {
+            only_codec = argv[++i];
+        }
+        else if (strcmp(argv[i], "-s") == 0  &&  i + 1 < argc)
+        {
+            cpu_seconds = atof(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: codec_bench [-j threads] [-o report.csv] [-c codec] [-s cpu-seconds]\n");
+            exit(2);
+        }
+    }
+    if (n_threads < 1)
+        n_threads = 1;
+    if (n_threads > MAX_THREADS)
+        n_threads = MAX_THREADS;
+
+    make_signal();
+
+    printf("codec           dir    thr  bytes  ch-s/cpu-s  ch-s/wall-s    p50 us    p90 us    p99 us    max us\n");
+    selected = 0;
+    for (c = codecs;  c->name;  c++)
+    {
+        /* -c picks out a codec by the start of its name, so "g726" gets all the rates */
+        if (only_codec  &&  strncmp(c->name, only_codec, strlen(only_codec)))
+            continue;
+        selected++;
+        for (i = DIR_ENCODE;  i <= DIR_DECODE;  i++)
+        {
+            if (run_bench(c, i, 1, cpu_seconds))
+                exit(2);
+            if (n_threads > 1  &&  run_bench(c, i, n_threads, cpu_seconds))
+                exit(2);
+        }
+    }
+    if (selected == 0)
+    {
+        fprintf(stderr, "No codecs selected\n");
+        exit(2);
+    }
+
+    if (write_report(report))
+    {
+        fprintf(stderr, "Cannot write report '%s'\n", report);
+        exit(2);
+    }
+    printf("\nReport in %s\n", report);
+    free(results);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
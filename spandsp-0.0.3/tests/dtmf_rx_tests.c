@@ -125,6 +125,18 @@ they wish to give it away for free.
 
 #define ALL_POSSIBLE_DIGITS         "123A456B789C*0#D"
 
+#define BANK_CHANNELS               13
+#define BANK_FRAME_LEN              160
+#define BANK_TEST_LEN               (2*16*1000)
+/* A channel is restarted on a block boundary, so it can be compared with a fresh receiver */
+#define BANK_RESET_AT               (102*150)
+
+/* The decision interval used for the sliding DFT mode */
+#define SLIDING_HOP                 8
+#define LATENCY_DIGITS              16
+#define LATENCY_SPACING             1000
+#define REPEAT_DIGITS               8
+
 #define MITEL_DIR                   "../itutests/mitel/"
 #define BELLCORE_DIR                "../itutests/bellcore/"
 
@@ -159,6 +171,8 @@ int callback_roll;
 int step;
 
 int use_dialtone_filter = FALSE;
+int use_fixed_point = FALSE;
+int use_sliding = FALSE;
 
 char *decode_test_file = NULL;
 
@@ -167,6 +181,67 @@ static int16_t amp2[1000000];
 
 codec_munge_state_t *munge = NULL;
 
+/* The tests can be run against the usual floating point receiver, that receiver
+   in its sliding DFT mode, or the integer one from tone_detect_fixed.c */
+typedef struct
+{
+    dtmf_rx_state_t f;
+    dtmf_rx_fixed_state_t i;
+} test_dtmf_rx_state_t;
+
+static void test_dtmf_rx_init(test_dtmf_rx_state_t *s,
+                              void (*callback)(void *user_data, const char *digits, int len),
+                              void *user_data)
+{
+    if (use_fixed_point)
+    {
+        dtmf_rx_fixed_init(&s->i, callback, user_data);
+    }
+    else
+    {
+        dtmf_rx_init(&s->f, callback, user_data);
+        if (use_sliding)
+            dtmf_rx_set_sliding(&s->f, SLIDING_HOP);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void test_dtmf_rx_set_realtime_callback(test_dtmf_rx_state_t *s,
+                                               void (*callback)(void *user_data, int signal),
+                                               void *user_data)
+{
+    if (use_fixed_point)
+        dtmf_rx_fixed_set_realtime_callback(&s->i, callback, user_data);
+    else
+        dtmf_rx_set_realtime_callback(&s->f, callback, user_data);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void test_dtmf_rx_parms(test_dtmf_rx_state_t *s, int filter_dialtone, int twist, int reverse_twist)
+{
+    if (use_fixed_point)
+        dtmf_rx_fixed_parms(&s->i, filter_dialtone, twist, reverse_twist);
+    else
+        dtmf_rx_parms(&s->f, filter_dialtone, twist, reverse_twist);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_dtmf_rx(test_dtmf_rx_state_t *s, const int16_t amp[], int samples)
+{
+    if (use_fixed_point)
+        return dtmf_rx_fixed(&s->i, amp, samples);
+    return dtmf_rx(&s->f, amp, samples);
+}
+/*- End of function --------------------------------------------------------*/
+
+static size_t test_dtmf_rx_get(test_dtmf_rx_state_t *s, char *buf, int max)
+{
+    if (use_fixed_point)
+        return dtmf_rx_fixed_get(&s->i, buf, max);
+    return dtmf_rx_get(&s->f, buf, max);
+}
+/*- End of function --------------------------------------------------------*/
+
 static void my_dtmf_gen_init(float low_fudge,
                              int low_level,
                              float high_fudge,
@@ -315,12 +390,12 @@ static void mitel_cm7291_side_1_tests(void)
     int nminus;
     float rrb;
     float rcfo;
-    dtmf_rx_state_t dtmf_state;
+    test_dtmf_rx_state_t dtmf_state;
     awgn_state_t noise_source;
 
-    dtmf_rx_init(&dtmf_state, NULL, NULL);
+    test_dtmf_rx_init(&dtmf_state, NULL, NULL);
     if (use_dialtone_filter)
-        dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
+        test_dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
 
     /* Test 1: Mitel's test 1 isn't really a test. Its a calibration step,
        which has no meaning here. */
@@ -343,9 +418,9 @@ static void mitel_cm7291_side_1_tests(void)
         {
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
+            test_dtmf_rx(&dtmf_state, amp, len);
 
-            actual = dtmf_rx_get(&dtmf_state, buf, 128);
+            actual = test_dtmf_rx_get(&dtmf_state, buf, 128);
 
             if (actual != 1  ||  buf[0] != digit[0])
             {
@@ -397,16 +472,16 @@ static void mitel_cm7291_side_1_tests(void)
             my_dtmf_gen_init((float) i/1000.0f, -17, 0.0f, -17, 50, 50);
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
-            nplus += dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, len);
+            nplus += test_dtmf_rx_get(&dtmf_state, buf, 128);
         }
         for (nminus = 0, i = -1;  i >= -60;  i--)
         {
             my_dtmf_gen_init((float) i/1000.0f, -17, 0.0f, -17, 50, 50);
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
-            nminus += dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, len);
+            nminus += test_dtmf_rx_get(&dtmf_state, buf, 128);
         }
         rrb = (float) (nplus + nminus)/10.0f;
         rcfo = (float) (nplus - nminus)/10.0f;
@@ -427,16 +502,16 @@ static void mitel_cm7291_side_1_tests(void)
             my_dtmf_gen_init(0.0f, -17, (float) i/1000.0f, -17, 50, 50);
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
-            nplus += dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, len);
+            nplus += test_dtmf_rx_get(&dtmf_state, buf, 128);
         }
         for (nminus = 0, i = -1;  i >= -60;  i--)
         {
             my_dtmf_gen_init(0.0f, -17, (float) i/1000.0f, -17, 50, 50);
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
-            nminus += dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, len);
+            nminus += test_dtmf_rx_get(&dtmf_state, buf, 128);
         }
         rrb = (float) (nplus + nminus)/10.0f;
         rcfo = (float) (nplus - nminus)/10.0f;
@@ -489,8 +564,8 @@ static void mitel_cm7291_side_1_tests(void)
 
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
-            nplus += dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, len);
+            nplus += test_dtmf_rx_get(&dtmf_state, buf, 128);
         }
         printf("    %c normal twist  = %.2fdB\n", digit[0], (float) nplus/10.0);
         if (nplus < 80)
@@ -504,8 +579,8 @@ static void mitel_cm7291_side_1_tests(void)
 
             len = my_dtmf_generate(amp, digit);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
-            nminus += dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, len);
+            nminus += test_dtmf_rx_get(&dtmf_state, buf, 128);
         }
         printf("    %c reverse twist = %.2fdB\n", digit[0], (float) nminus/10.0);
         if (nminus < 40)
@@ -532,8 +607,8 @@ static void mitel_cm7291_side_1_tests(void)
 
         len = my_dtmf_generate(amp, "1");
         codec_munge(munge, amp, len);
-        dtmf_rx(&dtmf_state, amp, len);
-        nplus += dtmf_rx_get(&dtmf_state, buf, 128);
+        test_dtmf_rx(&dtmf_state, amp, len);
+        nplus += test_dtmf_rx_get(&dtmf_state, buf, 128);
     }
     printf("    Dynamic range = %ddB\n", nplus);
     printf("    Passed\n");
@@ -554,8 +629,8 @@ static void mitel_cm7291_side_1_tests(void)
 
         len = my_dtmf_generate(amp, "1");
         codec_munge(munge, amp, len);
-        dtmf_rx(&dtmf_state, amp, len);
-        nplus += dtmf_rx_get(&dtmf_state, buf, 128);
+        test_dtmf_rx(&dtmf_state, amp, len);
+        nplus += test_dtmf_rx_get(&dtmf_state, buf, 128);
     }
     printf("    Guard time = %dms\n", (500 - nplus)/10);
     printf("    Passed\n");
@@ -587,9 +662,9 @@ static void mitel_cm7291_side_1_tests(void)
                 amp[sample] = saturate(amp[sample] + awgn(&noise_source));
             
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
+            test_dtmf_rx(&dtmf_state, amp, len);
 
-            if (dtmf_rx_get(&dtmf_state, buf, 128) != 1)
+            if (test_dtmf_rx_get(&dtmf_state, buf, 128) != 1)
                 break;
         }
         if (i == 1000)
@@ -616,11 +691,11 @@ static void mitel_cm7291_side_2_and_bellcore_tests(void)
     AFfilehandle inhandle;
     int frames;
     float x;
-    dtmf_rx_state_t dtmf_state;
+    test_dtmf_rx_state_t dtmf_state;
 
-    dtmf_rx_init(&dtmf_state, NULL, NULL);
+    test_dtmf_rx_init(&dtmf_state, NULL, NULL);
     if (use_dialtone_filter)
-        dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
+        test_dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
 
     /* The remainder of the Mitel tape is the talk-off test */
     /* Here we use the Bellcore test tapes (much tougher), in six
@@ -655,8 +730,8 @@ static void mitel_cm7291_side_2_and_bellcore_tests(void)
         hits = 0;
         while ((frames = afReadFrames(inhandle, AF_DEFAULT_TRACK, amp, SAMPLE_RATE)))
         {
-            dtmf_rx(&dtmf_state, amp, frames);
-            len = dtmf_rx_get(&dtmf_state, buf, 128);
+            test_dtmf_rx(&dtmf_state, amp, frames);
+            len = test_dtmf_rx_get(&dtmf_state, buf, 128);
             if (len > 0)
             {
                 for (i = 0;  i < len;  i++)
@@ -696,13 +771,13 @@ static void dial_tone_tolerance_tests(void)
     int len;
     int sample;
     char buf[128 + 1];
-    dtmf_rx_state_t dtmf_state;
+    test_dtmf_rx_state_t dtmf_state;
     tone_gen_descriptor_t dial_tone_desc;
     tone_gen_state_t dial_tone;
 
-    dtmf_rx_init(&dtmf_state, NULL, NULL);
+    test_dtmf_rx_init(&dtmf_state, NULL, NULL);
     if (use_dialtone_filter)
-        dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
+        test_dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
 
     /* Test dial tone tolerance */
     printf("Test: Dial tone tolerance.\n");
@@ -720,9 +795,9 @@ static void dial_tone_tolerance_tests(void)
             for (sample = 0;  sample < len;  sample++)
                 amp[sample] = saturate(amp[sample] + amp2[sample]);
             codec_munge(munge, amp, len);
-            dtmf_rx(&dtmf_state, amp, len);
+            test_dtmf_rx(&dtmf_state, amp, len);
 
-            if (dtmf_rx_get(&dtmf_state, buf, 128) != strlen(ALL_POSSIBLE_DIGITS))
+            if (test_dtmf_rx_get(&dtmf_state, buf, 128) != strlen(ALL_POSSIBLE_DIGITS))
                 break;
         }
         if (i != 10)
@@ -746,23 +821,23 @@ static void callback_function_tests(void)
     int j;
     int len;
     int sample;
-    dtmf_rx_state_t dtmf_state;
+    test_dtmf_rx_state_t dtmf_state;
 
     /* Test the callback mode for delivering detected digits */
     printf("Test: Callback digit delivery mode.\n");
     callback_hit = FALSE;
     callback_ok = TRUE;
     callback_roll = 0;
-    dtmf_rx_init(&dtmf_state, digit_delivery, (void *) 0x12345678);
+    test_dtmf_rx_init(&dtmf_state, digit_delivery, (void *) 0x12345678);
     if (use_dialtone_filter)
-        dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
+        test_dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
     my_dtmf_gen_init(0.0f, -10, 0.0f, -10, 50, 50);
     for (i = 1;  i < 10;  i++)
     {
         len = 0;
         for (j = 0;  j < i;  j++)
             len += my_dtmf_generate(amp + len, ALL_POSSIBLE_DIGITS);
-        dtmf_rx(&dtmf_state, amp, len);
+        test_dtmf_rx(&dtmf_state, amp, len);
         if (!callback_hit  ||  !callback_ok)
             break;
     }
@@ -778,10 +853,10 @@ static void callback_function_tests(void)
     callback_hit = FALSE;
     callback_ok = TRUE;
     callback_roll = 0;
-    dtmf_rx_init(&dtmf_state, NULL, NULL);
-    dtmf_rx_set_realtime_callback(&dtmf_state, digit_status, (void *) 0x12345678);
+    test_dtmf_rx_init(&dtmf_state, NULL, NULL);
+    test_dtmf_rx_set_realtime_callback(&dtmf_state, digit_status, (void *) 0x12345678);
     if (use_dialtone_filter)
-        dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
+        test_dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
     my_dtmf_gen_init(0.0f, -10, 0.0f, -10, 50, 50);
     step = 0;
     for (i = 1;  i < 10;  i++)
@@ -791,7 +866,7 @@ static void callback_function_tests(void)
             len += my_dtmf_generate(amp + len, ALL_POSSIBLE_DIGITS);
         for (sample = 0, j = 160;  sample < len;  sample += 160, j = ((len - sample) >= 160)  ?  160  :  (len - sample))
         {
-            dtmf_rx(&dtmf_state, &amp[sample], j);
+            test_dtmf_rx(&dtmf_state, &amp[sample], j);
             if (!callback_ok)
                 break;
             step += j;
@@ -807,19 +882,327 @@ static void callback_function_tests(void)
 }
 /*- End of function --------------------------------------------------------*/
 
+typedef struct
+{
+    int position;
+    int reports;
+    int report_at[LATENCY_DIGITS];
+    char report_digit[LATENCY_DIGITS];
+} latency_log_t;
+
+static void latency_status(void *data, int signal)
+{
+    latency_log_t *log;
+
+    log = (latency_log_t *) data;
+    if (signal  &&  log->reports < LATENCY_DIGITS)
+    {
+        log->report_at[log->reports] = log->position;
+        log->report_digit[log->reports++] = (char) signal;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void sliding_dft_tests(void)
+{
+    dtmf_rx_state_t block_rx;
+    dtmf_rx_state_t sliding_rx;
+    latency_log_t block_log;
+    latency_log_t sliding_log;
+    awgn_state_t noise_source;
+    int onset[LATENCY_DIGITS];
+    int block_latency;
+    int sliding_latency;
+    int worst_onset_error;
+    int error;
+    int len;
+    int i;
+
+    /* Compare how quickly the block and sliding DFT modes report the same
+       digits, and how well the sliding DFT mode finds where they start. The
+       digits start at varied offsets from the block boundaries. */
+    printf("Test: Sliding DFT mode latency and onset accuracy.\n");
+    len = LATENCY_DIGITS*LATENCY_SPACING;
+    memset(amp, 0, len*sizeof(amp[0]));
+    my_dtmf_gen_init(0.0f, -10, 0.0f, -10, 50, 50);
+    for (i = 0;  i < LATENCY_DIGITS;  i++)
+    {
+        onset[i] = i*LATENCY_SPACING + 100 + (i*37)%102;
+        my_dtmf_generate(amp + onset[i], (char []) {ALL_POSSIBLE_DIGITS[i], '\0'});
+    }
+    awgn_init_dbm0(&noise_source, 1234567, -40.0f);
+    for (i = 0;  i < len;  i++)
+        amp[i] = saturate(amp[i] + awgn(&noise_source));
+
+    dtmf_rx_init(&block_rx, NULL, NULL);
+    dtmf_rx_set_realtime_callback(&block_rx, latency_status, &block_log);
+    dtmf_rx_init(&sliding_rx, NULL, NULL);
+    dtmf_rx_set_realtime_callback(&sliding_rx, latency_status, &sliding_log);
+    if (dtmf_rx_set_sliding(&sliding_rx, SLIDING_HOP))
+    {
+        printf("    Failed to select the sliding DFT mode\n");
+        exit(2);
+    }
+    memset(&block_log, 0, sizeof(block_log));
+    memset(&sliding_log, 0, sizeof(sliding_log));
+    worst_onset_error = 0;
+    /* Feed the audio a sample at a time, so the reports are timed exactly */
+    for (i = 0;  i < len;  i++)
+    {
+        block_log.position =
+        sliding_log.position = i + 1;
+        dtmf_rx(&block_rx, &amp[i], 1);
+        dtmf_rx(&sliding_rx, &amp[i], 1);
+        if (sliding_log.position == sliding_log.report_at[sliding_log.reports - 1]  &&  sliding_log.reports > 0)
+        {
+            error = abs((int) dtmf_rx_onset(&sliding_rx) - onset[sliding_log.reports - 1]);
+            if (error > worst_onset_error)
+                worst_onset_error = error;
+        }
+    }
+    if (block_log.reports != LATENCY_DIGITS
+        ||
+        sliding_log.reports != LATENCY_DIGITS
+        ||
+        memcmp(block_log.report_digit, ALL_POSSIBLE_DIGITS, LATENCY_DIGITS)
+        ||
+        memcmp(sliding_log.report_digit, ALL_POSSIBLE_DIGITS, LATENCY_DIGITS))
+    {
+        printf("    The digits were not all reported\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    block_latency = 0;
+    sliding_latency = 0;
+    for (i = 0;  i < LATENCY_DIGITS;  i++)
+    {
+        block_latency += block_log.report_at[i] - onset[i];
+        sliding_latency += sliding_log.report_at[i] - onset[i];
+    }
+    printf("    Mean latency %.1fms in block mode, %.1fms in sliding DFT mode\n",
+           block_latency/(8.0*LATENCY_DIGITS),
+           sliding_latency/(8.0*LATENCY_DIGITS));
+    printf("    Worst onset error %d samples\n", worst_onset_error);
+    if (sliding_latency >= block_latency  ||  worst_onset_error > 2*SLIDING_HOP)
+    {
+        printf("    Failed\n");
+        exit(2);
+    }
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
+static void sliding_repeat_tests(void)
+{
+    static const int cadences[][2] =
+    {
+        {100, 50},
+        {200, 45},
+        {0, 0}
+    };
+    dtmf_rx_state_t sliding_rx;
+    latency_log_t sliding_log;
+    tone_gen_state_t tone;
+    int onset[REPEAT_DIGITS];
+    int onset_error;
+    int latency;
+    int first_latency;
+    int len;
+    int i;
+    int j;
+
+    /* The same digit, sent again and again with short gaps, must be found
+       afresh each time. None of the evidence for one burst may carry over to
+       the next, to start it early or late. */
+    printf("Test: Sliding DFT mode with a repeated digit.\n");
+    for (j = 0;  cadences[j][0];  j++)
+    {
+        len = (REPEAT_DIGITS + 1)*(cadences[j][0] + cadences[j][1])*8;
+        memset(amp, 0, len*sizeof(amp[0]));
+        my_dtmf_gen_init(0.0f, -10, 0.0f, -10, cadences[j][0], 0);
+        for (i = 0;  i < REPEAT_DIGITS;  i++)
+        {
+            onset[i] = 999 + i*(cadences[j][0] + cadences[j][1])*8;
+            tone_gen_init(&tone, &my_dtmf_digit_tones[5]);
+            tone_gen(&tone, amp + onset[i], cadences[j][0]*8);
+        }
+        dtmf_rx_init(&sliding_rx, NULL, NULL);
+        dtmf_rx_set_realtime_callback(&sliding_rx, latency_status, &sliding_log);
+        dtmf_rx_set_sliding(&sliding_rx, SLIDING_HOP);
+        memset(&sliding_log, 0, sizeof(sliding_log));
+        first_latency = 0;
+        for (i = 0;  i < len;  i++)
+        {
+            sliding_log.position = i + 1;
+            dtmf_rx(&sliding_rx, &amp[i], 1);
+            if (sliding_log.reports > 0  &&  sliding_log.position == sliding_log.report_at[sliding_log.reports - 1])
+            {
+                onset_error = abs((int) dtmf_rx_onset(&sliding_rx) - onset[sliding_log.reports - 1]);
+                latency = sliding_log.report_at[sliding_log.reports - 1] - onset[sliding_log.reports - 1];
+                if (sliding_log.reports == 1)
+                    first_latency = latency;
+                if (onset_error > 2*SLIDING_HOP
+                    ||
+                    latency < DTMF_BLOCK_LEN
+                    ||
+                    latency > first_latency + 2*SLIDING_HOP)
+                {
+                    printf("    %dms on, %dms off - repeat %d has onset error %d samples, latency %d samples\n",
+                           cadences[j][0], cadences[j][1], sliding_log.reports, onset_error, latency);
+                    printf("    Failed\n");
+                    exit(2);
+                }
+            }
+        }
+        if (sliding_log.reports != REPEAT_DIGITS)
+        {
+            printf("    %dms on, %dms off - %d of %d repeats reported\n", cadences[j][0], cadences[j][1], sliding_log.reports, REPEAT_DIGITS);
+            printf("    Failed\n");
+            exit(2);
+        }
+        printf("    %dms on, %dms off - %d repeats OK, latency %.1fms\n",
+               cadences[j][0], cadences[j][1], REPEAT_DIGITS, first_latency/8.0);
+    }
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_test_signal(int16_t amp[], int chan, int len)
+{
+    char digits[2*16 + 1];
+    tone_gen_descriptor_t dial_tone_desc;
+    tone_gen_state_t dial_tone;
+    awgn_state_t noise_source;
+    int i;
+    int n;
+
+    /* Give each channel its own digits, levels, timing, and impairments */
+    for (i = 0;  i < 2*16;  i++)
+        digits[i] = ALL_POSSIBLE_DIGITS[(i + chan)%16];
+    digits[2*16] = '\0';
+    my_dtmf_gen_init(0.005f*(chan%5 - 2),
+                     -4 - chan,
+                     -0.004f*(chan%3 - 1),
+                     -4 - (3*chan)%17,
+                     40 + 10*(chan%4),
+                     50);
+    n = my_dtmf_generate(amp, digits);
+    for (i = n;  i < len;  i++)
+        amp[i] = 0;
+    if ((chan & 1))
+    {
+        make_tone_gen_descriptor(&dial_tone_desc, 350, -30 + chan, 440, -30 + chan, 1, 0, 0, 0, TRUE);
+        tone_gen_init(&dial_tone, &dial_tone_desc);
+        tone_gen(&dial_tone, amp2, len);
+        for (i = 0;  i < len;  i++)
+            amp[i] = saturate(amp[i] + amp2[i]);
+    }
+    else
+    {
+        awgn_init_dbm0(&noise_source, 1234567 + chan, -40.0f + chan);
+        for (i = 0;  i < len;  i++)
+            amp[i] = saturate(amp[i] + awgn(&noise_source));
+    }
+    codec_munge(munge, amp, len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_tests(void)
+{
+    static int16_t bank_amp[BANK_CHANNELS][BANK_TEST_LEN];
+    char ref_digits[BANK_CHANNELS][128 + 1];
+    char bank_digits[BANK_CHANNELS][128 + 1];
+    char buf[128 + 1];
+    dtmf_rx_state_t ref[BANK_CHANNELS];
+    dtmf_rx_bank_state_t *bank;
+    const int16_t *amp_in[BANK_CHANNELS];
+    int filter;
+    int total;
+    int len;
+    int c;
+    int i;
+
+    /* Test a bank of receivers gives the same digits as separate ones */
+    printf("Test: DTMF receiver bank.\n");
+    for (c = 0;  c < BANK_CHANNELS;  c++)
+        bank_test_signal(bank_amp[c], c, BANK_TEST_LEN);
+    for (filter = FALSE;  filter <= TRUE;  filter++)
+    {
+        if ((bank = dtmf_rx_bank_init(NULL, BANK_CHANNELS, NULL, NULL)) == NULL)
+        {
+            printf("    Failed to create the bank\n");
+            exit(2);
+        }
+        dtmf_rx_bank_parms(bank, filter, -1, -1);
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            dtmf_rx_init(&ref[c], NULL, NULL);
+            dtmf_rx_parms(&ref[c], filter, -1, -1);
+            ref_digits[c][0] = '\0';
+            bank_digits[c][0] = '\0';
+        }
+        for (i = 0;  i < BANK_TEST_LEN;  i += len)
+        {
+            len = BANK_FRAME_LEN;
+            if (i < BANK_RESET_AT  &&  i + len > BANK_RESET_AT)
+                len = BANK_RESET_AT - i;
+            /* Restart one channel part way through, as for a new call */
+            if (i == BANK_RESET_AT)
+            {
+                dtmf_rx_init(&ref[5], NULL, NULL);
+                dtmf_rx_parms(&ref[5], filter, -1, -1);
+                dtmf_rx_bank_reset_channel(bank, 5);
+            }
+            for (c = 0;  c < BANK_CHANNELS;  c++)
+            {
+                amp_in[c] = &bank_amp[c][i];
+                dtmf_rx(&ref[c], amp_in[c], len);
+                dtmf_rx_get(&ref[c], buf, 128);
+                strcat(ref_digits[c], buf);
+            }
+            dtmf_rx_bank(bank, amp_in, len);
+            for (c = 0;  c < BANK_CHANNELS;  c++)
+            {
+                dtmf_rx_get(dtmf_rx_bank_channel(bank, c), buf, 128);
+                strcat(bank_digits[c], buf);
+            }
+        }
+        total = 0;
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            if (strcmp(ref_digits[c], bank_digits[c]))
+            {
+                printf("    Channel %d: expected '%s', got '%s'\n", c, ref_digits[c], bank_digits[c]);
+                printf("    Failed\n");
+                exit(2);
+            }
+            total += strlen(ref_digits[c]);
+        }
+        dtmf_rx_bank_release(bank);
+        printf("    %d digits received across %d channels, with the dial tone filter %s\n", total, BANK_CHANNELS, (filter)  ?  "on"  :  "off");
+        if (total == 0)
+        {
+            printf("    Failed\n");
+            exit(2);
+        }
+    }
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
 static void decode_test(const char *test_file)
 {
     int16_t amp[160];
     AFfilehandle inhandle;
-    dtmf_rx_state_t dtmf_state;
+    test_dtmf_rx_state_t dtmf_state;
     char buf[128 + 1];
     int actual;
     int samples;
     int total;
 
-    dtmf_rx_init(&dtmf_state, NULL, NULL);
+    test_dtmf_rx_init(&dtmf_state, NULL, NULL);
     if (use_dialtone_filter)
-        dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
+        test_dtmf_rx_parms(&dtmf_state, TRUE, -1, -1);
 
     /* We will decode the audio from a wave file. */
     
@@ -833,8 +1216,8 @@ static void decode_test(const char *test_file)
     while ((samples = afReadFrames(inhandle, AF_DEFAULT_TRACK, amp, 160)) > 0)
     {
         codec_munge(munge, amp, samples);
-        dtmf_rx(&dtmf_state, amp, samples);
-        if ((actual = dtmf_rx_get(&dtmf_state, buf, 128)) > 0)
+        test_dtmf_rx(&dtmf_state, amp, samples);
+        if ((actual = test_dtmf_rx_get(&dtmf_state, buf, 128)) > 0)
             printf("Received '%s'\n", buf);
         total += actual;
     }
@@ -850,6 +1233,8 @@ int main(int argc, char *argv[])
     int channel_codec;
 
     use_dialtone_filter = FALSE;
+    use_fixed_point = FALSE;
+    use_sliding = FALSE;
     channel_codec = MUNGE_CODEC_NONE;
     decode_test_file = NULL;
     for (i = 1;  i < argc;  i++)
@@ -869,6 +1254,16 @@ int main(int argc, char *argv[])
             use_dialtone_filter = TRUE;
             continue;
         }
+        if (strcmp(argv[i], "-i") == 0)
+        {
+            use_fixed_point = TRUE;
+            continue;
+        }
+        if (strcmp(argv[i], "-s") == 0)
+        {
+            use_sliding = TRUE;
+            continue;
+        }
     }
     munge = codec_munge_init(channel_codec);
 
@@ -880,8 +1275,11 @@ int main(int argc, char *argv[])
     {
         time(&now);
         mitel_cm7291_side_1_tests();
+        bank_tests();
         mitel_cm7291_side_2_and_bellcore_tests();
         dial_tone_tolerance_tests();
+        sliding_dft_tests();
+        sliding_repeat_tests();
         callback_function_tests();
         printf("    Passed\n");
         duration = time(NULL) - now;
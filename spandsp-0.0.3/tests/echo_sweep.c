@@ -0,0 +1,683 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * echo_sweep.c - Sweep the echo canceller tuning constants over the G.168
+ *                line models and some speech samples, in parallel.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \page echo_sweep_page Echo canceller tuning sweeper
+\section echo_sweep_page_sec_1 What does it do?
+The echo canceller's tuning constants (see echo_can_tuning_t) were picked by
+hand. This program tries every combination of a set of values for some of
+them, over a set of echo paths and speech samples, and scores each
+combination, so the canceller can be tuned for a particular mix of trunks.
+
+\section echo_sweep_page_sec_2 How does it work?
+Each combination of tuning values is run against every scenario, which is
+one of the G.168 line models at an ERL, with one pair of far end and near
+end speech files. Every run has its own canceller and line model, so the
+runs are spread over all the CPUs with a pool of worker threads. A run is:
+
+    - 5s of far end speech only. The convergence time is taken from
+      echo_can_get_stats(), and the ERLE of the linear canceller is measured
+      over the last 500ms.
+    - 2s of double talk, with the near end at the same level.
+    - 1s of far end speech only. The ERLE over the first 500ms is compared
+      with the ERLE before the double talk. The loss is the double talk
+      divergence.
+
+The combinations are listed best first, by a crude figure of merit:
+
+    score = mean ERLE - 2*(mean divergence) - (mean convergence time)/100ms
+
+all in dB. Runs which never converge count as converging at the end of the
+first phase.
+
+\section echo_sweep_page_sec_3 How do I use it?
+Give each tuning constant to sweep as -p name=values, where the values are
+a comma separated list or a lo:hi:step range. Constants which aren't swept
+keep their defaults. For example:
+
+    ./echo_sweep -p dtd_hangover=200:1000:200 -p transfer_count=2,4,6,8
+
+By default all 8 line models are used at 6dB and 10dB ERL, with the G.168
+speech samples, sound_c1_8k.wav and sound_c3_8k.wav, each way round.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <audiofile.h>
+#include <tiffio.h>
+#if defined(HAVE_TGMATH_H)
+#include <tgmath.h>
+#endif
+#if defined(HAVE_MATH_H)
+#include <math.h>
+#endif
+
+#include "spandsp.h"
+#include "spandsp/g168models.h"
+
+#if !defined(NULL)
+#define NULL (void *) 0
+#endif
+
+#define SAMPLE_RATE         8000
+#define TAPS                256
+#define MAX_SIGNAL_LEN      (60*SAMPLE_RATE)
+#define MAX_THREADS         256
+#define MAX_VALUES          64
+#define MAX_ERLS            16
+#define MAX_WAVS            16
+
+/* Levels, as in echo_tests */
+#define SPEECH_LEVEL        -15.0
+#define CSS_SCALE           5.60
+
+/* The phases of a run, in samples */
+#define CONVERGE_LEN        (5*SAMPLE_RATE)
+#define DOUBLE_TALK_LEN     (2*SAMPLE_RATE)
+#define RECOVER_LEN         (1*SAMPLE_RATE)
+#define ERLE_WINDOW         (SAMPLE_RATE/2)
+
+/* The tuning constants which can be swept */
+#define TUNING(x) #x, offsetof(echo_can_tuning_t, x)
+
+typedef struct
+{
+    const char *name;
+    size_t offset;
+    int n_values;
+    int values[MAX_VALUES];
+} tuning_param_t;
+
+static tuning_param_t params[] =
+{
+    {TUNING(min_tx_power)},
+    {TUNING(min_rx_power)},
+    {TUNING(dtd_hangover)},
+    {TUNING(transfer_fg_eighths)},
+    {TUNING(transfer_tx_eighths)},
+    {TUNING(transfer_count)},
+    {TUNING(nlp_ratio)},
+    {TUNING(bgn_max_level)},
+    {NULL, 0}
+};
+
+typedef struct
+{
+    const char *name;
+    int16_t *amp;
+    int len;
+} speech_t;
+
+typedef struct
+{
+    int model;
+    float erl;
+    speech_t *far;
+    speech_t *near;
+} scenario_t;
+
+typedef struct
+{
+    echo_can_tuning_t tuning;
+    float conv_mean;
+    float conv_worst;
+    float erle_mean;
+    float erle_worst;
+    float div_mean;
+    float div_worst;
+    float score;
+} config_t;
+
+typedef struct
+{
+    float conv;
+    float erle;
+    float div;
+} run_result_t;
+
+static speech_t speech[MAX_WAVS];
+static int n_speech;
+
+static scenario_t *scenarios;
+static int n_scenarios;
+
+static config_t *configs;
+static int n_configs;
+
+static run_result_t *results;
+static int n_runs;
+static int next_run;
+static int done_runs;
+static pthread_mutex_t run_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void speech_load(speech_t *s, const char *name)
+{
+    AFfilehandle handle;
+
+    s->name = name;
+    if ((handle = afOpenFile(name, "r", 0)) == AF_NULL_FILEHANDLE)
+    {
+        fprintf(stderr, "    Cannot open wave file '%s'\n", name);
+        exit(2);
+    }
+    if (afGetFrameSize(handle, AF_DEFAULT_TRACK, 1) != 2.0
+        ||
+        afGetRate(handle, AF_DEFAULT_TRACK) != (float) SAMPLE_RATE
+        ||
+        afGetChannels(handle, AF_DEFAULT_TRACK) != 1.0)
+    {
+        fprintf(stderr, "    '%s' is not 8000 samples/s 16 bit mono\n", name);
+        exit(2);
+    }
+    if ((s->amp = malloc(MAX_SIGNAL_LEN*sizeof(int16_t))) == NULL)
+    {
+        fprintf(stderr, "    Out of memory\n");
+        exit(2);
+    }
+    s->len = afReadFrames(handle, AF_DEFAULT_TRACK, s->amp, MAX_SIGNAL_LEN);
+    if (s->len <= 0)
+    {
+        fprintf(stderr, "    Error reading sound file '%s'\n", name);
+        exit(2);
+    }
+    afCloseFile(handle);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int16_t clip(float x)
+{
+    if (x > 32767.0)
+        return 32767;
+    if (x < -32767.0)
+        return -32767;
+    return (int16_t) x;
+}
+/*- End of function --------------------------------------------------------*/
+
+static inline int16_t codec_munge(int16_t amp)
+{
+    return ulaw_to_linear(linear_to_ulaw(amp));
+}
+/*- End of function --------------------------------------------------------*/
+
+static float erle_db(double rx_power, double clean_power)
+{
+    if (clean_power < 1.0)
+        clean_power = 1.0;
+    if (rx_power < 1.0)
+        rx_power = 1.0;
+    return 10.0*log10(rx_power/clean_power);
+}
+/*- End of function --------------------------------------------------------*/
+
+/* One run of a set of tuning values against a scenario. The line model is
+   the same as echo_tests, with u-law munging. */
+static void run(const echo_can_tuning_t *tuning, const scenario_t *sc, run_result_t *result)
+{
+    echo_can_state_t *ec;
+    echo_can_stats_t stats;
+    fir32_state_t line;
+    float level;
+    float echo_gain;
+    double rx_power;
+    double clean_power;
+    float erle_before;
+    int16_t tx;
+    int16_t rx;
+    int16_t near;
+    int16_t echo;
+    int far_pos;
+    int near_pos;
+    int i;
+
+    ec = echo_can_create(TAPS, ECHO_CAN_USE_ADAPTION | ECHO_CAN_USE_NLP);
+    if (ec == NULL  ||  fir32_create(&line, g168_line_models[sc->model - 1], g168_line_model_sizes[sc->model - 1]) == NULL)
+    {
+        fprintf(stderr, "    Out of memory\n");
+        exit(2);
+    }
+    echo_can_set_tuning(ec, tuning);
+    level = pow(10.0, SPEECH_LEVEL/20.0)*CSS_SCALE;
+    echo_gain = pow(10.0, -sc->erl/20.0)*32768.0*g168_line_model_ki[sc->model - 1];
+
+    far_pos = 0;
+    near_pos = 0;
+    rx_power = 0.0;
+    clean_power = 0.0;
+    erle_before = 0.0;
+    result->conv = CONVERGE_LEN*1000.0/SAMPLE_RATE;
+    for (i = 0;  i < CONVERGE_LEN + DOUBLE_TALK_LEN + RECOVER_LEN;  i++)
+    {
+        tx = codec_munge(clip(level*sc->far->amp[far_pos]));
+        if (++far_pos >= sc->far->len)
+            far_pos = 0;
+        near = 0;
+        if (i >= CONVERGE_LEN  &&  i < CONVERGE_LEN + DOUBLE_TALK_LEN)
+        {
+            near = codec_munge(clip(level*sc->near->amp[near_pos]));
+            if (++near_pos >= sc->near->len)
+                near_pos = 0;
+        }
+        echo = fir32(&line, tx*echo_gain);
+        rx = codec_munge(clip(echo + near));
+
+        echo_can_update(ec, echo_can_hpf_tx(ec, tx), rx);
+
+        /* ERLE of the linear part of the canceller, at the end of the
+           first phase and the start of the last. The canceller works on
+           rx halved, and ec->clean is on that scale, so rx must be too. */
+        if ((i >= CONVERGE_LEN - ERLE_WINDOW  &&  i < CONVERGE_LEN)
+            ||
+            (i >= CONVERGE_LEN + DOUBLE_TALK_LEN  &&  i < CONVERGE_LEN + DOUBLE_TALK_LEN + ERLE_WINDOW))
+        {
+            rx_power += (double) (ec->rx >> 1)*(ec->rx >> 1);
+            clean_power += (double) ec->clean*ec->clean;
+        }
+        if (i == CONVERGE_LEN - 1)
+        {
+            erle_before = erle_db(rx_power, clean_power);
+            echo_can_get_stats(ec, &stats);
+            if (stats.converge_time >= 0)
+                result->conv = stats.converge_time;
+            rx_power = 0.0;
+            clean_power = 0.0;
+        }
+    }
+    result->erle = erle_before;
+    result->div = erle_before - erle_db(rx_power, clean_power);
+
+    fir32_free(&line);
+    echo_can_free(ec);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *worker(void *arg)
+{
+    int n;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&run_lock);
+        n = (next_run < n_runs)  ?  next_run++  :  -1;
+        pthread_mutex_unlock(&run_lock);
+        if (n < 0)
+            break;
+
+        run(&configs[n/n_scenarios].tuning, &scenarios[n%n_scenarios], &results[n]);
+
+        pthread_mutex_lock(&run_lock);
+        if ((++done_runs % 100) == 0  ||  done_runs == n_runs)
+        {
+            fprintf(stderr, "\r%d/%d runs", done_runs, n_runs);
+            if (done_runs == n_runs)
+                fprintf(stderr, "\n");
+        }
+        pthread_mutex_unlock(&run_lock);
+    }
+    return NULL;
+}
+/*- End of function --------------------------------------------------------*/
+
+static tuning_param_t *find_param(const char *name, size_t len)
+{
+    tuning_param_t *p;
+
+    for (p = params;  p->name;  p++)
+    {
+        if (strlen(p->name) == len  &&  strncmp(p->name, name, len) == 0)
+            return p;
+    }
+    return NULL;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Parse name=v1,v2,... or name=lo:hi:step */
+static int parse_param(const char *s)
+{
+    tuning_param_t *p;
+    const char *eq;
+    int lo;
+    int hi;
+    int step;
+    int v;
+
+    if ((eq = strchr(s, '=')) == NULL  ||  (p = find_param(s, eq - s)) == NULL)
+        return -1;
+    s = eq + 1;
+    p->n_values = 0;
+    if (sscanf(s, "%d:%d:%d", &lo, &hi, &step) == 3)
+    {
+        if (step <= 0)
+            return -1;
+        for (v = lo;  v <= hi  &&  p->n_values < MAX_VALUES;  v += step)
+            p->values[p->n_values++] = v;
+        return 0;
+    }
+    while (*s  &&  p->n_values < MAX_VALUES)
+    {
+        p->values[p->n_values++] = atoi(s);
+        if ((s = strchr(s, ',')) == NULL)
+            break;
+        s++;
+    }
+    return (p->n_values > 0)  ?  0  :  -1;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Every combination of the swept values */
+static void build_configs(void)
+{
+    echo_can_tuning_t defaults;
+    tuning_param_t *p;
+    int i;
+    int n;
+
+    echo_can_default_tuning(&defaults);
+    n_configs = 1;
+    for (p = params;  p->name;  p++)
+    {
+        if (p->n_values)
+            n_configs *= p->n_values;
+    }
+    if ((configs = calloc(n_configs, sizeof(*configs))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    for (i = 0;  i < n_configs;  i++)
+    {
+        configs[i].tuning = defaults;
+        n = i;
+        for (p = params;  p->name;  p++)
+        {
+            if (p->n_values == 0)
+                continue;
+            *(int *) ((char *) &configs[i].tuning + p->offset) = p->values[n%p->n_values];
+            n /= p->n_values;
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void build_scenarios(const float erls[], int n_erls)
+{
+    int m;
+    int e;
+    int w;
+
+    n_scenarios = G168_LINE_MODELS*n_erls*n_speech;
+    if ((scenarios = calloc(n_scenarios, sizeof(*scenarios))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    n_scenarios = 0;
+    for (m = 1;  m <= G168_LINE_MODELS;  m++)
+    {
+        for (e = 0;  e < n_erls;  e++)
+        {
+            /* Each speech file as far end speech, with the next one as the
+               near end */
+            for (w = 0;  w < n_speech;  w++)
+            {
+                scenarios[n_scenarios].model = m;
+                scenarios[n_scenarios].erl = erls[e];
+                scenarios[n_scenarios].far = &speech[w];
+                scenarios[n_scenarios].near = &speech[(w + 1)%n_speech];
+                n_scenarios++;
+            }
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void score_configs(void)
+{
+    config_t *c;
+    run_result_t *r;
+    int i;
+    int j;
+
+    for (i = 0;  i < n_configs;  i++)
+    {
+        c = &configs[i];
+        c->conv_worst = 0.0;
+        c->erle_worst = 1000.0;
+        c->div_worst = -1000.0;
+        for (j = 0;  j < n_scenarios;  j++)
+        {
+            r = &results[i*n_scenarios + j];
+            c->conv_mean += r->conv;
+            c->erle_mean += r->erle;
+            c->div_mean += r->div;
+            if (r->conv > c->conv_worst)
+                c->conv_worst = r->conv;
+            if (r->erle < c->erle_worst)
+                c->erle_worst = r->erle;
+            if (r->div > c->div_worst)
+                c->div_worst = r->div;
+        }
+        c->conv_mean /= n_scenarios;
+        c->erle_mean /= n_scenarios;
+        c->div_mean /= n_scenarios;
+        c->score = c->erle_mean - 2.0*c->div_mean - c->conv_mean/100.0;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int compare_score(const void *a, const void *b)
+{
+    const config_t *ca = (const config_t *) a;
+    const config_t *cb = (const config_t *) b;
+
+    if (ca->score > cb->score)
+        return -1;
+    if (ca->score < cb->score)
+        return 1;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void print_tuning(FILE *f, const echo_can_tuning_t *tuning, const char *sep)
+{
+    tuning_param_t *p;
+
+    for (p = params;  p->name;  p++)
+        fprintf(f, "%d%s", *(const int *) ((const char *) tuning + p->offset), sep);
+}
+/*- End of function --------------------------------------------------------*/
+
+static int write_csv(const char *name)
+{
+    tuning_param_t *p;
+    scenario_t *sc;
+    run_result_t *r;
+    FILE *f;
+    int i;
+
+    if ((f = fopen(name, "w")) == NULL)
+        return -1;
+    for (p = params;  p->name;  p++)
+        fprintf(f, "%s,", p->name);
+    fprintf(f, "model,erl,far,near,converge_ms,erle,divergence\n");
+    for (i = 0;  i < n_runs;  i++)
+    {
+        sc = &scenarios[i%n_scenarios];
+        r = &results[i];
+        print_tuning(f, &configs[i/n_scenarios].tuning, ",");
+        fprintf(f, "%d,%.1f,%s,%s,%.0f,%.2f,%.2f\n", sc->model, sc->erl, sc->far->name, sc->near->name, r->conv, r->erle, r->div);
+    }
+    fclose(f);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    pthread_t threads[MAX_THREADS];
+    tuning_param_t *p;
+    const char *csv;
+    float erls[MAX_ERLS];
+    int n_erls;
+    int n_threads;
+    int top;
+    int i;
+    char *s;
+
+    csv = NULL;
+    n_erls = 0;
+    n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    top = 20;
+    for (i = 1;  i < argc;  i++)
+    {
+        if (strcmp(argv[i], "-p") == 0  &&  i + 1 < argc)
+        {
+            if (parse_param(argv[++i]))
+            {
+                fprintf(stderr, "Bad tuning parameter '%s'\n", argv[i]);
+                exit(2);
+            }
+        }
+        else if (strcmp(argv[i], "-erl") == 0  &&  i + 1 < argc)
+        {
+            for (s = argv[++i];  s  &&  n_erls < MAX_ERLS;  s = strchr(s, ','))
+            {
+                if (*s == ',')
+                    s++;
+                erls[n_erls++] = atof(s);
+            }
+        }
+        else if (strcmp(argv[i], "-wav") == 0  &&  i + 1 < argc)
+        {
+            if (n_speech < MAX_WAVS)
+                speech_load(&speech[n_speech++], argv[++i]);
+        }
+        else if (strcmp(argv[i], "-j") == 0  &&  i + 1 < argc)
+        {
+            n_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0  &&  i + 1 < argc)
+        {
+            csv = argv[++i];
+        }
+        else if (strcmp(argv[i], "-top") == 0  &&  i + 1 < argc)
+        {
+            top = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: echo_sweep [-p name=v1,v2,...|name=lo:hi:step]... [-erl dB,dB,...]\n"
+                            "                  [-wav speech.wav]... [-j threads] [-o runs.csv] [-top n]\n"
+                            "Tuning parameters:");
+            for (p = params;  p->name;  p++)
+                fprintf(stderr, " %s", p->name);
+            fprintf(stderr, "\n");
+            exit(2);
+        }
+    }
+    if (n_erls == 0)
+    {
+        erls[n_erls++] = 6.0;
+        erls[n_erls++] = 10.0;
+    }
+    if (n_speech == 0)
+    {
+        speech_load(&speech[n_speech++], "sound_c1_8k.wav");
+        speech_load(&speech[n_speech++], "sound_c3_8k.wav");
+    }
+    if (n_threads < 1)
+        n_threads = 1;
+    if (n_threads > MAX_THREADS)
+        n_threads = MAX_THREADS;
+
+    build_configs();
+    build_scenarios(erls, n_erls);
+    n_runs = n_configs*n_scenarios;
+    if ((results = calloc(n_runs, sizeof(*results))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    if (n_threads > n_runs)
+        n_threads = n_runs;
+    printf("%d tunings x %d scenarios on %d threads\n", n_configs, n_scenarios, n_threads);
+    fflush(stdout);
+
+    for (i = 0;  i < n_threads;  i++)
+    {
+        if (pthread_create(&threads[i], NULL, worker, NULL))
+        {
+            fprintf(stderr, "Cannot create thread\n");
+            exit(2);
+        }
+    }
+    for (i = 0;  i < n_threads;  i++)
+        pthread_join(threads[i], NULL);
+
+    if (csv  &&  write_csv(csv))
+    {
+        fprintf(stderr, "Cannot write '%s'\n", csv);
+        exit(2);
+    }
+
+    score_configs();
+    qsort(configs, n_configs, sizeof(*configs), compare_score);
+
+    printf("\n");
+    for (p = params;  p->name;  p++)
+        printf("%s ", p->name);
+    printf("\n\n");
+    printf("  score  conv ms (worst)  ERLE dB (worst)  DT div dB (worst)  tuning\n");
+    for (i = 0;  i < n_configs  &&  i < top;  i++)
+    {
+        printf("%7.2f  %7.0f (%5.0f)  %7.2f (%6.2f)  %9.2f (%6.2f)  ",
+               configs[i].score,
+               configs[i].conv_mean, configs[i].conv_worst,
+               configs[i].erle_mean, configs[i].erle_worst,
+               configs[i].div_mean, configs[i].div_worst);
+        print_tuning(stdout, &configs[i].tuning, " ");
+        printf("\n");
+    }
+
+    free(results);
+    free(configs);
+    free(scenarios);
+    for (i = 0;  i < n_speech;  i++)
+        free(speech[i].amp);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
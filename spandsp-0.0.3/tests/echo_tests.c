@@ -263,40 +263,11 @@ static inline int16_t codec_munge(int16_t amp)
 
 static int channel_model_create(int model)
 {
-    static const int32_t *line_models[] =
-    {
-        line_model_d2_coeffs,
-        line_model_d3_coeffs,
-        line_model_d4_coeffs,
-        line_model_d5_coeffs,
-        line_model_d6_coeffs,
-        line_model_d7_coeffs,
-        line_model_d8_coeffs,
-        line_model_d9_coeffs
-    };
-
-    static int line_model_sizes[] =
-    {
-        sizeof(line_model_d2_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d3_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d4_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d5_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d6_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d7_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d8_coeffs)/sizeof(int32_t),
-        sizeof(line_model_d9_coeffs)/sizeof(int32_t)
-    };
-
-    static float ki[] = 
-    {
-	1.39E-5, 1.44E-5, 1.52E-5, 1.77E-5, 9.33E-6, 1.51E-5, 2.33E-5, 1.33E-5
-    };
-
-    if (model < 1  ||  model > (int) (sizeof(line_model_sizes)/sizeof(line_model_sizes[0])))
+    if (model < 1  ||  model > G168_LINE_MODELS)
         return -1;
-    fir32_create(&line_model, line_models[model-1], line_model_sizes[model-1]);
+    fir32_create(&line_model, g168_line_models[model-1], g168_line_model_sizes[model-1]);
 
-    model_ki = ki[model-1];
+    model_ki = g168_line_model_ki[model-1];
 
     return 0;
 }
@@ -475,7 +446,9 @@ FILE *flevel;
 int Rin_type, Sgen_type;
 int failed;
 int verbose, quiet;
+int csv;
 float threshold;
+float margin;
 int model_number;
 char test_name[80];
 
@@ -489,6 +462,9 @@ tone_gen_state_t sgen_tone_state;
    the test has failed (for example Lres exceeding some threshold).
 
    Different test callback functions are required for each G168 test.
+   They also keep track of margin, the closest (in dB) the measured
+   level came to the pass/fail limit while the test was running.  A
+   negative margin means the limit was exceeded.
 */
 int (*test_callback)(void);
 
@@ -509,6 +485,10 @@ int (*test_callback)(void);
 #define HOTH_SCALE 2.40
 #define CSS_SCALE  5.60
 
+/* margin before any test callback has run */
+
+#define NO_MARGIN  100.0
+
 static void reset_all(void) {
     echo_can_flush(ctx);
     maxLRin = maxLSgen = maxLSin = maxLSout = maxLres = -100.0;
@@ -519,6 +499,7 @@ static void reset_all(void) {
     Sgen_type = NONE;
     failed = FALSE;
     test_clock = 0.0;
+    margin = NO_MARGIN;
 }
 
 static void reset_meter_peaks(void) {
@@ -564,6 +545,8 @@ static void update_levels(int16_t rin, int16_t sin, int16_t sout, int16_t sgen)
 
 static void write_log_files(int16_t rout, int16_t sin)
 {
+    if (fdump == NULL)
+        return;
     fprintf(flevel, "%f\t%f\t%f\t%f\n",LRin, LSin, LSout, LSgen);
     fprintf(fdump, "%d %d %d", ctx->tx, ctx->rx, ctx->clean);
     fprintf(fdump, " %d %d %d %d %d %d %d %d %d %d\n", ctx->clean_nlp, ctx->Ltx, 
@@ -622,9 +605,10 @@ static void run_test(float time, float units) {
 	update_levels(rin, sin, sout, sgen);
 	write_log_files(rout, sin);
 	
-	/* now test for fail condition */
+	/* now test for fail condition, the callback keeps running after
+	   a failure so the margin covers the whole test */
 	if (test_callback != NULL) {
-	    if ( (failed == FALSE) && (test_callback() == FALSE)) {
+	    if (test_callback() == FALSE) {
 		/* test has failed */
 		failed = TRUE;
 	    }
@@ -644,6 +628,18 @@ static void print_title(const char *title) {
 
 static void print_results(void) {
 
+    /* one line of comma separated values, for g168_runner etc */
+
+    if (csv == TRUE) {
+	printf("%s,%d,%.1f,%.3f,%.2f,%.2f,%.2f,%.2f,", 
+	       test_name, model_number, 20.0*log10(erl), 
+	       test_clock, maxLRin, maxLSin, maxLSgen, maxLSout);
+	if (margin < NO_MARGIN)
+	    printf("%.2f", margin);
+	printf(",%s\n", (failed == TRUE) ? "FAIL" : "PASS");
+	return;
+    }
+
     if (quiet == FALSE) 
 	printf("test  model  ERL   time     Max Rin  Max Sin  Max Sgen  Max Sout  Result\n");
     printf("%-4s  %-1d      %-5.1f%6.2fs%9.2f%9.2f%10.2f%10.2f   ", 
@@ -655,58 +651,48 @@ static void print_results(void) {
 	printf("PASS\n");
 }
 
-static int test_2a(void) {
-    if (LSout > -65.0) 
+/* Returns TRUE if level is within limit, and updates the margin */
+
+static int check_limit(float level, float limit) {
+    if ((limit - level) < margin)
+	margin = limit - level;
+    if (level > limit) 
 	return FALSE;
     else
 	return TRUE;
 }
 
+static int test_2a(void) {
+    return check_limit(LSout, -65.0);
+}
+
 static int test_2c(void) {
-    if (LSout > maxHoth) 
-	return FALSE;
-    else
-	return TRUE;
+    return check_limit(LSout, maxHoth);
 }
 
 static int test_3a(void) {
-    if (LSout > maxLSgen) 
-	return FALSE;
-    else
-	return TRUE;
+    return check_limit(LSout, maxLSgen);
 }
 
 static int test_3b(void) {
-    if (LSout > threshold) 
-	return FALSE;
-    else
-	return TRUE;
+    return check_limit(LSout, threshold);
 }
 
 static int test_3c_t2(void) {
-    if (LSout > maxLSgen) 
-	return FALSE;
-    else
-	return TRUE;
+    return check_limit(LSout, maxLSgen);
 }
 
 static int test_3c_t4t5(void) {
-    if (LSout > (maxLSgen+6.0)) 
-	return FALSE;
-    else
-	return TRUE;
+    return check_limit(LSout, maxLSgen+6.0);
 }
 
 static int test_9(void) {
-    if (fabs(LSout - LSgen) > 2.0) 
-	return FALSE;
-    else
-	return TRUE;
+    return check_limit(fabs(LSout - LSgen), 2.0);
 }
 
-#define N_TESTS 9
-static const char *supported_tests[] = {"ut1", "2aa", "2ca", "3a", "3ba", 
-					"3bb", "3c", "6", "9"};
+#define N_TESTS 12
+static const char *supported_tests[] = {"ut1", "ut2", "ut3", "ut4", "2aa", "2ca",
+					"3a", "3ba", "3bb", "3c", "6", "9"};
 
 static int is_test_supported(char *test) {
     int i;
@@ -757,6 +743,7 @@ int main(int argc, char *argv[])
     float tmp;
     int   cng;
     int   hpf;
+    int   log_files;
 
     /* default config ------------------------------------------------*/
 
@@ -773,6 +760,8 @@ int main(int argc, char *argv[])
     munge = TRUE;
     cng = FALSE;
     hpf = TRUE;
+    csv = FALSE;
+    log_files = TRUE;
     for(i=0; i<NPOLES+1; i++) {
       xvtx[i] = yvtx[i] = xvrx[i] = yvrx[i] = 0.0;
     }
@@ -787,7 +776,9 @@ int main(int argc, char *argv[])
 		        "[-r RinLeveldBm0] [-s SgenLeveldBm0] [-x XLeveldB]\n"
 		        "[-nomunge]\n"
 		        "[-cng]\n"
-		        "[-nohpf] Disable DC block HPF (-file mode)\n");
+		        "[-nohpf] Disable DC block HPF (-file mode)\n"
+		        "[-csv] Print results as comma separated values\n"
+		        "[-nolog] Don't write dump.txt and level.txt\n");
 
 	exit(1);
     }
@@ -861,6 +852,15 @@ int main(int argc, char *argv[])
         {
             hpf = FALSE;
         }
+        else if (strcmp(argv[i], "-csv") == 0)
+        {
+            csv = TRUE;
+            quiet = TRUE;
+        }
+        else if (strcmp(argv[i], "-nolog") == 0)
+        {
+            log_files = FALSE;
+        }
         else
         {
             fprintf(stderr, "Unknown test/option '%s' specified\n", argv[i]);
@@ -897,10 +897,13 @@ int main(int argc, char *argv[])
 	       20.0*log10(Sgen_level), Sgen_level);
     }
 
-    fdump = fopen("dump.txt","wt");
-    assert(fdump != NULL);
-    flevel = fopen("level.txt","wt");
-    assert(flevel != NULL);
+    fdump = flevel = NULL;
+    if (log_files == TRUE) {
+	fdump = fopen("dump.txt","wt");
+	assert(fdump != NULL);
+	flevel = fopen("level.txt","wt");
+	assert(flevel != NULL);
+    }
 
     if (file_mode == TRUE) {
 	/* process wave files instead of running tests, useful for
@@ -979,6 +982,147 @@ int main(int argc, char *argv[])
 	dump_h();
     }
 
+    /* unit test for the event trace ring - converge with NLP on, then
+       check we logged the events we expect, in time order.  The ring is
+       small enough to overflow, so we also check dropped events are
+       reported */
+
+    if (!strcasecmp(argv[1], "ut2")) {
+	echo_can_trace_event_t ev[256];
+	int      j, n, transfers, nlp_engage, modes;
+	uint32_t last, lost, last_transfer;
+
+	print_title("Performing Unit Test 2 - Event trace\n");
+	reset_all();
+	echo_can_adaption_mode(ctx, ECHO_CAN_USE_ADAPTION | ECHO_CAN_USE_NLP);
+	if (echo_can_trace_enable(ctx, 4)) {
+	    printf("Failed to enable trace\n");
+	    exit(2);
+	}
+	transfers = nlp_engage = modes = 0;
+	last = lost = 0;
+	last_transfer = (uint32_t) -2;
+	for(i=0; i<50; i++) {
+	    if (i == 40)
+		echo_can_adaption_mode(ctx, ECHO_CAN_USE_NLP);
+	    run_test(100, MSEC);
+	    while((n = echo_can_trace_read(ctx, ev, 256)) > 0) {
+		for(j=0; j<n; j++) {
+		    if (ev[j].sample < last)
+			failed = TRUE;
+		    last = ev[j].sample;
+		    /* only the start of each run of transfers is logged,
+		       so there are never two on consecutive samples */
+		    if (ev[j].type == ECHO_CAN_TRACE_FG_TRANSFER) {
+			if (ev[j].sample == last_transfer + 1)
+			    failed = TRUE;
+			last_transfer = ev[j].sample;
+			transfers++;
+		    }
+		    if (ev[j].type == ECHO_CAN_TRACE_NLP_ENGAGE)
+			nlp_engage++;
+		    if (ev[j].type == ECHO_CAN_TRACE_MODE)
+			modes++;
+		    if (ev[j].type == ECHO_CAN_TRACE_LOST)
+			lost += ev[j].value;
+		}
+	    }
+	}
+	echo_can_trace_disable(ctx);
+	if (verbose == TRUE)
+	    printf("transfers: %d nlp engage: %d mode changes: %d "
+		   "lost: %u (%u reported)\n", 
+		   transfers, nlp_engage, modes, ctx->trace_ring->lost, lost);
+	if ((transfers == 0) || (nlp_engage == 0) || (modes != 1))
+	    failed = TRUE;
+	/* every drop already noted in the ring must have reached us */
+	if (lost != ctx->trace_ring->lost_logged)
+	    failed = TRUE;
+	print_results();
+    }
+
+    /* unit test for the ERL/ERLE meters - converge, then check the
+       estimates against the ERL of the channel model.  Then check a
+       canceller with adaption off is never judged converged */
+
+    if (!strcasecmp(argv[1], "ut3")) {
+	echo_can_stats_t stats;
+
+	print_title("Performing Unit Test 3 - ERL/ERLE metering\n");
+	reset_all();
+	echo_can_adaption_mode(ctx, ECHO_CAN_USE_ADAPTION);
+	echo_can_get_stats(ctx, &stats);
+	if (stats.converged || (stats.converge_time != -1))
+	    failed = TRUE;
+	run_test(5, SEC);
+	echo_can_get_stats(ctx, &stats);
+	if (verbose == TRUE)
+	    printf("ERL: %5.1f dB ERLE: %5.1f dB converged: %d "
+		   "converge time: %d ms measured: %d ms\n", 
+		   stats.erl/10.0, stats.erle/10.0, stats.converged,
+		   stats.converge_time, stats.measured_time);
+	if (!stats.converged || (stats.converge_time < 0) || 
+	    (stats.converge_time > 1000))
+	    failed = TRUE;
+	if (fabs(stats.erl/10.0 + 20.0*log10(erl)) > 3.0)
+	    failed = TRUE;
+	if (stats.erle < 240)
+	    failed = TRUE;
+
+	/* a canceller that isn't adapting takes nothing out of the
+	   echo, so must never count as converged, whatever the ERL */
+	echo_can_flush(ctx);
+	echo_can_adaption_mode(ctx, 0);
+	run_test(5, SEC);
+	echo_can_get_stats(ctx, &stats);
+	if (verbose == TRUE)
+	    printf("Not adapting - ERL: %5.1f dB ERLE: %5.1f dB converged: %d "
+		   "converge time: %d ms\n", 
+		   stats.erl/10.0, stats.erle/10.0, stats.converged,
+		   stats.converge_time);
+	if (stats.converged || (stats.converge_time != -1))
+	    failed = TRUE;
+	print_results();
+    }
+
+    /* unit test for coefficient snapshots - converge, freeze the
+       filters, then check the snapshot matches the live taps.  The fg
+       filter is frozen by switching off adaption, the bg filter stops
+       changing once there is no Rin left in its delay line. */
+
+    if (!strcasecmp(argv[1], "ut4")) {
+	echo_can_snapshot_t *snap;
+	int16_t  fg[TEST_EC_TAPS], bg[TEST_EC_TAPS];
+	uint32_t sample;
+
+	print_title("Performing Unit Test 4 - Coefficient snapshot\n");
+	reset_all();
+	echo_can_adaption_mode(ctx, ECHO_CAN_USE_ADAPTION);
+	snap = echo_can_snapshot_create(TEST_EC_TAPS);
+	if ((snap == NULL) || echo_can_snapshot_attach(ctx, snap)) {
+	    printf("Failed to attach snapshot\n");
+	    exit(2);
+	}
+	if (echo_can_snapshot_read(snap, &sample, fg, bg) != 0)
+	    failed = TRUE;
+	run_test(1, SEC);
+	echo_can_adaption_mode(ctx, 0);
+	mute_Rin();
+	run_test(100, MSEC);
+	unmute_Rin();
+	if (echo_can_snapshot_read(snap, &sample, fg, bg) != TEST_EC_TAPS)
+	    failed = TRUE;
+	if (memcmp(fg, ctx->fir_taps16[0], sizeof(fg)) 
+	    || memcmp(bg, ctx->fir_taps16[1], sizeof(bg)))
+	    failed = TRUE;
+	if (verbose == TRUE)
+	    printf("snapshot at sample %u, seq %u\n", sample, snap->seq);
+	if (echo_can_snapshot_detach(ctx) != snap)
+	    failed = TRUE;
+	echo_can_snapshot_free(snap);
+	print_results();
+    }
+
     /* Test 1 - Steady state residual and returned echo level test */
     /* This functionality has been merged with test 2 in newer versions of G.168,
        so test 1 no longer exists. */
@@ -1557,8 +1701,10 @@ int main(int argc, char *argv[])
 #endif
 
 
-    fclose(fdump);
-    fclose(flevel);
+    if (fdump != NULL) {
+	fclose(fdump);
+	fclose(flevel);
+    }
 
     return  0;
 }
@@ -0,0 +1,513 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * g168_runner.c - Run the G.168 tests in echo_tests over a matrix of
+ *                 line models, ERLs and levels, in parallel.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \page g168_runner_page G.168 compliance runner
+\section g168_runner_page_sec_1 What does it do?
+g168_tests.sh and g168_quick.sh run echo_tests one case at a time. This
+program runs the G.168 tests implemented in echo_tests over every
+combination of line model, ERL and signal levels, spreading the cases over
+all the CPUs, and writes the results of the whole run to a single report.
+
+\section g168_runner_page_sec_2 How does it work?
+Each case is run as a separate echo_tests process, so every case has its
+own echo canceller, line model and signal sources, and nothing is shared
+between cases which run at the same time. A pool of worker threads takes
+cases from the matrix in turn, runs them, and collects the one line
+comma separated result echo_tests prints with -csv.
+
+The report has one row per case, giving the result and the margin, which
+is the closest (in dB) the measured level came to the test's pass/fail
+limit. A negative margin is a failure. A summary of each test, including
+its worst case, is printed at the end.
+
+\section g168_runner_page_sec_3 How do I use it?
+Run it in the tests directory, as echo_tests needs the speech files there.
+
+    ./g168_runner                  full matrix, all CPUs
+    ./g168_runner -quick           each test once at the default settings
+    ./g168_runner -t 3bb -m 1 -j 4 just test 3B(b) on model 1, 4 threads
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#if !defined(FALSE)
+#define FALSE 0
+#endif
+#if !defined(TRUE)
+#define TRUE (!FALSE)
+#endif
+
+#define REPORT_FILE_NAME    "g168_report.csv"
+#define MAX_THREADS         256
+
+/* The tests, and which extra levels each one depends on */
+typedef struct
+{
+    const char *name;
+    int vary_sgen;
+    int vary_x;
+} g168_test_t;
+
+static const g168_test_t tests[] =
+{
+    {"2aa", FALSE, FALSE},
+    {"2ca", FALSE, FALSE},
+    {"3a",  FALSE, FALSE},
+    {"3ba", TRUE,  FALSE},
+    {"3bb", FALSE, TRUE},
+    {"3c",  FALSE, FALSE},
+    {"6",   FALSE, FALSE},
+    {"9",   FALSE, FALSE},
+    {NULL,  FALSE, FALSE}
+};
+
+#define N_MODELS    8
+
+static const float erls[] = {6.0, 8.0, 10.0, 12.0, 18.0, 30.0};
+static const float rins[] = {-30.0, -24.0, -18.0, -12.0, -6.0, 0.0};
+static const float sgens[] = {-30.0, -18.0, -6.0};
+static const float xs[] = {6.0, 12.0, 18.0, 24.0, 30.0};
+
+/* The defaults in echo_tests, used for -quick */
+#define DEFAULT_MODEL   1
+#define DEFAULT_ERL     10.0
+#define DEFAULT_RIN     -15.0
+#define DEFAULT_SGEN    -15.0
+#define DEFAULT_X       6.0
+
+#define NELEM(x) ((int) (sizeof(x)/sizeof((x)[0])))
+
+enum
+{
+    RESULT_NOT_RUN = 0,
+    RESULT_PASS,
+    RESULT_FAIL,
+    RESULT_ERROR
+};
+
+typedef struct
+{
+    /* The case */
+    const g168_test_t *test;
+    int model;
+    float erl;
+    float rin;
+    float sgen;
+    float x;
+
+    /* What echo_tests made of it */
+    int result;
+    float time;
+    float max_rin;
+    float max_sin;
+    float max_sgen;
+    float max_sout;
+    int has_margin;
+    float margin;
+} g168_job_t;
+
+static const char *echo_tests = "./echo_tests";
+
+static g168_job_t *jobs;
+static int n_jobs;
+static int next_job;
+static int done_jobs;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void add_job(const g168_test_t *test, int model, float erl, float rin, float sgen, float x)
+{
+    g168_job_t *job;
+
+    if ((jobs = realloc(jobs, (n_jobs + 1)*sizeof(*jobs))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    job = &jobs[n_jobs++];
+    memset(job, 0, sizeof(*job));
+    job->test = test;
+    job->model = model;
+    job->erl = erl;
+    job->rin = rin;
+    job->sgen = sgen;
+    job->x = x;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void build_matrix(const char *only_test, int only_model, int quick)
+{
+    const g168_test_t *test;
+    int m;
+    int e;
+    int r;
+    int i;
+
+    for (test = tests;  test->name;  test++)
+    {
+        if (only_test  &&  strcmp(only_test, test->name))
+            continue;
+        if (quick)
+        {
+            add_job(test, (only_model)  ?  only_model  :  DEFAULT_MODEL, DEFAULT_ERL, DEFAULT_RIN, DEFAULT_SGEN, DEFAULT_X);
+            continue;
+        }
+        for (m = 1;  m <= N_MODELS;  m++)
+        {
+            if (only_model  &&  m != only_model)
+                continue;
+            for (e = 0;  e < NELEM(erls);  e++)
+            {
+                for (r = 0;  r < NELEM(rins);  r++)
+                {
+                    if (test->vary_sgen)
+                    {
+                        for (i = 0;  i < NELEM(sgens);  i++)
+                            add_job(test, m, erls[e], rins[r], sgens[i], DEFAULT_X);
+                    }
+                    else if (test->vary_x)
+                    {
+                        for (i = 0;  i < NELEM(xs);  i++)
+                            add_job(test, m, erls[e], rins[r], DEFAULT_SGEN, xs[i]);
+                    }
+                    else
+                    {
+                        add_job(test, m, erls[e], rins[r], DEFAULT_SGEN, DEFAULT_X);
+                    }
+                }
+            }
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Parse the line echo_tests -csv prints:
+   test,model,erl,time,max_rin,max_sin,max_sgen,max_sout,margin,result
+   The margin is empty if no test limit was ever checked. */
+static int parse_result(g168_job_t *job, char *line)
+{
+    char *field[10];
+    char *s;
+    int n;
+
+    n = 0;
+    field[n++] = line;
+    for (s = line;  *s  &&  n < 10;  s++)
+    {
+        if (*s == ',')
+        {
+            *s = '\0';
+            field[n++] = s + 1;
+        }
+    }
+    if (n != 10  ||  strcmp(field[0], job->test->name))
+        return -1;
+    job->time = atof(field[3]);
+    job->max_rin = atof(field[4]);
+    job->max_sin = atof(field[5]);
+    job->max_sgen = atof(field[6]);
+    job->max_sout = atof(field[7]);
+    job->has_margin = (field[8][0] != '\0');
+    job->margin = atof(field[8]);
+    if (strncmp(field[9], "PASS", 4) == 0)
+        job->result = RESULT_PASS;
+    else if (strncmp(field[9], "FAIL", 4) == 0)
+        job->result = RESULT_FAIL;
+    else
+        return -1;
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void run_job(g168_job_t *job)
+{
+    char cmd[512];
+    char line[512];
+    FILE *f;
+    int found;
+
+    /* The test's own options set the levels it doesn't vary, so only pass
+       the ones that matter to this test */
+    snprintf(cmd, sizeof(cmd), "%s %s -m %d -erl %g -r %g", echo_tests, job->test->name, job->model, job->erl, job->rin);
+    if (job->test->vary_sgen)
+        snprintf(cmd + strlen(cmd), sizeof(cmd) - strlen(cmd), " -s %g", job->sgen);
+    if (job->test->vary_x)
+        snprintf(cmd + strlen(cmd), sizeof(cmd) - strlen(cmd), " -x %g", job->x);
+    strcat(cmd, " -csv -nolog");
+
+    job->result = RESULT_ERROR;
+    if ((f = popen(cmd, "r")) == NULL)
+        return;
+    found = FALSE;
+    while (fgets(line, sizeof(line), f))
+    {
+        if (!found  &&  parse_result(job, line) == 0)
+            found = TRUE;
+    }
+    if (pclose(f) != 0  ||  !found)
+        job->result = RESULT_ERROR;
+}
+/*- End of function --------------------------------------------------------*/
+
+static const char *result_name(int result)
+{
+    switch (result)
+    {
+    case RESULT_PASS:
+        return "PASS";
+    case RESULT_FAIL:
+        return "FAIL";
+    case RESULT_ERROR:
+        return "ERROR";
+    }
+    return "NOT RUN";
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *worker(void *arg)
+{
+    g168_job_t *job;
+    int verbose;
+
+    verbose = *(int *) arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&job_lock);
+        job = (next_job < n_jobs)  ?  &jobs[next_job++]  :  NULL;
+        pthread_mutex_unlock(&job_lock);
+        if (job == NULL)
+            break;
+
+        run_job(job);
+
+        pthread_mutex_lock(&job_lock);
+        done_jobs++;
+        if (verbose  ||  job->result != RESULT_PASS)
+        {
+            printf("[%5d/%5d] %-3s model %d ERL %4.1f Rin %5.1f Sgen %5.1f X %4.1f  %s\n",
+                   done_jobs, n_jobs, job->test->name, job->model, job->erl, job->rin, job->sgen, job->x, result_name(job->result));
+            fflush(stdout);
+        }
+        pthread_mutex_unlock(&job_lock);
+    }
+    return NULL;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int write_report(const char *name)
+{
+    g168_job_t *job;
+    FILE *f;
+    int i;
+
+    if ((f = fopen(name, "w")) == NULL)
+        return -1;
+    fprintf(f, "test,model,erl,rin,sgen,x,time,max_rin,max_sin,max_sgen,max_sout,margin,result\n");
+    for (i = 0;  i < n_jobs;  i++)
+    {
+        job = &jobs[i];
+        fprintf(f, "%s,%d,%.1f,%.1f,", job->test->name, job->model, job->erl, job->rin);
+        if (job->test->vary_sgen)
+            fprintf(f, "%.1f", job->sgen);
+        fprintf(f, ",");
+        if (job->test->vary_x)
+            fprintf(f, "%.1f", job->x);
+        fprintf(f, ",");
+        if (job->result == RESULT_PASS  ||  job->result == RESULT_FAIL)
+        {
+            fprintf(f, "%.3f,%.2f,%.2f,%.2f,%.2f,", job->time, job->max_rin, job->max_sin, job->max_sgen, job->max_sout);
+            if (job->has_margin)
+                fprintf(f, "%.2f", job->margin);
+        }
+        else
+        {
+            fprintf(f, ",,,,,");
+        }
+        fprintf(f, ",%s\n", result_name(job->result));
+    }
+    fclose(f);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int print_summary(void)
+{
+    const g168_test_t *test;
+    g168_job_t *job;
+    g168_job_t *worst;
+    int count[4];
+    int total[4];
+    int i;
+
+    memset(total, 0, sizeof(total));
+    printf("test   runs   pass   fail  error  worst margin  (model, ERL, Rin, Sgen, X)\n");
+    for (test = tests;  test->name;  test++)
+    {
+        memset(count, 0, sizeof(count));
+        worst = NULL;
+        for (i = 0;  i < n_jobs;  i++)
+        {
+            job = &jobs[i];
+            if (job->test != test)
+                continue;
+            count[job->result]++;
+            if (job->has_margin  &&  (worst == NULL  ||  job->margin < worst->margin))
+                worst = job;
+        }
+        if (count[RESULT_PASS] + count[RESULT_FAIL] + count[RESULT_ERROR] == 0)
+            continue;
+        printf("%-4s %6d %6d %6d %6d", test->name, count[RESULT_PASS] + count[RESULT_FAIL] + count[RESULT_ERROR],
+               count[RESULT_PASS], count[RESULT_FAIL], count[RESULT_ERROR]);
+        if (worst)
+            printf("  %9.2f dB  (%d, %.1f, %.1f, %.1f, %.1f)", worst->margin, worst->model, worst->erl, worst->rin, worst->sgen, worst->x);
+        printf("\n");
+        for (i = 0;  i < 4;  i++)
+            total[i] += count[i];
+    }
+    printf("all  %6d %6d %6d %6d\n", total[RESULT_PASS] + total[RESULT_FAIL] + total[RESULT_ERROR],
+           total[RESULT_PASS], total[RESULT_FAIL], total[RESULT_ERROR]);
+    return total[RESULT_FAIL] + total[RESULT_ERROR];
+}
+/*- End of function --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    pthread_t threads[MAX_THREADS];
+    const char *report;
+    const char *only_test;
+    int only_model;
+    int n_threads;
+    int quick;
+    int verbose;
+    int bad;
+    int i;
+    time_t start;
+
+    report = REPORT_FILE_NAME;
+    only_test = NULL;
+    only_model = 0;
+    n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    quick = FALSE;
+    verbose = FALSE;
+    for (i = 1;  i < argc;  i++)
+    {
+        if (strcmp(argv[i], "-j") == 0  &&  i + 1 < argc)
+        {
+            n_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0  &&  i + 1 < argc)
+        {
+            report = argv[++i];
+        }
+        else if (strcmp(argv[i], "-e") == 0  &&  i + 1 < argc)
+        {
+            echo_tests = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0  &&  i + 1 < argc)
+        {
+            only_test = argv[++i];
+        }
+        else if (strcmp(argv[i], "-m") == 0  &&  i + 1 < argc)
+        {
+            only_model = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-quick") == 0)
+        {
+            quick = TRUE;
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            verbose = TRUE;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: g168_runner [-j threads] [-o report.csv] [-e path/to/echo_tests]\n"
+                            "                   [-t test] [-m model] [-quick] [-v]\n");
+            exit(2);
+        }
+    }
+    if (n_threads < 1)
+        n_threads = 1;
+    if (n_threads > MAX_THREADS)
+        n_threads = MAX_THREADS;
+    if (access(echo_tests, X_OK))
+    {
+        fprintf(stderr, "Cannot run '%s'\n", echo_tests);
+        exit(2);
+    }
+
+    build_matrix(only_test, only_model, quick);
+    if (n_jobs == 0)
+    {
+        fprintf(stderr, "No test cases selected\n");
+        exit(2);
+    }
+    if (n_threads > n_jobs)
+        n_threads = n_jobs;
+    printf("Running %d G.168 test cases on %d threads\n", n_jobs, n_threads);
+    fflush(stdout);
+
+    time(&start);
+    for (i = 0;  i < n_threads;  i++)
+    {
+        if (pthread_create(&threads[i], NULL, worker, &verbose))
+        {
+            fprintf(stderr, "Cannot create thread\n");
+            exit(2);
+        }
+    }
+    for (i = 0;  i < n_threads;  i++)
+        pthread_join(threads[i], NULL);
+
+    if (write_report(report))
+    {
+        fprintf(stderr, "Cannot write report '%s'\n", report);
+        exit(2);
+    }
+    printf("\n");
+    bad = print_summary();
+    printf("\n%d cases in %lds, report in %s\n", n_jobs, (long int) (time(NULL) - start), report);
+    free(jobs);
+    if (bad)
+    {
+        printf("Tests failed\n");
+        exit(1);
+    }
+    printf("Tests passed\n");
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
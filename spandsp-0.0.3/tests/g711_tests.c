@@ -59,6 +59,87 @@ int16_t amp[65536];
 const uint8_t alaw_1khz_sine[] = {0x34, 0x21, 0x21, 0x34, 0xB4, 0xA1, 0xA1, 0xB4};
 const uint8_t ulaw_1khz_sine[] = {0x1E, 0x0B, 0x0B, 0x1E, 0x9E, 0x8B, 0x8B, 0x9E};
 
+static int test_block_functions(void)
+{
+    static int16_t linear[65536];
+    static int16_t decoded[256];
+    static uint8_t law[65536];
+    uint8_t codes[256];
+    int failures;
+    int offset;
+    int i;
+
+    failures = 0;
+    for (i = 0;  i < 65536;  i++)
+        linear[i] = (int16_t) (i - 32768);
+    for (i = 0;  i < 256;  i++)
+        codes[i] = (uint8_t) i;
+
+    /* Every linear value, starting at each offset, so every value passes
+       through every lane of the vector code, and the scalar tail */
+    for (offset = 0;  offset < 32;  offset++)
+    {
+        g711_ulaw_encode_block(law, linear + offset, 65536 - offset);
+        for (i = 0;  i < 65536 - offset;  i++)
+        {
+            if (law[i] != linear_to_ulaw(linear[i + offset]))
+            {
+                printf("u-law block encode of %d gave 0x%02x, not 0x%02x\n", linear[i + offset], law[i], linear_to_ulaw(linear[i + offset]));
+                failures++;
+            }
+        }
+        g711_alaw_encode_block(law, linear + offset, 65536 - offset);
+        for (i = 0;  i < 65536 - offset;  i++)
+        {
+            if (law[i] != linear_to_alaw(linear[i + offset]))
+            {
+                printf("A-law block encode of %d gave 0x%02x, not 0x%02x\n", linear[i + offset], law[i], linear_to_alaw(linear[i + offset]));
+                failures++;
+            }
+        }
+    }
+
+    g711_ulaw_decode_block(decoded, codes, 256);
+    for (i = 0;  i < 256;  i++)
+    {
+        if (decoded[i] != ulaw_to_linear(codes[i]))
+        {
+            printf("u-law block decode of 0x%02x gave %d, not %d\n", codes[i], decoded[i], ulaw_to_linear(codes[i]));
+            failures++;
+        }
+    }
+    g711_alaw_decode_block(decoded, codes, 256);
+    for (i = 0;  i < 256;  i++)
+    {
+        if (decoded[i] != alaw_to_linear(codes[i]))
+        {
+            printf("A-law block decode of 0x%02x gave %d, not %d\n", codes[i], decoded[i], alaw_to_linear(codes[i]));
+            failures++;
+        }
+    }
+
+    g711_alaw_to_ulaw_block(law, codes, 256);
+    for (i = 0;  i < 256;  i++)
+    {
+        if (law[i] != alaw_to_ulaw(codes[i]))
+        {
+            printf("A-law -> u-law block transcode of 0x%02x gave 0x%02x, not 0x%02x\n", codes[i], law[i], alaw_to_ulaw(codes[i]));
+            failures++;
+        }
+    }
+    g711_ulaw_to_alaw_block(law, codes, 256);
+    for (i = 0;  i < 256;  i++)
+    {
+        if (law[i] != ulaw_to_alaw(codes[i]))
+        {
+            printf("u-law -> A-law block transcode of 0x%02x gave 0x%02x, not 0x%02x\n", codes[i], law[i], ulaw_to_alaw(codes[i]));
+            failures++;
+        }
+    }
+    return failures;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     AFfilehandle outhandle;
@@ -252,6 +333,13 @@ int main(int argc, char *argv[])
             }
         }
     }
+
+    printf("Testing the block functions against the single sample functions\n");
+    if (test_block_functions())
+    {
+        printf("Test failed\n");
+        exit(2);
+    }
     
     if (afCloseFile(outhandle))
     {
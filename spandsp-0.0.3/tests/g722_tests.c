@@ -85,6 +85,9 @@ and the resulting audio stored in post_g722.wav.
 
 #define MAX_TEST_VECTOR_LEN 40000
 
+#define BATCH_CHANNELS      5
+#define BATCH_TEST_LEN      16000
+
 #define TESTDATA_DIR        "../itutests/g722/"
 
 #define EIGHTK_IN_FILE_NAME "../localtests/short_nb_voice.wav"
@@ -146,6 +149,23 @@ static const char *decode_test_files[] =
     NULL
 };
 
+/* The QMFs are bypassed by the ITU tests, so the full codec is checked against
+   results from the original straightforward QMF code. */
+static const struct
+{
+    int rate;
+    int options;
+    uint32_t encoded_check;
+    uint32_t decoded_check;
+} qmf_test_sets[] =
+{
+    {48000, 0,           0x6E77E4E8, 0x8073D1D4},
+    {48000, G722_PACKED, 0xE720CCF5, 0x6EAF666A},
+    {56000, G722_PACKED, 0x3E0F3740, 0x969A2719},
+    {64000, 0,           0x0FA81EB5, 0x9BB0D62F},
+    {0, 0, 0, 0}
+};
+
 int16_t itu_data[MAX_TEST_VECTOR_LEN];
 uint16_t itu_ref[MAX_TEST_VECTOR_LEN];
 uint16_t itu_ref_upper[MAX_TEST_VECTOR_LEN];
@@ -217,6 +237,130 @@ static int get_test_vector(const char *file, uint16_t buf[], int max_len)
 }
 /*- End of function --------------------------------------------------------*/
 
+static void batch_test_signal(int16_t amp[], int chan, int len)
+{
+    uint32_t seed;
+    int tri;
+    int step;
+    int i;
+
+    /* A triangle wave with some noise, generated with integer arithmetic so it is
+       the same everywhere */
+    seed = chan + 1;
+    tri = 0;
+    step = 40 + 97*chan;
+    for (i = 0;  i < len;  i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        tri += step;
+        if (tri > 12000  ||  tri < -12000)
+        {
+            step = -step;
+            tri += 2*step;
+        }
+        amp[i] = (int16_t) (tri + ((int32_t) (seed >> 16) - 32768)/((chan & 1)  ?  4  :  64));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_qmf_and_batch(int rate, int options, uint32_t encoded_check, uint32_t decoded_check)
+{
+    static int16_t linear[BATCH_CHANNELS][BATCH_TEST_LEN];
+    static uint8_t ref_g722[BATCH_CHANNELS][BATCH_TEST_LEN];
+    static uint8_t batch_g722[BATCH_CHANNELS][BATCH_TEST_LEN];
+    static int16_t ref_out[BATCH_CHANNELS][BATCH_TEST_LEN];
+    static int16_t batch_out[BATCH_CHANNELS][BATCH_TEST_LEN];
+    g722_encode_state_t enc[BATCH_CHANNELS];
+    g722_decode_state_t dec[BATCH_CHANNELS];
+    g722_encode_state_t *batch_enc[BATCH_CHANNELS];
+    g722_decode_state_t *batch_dec[BATCH_CHANNELS];
+    const int16_t *amp_in[BATCH_CHANNELS];
+    uint8_t *g722_out[BATCH_CHANNELS];
+    const uint8_t *g722_in[BATCH_CHANNELS];
+    int16_t *amp_out[BATCH_CHANNELS];
+    uint32_t check;
+    int len;
+    int bytes;
+    int batch_bytes;
+    int samples;
+    int batch_samples;
+    int failures;
+    int c;
+    int i;
+
+    failures = 0;
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        batch_test_signal(linear[c], c, BATCH_TEST_LEN);
+        g722_encode_init(&enc[c], rate, options);
+        g722_decode_init(&dec[c], rate, options);
+        batch_enc[c] = g722_encode_init(NULL, rate, options);
+        batch_dec[c] = g722_decode_init(NULL, rate, options);
+    }
+
+    bytes = 0;
+    batch_bytes = 0;
+    for (i = 0;  i < BATCH_TEST_LEN;  i += BLOCK_LEN)
+    {
+        for (c = 0;  c < BATCH_CHANNELS;  c++)
+        {
+            amp_in[c] = &linear[c][i];
+            g722_out[c] = &batch_g722[c][batch_bytes];
+        }
+        batch_bytes += g722_encode_batch(batch_enc, g722_out, amp_in, BATCH_CHANNELS, BLOCK_LEN);
+        for (c = 0;  c < BATCH_CHANNELS;  c++)
+            len = g722_encode(&enc[c], &ref_g722[c][bytes], &linear[c][i], BLOCK_LEN);
+        bytes += len;
+    }
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        if (bytes != batch_bytes  ||  memcmp(ref_g722[c], batch_g722[c], bytes))
+        {
+            printf("Batch encode mismatch - channel %d\n", c);
+            failures++;
+        }
+    }
+
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        g722_in[c] = batch_g722[c];
+        amp_out[c] = batch_out[c];
+    }
+    batch_samples = g722_decode_batch(batch_dec, amp_out, g722_in, BATCH_CHANNELS, bytes);
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        samples = g722_decode(&dec[c], ref_out[c], ref_g722[c], bytes);
+        if (samples != batch_samples  ||  memcmp(ref_out[c], batch_out[c], samples*sizeof(int16_t)))
+        {
+            printf("Batch decode mismatch - channel %d\n", c);
+            failures++;
+        }
+    }
+
+    for (check = 0, i = 0;  i < bytes;  i++)
+        check = check*31 + ref_g722[0][i];
+    if (check != encoded_check)
+    {
+        printf("Encoded data check mismatch - %08X %08X\n", check, encoded_check);
+        failures++;
+    }
+    for (check = 0, i = 0;  i < batch_samples;  i++)
+        check = check*31 + (uint16_t) ref_out[0][i];
+    if (check != decoded_check)
+    {
+        printf("Decoded data check mismatch - %08X %08X\n", check, decoded_check);
+        failures++;
+    }
+
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        g722_encode_release(batch_enc[c]);
+        g722_decode_release(batch_dec[c]);
+    }
+    return failures;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     g722_encode_state_t enc_state;
@@ -304,6 +448,20 @@ int main(int argc, char *argv[])
 
     if (itutests)
     {
+        printf("Testing the QMFs and the batch API\n");
+        for (i = 0;  qmf_test_sets[i].rate;  i++)
+        {
+            if (test_qmf_and_batch(qmf_test_sets[i].rate,
+                                   qmf_test_sets[i].options,
+                                   qmf_test_sets[i].encoded_check,
+                                   qmf_test_sets[i].decoded_check))
+            {
+                printf("Test failed - %dbps, options %d\n", qmf_test_sets[i].rate, qmf_test_sets[i].options);
+                exit(2);
+            }
+        }
+        printf("Test passed\n");
+
         /* ITU G.722 encode tests, using configuration 1. The QMF is bypassed */
         for (file = 0;  encode_test_files[file];  file += 2)
         {
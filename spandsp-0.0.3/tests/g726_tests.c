@@ -91,6 +91,12 @@ decompressed, and the resulting audio stored in post_g726.wav.
 
 #define TESTDATA_DIR    "../itutests/g726/"
 
+#define BANK_CHANNELS       13
+#define BANK_FRAME_LEN      160
+#define BANK_ODD_FRAME_LEN  20
+#define BANK_TEST_LEN       8000
+#define BANK_ITU_CHANNELS   3
+
 int16_t outdata[MAX_TEST_VECTOR_LEN];
 uint8_t adpcmdata[MAX_TEST_VECTOR_LEN];
 
@@ -1078,6 +1084,228 @@ static int get_test_vector(const char *file, uint8_t buf[], int max_len)
 }
 /*- End of function --------------------------------------------------------*/
 
+static void bank_test_signal(int16_t amp[], int chan, int len)
+{
+    static uint32_t seed = 1;
+    int i;
+    int level;
+
+    /* A different mix for each channel - noise, tones, overload and silence -
+       so the channels take different paths through the adaption logic */
+    level = 32767 >> (chan%6);
+    for (i = 0;  i < len;  i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        switch (chan%4)
+        {
+        case 0:
+            amp[i] = (int16_t) (((int16_t) (seed >> 16)*level) >> 15);
+            break;
+        case 1:
+            amp[i] = (int16_t) (level*sin(2.0*3.14159*(300.0 + 250.0*chan)*i/8000.0));
+            break;
+        case 2:
+            amp[i] = ((i/1000) & 1)  ?  0  :  (int16_t) (level*sin(2.0*3.14159*1800.0*i/8000.0));
+            break;
+        default:
+            amp[i] = ((i/400) & 1)  ?  (int16_t) (seed >> 16)  :  -32768;
+            break;
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_bank(int bit_rate, int ext_coding, int packing, int frame_len)
+{
+    static int16_t linear[BANK_CHANNELS][BANK_TEST_LEN];
+    static int16_t in[BANK_CHANNELS][BANK_TEST_LEN];
+    static uint8_t ref_adpcm[BANK_CHANNELS][BANK_TEST_LEN];
+    static uint8_t bank_adpcm[BANK_CHANNELS][BANK_TEST_LEN];
+    static int16_t ref_out[BANK_CHANNELS][BANK_TEST_LEN];
+    static int16_t bank_out[BANK_CHANNELS][BANK_TEST_LEN];
+    g726_state_t enc[BANK_CHANNELS];
+    g726_state_t dec[BANK_CHANNELS];
+    g726_state_t rand_dec[BANK_CHANNELS];
+    g726_bank_state_t *bank_enc;
+    g726_bank_state_t *bank_dec;
+    g726_bank_state_t *bank_rand_dec;
+    const int16_t *amp_in[BANK_CHANNELS];
+    int16_t *amp_out[BANK_CHANNELS];
+    uint8_t *adpcm_out[BANK_CHANNELS];
+    const uint8_t *adpcm_in[BANK_CHANNELS];
+    bitstream_state_t bs;
+    int bank_samples;
+    int bank_bytes;
+    int samples;
+    int bytes;
+    int failures;
+    int c;
+    int i;
+
+    for (c = 0;  c < BANK_CHANNELS;  c++)
+    {
+        bank_test_signal(linear[c], c, BANK_TEST_LEN);
+        for (i = 0;  i < BANK_TEST_LEN;  i++)
+        {
+            switch (ext_coding)
+            {
+            case G726_ENCODING_ALAW:
+                ((uint8_t *) in[c])[i] = linear_to_alaw(linear[c][i]);
+                break;
+            case G726_ENCODING_ULAW:
+                ((uint8_t *) in[c])[i] = linear_to_ulaw(linear[c][i]);
+                break;
+            default:
+                in[c][i] = linear[c][i];
+                break;
+            }
+        }
+        g726_init(&enc[c], bit_rate, ext_coding, packing);
+        g726_init(&dec[c], bit_rate, ext_coding, packing);
+        g726_init(&rand_dec[c], bit_rate, ext_coding, packing);
+        adpcm_out[c] = bank_adpcm[c];
+        adpcm_in[c] = bank_adpcm[c];
+        amp_out[c] = bank_out[c];
+    }
+    bank_enc = g726_bank_init(NULL, BANK_CHANNELS, bit_rate, ext_coding, packing);
+    bank_dec = g726_bank_init(NULL, BANK_CHANNELS, bit_rate, ext_coding, packing);
+    bank_rand_dec = g726_bank_init(NULL, BANK_CHANNELS, bit_rate, ext_coding, packing);
+    if (bank_enc == NULL  ||  bank_dec == NULL  ||  bank_rand_dec == NULL)
+        return 1;
+
+    failures = 0;
+    for (i = 0;  i < BANK_TEST_LEN;  i += frame_len)
+    {
+        /* Restart one channel part way through, as for a new call. The bank
+           keeps the channel's octet phase, so the separate contexts must too. */
+        if (i == 7*frame_len)
+        {
+            bs = enc[5].bs;
+            g726_init(&enc[5], bit_rate, ext_coding, packing);
+            enc[5].bs = bs;
+            bs = dec[5].bs;
+            g726_init(&dec[5], bit_rate, ext_coding, packing);
+            dec[5].bs = bs;
+            g726_bank_reset_channel(bank_enc, 5);
+            g726_bank_reset_channel(bank_dec, 5);
+        }
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            if (ext_coding == G726_ENCODING_LINEAR)
+                amp_in[c] = in[c] + i;
+            else
+                amp_in[c] = (const int16_t *) ((const uint8_t *) in[c] + i);
+        }
+        bank_bytes = g726_bank_encode(bank_enc, adpcm_out, amp_in, frame_len);
+        bank_samples = g726_bank_decode(bank_dec, amp_out, adpcm_in, bank_bytes);
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            bytes = g726_encode(&enc[c], ref_adpcm[c], amp_in[c], frame_len);
+            if (bytes != bank_bytes  ||  memcmp(ref_adpcm[c], bank_adpcm[c], bytes))
+            {
+                printf("Bank encode mismatch - channel %d, sample %d\n", c, i);
+                failures++;
+                continue;
+            }
+            samples = g726_decode(&dec[c], ref_out[c], ref_adpcm[c], bytes);
+            if (ext_coding == G726_ENCODING_LINEAR)
+                bytes = samples*sizeof(int16_t);
+            else
+                bytes = samples;
+            if (samples != bank_samples  ||  memcmp(ref_out[c], bank_out[c], bytes))
+            {
+                printf("Bank decode mismatch - channel %d, sample %d\n", c, i);
+                failures++;
+            }
+        }
+    }
+
+    /* Random ADPCM data drives the decoders to the limits of their adaption
+       much more than real signals */
+    for (i = 0;  i < BANK_TEST_LEN;  i += frame_len)
+    {
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            for (bytes = 0;  bytes < frame_len;  bytes++)
+                bank_adpcm[c][bytes] = (uint8_t) (rand() >> 8);
+        }
+        bank_samples = g726_bank_decode(bank_rand_dec, amp_out, adpcm_in, frame_len);
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            samples = g726_decode(&rand_dec[c], ref_out[c], bank_adpcm[c], frame_len);
+            if (ext_coding == G726_ENCODING_LINEAR)
+                bytes = samples*sizeof(int16_t);
+            else
+                bytes = samples;
+            if (samples != bank_samples  ||  memcmp(ref_out[c], bank_out[c], bytes))
+            {
+                printf("Bank random decode mismatch - channel %d, sample %d\n", c, i);
+                failures++;
+            }
+        }
+    }
+    g726_bank_release(bank_enc);
+    g726_bank_release(bank_dec);
+    g726_bank_release(bank_rand_dec);
+    return failures;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_bank_itu(const test_set_t *set, int pcm_len, int adpcm_len)
+{
+    static uint8_t bank_adpcm[BANK_ITU_CHANNELS][MAX_TEST_VECTOR_LEN];
+    static int16_t bank_out[BANK_ITU_CHANNELS][MAX_TEST_VECTOR_LEN];
+    g726_bank_state_t *bank;
+    const int16_t *amp_in[BANK_ITU_CHANNELS];
+    int16_t *amp_out[BANK_ITU_CHANNELS];
+    uint8_t *adpcm_out[BANK_ITU_CHANNELS];
+    const uint8_t *adpcm_in[BANK_ITU_CHANNELS];
+    int failures;
+    int bytes;
+    int len;
+    int c;
+
+    /* Run the vector through every channel of a bank, and check each one
+       matches the single context results, which have already been checked
+       against the ITU reference data. */
+    failures = 0;
+    for (c = 0;  c < BANK_ITU_CHANNELS;  c++)
+    {
+        amp_in[c] = itudata;
+        adpcm_out[c] = bank_adpcm[c];
+        adpcm_in[c] = unpacked;
+        amp_out[c] = bank_out[c];
+    }
+    if (set->compression_law != G726_ENCODING_NONE)
+    {
+        bank = g726_bank_init(NULL, BANK_ITU_CHANNELS, set->rate, set->compression_law, G726_PACKING_NONE);
+        len = g726_bank_encode(bank, adpcm_out, amp_in, pcm_len);
+        for (c = 0;  c < BANK_ITU_CHANNELS;  c++)
+        {
+            if (memcmp(bank_adpcm[c], adpcmdata, len))
+            {
+                printf("Bank compressed mismatch - channel %d\n", c);
+                failures++;
+            }
+        }
+        g726_bank_release(bank);
+    }
+    bank = g726_bank_init(NULL, BANK_ITU_CHANNELS, set->rate, set->decompression_law, G726_PACKING_NONE);
+    len = g726_bank_decode(bank, amp_out, adpcm_in, adpcm_len);
+    bytes = (set->decompression_law == G726_ENCODING_LINEAR)  ?  len*sizeof(int16_t)  :  len;
+    for (c = 0;  c < BANK_ITU_CHANNELS;  c++)
+    {
+        if (memcmp(bank_out[c], outdata, bytes))
+        {
+            printf("Bank decompressed mismatch - channel %d\n", c);
+            failures++;
+        }
+    }
+    g726_bank_release(bank);
+    return failures;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     g726_state_t enc_state;
@@ -1154,6 +1382,30 @@ int main(int argc, char *argv[])
     conditioning_samples = 0;
     if (itutests)
     {
+        printf("Testing G.726 banks against separate contexts\n");
+        for (bit_rate = 16000;  bit_rate <= 40000;  bit_rate += 8000)
+        {
+            for (i = G726_ENCODING_LINEAR;  i <= G726_ENCODING_ALAW;  i++)
+            {
+                for (packing = G726_PACKING_NONE;  packing <= G726_PACKING_RIGHT;  packing++)
+                {
+                    if (test_bank(bit_rate, i, packing, BANK_FRAME_LEN))
+                    {
+                        printf("Test failed - %dbps, coding %d, packing %d\n", bit_rate, i, packing);
+                        exit(2);
+                    }
+                    /* Frames which are not a whole number of octets leave the
+                       channel reset part way through an octet */
+                    if (test_bank(bit_rate, i, packing, BANK_ODD_FRAME_LEN))
+                    {
+                        printf("Test failed - %dbps, coding %d, packing %d, %d sample frames\n", bit_rate, i, packing, BANK_ODD_FRAME_LEN);
+                        exit(2);
+                    }
+                }
+            }
+        }
+        printf("Test passed\n");
+
         for (test = 0;  itu_test_sets[test].rate;  test++)
         {
             printf("Test %2d: '%s' + '%s'\n"
@@ -1271,6 +1523,13 @@ int main(int argc, char *argv[])
                 printf("Test %d: Length mismatch - ref = %d, processed = %d\n", test, samples, len3 - conditioning_adpcm);
                 exit(2);
             }
+            printf("Test %d: Bank check - %d channels\n", test, BANK_ITU_CHANNELS);
+            if (test_bank_itu(&itu_test_sets[test], len2, conditioning_adpcm + adpcm))
+            {
+                printf("Test failed\n");
+                exit(2);
+            }
+            printf("Test passed\n");
         }
 
         printf("Tests passed.\n");
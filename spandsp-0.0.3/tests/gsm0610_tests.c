@@ -149,6 +149,8 @@ will be compressed to GSM 06.10 data, decompressed, and the resulting audio stor
 
 #define HIST_LEN        1000
 
+#define CHECK_FRAMES    400
+
 uint8_t law_in_vector[1000000];
 int16_t in_vector[1000000];
 uint16_t code_vector_buf[1000000];
@@ -454,6 +456,79 @@ static int perform_law_test(int full, int law, const char *name)
     return 0;
 }
 
+static void check_test_signal(int16_t amp[], int len)
+{
+    uint32_t seed;
+    int tri;
+    int step;
+    int shift;
+    int i;
+    int v;
+
+    /* A triangle wave with some noise, generated with integer arithmetic so it is
+       the same everywhere. The level steps every 40 frames, from silence up to
+       hard clipping, so the encoder's scaling is pushed to both extremes. */
+    seed = 1;
+    tri = 0;
+    step = 97;
+    for (i = 0;  i < len;  i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        tri += step;
+        if (tri > 12000  ||  tri < -12000)
+        {
+            step = -step;
+            tri += 2*step;
+        }
+        v = tri + ((int32_t) (seed >> 16) - 32768)/8;
+        shift = (i/(40*BLOCK_LEN))%10;
+        if (shift == 0)
+            v = 0;
+        else if (shift < 8)
+            v >>= (8 - shift);
+        else
+            v *= 4*(shift - 7);
+        /*endif*/
+        amp[i] = saturate(v);
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static int perform_check_test(uint32_t encoded_check)
+{
+    static int16_t amp[CHECK_FRAMES*BLOCK_LEN];
+    static uint8_t code[CHECK_FRAMES*76];
+    gsm0610_state_t *gsm0610_enc_state;
+    uint32_t check;
+    int len;
+    int i;
+
+    /* Without the ETSI vectors, this at least checks the encoder's hot loops, which
+       have SIMD versions on some machines, give the same results as always */
+    printf("Performing encoder check test\n");
+    check_test_signal(amp, CHECK_FRAMES*BLOCK_LEN);
+    if ((gsm0610_enc_state = gsm0610_init(NULL, GSM0610_PACKING_NONE)) == NULL)
+    {
+        fprintf(stderr, "    Cannot create encoder\n");
+        exit(2);
+    }
+    len = gsm0610_encode(gsm0610_enc_state, code, amp, CHECK_FRAMES);
+    gsm0610_release(gsm0610_enc_state);
+    for (check = 0, i = 0;  i < len;  i++)
+        check = check*31 + code[i];
+    /*endfor*/
+    if (check != encoded_check)
+    {
+        printf("Test failed: encoded data check mismatch - %08X %08X\n", check, encoded_check);
+        exit(2);
+    }
+    /*endif*/
+    printf("Test passed\n");
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     AFfilehandle inhandle;
@@ -491,6 +566,7 @@ int main(int argc, char *argv[])
 
     if (etsitests)
     {
+        perform_check_test(0x31E6D160);
         perform_linear_test(TRUE, 1, "Seq01");
         perform_linear_test(TRUE, 1, "Seq02");
         perform_linear_test(TRUE, 1, "Seq03");
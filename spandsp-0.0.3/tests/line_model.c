@@ -46,6 +46,10 @@
 #include <math.h>
 #endif
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 #include "spandsp.h"
 #include "spandsp/g168models.h"
 
@@ -214,31 +218,36 @@ static float *models[] =
     ad_9_edd_3_model
 };
 
-static float calc_near_line_filter(one_way_line_model_state_t *s, float v)
+static __inline__ float line_filter(const float *coeffs, int len, float *buf, int *ptr, float v)
 {
     float sum;
     int j;
     int p;
 
-    /* Add the sample in the filter buffer */
-    p = s->near_buf_ptr;
-    s->near_buf[p] = v;
-    if (++p == s->near_filter_len)
+    /* Add the sample in the filter buffer, and its mirror image */
+    p = *ptr;
+    buf[p] = v;
+    buf[p + len] = v;
+    if (++p == len)
         p = 0;
-    s->near_buf_ptr = p;
-    
-    /* Apply the filter */
+    *ptr = p;
+
+    /* Apply the filter. The history is contiguous from buf[p], oldest first */
+    buf += p;
     sum = 0;
-    for (j = 0;  j < s->near_filter_len;  j++)
-    {
-        sum += s->near_filter[j]*s->near_buf[p];
-        if (++p >= s->near_filter_len)
-            p = 0;
-    }
-    
+    for (j = 0;  j < len;  j++)
+        sum += coeffs[j]*buf[j];
+    return sum;
+}
+/*- End of function --------------------------------------------------------*/
+
+static float calc_near_line_filter(one_way_line_model_state_t *s, float v)
+{
+    float sum;
+
+    sum = line_filter(s->near_filter, s->near_filter_len, s->near_buf, &s->near_buf_ptr, v);
     /* Add noise */
     sum += awgn(&s->near_noise);
-    
     return sum;
 }
 /*- End of function --------------------------------------------------------*/
@@ -246,29 +255,127 @@ static float calc_near_line_filter(one_way_line_model_state_t *s, float v)
 static float calc_far_line_filter(one_way_line_model_state_t *s, float v)
 {
     float sum;
+
+    sum = line_filter(s->far_filter, s->far_filter_len, s->far_buf, &s->far_buf_ptr, v);
+    /* Add noise */
+    sum += awgn(&s->far_noise);
+    return sum;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Filter a block of samples. This gives exactly the same answers as
+   line_filter() a sample at a time. Each output is still summed in the
+   same order, oldest sample first, so vectorising across neighbouring
+   outputs (rather than along the filter) doesn't change the rounding.
+   That only holds if the scalar code also does its float maths in SSE
+   registers, rather than on the x87 stack, and the compiler isn't fusing
+   multiplies and adds. */
+static void line_filter_block(const float *coeffs,
+                              int len,
+                              float *buf,
+                              int *ptr,
+                              float out[],
+                              const float in[],
+                              int samples)
+{
+    float x[LINE_FILTER_SIZE - 1 + LINE_MODEL_BLOCK];
+    float sum;
+    int i;
     int j;
     int p;
+#if defined(__SSE__)  &&  (defined(__x86_64__)  ||  defined(__SSE_MATH__))
+    __m128 acc0;
+    __m128 acc1;
+    __m128 c;
+#endif
 
-    /* Add the sample in the filter buffer */
-    p = s->far_buf_ptr;
-    s->far_buf[p] = v;
-    if (++p == s->far_filter_len)
-        p = 0;
-    s->far_buf_ptr = p;
-    
-    /* Apply the filter */
-    sum = 0;
-    for (j = 0;  j < s->far_filter_len;  j++)
+    /* Lay the history and the new samples out in one line */
+    p = *ptr;
+    memcpy(x, buf + p + 1, (len - 1)*sizeof(float));
+    memcpy(x + len - 1, in, samples*sizeof(float));
+
+    i = 0;
+#if defined(__SSE__)  &&  (defined(__x86_64__)  ||  defined(__SSE_MATH__))
+    for (  ;  i + 8 <= samples;  i += 8)
     {
-        sum += s->far_filter[j]*s->far_buf[p];
-        if (++p >= s->far_filter_len)
+        acc0 = _mm_setzero_ps();
+        acc1 = _mm_setzero_ps();
+        for (j = 0;  j < len;  j++)
+        {
+            c = _mm_set1_ps(coeffs[j]);
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(c, _mm_loadu_ps(x + i + j)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(c, _mm_loadu_ps(x + i + j + 4)));
+        }
+        _mm_storeu_ps(out + i, acc0);
+        _mm_storeu_ps(out + i + 4, acc1);
+    }
+    for (  ;  i + 4 <= samples;  i += 4)
+    {
+        acc0 = _mm_setzero_ps();
+        for (j = 0;  j < len;  j++)
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_set1_ps(coeffs[j]), _mm_loadu_ps(x + i + j)));
+        _mm_storeu_ps(out + i, acc0);
+    }
+#endif
+    for (  ;  i < samples;  i++)
+    {
+        sum = 0;
+        for (j = 0;  j < len;  j++)
+            sum += coeffs[j]*x[i + j];
+        out[i] = sum;
+    }
+
+    /* Bring the ring buffer up to date */
+    for (i = 0;  i < samples;  i++)
+    {
+        buf[p] = in[i];
+        buf[p + len] = in[i];
+        if (++p == len)
             p = 0;
     }
-    
-    /* Add noise */
-    sum += awgn(&s->far_noise);
+    *ptr = p;
+}
+/*- End of function --------------------------------------------------------*/
 
-    return sum;
+static void one_way_line_model_block(one_way_line_model_state_t *s, 
+                                     int16_t *output,
+                                     const int16_t *input,
+                                     int samples)
+{
+    float in[LINE_MODEL_BLOCK];
+    float out[LINE_MODEL_BLOCK];
+    int16_t amp[LINE_MODEL_BLOCK];
+    int16_t delayed;
+    int i;
+
+    /* Near end analogue section */
+    for (i = 0;  i < samples;  i++)
+        in[i] = input[i];
+    line_filter_block(s->near_filter, s->near_filter_len, s->near_buf, &s->near_buf_ptr, out, in, samples);
+    for (i = 0;  i < samples;  i++)
+    {
+        out[i] += awgn(&s->near_noise);
+        amp[i] = out[i];
+    }
+
+    /* Long distance digital section */
+    codec_munge(s->munge, amp, samples);
+    for (i = 0;  i < samples;  i++)
+    {
+        delayed = s->bulk_delay_buf[s->bulk_delay_ptr];
+        s->bulk_delay_buf[s->bulk_delay_ptr] = amp[i];
+        if (++s->bulk_delay_ptr >= s->bulk_delay)
+            s->bulk_delay_ptr = 0;
+        in[i] = delayed;
+    }
+
+    /* Far end analogue section */
+    line_filter_block(s->far_filter, s->far_filter_len, s->far_buf, &s->far_buf_ptr, out, in, samples);
+    for (i = 0;  i < samples;  i++)
+    {
+        out[i] += awgn(&s->far_noise);
+        output[i] = out[i];
+    }
 }
 /*- End of function --------------------------------------------------------*/
 
@@ -302,6 +409,18 @@ void one_way_line_model(one_way_line_model_state_t *s,
           | < hybrid
         terminal
      */
+    if (samples >= 4)
+    {
+        for (i = 0;  i < samples;  i += LINE_MODEL_BLOCK)
+        {
+            one_way_line_model_block(s,
+                                     output + i,
+                                     input + i,
+                                     (samples - i > LINE_MODEL_BLOCK)  ?  LINE_MODEL_BLOCK  :  (samples - i));
+        }
+        return;
+    }
+    /* Not worth setting up a block for a few samples */
     for (i = 0;  i < samples;  i++)
     {
         in = input[i];
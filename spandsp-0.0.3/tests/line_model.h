@@ -58,6 +58,10 @@ The path being modelled is:
 
 #define LINE_FILTER_SIZE 129
 
+/*! The largest block one_way_line_model() filters in one go. Longer calls
+    are split into blocks of this size. */
+#define LINE_MODEL_BLOCK 160
+
 /*!
     One way line model descriptor. This holds the complete state of
     a line model with transmission in only one direction.
@@ -70,9 +74,11 @@ typedef struct
     float *near_filter;
     /*! The number of coefficients for the near end analogue section simulation filter */
     int near_filter_len;
-    /*! Last transmitted samples (ring buffer, used by the line filter) */
-    float near_buf[LINE_FILTER_SIZE];
-    /*! Pointer of the last transmitted sample in buf */
+    /*! Last transmitted samples (ring buffer, used by the line filter). Each
+        sample is stored twice, LINE_FILTER_SIZE apart, so the whole history
+        is always available contiguously, starting at the oldest sample. */
+    float near_buf[2*LINE_FILTER_SIZE];
+    /*! Pointer to the oldest sample in buf */
     int near_buf_ptr;
     /*! The noise source for local analogue section of the line */
     awgn_state_t near_noise;
@@ -88,9 +94,11 @@ typedef struct
     float *far_filter;
     /*! The number of coefficients for the far end analogue section simulation filter */
     int far_filter_len;
-    /*! Last transmitted samples (ring buffer, used by the line filter) */
-    float far_buf[LINE_FILTER_SIZE];
-    /*! Pointer of the last transmitted sample in buf */
+    /*! Last transmitted samples (ring buffer, used by the line filter). Each
+        sample is stored twice, LINE_FILTER_SIZE apart, so the whole history
+        is always available contiguously, starting at the oldest sample. */
+    float far_buf[2*LINE_FILTER_SIZE];
+    /*! Pointer to the oldest sample in buf */
     int far_buf_ptr;
     /*! The noise source for distant analogue section of the line */
     awgn_state_t far_noise;
@@ -137,6 +145,14 @@ both_ways_line_model_state_t *both_ways_line_model_init(int model1,
 
 int both_ways_line_model_release(both_ways_line_model_state_t *s);
 
+/*! Process a block of samples through a one way line model. Blocks of
+    several samples are filtered and munged a block at a time, which is much
+    faster than a sample at a time, but the results are bit exact whatever
+    block sizes are used.
+    \param s The line model context.
+    \param output The output samples.
+    \param input The input samples.
+    \param samples The number of samples. */
 void one_way_line_model(one_way_line_model_state_t *s, 
                         int16_t *output,
                         const int16_t *input,
@@ -161,6 +161,64 @@ static void test_one_way_model(int line_model_no, int speech_test)
     one_way_line_model_release(model);
 }
 
+static void test_one_way_model_block(int line_model_no)
+{
+    one_way_line_model_state_t *model1;
+    one_way_line_model_state_t *model2;
+    int16_t input1[BLOCK_LEN];
+    int16_t output1[BLOCK_LEN];
+    int16_t output2[BLOCK_LEN];
+    int codecs[] = {MUNGE_CODEC_NONE, MUNGE_CODEC_ALAW, MUNGE_CODEC_ULAW, MUNGE_CODEC_G726_32K};
+    int i;
+    int j;
+    int k;
+    awgn_state_t noise1;
+    clock_t start;
+    clock_t end;
+
+    /* The block mode model must give exactly the same answers as running it
+       a sample at a time */
+    for (k = 0;  k < 4;  k++)
+    {
+        model1 = one_way_line_model_init(line_model_no, -50, codecs[k]);
+        model2 = one_way_line_model_init(line_model_no, -50, codecs[k]);
+        if (model1 == NULL  ||  model2 == NULL)
+        {
+            fprintf(stderr, "    Failed to create line model\n");
+            exit(2);
+        }
+        awgn_init_dbm0(&noise1, 1234567, -10.0f);
+        for (i = 0;  i < 1000;  i++)
+        {
+            for (j = 0;  j < BLOCK_LEN;  j++)
+                input1[j] = awgn(&noise1);
+            for (j = 0;  j < BLOCK_LEN;  j++)
+                one_way_line_model(model1, &output1[j], &input1[j], 1);
+            one_way_line_model(model2, output2, input1, BLOCK_LEN);
+            if (memcmp(output1, output2, sizeof(output1)))
+            {
+                fprintf(stderr, "    Block mode line model differs (codec %d, block %d)\n", codecs[k], i);
+                exit(2);
+            }
+        }
+        one_way_line_model_release(model1);
+        one_way_line_model_release(model2);
+    }
+
+    /* See how much faster than real time it runs */
+    model1 = one_way_line_model_init(line_model_no, -50, MUNGE_CODEC_ALAW);
+    for (j = 0;  j < BLOCK_LEN;  j++)
+        input1[j] = awgn(&noise1);
+    start = clock();
+    for (i = 0;  i < 10000;  i++)
+        one_way_line_model(model1, output1, input1, BLOCK_LEN);
+    end = clock();
+    one_way_line_model_release(model1);
+    printf("Block mode line model is bit exact, and runs at %.0fx real time\n",
+           (10000.0*BLOCK_LEN/SAMPLE_RATE)/((double) (end - start)/CLOCKS_PER_SEC));
+}
+/*- End of function --------------------------------------------------------*/
+
 static void test_both_ways_model(int line_model_no, int speech_test)
 {
     both_ways_line_model_state_t *model;
@@ -297,6 +355,7 @@ int main(int argc, char *argv[])
     if (argc > 2)
         speech_test = FALSE;
     test_one_way_model(line_model_no, speech_test);
+    test_one_way_model_block(line_model_no);
     test_both_ways_model(line_model_no, speech_test);
 }
 /*- End of function --------------------------------------------------------*/
@@ -69,6 +69,100 @@ will be compressed to LPC10 data, decompressed, and the resulting audio stored i
 #define DECOMPRESS_FILE_NAME    "lpc10_in.lpc10"
 #define OUT_FILE_NAME           "post_lpc10.wav"
 
+#define BATCH_CHANNELS          4
+#define BATCH_FRAMES            200
+
+static void batch_test_signal(int16_t amp[], int chan, int len)
+{
+    uint32_t seed;
+    int tri;
+    int step;
+    int i;
+
+    /* A triangle wave with some noise, generated with integer arithmetic so it is
+       the same everywhere. It switches on and off, so both voiced and unvoiced
+       frames are seen. */
+    seed = chan + 1;
+    tri = 0;
+    step = 150 + 37*chan;
+    for (i = 0;  i < len;  i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        tri += step;
+        if (tri > 8000  ||  tri < -8000)
+        {
+            step = -step;
+            tri += 2*step;
+        }
+        amp[i] = (int16_t) ((((i/2000) & 1)  ?  tri  :  0) + ((int32_t) (seed >> 16) - 32768)/64);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_batch(void)
+{
+    static int16_t linear[BATCH_CHANNELS][BATCH_FRAMES*BLOCK_LEN];
+    static uint8_t ref_code[BATCH_CHANNELS][BATCH_FRAMES*7];
+    static uint8_t batch_code[BATCH_CHANNELS][BATCH_FRAMES*7];
+    lpc10_encode_state_t *enc;
+    lpc10_encode_state_t *batch_enc[BATCH_CHANNELS];
+    const int16_t *amp_in[BATCH_CHANNELS];
+    uint8_t *code_out[BATCH_CHANNELS];
+    int bytes;
+    int batch_bytes;
+    int failures;
+    int c;
+    int i;
+
+    /* Encode some channels one at a time, and all together with a few frames per
+       call, and check the results are identical */
+    printf("Performing batch test - %d channels\n", BATCH_CHANNELS);
+    failures = 0;
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        batch_test_signal(linear[c], c, BATCH_FRAMES*BLOCK_LEN);
+        if ((enc = lpc10_encode_init(NULL, TRUE)) == NULL)
+        {
+            fprintf(stderr, "    Cannot create encoder\n");
+            exit(2);
+        }
+        bytes = lpc10_encode(enc, ref_code[c], linear[c], BATCH_FRAMES);
+        lpc10_encode_release(enc);
+        if ((batch_enc[c] = lpc10_encode_init(NULL, TRUE)) == NULL)
+        {
+            fprintf(stderr, "    Cannot create encoder\n");
+            exit(2);
+        }
+    }
+    batch_bytes = 0;
+    for (i = 0;  i < BATCH_FRAMES;  i += 5)
+    {
+        for (c = 0;  c < BATCH_CHANNELS;  c++)
+        {
+            amp_in[c] = &linear[c][i*BLOCK_LEN];
+            code_out[c] = &batch_code[c][batch_bytes];
+        }
+        batch_bytes += lpc10_encode_batch(batch_enc, code_out, amp_in, BATCH_CHANNELS, 5);
+    }
+    for (c = 0;  c < BATCH_CHANNELS;  c++)
+    {
+        if (bytes != batch_bytes  ||  memcmp(ref_code[c], batch_code[c], bytes))
+        {
+            printf("Batch encode mismatch - channel %d\n", c);
+            failures++;
+        }
+        lpc10_encode_release(batch_enc[c]);
+    }
+    if (failures)
+    {
+        printf("Tests failed.\n");
+        exit(2);
+    }
+    printf("Test passed\n");
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     AFfilehandle inhandle;
@@ -128,6 +222,8 @@ int main(int argc, char *argv[])
         }
     }
 
+    test_batch();
+
     compress_file = -1;
     decompress_file = -1;
     inhandle = AF_NULL_FILEHANDLE;
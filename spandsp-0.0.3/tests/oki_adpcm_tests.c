@@ -66,6 +66,142 @@ compression may be tested.
 
 #define HIST_LEN        1000
 
+#define BANK_CHANNELS   13
+#define BANK_FRAME_LEN  160
+#define BANK_TEST_LEN   8000
+
+static void bank_test_signal(int16_t amp[], int chan, int len)
+{
+    static uint32_t seed = 1;
+    int i;
+    int level;
+
+    /* A different mix for each channel - noise, tones, overload and silence -
+       so the channels take different paths through the step size adaption */
+    level = 32767 >> (chan%6);
+    for (i = 0;  i < len;  i++)
+    {
+        seed = seed*1664525 + 1013904223;
+        switch (chan%4)
+        {
+        case 0:
+            amp[i] = (int16_t) (((int16_t) (seed >> 16)*level) >> 15);
+            break;
+        case 1:
+            amp[i] = (int16_t) (level*sin(2.0*3.14159*(300.0 + 250.0*chan)*i/8000.0));
+            break;
+        case 2:
+            amp[i] = ((i/1000) & 1)  ?  0  :  (int16_t) (level*sin(2.0*3.14159*1800.0*i/8000.0));
+            break;
+        default:
+            amp[i] = ((i/400) & 1)  ?  (int16_t) (seed >> 16)  :  -32768;
+            break;
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int test_bank(int bit_rate)
+{
+    static int16_t in[BANK_CHANNELS][BANK_TEST_LEN];
+    static uint8_t ref_adpcm[BANK_CHANNELS][BANK_FRAME_LEN];
+    static uint8_t bank_adpcm[BANK_CHANNELS][BANK_FRAME_LEN];
+    static int16_t ref_out[BANK_CHANNELS][2*BANK_FRAME_LEN];
+    static int16_t bank_out[BANK_CHANNELS][2*BANK_FRAME_LEN];
+    oki_adpcm_state_t enc[BANK_CHANNELS];
+    oki_adpcm_state_t dec[BANK_CHANNELS];
+    oki_adpcm_state_t rand_dec[BANK_CHANNELS];
+    oki_adpcm_bank_state_t *bank_enc;
+    oki_adpcm_bank_state_t *bank_dec;
+    oki_adpcm_bank_state_t *bank_rand_dec;
+    const int16_t *amp_in[BANK_CHANNELS];
+    int16_t *amp_out[BANK_CHANNELS];
+    uint8_t *adpcm_out[BANK_CHANNELS];
+    const uint8_t *adpcm_in[BANK_CHANNELS];
+    int bank_samples;
+    int bank_bytes;
+    int samples;
+    int bytes;
+    int failures;
+    int c;
+    int i;
+
+    for (c = 0;  c < BANK_CHANNELS;  c++)
+    {
+        bank_test_signal(in[c], c, BANK_TEST_LEN);
+        oki_adpcm_init(&enc[c], bit_rate);
+        oki_adpcm_init(&dec[c], bit_rate);
+        oki_adpcm_init(&rand_dec[c], bit_rate);
+        adpcm_out[c] = bank_adpcm[c];
+        adpcm_in[c] = bank_adpcm[c];
+        amp_out[c] = bank_out[c];
+    }
+    bank_enc = oki_adpcm_bank_init(NULL, BANK_CHANNELS, bit_rate);
+    bank_dec = oki_adpcm_bank_init(NULL, BANK_CHANNELS, bit_rate);
+    bank_rand_dec = oki_adpcm_bank_init(NULL, BANK_CHANNELS, bit_rate);
+    if (bank_enc == NULL  ||  bank_dec == NULL  ||  bank_rand_dec == NULL)
+        return 1;
+
+    failures = 0;
+    for (i = 0;  i < BANK_TEST_LEN;  i += BANK_FRAME_LEN)
+    {
+        /* Restart one channel part way through, as for a new call */
+        if (i == BANK_TEST_LEN/2)
+        {
+            oki_adpcm_init(&enc[5], bit_rate);
+            oki_adpcm_init(&dec[5], bit_rate);
+            oki_adpcm_bank_reset_channel(bank_enc, 5);
+            oki_adpcm_bank_reset_channel(bank_dec, 5);
+        }
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+            amp_in[c] = in[c] + i;
+        bank_bytes = oki_adpcm_bank_encode(bank_enc, adpcm_out, amp_in, BANK_FRAME_LEN);
+        bank_samples = oki_adpcm_bank_decode(bank_dec, amp_out, adpcm_in, bank_bytes);
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            bytes = oki_adpcm_encode(&enc[c], ref_adpcm[c], amp_in[c], BANK_FRAME_LEN);
+            if (bytes != bank_bytes  ||  memcmp(ref_adpcm[c], bank_adpcm[c], bytes))
+            {
+                printf("Bank encode mismatch - channel %d, sample %d\n", c, i);
+                failures++;
+                continue;
+            }
+            samples = oki_adpcm_decode(&dec[c], ref_out[c], ref_adpcm[c], bytes);
+            if (samples != bank_samples  ||  memcmp(ref_out[c], bank_out[c], samples*sizeof(int16_t)))
+            {
+                printf("Bank decode mismatch - channel %d, sample %d\n", c, i);
+                failures++;
+            }
+        }
+    }
+
+    /* Random ADPCM data drives the decoders to the limits of their adaption
+       much more than real signals */
+    for (i = 0;  i < BANK_TEST_LEN;  i += BANK_FRAME_LEN)
+    {
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            for (bytes = 0;  bytes < BANK_FRAME_LEN/2;  bytes++)
+                bank_adpcm[c][bytes] = (uint8_t) (rand() >> 8);
+        }
+        bank_samples = oki_adpcm_bank_decode(bank_rand_dec, amp_out, adpcm_in, BANK_FRAME_LEN/2);
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            samples = oki_adpcm_decode(&rand_dec[c], ref_out[c], bank_adpcm[c], BANK_FRAME_LEN/2);
+            if (samples != bank_samples  ||  memcmp(ref_out[c], bank_out[c], samples*sizeof(int16_t)))
+            {
+                printf("Bank random decode mismatch - channel %d, sample %d\n", c, i);
+                failures++;
+            }
+        }
+    }
+    oki_adpcm_bank_release(bank_enc);
+    oki_adpcm_bank_release(bank_dec);
+    oki_adpcm_bank_release(bank_rand_dec);
+    return failures;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     int i;
@@ -113,6 +249,13 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
+    printf("Testing Oki ADPCM banks against separate contexts\n");
+    if (test_bank(32000)  ||  test_bank(24000))
+    {
+        printf("Tests failed.\n");
+        exit(2);
+    }
+
     if ((inhandle = afOpenFile(in_file_name, "r", 0)) == AF_NULL_FILEHANDLE)
     {
         printf("    Cannot open wave file '%s'\n", in_file_name);
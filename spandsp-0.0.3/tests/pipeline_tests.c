@@ -0,0 +1,444 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * pipeline_tests.c - Tests for the channel processing pipeline.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+/*! \page pipeline_tests_page Channel processing pipeline tests
+\section pipeline_tests_page_sec_1 What does it do?
+These tests build a channel's transmitted audio, from noise, and its received
+audio, from an echo of the transmitted audio with DTMF digits added. Some chunks
+of the received audio are treated as lost. The channel is processed by an echo
+canceller, a DTMF receiver, a packet loss concealer and a G.726 encoder, first
+by calling each module in turn over each chunk, and then through pipelines with
+a range of block sizes. The audio, the encoded output and the digits must be
+exactly the same every time. A second channel, with a tone analysis engine and
+an A-law encoder, is checked the same way.
+
+The time taken with and without a pipeline is then measured, and the time spent
+in each stage of the pipeline is reported.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <inttypes.h>
+#if defined(HAVE_TGMATH_H)
+#include <tgmath.h>
+#endif
+#if defined(HAVE_MATH_H)
+#include <math.h>
+#endif
+#include <tiffio.h>
+
+#include "spandsp.h"
+
+#define TEST_LEN                (10*SAMPLE_RATE)
+#define CHUNK_LEN               160
+#define ECHO_DELAY              40
+#define EC_TAPS                 256
+#define TIMING_PASSES           10
+#define LOG_LEN                 256
+
+typedef struct
+{
+    echo_can_state_t *ec;
+    dtmf_rx_state_t dtmf;
+    tone_analysis_state_t engine;
+    plc_state_t plc;
+    g726_state_t g726;
+    pipeline_state_t pipeline;
+    int16_t amp[TEST_LEN];
+    int16_t ref[TEST_LEN];
+    uint8_t code[TEST_LEN];
+    int code_len;
+    char digits[LOG_LEN];
+} channel_t;
+
+static int16_t tx_signal[TEST_LEN];
+static int16_t rx_signal[TEST_LEN];
+static channel_t reference;
+static channel_t piped;
+
+static int chunk_lost(int chunk)
+{
+    /* Scattered single losses, after the digits, and one burst long enough for
+       the fill-in to fade to silence */
+    return ((chunk >= 120  &&  (chunk%17) == 16)  ||  (chunk >= 200  &&  chunk < 204));
+}
+/*- End of function --------------------------------------------------------*/
+
+static void make_test_signals(void)
+{
+    dtmf_tx_state_t dtmf_gen;
+    awgn_state_t noise_source;
+    int16_t digits[TEST_LEN];
+    int len;
+    int i;
+
+    awgn_init_dbm0(&noise_source, 1234567, -15.0f);
+    for (i = 0;  i < TEST_LEN;  i++)
+        tx_signal[i] = awgn(&noise_source);
+
+    memset(digits, 0, sizeof(digits));
+    dtmf_tx_init(&dtmf_gen);
+    dtmf_tx_put(&dtmf_gen, "123456789*0#ABCD");
+    len = dtmf_tx(&dtmf_gen, &digits[SAMPLE_RATE/2], TEST_LEN - SAMPLE_RATE/2);
+    if (len <= 0)
+    {
+        printf("    No DTMF generated\n");
+        printf("Tests failed.\n");
+        exit(2);
+    }
+    /* The received audio is a delayed, attenuated echo of the transmitted audio,
+       with the digits on top. */
+    for (i = 0;  i < TEST_LEN;  i++)
+    {
+        rx_signal[i] = digits[i];
+        if (i >= ECHO_DELAY)
+            rx_signal[i] += tx_signal[i - ECHO_DELAY]/4;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void channel_init(channel_t *chan, int with_engine)
+{
+    chan->ec = echo_can_create(EC_TAPS, ECHO_CAN_USE_ADAPTION | ECHO_CAN_USE_NLP | ECHO_CAN_USE_CLIP | ECHO_CAN_USE_TX_HPF);
+    dtmf_rx_init(&chan->dtmf, NULL, NULL);
+    if (with_engine)
+    {
+        tone_analysis_init(&chan->engine);
+        dtmf_rx_subscribe(&chan->dtmf, &chan->engine);
+    }
+    plc_init(&chan->plc);
+    g726_init(&chan->g726, 32000, G726_ENCODING_LINEAR, G726_PACKING_LEFT);
+    memcpy(chan->amp, rx_signal, sizeof(rx_signal));
+    memcpy(chan->ref, tx_signal, sizeof(tx_signal));
+    chan->code_len = 0;
+    chan->digits[0] = '\0';
+}
+/*- End of function --------------------------------------------------------*/
+
+static void channel_collect(channel_t *chan)
+{
+    int len;
+
+    len = strlen(chan->digits);
+    dtmf_rx_get(&chan->dtmf, chan->digits + len, LOG_LEN - 1 - len);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void run_modules(channel_t *chan)
+{
+    int16_t *amp;
+    int16_t *ref;
+    int i;
+
+    /* Each module in turn, over each chunk */
+    for (i = 0;  i < TEST_LEN;  i += CHUNK_LEN)
+    {
+        amp = &chan->amp[i];
+        ref = &chan->ref[i];
+        if (chunk_lost(i/CHUNK_LEN))
+            memset(amp, 0, CHUNK_LEN*sizeof(amp[0]));
+        echo_can_hpf_tx_block(chan->ec, ref, CHUNK_LEN);
+        echo_can_update_block(chan->ec, amp, ref, amp, CHUNK_LEN);
+        dtmf_rx(&chan->dtmf, amp, CHUNK_LEN);
+        if (chunk_lost(i/CHUNK_LEN))
+            plc_fillin(&chan->plc, amp, CHUNK_LEN);
+        else
+            plc_rx(&chan->plc, amp, CHUNK_LEN);
+        chan->code_len += g726_encode(&chan->g726, &chan->code[chan->code_len], amp, CHUNK_LEN);
+        channel_collect(chan);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Each chunk is passed as two calls, of split samples and the rest, or as
+   one call when split is zero */
+static void run_pipeline(channel_t *chan, int split)
+{
+    int len;
+    int i;
+    int j;
+
+    for (i = 0;  i < TEST_LEN;  i += CHUNK_LEN)
+    {
+        for (j = i;  j < i + CHUNK_LEN;  j += len)
+        {
+            len = (split  &&  j == i)  ?  split  :  (i + CHUNK_LEN - j);
+            if (chunk_lost(i/CHUNK_LEN))
+                chan->code_len += pipeline_fillin(&chan->pipeline, &chan->amp[j], &chan->ref[j], len, &chan->code[chan->code_len]);
+            else
+                chan->code_len += pipeline_process(&chan->pipeline, &chan->amp[j], &chan->ref[j], len, &chan->code[chan->code_len]);
+        }
+        channel_collect(chan);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void build_pipeline(channel_t *chan, int block_size)
+{
+    if (pipeline_init(&chan->pipeline, block_size) == NULL
+        ||
+        pipeline_add_echo_can_hpf_tx(&chan->pipeline, chan->ec) < 0
+        ||
+        pipeline_add_echo_can(&chan->pipeline, chan->ec) < 0
+        ||
+        pipeline_add_dtmf_rx(&chan->pipeline, &chan->dtmf) < 0
+        ||
+        pipeline_add_plc(&chan->pipeline, &chan->plc) < 0
+        ||
+        pipeline_add_g726_encode(&chan->pipeline, &chan->g726) < 0)
+    {
+        printf("    Failed to build a pipeline with %d sample blocks\n", block_size);
+        printf("Tests failed.\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void compare_channels(channel_t *a, channel_t *b, int block_size)
+{
+    if (memcmp(a->amp, b->amp, sizeof(a->amp))
+        ||
+        memcmp(a->ref, b->ref, sizeof(a->ref))
+        ||
+        a->code_len != b->code_len
+        ||
+        memcmp(a->code, b->code, a->code_len)
+        ||
+        strcmp(a->digits, b->digits))
+    {
+        printf("    Pipeline with %d sample blocks differs from the separate modules\n", block_size);
+        printf("    Separate '%s', %d bytes\n", a->digits, a->code_len);
+        printf("    Pipeline '%s', %d bytes\n", b->digits, b->code_len);
+        printf("Tests failed.\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void check_stats(pipeline_state_t *s, int block_size)
+{
+    const char *name;
+    uint64_t samples;
+    uint64_t cycles;
+    int i;
+
+    for (i = 0;  pipeline_get_stage_stats(s, i, &name, &samples, &cycles) == 0;  i++)
+    {
+        if (samples != TEST_LEN)
+        {
+            printf("    Stage '%s' of the pipeline with %d sample blocks processed %" PRIu64 " samples\n", name, block_size, samples);
+            printf("Tests failed.\n");
+            exit(2);
+        }
+    }
+    if (i != s->stages)
+    {
+        printf("    Only %d of %d stages reported\n", i, s->stages);
+        printf("Tests failed.\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void equivalence_tests(void)
+{
+    static const int block_sizes[] =
+    {
+        PLC_PITCH_OVERLAP_MAX, 40, 80, 160, 333, 0
+    };
+    static const int splits[] =
+    {
+        PLC_PITCH_OVERLAP_MAX, 57, 0
+    };
+    int i;
+
+    printf("Test: pipelines give the same results as separate modules\n");
+    channel_init(&reference, FALSE);
+    run_modules(&reference);
+    echo_can_free(reference.ec);
+    if (strcmp(reference.digits, "123456789*0#ABCD"))
+    {
+        printf("    Separate modules received '%s'\n", reference.digits);
+        printf("Tests failed.\n");
+        exit(2);
+    }
+    for (i = 0;  block_sizes[i];  i++)
+    {
+        channel_init(&piped, FALSE);
+        build_pipeline(&piped, block_sizes[i]);
+        run_pipeline(&piped, 0);
+        echo_can_free(piped.ec);
+        compare_channels(&reference, &piped, block_sizes[i]);
+        check_stats(&piped.pipeline, block_sizes[i]);
+        printf("    %d sample blocks OK\n", block_sizes[i]);
+    }
+
+    /* Lost and recovered audio may be passed in smaller chunks, as long as the
+       first chunk holds the concealer's whole blend */
+    for (i = 0;  splits[i];  i++)
+    {
+        channel_init(&piped, FALSE);
+        build_pipeline(&piped, PIPELINE_DEFAULT_BLOCK_SIZE);
+        run_pipeline(&piped, splits[i]);
+        echo_can_free(piped.ec);
+        compare_channels(&reference, &piped, PIPELINE_DEFAULT_BLOCK_SIZE);
+        printf("    Chunks split at %d samples OK\n", splits[i]);
+    }
+
+    /* Blocks shorter than the concealer's blend can't be given to it */
+    pipeline_init(&piped.pipeline, PLC_PITCH_OVERLAP_MAX - 1);
+    if (pipeline_add_plc(&piped.pipeline, &piped.plc) >= 0)
+    {
+        printf("    A concealer was accepted with %d sample blocks\n", PLC_PITCH_OVERLAP_MAX - 1);
+        printf("Tests failed.\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void tone_analysis_pipeline_tests(void)
+{
+    static const int block_sizes[] =
+    {
+        1, 7, 80, 160, 0
+    };
+    int i;
+    int j;
+
+    /* A channel with no reference audio, no loss, a tone analysis engine and
+       an A-law encoder */
+    printf("Test: tone analysis pipelines give the same results as separate modules\n");
+    channel_init(&reference, TRUE);
+    echo_can_free(reference.ec);
+    for (j = 0;  j < TEST_LEN;  j += CHUNK_LEN)
+    {
+        tone_analysis(&reference.engine, &reference.amp[j], CHUNK_LEN);
+        g711_alaw_encode_block(&reference.code[j], &reference.amp[j], CHUNK_LEN);
+        channel_collect(&reference);
+    }
+    reference.code_len = TEST_LEN;
+    for (i = 0;  block_sizes[i];  i++)
+    {
+        channel_init(&piped, TRUE);
+        echo_can_free(piped.ec);
+        pipeline_init(&piped.pipeline, block_sizes[i]);
+        pipeline_add_tone_analysis(&piped.pipeline, &piped.engine);
+        pipeline_add_alaw_encode(&piped.pipeline);
+        for (j = 0;  j < TEST_LEN;  j += CHUNK_LEN)
+        {
+            piped.code_len += pipeline_process(&piped.pipeline, &piped.amp[j], NULL, CHUNK_LEN, &piped.code[j]);
+            channel_collect(&piped);
+        }
+        compare_channels(&reference, &piped, block_sizes[i]);
+        check_stats(&piped.pipeline, block_sizes[i]);
+        printf("    %d sample blocks OK\n", block_sizes[i]);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static double elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec)/1.0e9;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void timing_tests(void)
+{
+    struct timespec start;
+    struct timespec end;
+    double separate;
+    double pipelined;
+    const char *name;
+    uint64_t samples;
+    uint64_t cycles;
+    uint64_t total;
+    int pass;
+    int i;
+
+    printf("Test: pipeline timing, over %d seconds of audio.\n", TIMING_PASSES*TEST_LEN/SAMPLE_RATE);
+    separate = 0.0;
+    pipelined = 0.0;
+    total = 0;
+    for (pass = 0;  pass < TIMING_PASSES;  pass++)
+    {
+        channel_init(&reference, FALSE);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run_modules(&reference);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        separate += elapsed(&start, &end);
+        echo_can_free(reference.ec);
+
+        channel_init(&piped, FALSE);
+        build_pipeline(&piped, PIPELINE_DEFAULT_BLOCK_SIZE);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run_pipeline(&piped, 0);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        pipelined += elapsed(&start, &end);
+        echo_can_free(piped.ec);
+    }
+    printf("    Separate modules %.3fs, pipeline %.3fs\n", separate, pipelined);
+
+    /* The accounting is for the last pass */
+    for (i = 0;  pipeline_get_stage_stats(&piped.pipeline, i, &name, &samples, &cycles) == 0;  i++)
+        total += cycles;
+    for (i = 0;  pipeline_get_stage_stats(&piped.pipeline, i, &name, &samples, &cycles) == 0;  i++)
+    {
+        printf("    %-16s %8.1f per sample  %5.1f%%\n",
+               name,
+               (double) cycles/samples,
+               (total)  ?  100.0*cycles/total  :  0.0);
+    }
+    pipeline_reset_stats(&piped.pipeline);
+    pipeline_get_stage_stats(&piped.pipeline, 0, &name, &samples, &cycles);
+    if (samples  ||  cycles)
+    {
+        printf("    Stage accounting was not cleared\n");
+        printf("Tests failed.\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    make_test_signals();
+    equivalence_tests();
+    tone_analysis_pipeline_tests();
+    timing_tests();
+    printf("Tests passed.\n");
+    return  0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
@@ -40,6 +40,9 @@ command line. The PLC module is then used to reconstruct an acceptable
 approximation to the original signal. The resulting audio is written to a new
 audio file, called post_plc.wav. This file contains 8000 sample/second
 16 bits/sample linear audio.
+
+Before that, a check is made that a gap filled in with one call to plc_fillin()
+gives exactly the same audio as the same gap filled in by several shorter calls.
 */
 
 #ifdef HAVE_CONFIG_H
@@ -65,6 +68,78 @@ audio file, called post_plc.wav. This file contains 8000 sample/second
 #define INPUT_FILE_NAME     "../localtests/short_nb_voice.wav"
 #define OUTPUT_FILE_NAME    "post_plc.wav"
 
+static void make_voice(int16_t amp[], int len, uint32_t phase_acc[3], int32_t phase_rate)
+{
+    int i;
+
+    /* A buzz, rich in harmonics, which the pitch estimator can lock on to */
+    for (i = 0;  i < len;  i++)
+    {
+        amp[i] = (int16_t) (dds_modf(&phase_acc[0], phase_rate, 6000.0, 0)
+                          + dds_modf(&phase_acc[1], 2*phase_rate, 3000.0, 0)
+                          + dds_modf(&phase_acc[2], 3*phase_rate, 1500.0, 0));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int split_gap_tests(void)
+{
+    static const int splits[][4] =
+    {
+        {160, 0, 0, 0},
+        {80, 80, 0, 0},
+        {30, 130, 0, 0},
+        {53, 41, 66, 0},
+        {100, 37, 200, 143}
+    };
+    plc_state_t whole;
+    plc_state_t split;
+    int16_t speech[160];
+    int16_t amp[480 + 160];
+    int16_t amp2[480 + 160];
+    uint32_t phase_acc[3];
+    int32_t phase_rate;
+    int gap_len;
+    int i;
+    int j;
+    int k;
+
+    printf("Checking gaps give the same fill-in however they are split\n");
+    for (i = 0;  i < (int) (sizeof(splits)/sizeof(splits[0]));  i++)
+    {
+        plc_init(&whole);
+        plc_init(&split);
+        memset(phase_acc, 0, sizeof(phase_acc));
+        phase_rate = dds_phase_ratef(110.0f + 20.0f*i);
+        for (j = 0;  j < 5;  j++)
+        {
+            make_voice(speech, 160, phase_acc, phase_rate);
+            plc_rx(&whole, speech, 160);
+            plc_rx(&split, speech, 160);
+        }
+        gap_len = 0;
+        for (k = 0;  k < 4  &&  splits[i][k];  k++)
+        {
+            plc_fillin(&split, amp2 + gap_len, splits[i][k]);
+            gap_len += splits[i][k];
+        }
+        plc_fillin(&whole, amp, gap_len);
+        /* The blend back into real speech should match too */
+        make_voice(amp + gap_len, 160, phase_acc, phase_rate);
+        memcpy(amp2 + gap_len, amp + gap_len, 160*sizeof(amp[0]));
+        plc_rx(&whole, amp + gap_len, 160);
+        plc_rx(&split, amp2 + gap_len, 160);
+        if (memcmp(amp, amp2, (gap_len + 160)*sizeof(amp[0])))
+        {
+            printf("    A %d sample gap, split into %d calls, differs\n", gap_len, k);
+            return -1;
+        }
+        printf("    A %d sample gap, split into %d calls, matches\n", gap_len, k);
+    }
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     AFfilehandle inhandle;
@@ -113,6 +188,11 @@ int main(int argc, char *argv[])
         if (strcmp(argv[i], "-s") == 0)
             block_synthetic = TRUE;
     }
+    if (split_gap_tests())
+    {
+        printf("Tests failed.\n");
+        exit(2);
+    }
     if ((filesetup = afNewFileSetup()) == AF_NULL_FILESETUP)
     {
         fprintf(stderr, "    Failed to create file setup\n");
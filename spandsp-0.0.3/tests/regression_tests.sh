@@ -70,6 +70,15 @@ then
 fi
 echo bell_mf_rx_tests completed OK
 
+./bell_mf_rx_tests -i >$STDOUT_DEST 2>$STDERR_DEST
+RETVAL=$?
+if [ $RETVAL != 0 ]
+then
+    echo bell_mf_rx_tests -i failed!
+    exit $RETVAL
+fi
+echo bell_mf_rx_tests -i completed OK
+
 ./bell_mf_tx_tests >$STDOUT_DEST 2>$STDERR_DEST
 RETVAL=$?
 if [ $RETVAL != 0 ]
@@ -124,6 +133,24 @@ then
 fi
 echo dtmf_rx_tests completed OK
 
+./dtmf_rx_tests -i >$STDOUT_DEST 2>$STDERR_DEST
+RETVAL=$?
+if [ $RETVAL != 0 ]
+then
+    echo dtmf_rx_tests -i failed!
+    exit $RETVAL
+fi
+echo dtmf_rx_tests -i completed OK
+
+./dtmf_rx_tests -s >$STDOUT_DEST 2>$STDERR_DEST
+RETVAL=$?
+if [ $RETVAL != 0 ]
+then
+    echo dtmf_rx_tests -s failed!
+    exit $RETVAL
+fi
+echo dtmf_rx_tests -s completed OK
+
 ./dtmf_tx_tests >$STDOUT_DEST 2>$STDERR_DEST
 RETVAL=$?
 if [ $RETVAL != 0 ]
@@ -296,6 +323,15 @@ then
 fi
 echo oki_adpcm_tests completed OK
 
+./pipeline_tests >$STDOUT_DEST 2>$STDERR_DEST
+RETVAL=$?
+if [ $RETVAL != 0 ]
+then
+    echo pipeline_tests failed!
+    exit $RETVAL
+fi
+echo pipeline_tests completed OK
+
 #./playout_tests >$STDOUT_DEST 2>$STDERR_DEST
 #RETVAL=$?
 #if [ $RETVAL != 0 ]
@@ -571,6 +607,15 @@ echo t4_tests completed OK
 #echo time_scale_tests completed OK
 echo time_scale_tests not enabled
 
+./tone_analysis_tests >$STDOUT_DEST 2>$STDERR_DEST
+RETVAL=$?
+if [ $RETVAL != 0 ]
+then
+    echo tone_analysis_tests failed!
+    exit $RETVAL
+fi
+echo tone_analysis_tests completed OK
+
 #./tone_generate_tests >$STDOUT_DEST 2>$STDERR_DEST
 #RETVAL=$?
 #if [ $RETVAL != 0 ]
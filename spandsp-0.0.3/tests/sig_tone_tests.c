@@ -56,6 +56,18 @@
 
 #define OUT_FILE_NAME   "sig_tone.wav"
 
+#define BANK_CHANNELS       19
+#define BANK_TEST_LEN       40000
+#define BANK_FRAME_LEN      100
+#define BANK_RESET_AT       20000
+#define BANK_MAX_CHANGES    200
+
+typedef struct
+{
+    int changes;
+    int what[BANK_MAX_CHANGES];
+} bank_log_t;
+
 static int sampleno = 0;
 static int tone_1_present = 0;
 static int tone_2_present = 0;
@@ -155,6 +167,203 @@ void map_frequency_response(sig_tone_state_t *s)
 }
 /*- End of function --------------------------------------------------------*/
 
+static int bank_handler(void *user_data, int what)
+{
+    bank_log_t *log;
+
+    log = (bank_log_t *) user_data;
+    if ((what & SIG_TONE_1_CHANGE)  &&  log->changes < BANK_MAX_CHANGES)
+        log->what[log->changes++] = what;
+    /*endif*/
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_test_signal(int16_t amp[], int chan, int freq, int len)
+{
+    awgn_state_t noise_source;
+    uint32_t phase_acc;
+    int32_t phase_rate;
+    int32_t scaling;
+    int on;
+    int off;
+    int i;
+
+    /* Give each channel its own tone level, offset, and cadence. Some of the
+       tones are long enough for the receiver to go into flat mode. */
+    phase_rate = dds_phase_rate(freq + 5*(chan%3 - 1));
+    scaling = dds_scaling_dbm0(-10 - 2*(chan%8));
+    phase_acc = 0;
+    on = 600 + 400*(chan%8);
+    off = 300 + 50*chan;
+    awgn_init_dbm0(&noise_source, 1234567 + chan, -40.0f + chan);
+    for (i = 0;  i < len;  i++)
+    {
+        if ((i%(on + off)) < on)
+            amp[i] = dds_mod(&phase_acc, phase_rate, scaling, 0);
+        else
+            amp[i] = 0;
+        /*endif*/
+        amp[i] = alaw_to_linear(linear_to_alaw(saturate(amp[i] + awgn(&noise_source))));
+    }
+    /*endfor*/
+}
+/*- End of function --------------------------------------------------------*/
+
+static int same_rx_state(sig_tone_state_t *a, sig_tone_state_t *b)
+{
+    return  memcmp(a->notch_z1, b->notch_z1, sizeof(a->notch_z1)) == 0
+            &&
+            memcmp(a->notch_z2, b->notch_z2, sizeof(a->notch_z2)) == 0
+            &&
+            memcmp(a->broad_z, b->broad_z, sizeof(a->broad_z)) == 0
+            &&
+            a->notch_zl == b->notch_zl
+            &&
+            a->broad_zl == b->broad_zl
+            &&
+            a->mown_notch == b->mown_notch
+            &&
+            a->mown_bandpass == b->mown_bandpass
+            &&
+            a->flat_mode == b->flat_mode
+            &&
+            a->tone_present == b->tone_present
+            &&
+            a->notch_enabled == b->notch_enabled
+            &&
+            a->flat_mode_timeout == b->flat_mode_timeout
+            &&
+            a->notch_insertion_timeout == b->notch_insertion_timeout
+            &&
+            a->tone_persistence_timeout == b->tone_persistence_timeout
+            &&
+            a->signaling_state_duration == b->signaling_state_duration;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void bank_tests(void)
+{
+    static const int tone_freqs[3] = {2280, 2600, 2400};
+    static int16_t bank_signal[BANK_CHANNELS][BANK_TEST_LEN];
+    static int16_t ref_amp[BANK_CHANNELS][BANK_TEST_LEN];
+    static int16_t bank_amp[BANK_CHANNELS][BANK_TEST_LEN];
+    bank_log_t ref_log[BANK_CHANNELS];
+    bank_log_t bank_log[BANK_CHANNELS];
+    void *bank_user_data[BANK_CHANNELS];
+    sig_tone_state_t ref[BANK_CHANNELS];
+    sig_tone_bank_state_t *bank;
+    int16_t *amp_in[BANK_CHANNELS];
+    int tone_type;
+    int total;
+    int len;
+    int c;
+    int i;
+
+    /* Test a bank of receivers gives the same output, and the same signaling
+       changes, as separate ones */
+    printf("Test: signaling tone receiver bank.\n");
+    for (tone_type = SIG_TONE_2280HZ;  tone_type <= SIG_TONE_2400HZ_2600HZ;  tone_type++)
+    {
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            bank_test_signal(bank_signal[c], c, tone_freqs[tone_type - 1], BANK_TEST_LEN);
+            memcpy(ref_amp[c], bank_signal[c], sizeof(int16_t)*BANK_TEST_LEN);
+            memcpy(bank_amp[c], bank_signal[c], sizeof(int16_t)*BANK_TEST_LEN);
+            ref_log[c].changes = 0;
+            bank_log[c].changes = 0;
+            bank_user_data[c] = &bank_log[c];
+        }
+        /*endfor*/
+        if ((bank = sig_tone_bank_init(NULL, BANK_CHANNELS, tone_type, bank_handler, bank_user_data)) == NULL)
+        {
+            printf("    Failed to create the bank\n");
+            exit(2);
+        }
+        /*endif*/
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            sig_tone_init(&ref[c], tone_type, bank_handler, &ref_log[c]);
+            /* Leave one channel muted */
+            if (c != 3)
+            {
+                ref[c].current_tx_tone |= SIG_TONE_RX_PASSTHROUGH;
+                sig_tone_bank_channel(bank, c)->current_tx_tone |= SIG_TONE_RX_PASSTHROUGH;
+            }
+            /*endif*/
+        }
+        /*endfor*/
+        for (i = 0;  i < BANK_TEST_LEN;  i += len)
+        {
+            len = BANK_FRAME_LEN;
+            if (i + len > BANK_TEST_LEN)
+                len = BANK_TEST_LEN - i;
+            /*endif*/
+            /* Restart one channel part way through, as for a new call */
+            if (i == BANK_RESET_AT)
+            {
+                sig_tone_init(&ref[5], tone_type, bank_handler, &ref_log[5]);
+                ref[5].current_tx_tone |= SIG_TONE_RX_PASSTHROUGH;
+                sig_tone_bank_reset_channel(bank, 5);
+                sig_tone_bank_channel(bank, 5)->current_tx_tone |= SIG_TONE_RX_PASSTHROUGH;
+            }
+            /*endif*/
+            for (c = 0;  c < BANK_CHANNELS;  c++)
+            {
+                sig_tone_rx(&ref[c], &ref_amp[c][i], len);
+                amp_in[c] = &bank_amp[c][i];
+            }
+            /*endfor*/
+            sig_tone_rx_bank(bank, amp_in, len);
+            for (c = 0;  c < BANK_CHANNELS;  c++)
+            {
+                if (!same_rx_state(&ref[c], sig_tone_bank_channel(bank, c)))
+                {
+                    printf("    Channel %d: the receiver state differs at sample %d\n", c, i + len);
+                    printf("    Failed\n");
+                    exit(2);
+                }
+                /*endif*/
+            }
+            /*endfor*/
+        }
+        /*endfor*/
+        total = 0;
+        for (c = 0;  c < BANK_CHANNELS;  c++)
+        {
+            if (memcmp(ref_amp[c], bank_amp[c], sizeof(int16_t)*BANK_TEST_LEN))
+            {
+                printf("    Channel %d: the audio output differs\n", c);
+                printf("    Failed\n");
+                exit(2);
+            }
+            /*endif*/
+            if (ref_log[c].changes != bank_log[c].changes
+                ||
+                memcmp(ref_log[c].what, bank_log[c].what, sizeof(int)*ref_log[c].changes))
+            {
+                printf("    Channel %d: expected %d signaling changes, got %d, or they differ\n", c, ref_log[c].changes, bank_log[c].changes);
+                printf("    Failed\n");
+                exit(2);
+            }
+            /*endif*/
+            total += ref_log[c].changes;
+        }
+        /*endfor*/
+        sig_tone_bank_release(bank);
+        printf("    %d signaling changes across %d channels, for tone type %d\n", total, BANK_CHANNELS, tone_type);
+        if (total == 0)
+        {
+            printf("    Failed\n");
+            exit(2);
+        }
+        /*endif*/
+    }
+    /*endfor*/
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
 int main(int argc, char *argv[])
 {
     int16_t amp[160];
@@ -257,6 +466,8 @@ int main(int argc, char *argv[])
     }
     /*endif*/
     afFreeFileSetup(filesetup);
+
+    bank_tests();
     
     printf("Tests completed.\n");
     return  0;
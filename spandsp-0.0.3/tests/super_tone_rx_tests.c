@@ -351,6 +351,50 @@ static void super_tone_rx_fill_descriptor(super_tone_rx_descriptor_t *desc)
 }
 /*- End of function --------------------------------------------------------*/
 
+static void frequency_limit_tests(void)
+{
+    super_tone_rx_descriptor_t *desc;
+    int tone_id;
+    int i;
+
+    /* Fill the descriptor with as many frequencies as it can hold, far enough
+       apart that none are merged. One more must be refused, rather than quietly
+       becoming a silent period. */
+    printf("Test: adding too many frequencies\n");
+    if ((desc = super_tone_rx_make_descriptor(NULL)) == NULL)
+    {
+        printf("    Failed to create a descriptor\n");
+        exit(2);
+    }
+    tone_id = super_tone_rx_add_tone(desc);
+    for (i = 0;  i < BINS/2;  i++)
+    {
+        if (super_tone_rx_add_element(desc, tone_id, 300 + 40*i, 0, 100, 0) != i)
+        {
+            printf("    Frequency %d was refused\n", i + 1);
+            exit(2);
+        }
+    }
+    if (super_tone_rx_add_element(desc, tone_id, 300 + 40*i, 0, 100, 0) >= 0
+        ||
+        super_tone_rx_add_element(desc, tone_id, 300, 300 + 40*i, 100, 0) >= 0)
+    {
+        printf("    A frequency beyond the %d allowed was accepted\n", BINS/2);
+        exit(2);
+    }
+    /* Frequencies already in the descriptor, and silence, can still be used */
+    if (super_tone_rx_add_element(desc, tone_id, 300, 340, 100, 0) != i
+        ||
+        super_tone_rx_add_element(desc, tone_id, 0, 0, 100, 0) != i + 1)
+    {
+        printf("    An element needing no new frequencies was refused\n");
+        exit(2);
+    }
+    super_tone_rx_free_descriptor(desc);
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
 static void wakeup(void *data, int code)
 {
     if (code >= 0)
@@ -381,6 +425,7 @@ int main(int argc, char *argv[])
     super_tone_rx_state_t *super;
     super_tone_rx_descriptor_t desc;
 
+    frequency_limit_tests();
     if ((inhandle = afOpenFile(IN_FILE_NAME, "r", 0)) == AF_NULL_FILEHANDLE)
     {
         fprintf(stderr, "    Cannot open wave file '%s'\n", IN_FILE_NAME);
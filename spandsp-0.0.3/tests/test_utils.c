@@ -95,7 +95,7 @@ codec_munge_state_t *codec_munge_init(int codec)
 
 void codec_munge(codec_munge_state_t *s, int16_t amp[], int len)
 {
-    uint8_t law;
+    uint8_t law[160];
     uint8_t adpcmdata[160];
     int i;
     int adpcm;
@@ -107,17 +107,19 @@ void codec_munge(codec_munge_state_t *s, int16_t amp[], int len)
         /* Do nothing */
         break;
     case MUNGE_CODEC_ALAW:
-        for (i = 0;  i < len;  i++)
+        for (i = 0;  i < len;  i += x)
         {
-            law = linear_to_alaw(amp[i]);
-            amp[i] = alaw_to_linear(law);
+            x = (len - i >= 160)  ?  160  :  (len - i);
+            g711_alaw_encode_block(law, amp + i, x);
+            g711_alaw_decode_block(amp + i, law, x);
         }
         break;
     case MUNGE_CODEC_ULAW:
-        for (i = 0;  i < len;  i++)
+        for (i = 0;  i < len;  i += x)
         {
-            law = linear_to_ulaw(amp[i]);
-            amp[i] = ulaw_to_linear(law);
+            x = (len - i >= 160)  ?  160  :  (len - i);
+            g711_ulaw_encode_block(law, amp + i, x);
+            g711_ulaw_decode_block(amp + i, law, x);
         }
         break;
     case MUNGE_CODEC_G726_32K:
@@ -0,0 +1,523 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * tone_analysis_tests.c - Tests for the shared tone analysis engine.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \file */
+
+/*! \page tone_analysis_tests_page Shared tone analysis tests
+\section tone_analysis_tests_page_sec_1 What does it do?
+These tests build a signal containing DTMF digits, Bell MF digits and call
+progress tones, in a little noise. Two DTMF receivers, a Bell MF receiver and a
+supervisory tone detector are subscribed to one tone analysis engine, and a
+second set of the same detectors is run separately. The signal is passed to
+both in randomly sized chunks, and the two sets of detectors must report the
+same digits, tones and tone segments.
+
+The time taken by each arrangement is then measured, over a number of passes
+of the signal, and the numbers of Goertzel filters asked for and actually run
+are reported.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <inttypes.h>
+#if defined(HAVE_TGMATH_H)
+#include <tgmath.h>
+#endif
+#if defined(HAVE_MATH_H)
+#include <math.h>
+#endif
+#include <tiffio.h>
+
+#include "spandsp.h"
+
+#define TEST_LEN                (20*SAMPLE_RATE)
+#define TIMING_PASSES           20
+#define LOG_LEN                 4096
+
+typedef struct
+{
+    dtmf_rx_state_t dtmf[2];
+    bell_mf_rx_state_t bell_mf;
+    super_tone_rx_state_t *super;
+    char dtmf_digits[2][LOG_LEN];
+    char bell_mf_digits[LOG_LEN];
+    char tone_log[LOG_LEN];
+} detector_set_t;
+
+static int16_t test_signal[TEST_LEN];
+static int16_t quiet_signal[TEST_LEN];
+static super_tone_rx_descriptor_t tone_desc;
+
+static void log_append(char *log, const char *text)
+{
+    if (strlen(log) + strlen(text) < LOG_LEN)
+        strcat(log, text);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void tone_report(void *user_data, int code)
+{
+    detector_set_t *set;
+    char buf[32];
+
+    set = (detector_set_t *) user_data;
+    sprintf(buf, "T%d ", code);
+    log_append(set->tone_log, buf);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void tone_segment(void *user_data, int f1, int f2, int duration)
+{
+    detector_set_t *set;
+    char buf[64];
+
+    set = (detector_set_t *) user_data;
+    sprintf(buf, "S%d/%d/%d ", f1, f2, duration);
+    log_append(set->tone_log, buf);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void make_test_signal(void)
+{
+    dtmf_tx_state_t dtmf_gen;
+    bell_mf_tx_state_t bell_mf_gen;
+    tone_gen_descriptor_t tone_gen_desc;
+    tone_gen_state_t tone;
+    awgn_state_t noise_source;
+    int16_t digits[2*SAMPLE_RATE];
+    int len;
+    int n;
+    int i;
+
+    memset(test_signal, 0, sizeof(test_signal));
+    len = SAMPLE_RATE/10;
+
+    dtmf_tx_init(&dtmf_gen);
+    dtmf_tx_put(&dtmf_gen, "123456789*0#ABCD");
+    len += dtmf_tx(&dtmf_gen, &test_signal[len], TEST_LEN - len);
+    len += SAMPLE_RATE/2;
+
+    bell_mf_tx_init(&bell_mf_gen);
+    bell_mf_tx_put(&bell_mf_gen, "*1234567890#");
+    len += bell_mf_tx(&bell_mf_gen, &test_signal[len], TEST_LEN - len);
+    len += SAMPLE_RATE/2;
+
+    /* Four cycles of busy tone */
+    make_tone_gen_descriptor(&tone_gen_desc, 480, -20, 620, -20, 500, 500, 0, 0, TRUE);
+    tone_gen_init(&tone, &tone_gen_desc);
+    len += tone_gen(&tone, &test_signal[len], 4*SAMPLE_RATE);
+
+    /* Dial tone, with some DTMF over its tail */
+    make_tone_gen_descriptor(&tone_gen_desc, 350, -22, 440, -22, 3000, 0, 0, 0, FALSE);
+    tone_gen_init(&tone, &tone_gen_desc);
+    tone_gen(&tone, &test_signal[len], 3*SAMPLE_RATE);
+    len += SAMPLE_RATE;
+    dtmf_tx_init(&dtmf_gen);
+    dtmf_tx_put(&dtmf_gen, "5551234");
+    n = dtmf_tx(&dtmf_gen, digits, 2*SAMPLE_RATE);
+    for (i = 0;  i < n;  i++)
+        test_signal[len + i] = saturate(test_signal[len + i] + digits[i]);
+    len += 2*SAMPLE_RATE + SAMPLE_RATE/2;
+
+    /* Two cycles of ringback tone */
+    make_tone_gen_descriptor(&tone_gen_desc, 440, -19, 480, -19, 2000, 4000, 0, 0, TRUE);
+    tone_gen_init(&tone, &tone_gen_desc);
+    len += tone_gen(&tone, &test_signal[len], 8*SAMPLE_RATE);
+
+    awgn_init_dbm0(&noise_source, 1234567, -50.0f);
+    for (i = 0;  i < TEST_LEN;  i++)
+        test_signal[i] = saturate(test_signal[i] + awgn(&noise_source));
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Mostly a quiet line, with some bursts at speech levels, a few DTMF digits,
+   and a little busy tone. This is more like the audio a detector sees on a
+   real call. */
+static void make_quiet_signal(void)
+{
+    dtmf_tx_state_t dtmf_gen;
+    tone_gen_descriptor_t tone_gen_desc;
+    tone_gen_state_t tone;
+    awgn_state_t noise_source;
+    awgn_state_t speech_source;
+    int burst;
+    int i;
+
+    memset(quiet_signal, 0, sizeof(quiet_signal));
+    dtmf_tx_init(&dtmf_gen);
+    dtmf_tx_put(&dtmf_gen, "2580");
+    dtmf_tx(&dtmf_gen, &quiet_signal[2*SAMPLE_RATE], SAMPLE_RATE);
+    make_tone_gen_descriptor(&tone_gen_desc, 480, -20, 620, -20, 500, 500, 0, 0, TRUE);
+    tone_gen_init(&tone, &tone_gen_desc);
+    tone_gen(&tone, &quiet_signal[14*SAMPLE_RATE], 3*SAMPLE_RATE);
+
+    awgn_init_dbm0(&noise_source, 7654321, -55.0f);
+    awgn_init_dbm0(&speech_source, 1234567, -30.0f);
+    for (i = 0;  i < TEST_LEN;  i++)
+    {
+        quiet_signal[i] = saturate(quiet_signal[i] + awgn(&noise_source));
+        /* Bursts of 200ms to 600ms, starting every 1.6s, between 5s and 13s */
+        burst = i%(8*SAMPLE_RATE/5);
+        if (i >= 5*SAMPLE_RATE  &&  i < 13*SAMPLE_RATE  &&  burst < (200 + (i/(8*SAMPLE_RATE/5))%3*200)*SAMPLE_RATE/1000)
+            quiet_signal[i] = saturate(quiet_signal[i] + awgn(&speech_source));
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void make_tone_set(void)
+{
+    int tone_id;
+
+    super_tone_rx_make_descriptor(&tone_desc);
+    /* Dial tone */
+    tone_id = super_tone_rx_add_tone(&tone_desc);
+    super_tone_rx_add_element(&tone_desc, tone_id, 350, 440, 700, 0);
+    /* Busy tone */
+    tone_id = super_tone_rx_add_tone(&tone_desc);
+    super_tone_rx_add_element(&tone_desc, tone_id, 480, 620, 400, 600);
+    super_tone_rx_add_element(&tone_desc, tone_id, 0, 0, 400, 600);
+    /* Ringback tone */
+    tone_id = super_tone_rx_add_tone(&tone_desc);
+    super_tone_rx_add_element(&tone_desc, tone_id, 440, 480, 1800, 2200);
+    super_tone_rx_add_element(&tone_desc, tone_id, 0, 0, 3600, 4400);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void detector_set_init(detector_set_t *set)
+{
+    dtmf_rx_init(&set->dtmf[0], NULL, NULL);
+    dtmf_rx_init(&set->dtmf[1], NULL, NULL);
+    bell_mf_rx_init(&set->bell_mf, NULL, NULL);
+    if ((set->super = super_tone_rx_init(NULL, &tone_desc, tone_report, set)) == NULL)
+    {
+        printf("    Failed to create the supervisory tone detector\n");
+        exit(2);
+    }
+    super_tone_rx_segment_callback(set->super, tone_segment);
+    set->dtmf_digits[0][0] = '\0';
+    set->dtmf_digits[1][0] = '\0';
+    set->bell_mf_digits[0] = '\0';
+    set->tone_log[0] = '\0';
+}
+/*- End of function --------------------------------------------------------*/
+
+static void detector_set_collect(detector_set_t *set)
+{
+    char buf[128 + 1];
+
+    dtmf_rx_get(&set->dtmf[0], buf, 128);
+    log_append(set->dtmf_digits[0], buf);
+    dtmf_rx_get(&set->dtmf[1], buf, 128);
+    log_append(set->dtmf_digits[1], buf);
+    bell_mf_rx_get(&set->bell_mf, buf, 128);
+    log_append(set->bell_mf_digits, buf);
+}
+/*- End of function --------------------------------------------------------*/
+
+static void subscribe_set(detector_set_t *set, tone_analysis_state_t *engine, int sub[4])
+{
+    if ((sub[0] = dtmf_rx_subscribe(&set->dtmf[0], engine)) < 0
+        ||
+        (sub[1] = dtmf_rx_subscribe(&set->dtmf[1], engine)) < 0
+        ||
+        (sub[2] = bell_mf_rx_subscribe(&set->bell_mf, engine)) < 0
+        ||
+        (sub[3] = super_tone_rx_subscribe(set->super, engine)) < 0)
+    {
+        printf("    Failed to subscribe the detectors\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void report_skips(tone_analysis_state_t *engine, const int sub[4])
+{
+    static const char *names[4] =
+    {
+        "DTMF", "Second DTMF", "Bell MF", "Supervisory tones"
+    };
+    int blocks;
+    int skipped;
+    int i;
+
+    for (i = 0;  i < 4;  i++)
+    {
+        tone_analysis_get_skip_stats(engine, sub[i], &blocks, &skipped);
+        printf("    %s: %d of %d blocks skipped (%.1f%%)\n", names[i], skipped, blocks, (blocks)  ?  100.0*skipped/blocks  :  0.0);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void compare_logs(const char *what, const char *expected, const char *actual)
+{
+    if (strcmp(expected, actual))
+    {
+        printf("    %s: expected '%s', got '%s'\n", what, expected, actual);
+        printf("    Failed\n");
+        exit(2);
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static void sharing_tests(void)
+{
+    detector_set_t ref;
+    detector_set_t shared;
+    tone_analysis_state_t engine;
+    dtmf_rx_state_t filtered;
+    int sub[4];
+    int len;
+    int i;
+
+    printf("Test: detectors sharing a tone analysis engine.\n");
+    detector_set_init(&ref);
+    detector_set_init(&shared);
+    tone_analysis_init(&engine);
+    subscribe_set(&shared, &engine, sub);
+    /* The engine cannot filter out dial tone, so a receiver which should must
+       be refused */
+    dtmf_rx_init(&filtered, NULL, NULL);
+    dtmf_rx_parms(&filtered, TRUE, -1, -1);
+    if (dtmf_rx_subscribe(&filtered, &engine) >= 0)
+    {
+        printf("    A DTMF receiver filtering dial tone was subscribed\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    srand(42);
+    for (i = 0;  i < TEST_LEN;  i += len)
+    {
+        len = rand()%240 + 1;
+        if (len > TEST_LEN - i)
+            len = TEST_LEN - i;
+        dtmf_rx(&ref.dtmf[0], &test_signal[i], len);
+        dtmf_rx(&ref.dtmf[1], &test_signal[i], len);
+        bell_mf_rx(&ref.bell_mf, &test_signal[i], len);
+        super_tone_rx(ref.super, &test_signal[i], len);
+        detector_set_collect(&ref);
+        tone_analysis(&engine, &test_signal[i], len);
+        detector_set_collect(&shared);
+    }
+    compare_logs("DTMF", ref.dtmf_digits[0], shared.dtmf_digits[0]);
+    compare_logs("Second DTMF", ref.dtmf_digits[1], shared.dtmf_digits[1]);
+    compare_logs("Bell MF", ref.bell_mf_digits, shared.bell_mf_digits);
+    compare_logs("Supervisory tones", ref.tone_log, shared.tone_log);
+    printf("    DTMF '%s', Bell MF '%s'\n", ref.dtmf_digits[0], ref.bell_mf_digits);
+    printf("    Tones '%s'\n", ref.tone_log);
+    /* The DTMF and Bell MF receivers pick up a few of each other's digits, so
+       just look for the ones which were sent. */
+    if (strstr(ref.dtmf_digits[0], "123456789*0#ABCD") == NULL
+        ||
+        strstr(ref.dtmf_digits[0], "5551234") == NULL
+        ||
+        strstr(ref.bell_mf_digits, "*1234567890#") == NULL
+        ||
+        strstr(ref.tone_log, "T0 ") == NULL
+        ||
+        strstr(ref.tone_log, "T1 ") == NULL
+        ||
+        strstr(ref.tone_log, "T2 ") == NULL)
+    {
+        printf("    The expected digits and tones were not all found\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    printf("    %d filters requested, %d filters run in %d groups\n", engine.requested_bins, engine.bins, engine.groups);
+    if (engine.bins >= engine.requested_bins)
+    {
+        printf("    No filters were shared\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    report_skips(&engine, sub);
+    super_tone_rx_free(ref.super);
+    super_tone_rx_free(shared.super);
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
+static void gating_tests(void)
+{
+    detector_set_t ref;
+    detector_set_t gated;
+    tone_analysis_state_t ungated_engine;
+    tone_analysis_state_t engine;
+    int ungated_sub[4];
+    int sub[4];
+    int blocks;
+    int skipped;
+    int len;
+    int i;
+
+    printf("Test: energy gating, on a mostly quiet line.\n");
+    /* Compare against an engine with its gates turned off */
+    detector_set_init(&ref);
+    detector_set_init(&gated);
+    tone_analysis_init(&ungated_engine);
+    tone_analysis_init(&engine);
+    subscribe_set(&ref, &ungated_engine, ungated_sub);
+    subscribe_set(&gated, &engine, sub);
+    for (i = 0;  i < 4;  i++)
+        tone_analysis_set_gate(&ungated_engine, ungated_sub[i], 0.0f);
+    srand(4242);
+    for (i = 0;  i < TEST_LEN;  i += len)
+    {
+        len = rand()%240 + 1;
+        if (len > TEST_LEN - i)
+            len = TEST_LEN - i;
+        tone_analysis(&ungated_engine, &quiet_signal[i], len);
+        detector_set_collect(&ref);
+        tone_analysis(&engine, &quiet_signal[i], len);
+        detector_set_collect(&gated);
+    }
+    compare_logs("DTMF", ref.dtmf_digits[0], gated.dtmf_digits[0]);
+    compare_logs("Second DTMF", ref.dtmf_digits[1], gated.dtmf_digits[1]);
+    compare_logs("Bell MF", ref.bell_mf_digits, gated.bell_mf_digits);
+    compare_logs("Supervisory tones", ref.tone_log, gated.tone_log);
+    printf("    DTMF '%s', Bell MF '%s'\n", ref.dtmf_digits[0], ref.bell_mf_digits);
+    printf("    Tones '%s'\n", ref.tone_log);
+    if (strcmp(ref.dtmf_digits[0], "2580")  ||  strstr(ref.tone_log, "T1 ") == NULL)
+    {
+        printf("    The expected digits and tones were not all found\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    tone_analysis_get_skip_stats(&ungated_engine, ungated_sub[0], &blocks, &skipped);
+    if (skipped)
+    {
+        printf("    Blocks were skipped with the gates off\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    report_skips(&engine, sub);
+    /* Most of this signal is below the DTMF gate, and all but the tones are
+       below the Bell MF gate */
+    tone_analysis_get_skip_stats(&engine, sub[0], &blocks, &skipped);
+    if (skipped < blocks/2)
+    {
+        printf("    Too few blocks were skipped\n");
+        printf("    Failed\n");
+        exit(2);
+    }
+    super_tone_rx_free(ref.super);
+    super_tone_rx_free(gated.super);
+    printf("    Passed\n");
+}
+/*- End of function --------------------------------------------------------*/
+
+static double elapsed(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec)*1.0e-9;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void timing_tests(void)
+{
+    detector_set_t set;
+    tone_analysis_state_t engine;
+    struct timespec start;
+    struct timespec end;
+    double separate;
+    double shared;
+    double quiet;
+    int sub[4];
+    int pass;
+    int i;
+
+    printf("Test: tone analysis timing, over %d seconds of audio.\n", TIMING_PASSES*TEST_LEN/SAMPLE_RATE);
+    detector_set_init(&set);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (pass = 0;  pass < TIMING_PASSES;  pass++)
+    {
+        for (i = 0;  i < TEST_LEN;  i += 160)
+        {
+            dtmf_rx(&set.dtmf[0], &test_signal[i], 160);
+            dtmf_rx(&set.dtmf[1], &test_signal[i], 160);
+            bell_mf_rx(&set.bell_mf, &test_signal[i], 160);
+            super_tone_rx(set.super, &test_signal[i], 160);
+            detector_set_collect(&set);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    separate = elapsed(&start, &end);
+    super_tone_rx_free(set.super);
+
+    detector_set_init(&set);
+    tone_analysis_init(&engine);
+    subscribe_set(&set, &engine, sub);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (pass = 0;  pass < TIMING_PASSES;  pass++)
+    {
+        for (i = 0;  i < TEST_LEN;  i += 160)
+        {
+            tone_analysis(&engine, &test_signal[i], 160);
+            detector_set_collect(&set);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    shared = elapsed(&start, &end);
+    super_tone_rx_free(set.super);
+    printf("    Separate detectors %.3fs, shared engine %.3fs (%.2f times faster)\n", separate, shared, separate/shared);
+
+    detector_set_init(&set);
+    tone_analysis_init(&engine);
+    subscribe_set(&set, &engine, sub);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (pass = 0;  pass < TIMING_PASSES;  pass++)
+    {
+        for (i = 0;  i < TEST_LEN;  i += 160)
+        {
+            tone_analysis(&engine, &quiet_signal[i], 160);
+            detector_set_collect(&set);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    quiet = elapsed(&start, &end);
+    super_tone_rx_free(set.super);
+    printf("    Shared engine on a mostly quiet line %.3fs (%.2f times faster than on tones)\n", quiet, shared/quiet);
+}
+/*- End of function --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    make_test_signal();
+    make_quiet_signal();
+    make_tone_set();
+    sharing_tests();
+    gating_tests();
+    timing_tests();
+    printf("Tests passed.\n");
+    return  0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
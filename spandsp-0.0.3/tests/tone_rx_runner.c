@@ -0,0 +1,1102 @@
+/*
+ * SpanDSP - a series of DSP components for telephony
+ *
+ * tone_rx_runner.c - Run the twist, frequency deviation, noise and talk-off
+ *                    sweeps for the DTMF, Bell MF and R2 MF receivers, in
+ *                    parallel.
+ *
+ * Created 18 October 2026
+ *
+ * Copyright (C) 2026
+ *
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2, as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * $Id$
+ */
+
+/*! \page tone_rx_runner_page Tone receiver robustness runner
+\section tone_rx_runner_page_sec_1 What does it do?
+dtmf_rx_tests, bell_mf_rx_tests and r2_mf_rx_tests run their sweeps one after
+another, and the talk-off test against the Bellcore speech tapes alone takes
+most of an hour. This program runs the twist, frequency deviation, noise and
+talk-off sweeps for the floating point and integer DTMF and Bell MF receivers,
+and the forward and backward R2 MF receivers, spreading them over all the CPUs.
+As well as passing or failing each sweep, it measures how long each receiver
+takes to report each digit, and prints the distribution of those latencies.
+
+\section tone_rx_runner_page_sec_2 How does it work?
+The sweeps are split into independent cases - one digit and one direction of a
+twist sweep, one digit and one tone of a frequency deviation sweep, one digit of
+a noise sweep, or one speech file of the talk-off test. Each case runs on its
+own receiver, so nothing is shared between cases which run at the same time,
+and a pool of worker threads takes cases from the list in turn. The sweeps, and
+their pass/fail limits, follow those in the receivers' own test programs.
+
+Each tone burst is A-law munged, and fed to the receiver 1ms at a time. The time
+from the start of the burst to the end of the millisecond in which the digit was
+reported is the latency. The R2 MF receiver only reports at the end of its
+detection blocks, so its latencies come in steps of a block.
+
+The speech files are mapped into memory once, before the workers start, and
+all the talk-off cases read them from the shared read-only mapping, rather than
+each reading its own copy through the audio file library. Speech files which
+cannot be found are skipped, and reported as such.
+
+The report has one row per case, with its result, the measured value, and the
+latency percentiles. The talk-off limit is on the total hits over all the speech
+files, so every talk-off row carries the result for its receiver's total. The summary gives the worst case, and the latency
+distribution, for each receiver and sweep, and the total talk-off hits for
+each receiver.
+
+\section tone_rx_runner_page_sec_3 How do I use it?
+Run it in the tests directory, as the speech files are found relative to there.
+
+    ./tone_rx_runner                   all receivers and sweeps, all CPUs
+    ./tone_rx_runner -quick            one digit per sweep, fewer noise bursts
+    ./tone_rx_runner -d dtmf -s noise  just the DTMF noise sweep
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <string.h>
+#if defined(HAVE_TGMATH_H)
+#include <tgmath.h>
+#endif
+#if defined(HAVE_MATH_H)
+#include <math.h>
+#endif
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <tiffio.h>
+
+#include "spandsp.h"
+
+#define REPORT_FILE_NAME    "tone_rx_report.csv"
+#define MAX_THREADS         256
+
+#define MITEL_DIR           "../itutests/mitel/"
+#define BELLCORE_DIR        "../itutests/bellcore/"
+
+static const char *speech_files[] =
+{
+    MITEL_DIR    "mitel-cm7291-talkoff.wav",
+    BELLCORE_DIR "tr-tsy-00763-1.wav",
+    BELLCORE_DIR "tr-tsy-00763-2.wav",
+    BELLCORE_DIR "tr-tsy-00763-3.wav",
+    BELLCORE_DIR "tr-tsy-00763-4.wav",
+    BELLCORE_DIR "tr-tsy-00763-5.wav",
+    BELLCORE_DIR "tr-tsy-00763-6.wav",
+    NULL
+};
+
+/* The receivers are fed this many samples at a time, which sets the resolution
+   of the latency measurements */
+#define CHUNK_SAMPLES       (SAMPLE_RATE/1000)
+#define TALKOFF_SAMPLES     SAMPLE_RATE
+#define MAX_BURST_SAMPLES   (SAMPLE_RATE/2)
+/* Latencies are histogrammed in 1ms bins. The last bin holds anything longer */
+#define LATENCY_BINS        250
+
+#define NELEM(x) ((int) (sizeof(x)/sizeof((x)[0])))
+
+typedef struct
+{
+    float f1;
+    float f2;
+} tone_pair_t;
+
+/* In the order of the digit codes. The lower frequency comes first */
+static const tone_pair_t dtmf_tones[] =
+{
+    { 697.0, 1209.0}, { 697.0, 1336.0}, { 697.0, 1477.0}, { 697.0, 1633.0},
+    { 770.0, 1209.0}, { 770.0, 1336.0}, { 770.0, 1477.0}, { 770.0, 1633.0},
+    { 852.0, 1209.0}, { 852.0, 1336.0}, { 852.0, 1477.0}, { 852.0, 1633.0},
+    { 941.0, 1209.0}, { 941.0, 1336.0}, { 941.0, 1477.0}, { 941.0, 1633.0}
+};
+
+static const tone_pair_t bell_mf_tones[] =
+{
+    { 700.0,  900.0}, { 700.0, 1100.0}, { 900.0, 1100.0}, { 700.0, 1300.0},
+    { 900.0, 1300.0}, {1100.0, 1300.0}, { 700.0, 1500.0}, { 900.0, 1500.0},
+    {1100.0, 1500.0}, {1300.0, 1500.0}, { 700.0, 1700.0}, { 900.0, 1700.0},
+    {1100.0, 1700.0}, {1300.0, 1700.0}, {1500.0, 1700.0}
+};
+
+static const tone_pair_t r2_mf_fwd_tones[] =
+{
+    {1380.0, 1500.0}, {1380.0, 1620.0}, {1500.0, 1620.0}, {1380.0, 1740.0},
+    {1500.0, 1740.0}, {1620.0, 1740.0}, {1380.0, 1860.0}, {1500.0, 1860.0},
+    {1620.0, 1860.0}, {1740.0, 1860.0}, {1380.0, 1980.0}, {1500.0, 1980.0},
+    {1620.0, 1980.0}, {1740.0, 1980.0}, {1860.0, 1980.0}
+};
+
+static const tone_pair_t r2_mf_back_tones[] =
+{
+    {1020.0, 1140.0}, { 900.0, 1140.0}, { 900.0, 1020.0}, { 780.0, 1140.0},
+    { 780.0, 1020.0}, { 780.0,  900.0}, { 660.0, 1140.0}, { 660.0, 1020.0},
+    { 660.0,  900.0}, { 660.0,  780.0}, { 540.0, 1140.0}, { 540.0, 1020.0},
+    { 540.0,  900.0}, { 540.0,  780.0}, { 540.0,  660.0}
+};
+
+enum
+{
+    RX_DTMF = 0,
+    RX_DTMF_FIXED,
+    RX_BELL_MF,
+    RX_BELL_MF_FIXED,
+    RX_R2_MF_FWD,
+    RX_R2_MF_BACK
+};
+
+/* A receiver, and the settings and limits for its sweeps, taken from its own
+   test program */
+typedef struct
+{
+    const char *name;
+    int type;
+    const tone_pair_t *tones;
+    const char *codes;
+    /* The digits used for the twist, frequency deviation and noise sweeps */
+    const char *sweep_digits;
+    /* A digit sent for 50% longer than the others (Bell MF KP) */
+    char long_digit;
+    int on_time;
+    int off_time;
+    /* The level of the tone held steady in the twist sweep */
+    int twist_level;
+    /* The least acceptable normal and reverse twist, in dB */
+    float min_twist[2];
+    /* The least acceptable recognition bandwidth is
+       min_rrb + rcfo + 2*100*tolerance/f %. */
+    float min_rrb;
+    float tolerance;
+    /* The level of each tone, the first noise level, and the number of bursts
+       which must all be detected at each noise level, for the noise sweep */
+    int noise_tone_level;
+    int noise_start;
+    int noise_bursts;
+    /* The most talk-off hits allowed over all the speech files, or -1 for no limit */
+    int talkoff_limit;
+} rx_desc_t;
+
+static const rx_desc_t receivers[] =
+{
+    {"dtmf",          RX_DTMF,          dtmf_tones,       "123A456B789C*0#D", "159D",            '\0', 50, 50, -3, {8.0, 4.0}, 3.0,  0.0, -4, -13, 1000, 470},
+    {"dtmf-fixed",    RX_DTMF_FIXED,    dtmf_tones,       "123A456B789C*0#D", "159D",            '\0', 50, 50, -3, {8.0, 4.0}, 3.0,  0.0, -4, -13, 1000, 470},
+    {"bell-mf",       RX_BELL_MF,       bell_mf_tones,    "1234567890CA*B#",  "1234567890CA*B#", '*',  68, 68, -5, {6.0, 6.0}, 3.0, 10.0, -3, -10,  500,  -1},
+    {"bell-mf-fixed", RX_BELL_MF_FIXED, bell_mf_tones,    "1234567890CA*B#",  "1234567890CA*B#", '*',  68, 68, -5, {6.0, 6.0}, 3.0, 10.0, -3, -10,  500,  -1},
+    {"r2-mf-fwd",     RX_R2_MF_FWD,     r2_mf_fwd_tones,  "1234567890BCDEF",  "1234567890BCDEF", '\0', 68, 68, -5, {7.0, 7.0}, 0.0, 14.0, -3,  -3,  500,  -1},
+    {"r2-mf-back",    RX_R2_MF_BACK,    r2_mf_back_tones, "1234567890BCDEF",  "1234567890BCDEF", '\0', 68, 68, -5, {7.0, 7.0}, 0.0, 14.0, -3,  -3,  500,  -1},
+    {NULL}
+};
+
+enum
+{
+    SWEEP_TWIST = 0,
+    SWEEP_FREQ,
+    SWEEP_NOISE,
+    SWEEP_TALKOFF,
+    SWEEPS
+};
+
+static const char *sweep_names[SWEEPS] =
+{
+    "twist",
+    "freq",
+    "noise",
+    "talkoff"
+};
+
+enum
+{
+    RESULT_NOT_RUN = 0,
+    RESULT_PASS,
+    RESULT_FAIL,
+    RESULT_SKIPPED
+};
+
+/* A speech file, mapped into memory for the talk-off cases */
+typedef struct
+{
+    const char *name;
+    void *map;
+    size_t map_len;
+    /* The 16 bit little endian samples */
+    const uint8_t *data;
+    int samples;
+} speech_file_t;
+
+typedef struct
+{
+    /* The case */
+    const rx_desc_t *rx;
+    int sweep;
+    char digit;
+    /* Normal or reverse twist, the low or high tone, or the speech file */
+    int variant;
+
+    /* What the receiver made of it */
+    int result;
+    int bursts;
+    int detected;
+    /* The twist (dB), the recognition bandwidth (%), the acceptable S/N (dB),
+       or the false hits */
+    float value;
+    /* The centre frequency offset (%), for the frequency deviation sweep */
+    float rcfo;
+    float limit;
+    int latency[LATENCY_BINS];
+} tone_rx_job_t;
+
+/* Any of the receivers */
+typedef struct
+{
+    const rx_desc_t *desc;
+    union
+    {
+        dtmf_rx_state_t dtmf;
+        dtmf_rx_fixed_state_t dtmf_fixed;
+        bell_mf_rx_state_t bell_mf;
+        bell_mf_rx_fixed_state_t bell_mf_fixed;
+        r2_mf_rx_state_t r2_mf;
+    } s;
+    /* The R2 MF receiver reports what it hears, rather than new digits */
+    int r2_last;
+} tone_rx_t;
+
+static speech_file_t speech[NELEM(speech_files)];
+
+static tone_rx_job_t *jobs;
+static int n_jobs;
+static int next_job;
+static int done_jobs;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void rx_init(tone_rx_t *rx, const rx_desc_t *desc)
+{
+    rx->desc = desc;
+    rx->r2_last = 0;
+    switch (desc->type)
+    {
+    case RX_DTMF:
+        dtmf_rx_init(&rx->s.dtmf, NULL, NULL);
+        break;
+    case RX_DTMF_FIXED:
+        dtmf_rx_fixed_init(&rx->s.dtmf_fixed, NULL, NULL);
+        break;
+    case RX_BELL_MF:
+        bell_mf_rx_init(&rx->s.bell_mf, NULL, NULL);
+        break;
+    case RX_BELL_MF_FIXED:
+        bell_mf_rx_fixed_init(&rx->s.bell_mf_fixed, NULL, NULL);
+        break;
+    case RX_R2_MF_FWD:
+    case RX_R2_MF_BACK:
+        r2_mf_rx_init(&rx->s.r2_mf, desc->type == RX_R2_MF_FWD);
+        break;
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Feed some audio to a receiver, and collect any digits it reports */
+static int rx_feed(tone_rx_t *rx, const int16_t amp[], int len, char *buf, int max)
+{
+    int hit;
+    int digits;
+    int i;
+    int n;
+
+    switch (rx->desc->type)
+    {
+    case RX_DTMF:
+        dtmf_rx(&rx->s.dtmf, amp, len);
+        return dtmf_rx_get(&rx->s.dtmf, buf, max);
+    case RX_DTMF_FIXED:
+        dtmf_rx_fixed(&rx->s.dtmf_fixed, amp, len);
+        return dtmf_rx_fixed_get(&rx->s.dtmf_fixed, buf, max);
+    case RX_BELL_MF:
+        bell_mf_rx(&rx->s.bell_mf, amp, len);
+        return bell_mf_rx_get(&rx->s.bell_mf, buf, max);
+    case RX_BELL_MF_FIXED:
+        bell_mf_rx_fixed(&rx->s.bell_mf_fixed, amp, len);
+        return bell_mf_rx_fixed_get(&rx->s.bell_mf_fixed, buf, max);
+    }
+    /* r2_mf_rx() only says what it heard in a block if that block ends within
+       the call, so split the audio at the block boundaries */
+    digits = 0;
+    for (i = 0;  i < len;  i += n)
+    {
+        n = rx->s.r2_mf.samples - rx->s.r2_mf.current_sample;
+        if (n > len - i)
+            n = len - i;
+        hit = r2_mf_rx(&rx->s.r2_mf, amp + i, n);
+        if (rx->s.r2_mf.current_sample != 0)
+            continue;
+        if (hit  &&  hit != rx->r2_last  &&  digits < max)
+            buf[digits++] = hit;
+        rx->r2_last = hit;
+    }
+    buf[digits] = '\0';
+    return digits;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void make_burst(tone_gen_descriptor_t *desc,
+                       const rx_desc_t *rx,
+                       char digit,
+                       float low_fudge,
+                       int low_level,
+                       float high_fudge,
+                       int high_level)
+{
+    const tone_pair_t *pair;
+    int on_time;
+
+    pair = &rx->tones[strchr(rx->codes, digit) - rx->codes];
+    on_time = (digit == rx->long_digit)  ?  3*rx->on_time/2  :  rx->on_time;
+    make_tone_gen_descriptor(desc,
+                             pair->f1*(1.0 + low_fudge),
+                             low_level,
+                             pair->f2*(1.0 + high_fudge),
+                             high_level,
+                             on_time,
+                             rx->off_time,
+                             0,
+                             0,
+                             FALSE);
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Send one tone burst, and the gap after it. The burst counts as detected if
+   the receiver reports the right digit once, and nothing else. */
+static int send_burst(tone_rx_t *rx, tone_rx_job_t *job, tone_gen_descriptor_t *desc, char digit, awgn_state_t *noise)
+{
+    tone_gen_state_t tone;
+    int16_t amp[MAX_BURST_SAMPLES];
+    char buf[MAX_DTMF_DIGITS + 1];
+    int right;
+    int wrong;
+    int len;
+    int i;
+    int j;
+    int n;
+    int ms;
+
+    tone_gen_init(&tone, desc);
+    len = tone_gen(&tone, amp, MAX_BURST_SAMPLES);
+    for (i = 0;  i < len;  i++)
+    {
+        if (noise)
+            amp[i] = saturate(amp[i] + awgn(noise));
+        amp[i] = alaw_to_linear(linear_to_alaw(amp[i]));
+    }
+    right = 0;
+    wrong = 0;
+    for (i = 0;  i < len;  i += CHUNK_SAMPLES)
+    {
+        n = (len - i < CHUNK_SAMPLES)  ?  (len - i)  :  CHUNK_SAMPLES;
+        n = rx_feed(rx, amp + i, n, buf, MAX_DTMF_DIGITS);
+        for (j = 0;  j < n;  j++)
+        {
+            if (buf[j] != digit)
+            {
+                wrong++;
+                continue;
+            }
+            if (right++ == 0)
+            {
+                ms = (i + CHUNK_SAMPLES)/CHUNK_SAMPLES;
+                job->latency[(ms < LATENCY_BINS)  ?  ms  :  (LATENCY_BINS - 1)]++;
+            }
+        }
+    }
+    job->bursts++;
+    if (right == 1  &&  wrong == 0)
+    {
+        job->detected++;
+        return TRUE;
+    }
+    return FALSE;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void run_twist(tone_rx_job_t *job)
+{
+    tone_gen_descriptor_t desc;
+    tone_rx_t rx;
+    int level;
+    int n;
+    int i;
+
+    rx_init(&rx, job->rx);
+    /* Like the Mitel test, 10 bursts per dB of twist */
+    level = job->rx->twist_level;
+    for (n = 0, i = 10*level;  i >= 10*level - 200;  i--)
+    {
+        if (job->variant == 0)
+            make_burst(&desc, job->rx, job->digit, 0.0, level, 0.0, i/10);
+        else
+            make_burst(&desc, job->rx, job->digit, 0.0, i/10, 0.0, level);
+        n += send_burst(&rx, job, &desc, job->digit, NULL);
+    }
+    job->value = n/10.0;
+    job->limit = job->rx->min_twist[job->variant];
+    job->result = (job->value >= job->limit)  ?  RESULT_PASS  :  RESULT_FAIL;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void run_freq(tone_rx_job_t *job)
+{
+    tone_gen_descriptor_t desc;
+    tone_rx_t rx;
+    const tone_pair_t *pair;
+    float f;
+    int nplus;
+    int nminus;
+    int i;
+
+    rx_init(&rx, job->rx);
+    /* Step the frequency of one tone 0.1% at a time, out to 6%, each way */
+    for (nplus = 0, i = 1;  i <= 60;  i++)
+    {
+        if (job->variant == 0)
+            make_burst(&desc, job->rx, job->digit, i/1000.0, -17, 0.0, -17);
+        else
+            make_burst(&desc, job->rx, job->digit, 0.0, -17, i/1000.0, -17);
+        nplus += send_burst(&rx, job, &desc, job->digit, NULL);
+    }
+    for (nminus = 0, i = -1;  i >= -60;  i--)
+    {
+        if (job->variant == 0)
+            make_burst(&desc, job->rx, job->digit, i/1000.0, -17, 0.0, -17);
+        else
+            make_burst(&desc, job->rx, job->digit, 0.0, -17, i/1000.0, -17);
+        nminus += send_burst(&rx, job, &desc, job->digit, NULL);
+    }
+    job->value = (nplus + nminus)/10.0;
+    job->rcfo = (nplus - nminus)/10.0;
+    pair = &job->rx->tones[strchr(job->rx->codes, job->digit) - job->rx->codes];
+    f = (job->variant == 0)  ?  pair->f1  :  pair->f2;
+    job->limit = job->rx->min_rrb + job->rcfo + 2.0*100.0*job->rx->tolerance/f;
+    if (job->value >= job->limit  &&  job->value < 15.0 + job->rcfo)
+        job->result = RESULT_PASS;
+    else
+        job->result = RESULT_FAIL;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void run_noise(tone_rx_job_t *job, int quick)
+{
+    tone_gen_descriptor_t desc;
+    tone_rx_t rx;
+    awgn_state_t noise_source;
+    int bursts;
+    int level;
+    int i;
+    int j;
+
+    rx_init(&rx, job->rx);
+    bursts = (quick)  ?  job->rx->noise_bursts/10  :  job->rx->noise_bursts;
+    level = job->rx->noise_tone_level;
+    make_burst(&desc, job->rx, job->digit, 0.0, level, 0.0, level);
+    /* Reduce the noise until every burst is detected */
+    for (i = job->rx->noise_start;  i > -50;  i--)
+    {
+        awgn_init_dbm0(&noise_source, 1234567, (float) i);
+        for (j = 0;  j < bursts;  j++)
+        {
+            if (!send_burst(&rx, job, &desc, job->digit, &noise_source))
+                break;
+        }
+        if (j == bursts)
+            break;
+    }
+    job->value = level - i;
+    job->limit = 26.0;
+    job->result = (job->value <= job->limit)  ?  RESULT_PASS  :  RESULT_FAIL;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void run_talkoff(tone_rx_job_t *job)
+{
+    const speech_file_t *file;
+    const uint8_t *s;
+    tone_rx_t rx;
+    int16_t amp[TALKOFF_SAMPLES];
+    char buf[MAX_DTMF_DIGITS + 1];
+    int hits;
+    int len;
+    int i;
+    int j;
+
+    file = &speech[job->variant];
+    if (file->data == NULL)
+    {
+        job->result = RESULT_SKIPPED;
+        return;
+    }
+    rx_init(&rx, job->rx);
+    hits = 0;
+    for (i = 0;  i < file->samples;  i += len)
+    {
+        len = (file->samples - i < TALKOFF_SAMPLES)  ?  (file->samples - i)  :  TALKOFF_SAMPLES;
+        s = file->data + 2*i;
+        for (j = 0;  j < len;  j++)
+            amp[j] = (int16_t) (s[2*j] | (s[2*j + 1] << 8));
+        hits += rx_feed(&rx, amp, len, buf, MAX_DTMF_DIGITS);
+    }
+    job->value = hits;
+    job->limit = job->rx->talkoff_limit;
+    /* The limit applies to the total over all the files, so this is only
+       provisional. judge_talkoff() gives the real result, once all the files
+       have been run. */
+    job->result = RESULT_PASS;
+}
+/*- End of function --------------------------------------------------------*/
+
+static uint32_t get_le16(const uint8_t *s)
+{
+    return s[0] | (s[1] << 8);
+}
+/*- End of function --------------------------------------------------------*/
+
+static uint32_t get_le32(const uint8_t *s)
+{
+    return s[0] | (s[1] << 8) | (s[2] << 16) | ((uint32_t) s[3] << 24);
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Map a speech file, and find its samples. Only 16 bit mono PCM .wav files,
+   sampled at 8000 samples/second, are accepted. */
+static int map_speech_file(speech_file_t *file, const char *name)
+{
+    struct stat st;
+    const uint8_t *p;
+    size_t pos;
+    uint32_t chunk_len;
+    int format_ok;
+    int fd;
+
+    file->name = name;
+    file->map = NULL;
+    file->data = NULL;
+    file->samples = 0;
+    if ((fd = open(name, O_RDONLY)) < 0)
+        return -1;
+    if (fstat(fd, &st)  ||  st.st_size < 12)
+    {
+        close(fd);
+        return -1;
+    }
+    file->map_len = st.st_size;
+    file->map = mmap(NULL, file->map_len, PROT_READ, MAP_SHARED, fd, 0);
+    /* The mapping outlives the descriptor */
+    close(fd);
+    if (file->map == MAP_FAILED)
+    {
+        file->map = NULL;
+        return -1;
+    }
+    p = (const uint8_t *) file->map;
+    if (memcmp(p, "RIFF", 4)  ||  memcmp(p + 8, "WAVE", 4))
+        goto bad;
+    format_ok = FALSE;
+    for (pos = 12;  pos + 8 <= file->map_len;  pos += 8 + chunk_len + (chunk_len & 1))
+    {
+        chunk_len = get_le32(p + pos + 4);
+        if (chunk_len > file->map_len - pos - 8)
+        {
+            /* Truncated recordings are common enough. Take what is there. */
+            if (memcmp(p + pos, "data", 4))
+                goto bad;
+            chunk_len = file->map_len - pos - 8;
+        }
+        if (memcmp(p + pos, "fmt ", 4) == 0)
+        {
+            if (chunk_len < 16
+                ||
+                get_le16(p + pos + 8) != 1
+                ||
+                get_le16(p + pos + 10) != 1
+                ||
+                get_le32(p + pos + 12) != SAMPLE_RATE
+                ||
+                get_le16(p + pos + 22) != 16)
+            {
+                goto bad;
+            }
+            format_ok = TRUE;
+        }
+        else if (memcmp(p + pos, "data", 4) == 0)
+        {
+            if (!format_ok)
+                goto bad;
+            file->data = p + pos + 8;
+            file->samples = chunk_len/2;
+            /* Several receivers will work their way through the file at once */
+            posix_madvise(file->map, file->map_len, POSIX_MADV_SEQUENTIAL);
+            return 0;
+        }
+    }
+bad:
+    munmap(file->map, file->map_len);
+    file->map = NULL;
+    return -1;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void add_job(const rx_desc_t *rx, int sweep, char digit, int variant)
+{
+    tone_rx_job_t *job;
+
+    if ((jobs = realloc(jobs, (n_jobs + 1)*sizeof(*jobs))) == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(2);
+    }
+    job = &jobs[n_jobs++];
+    memset(job, 0, sizeof(*job));
+    job->rx = rx;
+    job->sweep = sweep;
+    job->digit = digit;
+    job->variant = variant;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void build_jobs(const char *only_rx, const char *only_sweep, int quick)
+{
+    const rx_desc_t *rx;
+    const char *s;
+    int i;
+
+    for (rx = receivers;  rx->name;  rx++)
+    {
+        if (only_rx  &&  strncmp(only_rx, rx->name, strlen(only_rx)))
+            continue;
+        for (s = rx->sweep_digits;  *s;  s++)
+        {
+            if (quick  &&  s != rx->sweep_digits)
+                break;
+            if (only_sweep == NULL  ||  strcmp(only_sweep, sweep_names[SWEEP_TWIST]) == 0)
+            {
+                add_job(rx, SWEEP_TWIST, *s, 0);
+                add_job(rx, SWEEP_TWIST, *s, 1);
+            }
+            if (only_sweep == NULL  ||  strcmp(only_sweep, sweep_names[SWEEP_FREQ]) == 0)
+            {
+                add_job(rx, SWEEP_FREQ, *s, 0);
+                add_job(rx, SWEEP_FREQ, *s, 1);
+            }
+            if (only_sweep == NULL  ||  strcmp(only_sweep, sweep_names[SWEEP_NOISE]) == 0)
+                add_job(rx, SWEEP_NOISE, *s, 0);
+        }
+        if (only_sweep == NULL  ||  strcmp(only_sweep, sweep_names[SWEEP_TALKOFF]) == 0)
+        {
+            for (i = 0;  speech_files[i];  i++)
+                add_job(rx, SWEEP_TALKOFF, '\0', i);
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static const char *result_name(int result)
+{
+    switch (result)
+    {
+    case RESULT_PASS:
+        return "PASS";
+    case RESULT_FAIL:
+        return "FAIL";
+    case RESULT_SKIPPED:
+        return "SKIPPED";
+    }
+    return "NOT RUN";
+}
+/*- End of function --------------------------------------------------------*/
+
+static const char *variant_name(const tone_rx_job_t *job)
+{
+    switch (job->sweep)
+    {
+    case SWEEP_TWIST:
+        return (job->variant == 0)  ?  "normal"  :  "reverse";
+    case SWEEP_FREQ:
+        return (job->variant == 0)  ?  "low"  :  "high";
+    case SWEEP_TALKOFF:
+        return speech_files[job->variant];
+    }
+    return "";
+}
+/*- End of function --------------------------------------------------------*/
+
+/* The latency, in ms, below which a fraction of the detected bursts fell */
+static int latency_percentile(const int hist[], float fraction)
+{
+    int total;
+    int sum;
+    int i;
+
+    for (total = 0, i = 0;  i < LATENCY_BINS;  i++)
+        total += hist[i];
+    if (total == 0)
+        return -1;
+    for (sum = 0, i = 0;  i < LATENCY_BINS;  i++)
+    {
+        sum += hist[i];
+        if (sum > 0  &&  sum >= fraction*total)
+            break;
+    }
+    return i;
+}
+/*- End of function --------------------------------------------------------*/
+
+static void *worker(void *arg)
+{
+    tone_rx_job_t *job;
+    int verbose;
+    int quick;
+
+    verbose = ((int *) arg)[0];
+    quick = ((int *) arg)[1];
+    for (;;)
+    {
+        pthread_mutex_lock(&job_lock);
+        job = (next_job < n_jobs)  ?  &jobs[next_job++]  :  NULL;
+        pthread_mutex_unlock(&job_lock);
+        if (job == NULL)
+            break;
+
+        switch (job->sweep)
+        {
+        case SWEEP_TWIST:
+            run_twist(job);
+            break;
+        case SWEEP_FREQ:
+            run_freq(job);
+            break;
+        case SWEEP_NOISE:
+            run_noise(job, quick);
+            break;
+        case SWEEP_TALKOFF:
+            run_talkoff(job);
+            break;
+        }
+
+        pthread_mutex_lock(&job_lock);
+        done_jobs++;
+        if (verbose  ||  job->result == RESULT_FAIL)
+        {
+            printf("[%4d/%4d] %-13s %-7s %c %-7s %8.2f  %s\n",
+                   done_jobs, n_jobs, job->rx->name, sweep_names[job->sweep], (job->digit)  ?  job->digit  :  ' ',
+                   (job->sweep == SWEEP_TALKOFF)  ?  ""  :  variant_name(job), job->value,
+                   (job->sweep == SWEEP_TALKOFF)  ?  "DONE"  :  result_name(job->result));
+            fflush(stdout);
+        }
+        pthread_mutex_unlock(&job_lock);
+    }
+    return NULL;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* The talk-off limit is on the total hits over all the speech files, so each
+   file's case gets the result for the total */
+static void judge_talkoff(void)
+{
+    const rx_desc_t *rx;
+    tone_rx_job_t *job;
+    int hits;
+    int result;
+    int i;
+
+    for (rx = receivers;  rx->name;  rx++)
+    {
+        hits = 0;
+        for (i = 0;  i < n_jobs;  i++)
+        {
+            job = &jobs[i];
+            if (job->rx == rx  &&  job->sweep == SWEEP_TALKOFF  &&  job->result == RESULT_PASS)
+                hits += job->value;
+        }
+        result = (rx->talkoff_limit < 0  ||  hits <= rx->talkoff_limit)  ?  RESULT_PASS  :  RESULT_FAIL;
+        for (i = 0;  i < n_jobs;  i++)
+        {
+            job = &jobs[i];
+            if (job->rx == rx  &&  job->sweep == SWEEP_TALKOFF  &&  job->result == RESULT_PASS)
+                job->result = result;
+        }
+    }
+}
+/*- End of function --------------------------------------------------------*/
+
+static int write_report(const char *name)
+{
+    tone_rx_job_t *job;
+    FILE *f;
+    int i;
+
+    if ((f = fopen(name, "w")) == NULL)
+        return -1;
+    fprintf(f, "receiver,sweep,digit,variant,bursts,detected,value,rcfo,limit,latency_min,latency_p50,latency_p90,latency_p99,latency_max,result\n");
+    for (i = 0;  i < n_jobs;  i++)
+    {
+        job = &jobs[i];
+        fprintf(f, "%s,%s,", job->rx->name, sweep_names[job->sweep]);
+        if (job->digit)
+            fprintf(f, "%c", job->digit);
+        fprintf(f, ",%s,", variant_name(job));
+        if (job->result == RESULT_PASS  ||  job->result == RESULT_FAIL)
+        {
+            fprintf(f, "%d,%d,%.2f,", job->bursts, job->detected, job->value);
+            if (job->sweep == SWEEP_FREQ)
+                fprintf(f, "%.2f", job->rcfo);
+            fprintf(f, ",");
+            if (job->sweep != SWEEP_TALKOFF  ||  job->limit >= 0.0)
+                fprintf(f, "%.2f", job->limit);
+            fprintf(f, ",");
+            if (job->detected)
+            {
+                fprintf(f, "%d,%d,%d,%d,%d",
+                        latency_percentile(job->latency, 0.0),
+                        latency_percentile(job->latency, 0.5),
+                        latency_percentile(job->latency, 0.9),
+                        latency_percentile(job->latency, 0.99),
+                        latency_percentile(job->latency, 1.0));
+            }
+            else
+            {
+                fprintf(f, ",,,,");
+            }
+        }
+        else
+        {
+            fprintf(f, ",,,,,,,,,,");
+        }
+        fprintf(f, ",%s\n", result_name(job->result));
+    }
+    fclose(f);
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+
+static int print_summary(void)
+{
+    const rx_desc_t *rx;
+    tone_rx_job_t *job;
+    tone_rx_job_t *worst;
+    int latency[LATENCY_BINS];
+    int count[4];
+    int bad;
+    int hits;
+    int sweep;
+    int i;
+    int j;
+
+    bad = 0;
+    printf("receiver      sweep    runs pass fail skip   worst      latency ms: min  p50  p90  p99  max\n");
+    for (rx = receivers;  rx->name;  rx++)
+    {
+        for (sweep = 0;  sweep < SWEEPS;  sweep++)
+        {
+            memset(count, 0, sizeof(count));
+            memset(latency, 0, sizeof(latency));
+            worst = NULL;
+            hits = 0;
+            for (i = 0;  i < n_jobs;  i++)
+            {
+                job = &jobs[i];
+                if (job->rx != rx  ||  job->sweep != sweep)
+                    continue;
+                count[job->result]++;
+                for (j = 0;  j < LATENCY_BINS;  j++)
+                    latency[j] += job->latency[j];
+                if (job->result != RESULT_PASS  &&  job->result != RESULT_FAIL)
+                    continue;
+                hits += job->value;
+                /* The worst case is the one closest to its limit */
+                if (worst == NULL
+                    ||
+                    (sweep == SWEEP_NOISE  &&  job->value > worst->value)
+                    ||
+                    (sweep != SWEEP_NOISE  &&  job->value - job->limit < worst->value - worst->limit))
+                {
+                    worst = job;
+                }
+            }
+            if (count[RESULT_PASS] + count[RESULT_FAIL] + count[RESULT_SKIPPED] == 0)
+                continue;
+            printf("%-13s %-7s %5d %4d %4d %4d",
+                   rx->name, sweep_names[sweep], count[RESULT_PASS] + count[RESULT_FAIL] + count[RESULT_SKIPPED],
+                   count[RESULT_PASS], count[RESULT_FAIL], count[RESULT_SKIPPED]);
+            if (sweep == SWEEP_TALKOFF)
+            {
+                if (worst)
+                    printf(" %5d hits", hits);
+                if (worst  &&  rx->talkoff_limit >= 0  &&  hits > rx->talkoff_limit)
+                {
+                    printf(" (more than %d)", rx->talkoff_limit);
+                    bad++;
+                }
+                printf("\n");
+                continue;
+            }
+            if (worst)
+            {
+                printf(" %c %-7s %6.2f", worst->digit, variant_name(worst), worst->value);
+                if (latency_percentile(latency, 1.0) >= 0)
+                {
+                    printf("  %4d %4d %4d %4d %4d",
+                           latency_percentile(latency, 0.0),
+                           latency_percentile(latency, 0.5),
+                           latency_percentile(latency, 0.9),
+                           latency_percentile(latency, 0.99),
+                           latency_percentile(latency, 1.0));
+                }
+            }
+            printf("\n");
+            bad += count[RESULT_FAIL];
+        }
+    }
+    return bad;
+}
+/*- End of function --------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+    pthread_t threads[MAX_THREADS];
+    tone_rx_t rx;
+    const rx_desc_t *desc;
+    const char *report;
+    const char *only_rx;
+    const char *only_sweep;
+    int n_threads;
+    int flags[2];
+    int bad;
+    int i;
+    time_t start;
+
+    report = REPORT_FILE_NAME;
+    only_rx = NULL;
+    only_sweep = NULL;
+    n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    /* Verbose, and quick */
+    flags[0] = FALSE;
+    flags[1] = FALSE;
+    for (i = 1;  i < argc;  i++)
+    {
+        if (strcmp(argv[i], "-j") == 0  &&  i + 1 < argc)
+        {
+            n_threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0  &&  i + 1 < argc)
+        {
+            report = argv[++i];
+        }
+        else if (strcmp(argv[i], "-d") == 0  &&  i + 1 < argc)
+        {
+            only_rx = argv[++i];
+        }
+        else if (strcmp(argv[i], "-s") == 0  &&  i + 1 < argc)
+        {
+            only_sweep = argv[++i];
+        }
+        else if (strcmp(argv[i], "-quick") == 0)
+        {
+            flags[1] = TRUE;
+        }
+        else if (strcmp(argv[i], "-v") == 0)
+        {
+            flags[0] = TRUE;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: tone_rx_runner [-j threads] [-o report.csv] [-d receiver]\n"
+                            "                      [-s twist|freq|noise|talkoff] [-quick] [-v]\n");
+            exit(2);
+        }
+    }
+    if (n_threads < 1)
+        n_threads = 1;
+    if (n_threads > MAX_THREADS)
+        n_threads = MAX_THREADS;
+
+    build_jobs(only_rx, only_sweep, flags[1]);
+    if (n_jobs == 0)
+    {
+        fprintf(stderr, "No test cases selected\n");
+        exit(2);
+    }
+    for (i = 0;  speech_files[i];  i++)
+    {
+        if (map_speech_file(&speech[i], speech_files[i]))
+            printf("Cannot use speech file '%s' - its talk-off cases will be skipped\n", speech_files[i]);
+    }
+    /* The receivers build their shared Goertzel descriptors the first time they
+       are initialised. Get that done before there are several threads. */
+    for (desc = receivers;  desc->name;  desc++)
+        rx_init(&rx, desc);
+
+    if (n_threads > n_jobs)
+        n_threads = n_jobs;
+    printf("Running %d tone receiver test cases on %d threads\n", n_jobs, n_threads);
+    fflush(stdout);
+
+    time(&start);
+    for (i = 0;  i < n_threads;  i++)
+    {
+        if (pthread_create(&threads[i], NULL, worker, flags))
+        {
+            fprintf(stderr, "Cannot create thread\n");
+            exit(2);
+        }
+    }
+    for (i = 0;  i < n_threads;  i++)
+        pthread_join(threads[i], NULL);
+
+    judge_talkoff();
+    if (write_report(report))
+    {
+        fprintf(stderr, "Cannot write report '%s'\n", report);
+        exit(2);
+    }
+    printf("\n");
+    bad = print_summary();
+    printf("\n%d cases in %lds, report in %s\n", n_jobs, (long int) (time(NULL) - start), report);
+    for (i = 0;  speech_files[i];  i++)
+    {
+        if (speech[i].map)
+            munmap(speech[i].map, speech[i].map_len);
+    }
+    free(jobs);
+    if (bad)
+    {
+        printf("Tests failed\n");
+        exit(1);
+    }
+    printf("Tests passed\n");
+    return 0;
+}
+/*- End of function --------------------------------------------------------*/
+/*- End of file ------------------------------------------------------------*/
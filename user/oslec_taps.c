@@ -0,0 +1,79 @@
+/*
+   oslec_taps.c
+   Created 18 October 2026
+
+   Prints a coefficient snapshot from /proc/oslec/taps as text, one
+   tap per line: tap number, foreground tap, background tap.  Handy for
+   plotting the impulse response of a live call, for example:
+
+     # echo 0 > /proc/oslec/taps
+     # ./oslec_taps > taps.txt
+     # gnuplot -persist -e "plot 'taps.txt' using 1:2 with lines"
+
+   Write -1 to /proc/oslec/taps when you are done, to free the
+   snapshot memory.
+*/
+
+/*
+  Copyright (C) 2026
+
+  All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define MAX_TAPS 4096
+
+int main(int argc, char *argv[]) {
+    FILE       *f;
+    const char *name;
+    uint32_t    hdr[2];
+    int16_t     fg[MAX_TAPS], bg[MAX_TAPS];
+    int         i, taps;
+
+    name = "/proc/oslec/taps";
+    if (argc > 1)
+	name = argv[1];
+
+    f = fopen(name, "rb");
+    if (f == NULL) {
+	fprintf(stderr, "Error opening %s\n", name);
+	exit(1);
+    }
+
+    /* record is: sample, taps, fg[taps], bg[taps] */
+
+    if (fread(hdr, sizeof(hdr), 1, f) != 1) {
+	fprintf(stderr, "No snapshot - is a channel being watched?\n");
+	exit(1);
+    }
+    taps = hdr[1];
+    if ((taps > MAX_TAPS) 
+	|| (fread(fg, sizeof(int16_t), taps, f) != taps)
+	|| (fread(bg, sizeof(int16_t), taps, f) != taps)) {
+	fprintf(stderr, "Bad snapshot record\n");
+	exit(1);
+    }
+    fclose(f);
+
+    printf("# sample %u taps %d\n", hdr[0], taps);
+    for(i=0; i<taps; i++)
+	printf("%d %d %d\n", i, fg[i], bg[i]);
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+   oslec_trace.c
+   Created 18 October 2026
+
+   Decodes the binary event trace logged by the echo canceller, for
+   example from /proc/oslec/trace.  Prints one event per line with a
+   sample accurate time stamp, so the canceller's behaviour can be
+   lined up with sample captures or echo complaints.
+
+   Usage:
+
+     # echo 1 > /proc/oslec/trace
+     (make a call)
+     # ./oslec_trace
+     # ./oslec_trace trace.bin
+*/
+
+/*
+  Copyright (C) 2026
+
+  All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <echo.h>
+
+#define FS 8000
+
+static const char *event_name(int type) {
+    switch(type) {
+    case ECHO_CAN_TRACE_FG_TRANSFER:
+	return "fg transfer";
+    case ECHO_CAN_TRACE_DTD_START:
+	return "dtd start";
+    case ECHO_CAN_TRACE_DTD_END:
+	return "dtd end";
+    case ECHO_CAN_TRACE_NLP_ENGAGE:
+	return "nlp engage";
+    case ECHO_CAN_TRACE_NLP_RELEASE:
+	return "nlp release";
+    case ECHO_CAN_TRACE_MODE:
+	return "mode";
+    case ECHO_CAN_TRACE_CLIP:
+	return "clip";
+    case ECHO_CAN_TRACE_LOST:
+	return "lost";
+    }
+    return "unknown";
+}
+
+static const char *value_name(int type) {
+    switch(type) {
+    case ECHO_CAN_TRACE_FG_TRANSFER:
+	return "Lclean_bg";
+    case ECHO_CAN_TRACE_DTD_START:
+    case ECHO_CAN_TRACE_DTD_END:
+	return "Lrx";
+    case ECHO_CAN_TRACE_NLP_ENGAGE:
+    case ECHO_CAN_TRACE_NLP_RELEASE:
+	return "Lclean";
+    case ECHO_CAN_TRACE_MODE:
+	return "mode";
+    case ECHO_CAN_TRACE_CLIP:
+	return "sample";
+    case ECHO_CAN_TRACE_LOST:
+	return "events";
+    }
+    return "value";
+}
+
+int main(int argc, char *argv[]) {
+    FILE                   *f;
+    const char             *name;
+    echo_can_trace_event_t  ev;
+    uint32_t                last;
+    unsigned long long      sample, lost;
+
+    name = "/proc/oslec/trace";
+    if (argc > 1)
+	name = argv[1];
+
+    f = fopen(name, "rb");
+    if (f == NULL) {
+	fprintf(stderr, "Error opening %s\n", name);
+	exit(1);
+    }
+
+    /* the 32 bit sample count in each event wraps after about 6
+       days, so unwrap it relative to the previous event */
+
+    last = 0;
+    sample = 0;
+    lost = 0;
+    printf("  sample      time (s)  event         value\n");
+    while(fread(&ev, sizeof(ev), 1, f) == 1) {
+	sample += (uint32_t)(ev.sample - last);
+	last = ev.sample;
+
+	/* the ring was full, so events were dropped just before this
+	   point - the count saturates at 32767 */
+
+	if (ev.type == ECHO_CAN_TRACE_LOST)
+	    lost += (uint16_t)ev.value;
+	printf("%10llu %13.4f  %-12s  %s %d\n", sample, (float)sample/FS,
+	       event_name(ev.type), value_name(ev.type), ev.value);
+    }
+    if (lost)
+	printf("\n%llu events were lost as the trace ring was full, see "
+	       "\"Trace lost\" in /proc/oslec/info for the exact total\n", lost);
+
+    fclose(f);
+
+    return 0;
+}